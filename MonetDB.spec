@@ -460,6 +460,8 @@ developer.
 %files client-tests
 %defattr(-,root,root)
 %{_bindir}/arraytest
+%{_bindir}/binresult
+%{_bindir}/binrows
 %{_bindir}/odbcsample1
 %{_bindir}/sample0
 %{_bindir}/sample1
@@ -468,6 +470,7 @@ developer.
 %{_bindir}/sample4
 %{_bindir}/smack00
 %{_bindir}/smack01
+%{_bindir}/streamcodec
 %{_bindir}/testgetinfo
 %{_bindir}/malsample.pl
 %{_bindir}/sqlsample.php
@@ -0,0 +1,174 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2008-2015 MonetDB B.V.
+ */
+
+/* Run the same queries over a connection that receives result sets
+ * as text and one that receives them in binary.  Every field must
+ * read the same on both, and the results that can be shipped in
+ * binary must actually arrive that way. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <mapi.h>
+#ifdef _MSC_VER
+#define LLFMT "%I64d"
+#else
+#define LLFMT "%lld"
+#endif
+
+#define CACHESIZE	100
+
+#define die(dbh,hdl)	do {						\
+				if (hdl)				\
+					mapi_explain_result(hdl,stderr); \
+				else if (dbh)				\
+					mapi_explain(dbh,stderr);	\
+				else					\
+					fprintf(stderr,"command failed\n"); \
+				exit(-1);				\
+			} while (0)
+
+static Mapi
+dbconnect(const char *host, int port, const char *lang, int binary)
+{
+	Mapi dbh;
+
+	dbh = mapi_mapi(host, port, "monetdb", "monetdb", lang, NULL);
+	if (dbh == NULL || mapi_error(dbh))
+		die(dbh, NULL);
+	mapi_set_binary(dbh, binary);
+	if (mapi_reconnect(dbh) != MOK || mapi_error(dbh))
+		die(dbh, NULL);
+	mapi_cache_limit(dbh, CACHESIZE);
+	return dbh;
+}
+
+static void
+update(Mapi dbh, const char *cmd)
+{
+	MapiHdl hdl;
+
+	if ((hdl = mapi_query(dbh, cmd)) == NULL || mapi_error(dbh))
+		die(dbh, hdl);
+	mapi_close_handle(hdl);
+}
+
+/* run a query on both connections and compare the results; the rows
+ * are printed as the binary connection sees them if show is set */
+static void
+compare(Mapi txt, Mapi bin, const char *query, int show)
+{
+	MapiHdl th, bh;
+	mapi_int64 rows = 0, binrows = 0, wrong = 0;
+	int i, n;
+
+	printf("%s\n", query);
+	if ((th = mapi_query(txt, query)) == NULL ||
+	    (bh = mapi_query(bin, query)) == NULL)
+		die(NULL, NULL);
+	if (mapi_error(txt) || mapi_error(bin)) {
+		/* both must fail the same way */
+		printf("error %s\n",
+		       mapi_error(txt) && mapi_error(bin) &&
+		       strcmp(mapi_result_error(th), mapi_result_error(bh)) == 0 ?
+		       "on both" : "DIFFERS");
+		mapi_close_handle(th);
+		mapi_close_handle(bh);
+		return;
+	}
+	if (mapi_get_field_count(th) != mapi_get_field_count(bh) ||
+	    mapi_get_row_count(th) != mapi_get_row_count(bh))
+		wrong++;
+	while ((n = mapi_fetch_row(th)) > 0) {
+		if (mapi_fetch_row(bh) != n) {
+			wrong++;
+			break;
+		}
+		if (mapi_fetch_column_row(bh) >= 0)
+			binrows++;
+		for (i = 0; i < n; i++) {
+			const char *t = mapi_fetch_field(th, i);
+			const char *b = mapi_fetch_field(bh, i);
+
+			if (t == NULL ? b != NULL : b == NULL || strcmp(t, b) != 0)
+				wrong++;
+			if (show)
+				printf("%s%s", i ? "|" : "", b ? b : "NULL");
+		}
+		if (show)
+			printf("\n");
+		rows++;
+	}
+	if (mapi_fetch_row(bh) != 0)
+		wrong++;
+	if (mapi_error(txt) || mapi_error(bin))
+		die(mapi_error(txt) ? txt : bin, NULL);
+	printf("rows " LLFMT ", in binary " LLFMT ", differences " LLFMT "\n",
+	       rows, binrows, wrong);
+	mapi_close_handle(th);
+	mapi_close_handle(bh);
+}
+
+int
+main(int argc, char **argv)
+{
+	Mapi txt, bin;
+
+	if (argc != 4) {
+		printf("usage:%s <host> <port> <language>\n", argv[0]);
+		exit(-1);
+	}
+
+	txt = dbconnect(argv[1], atoi(argv[2]), argv[3], 0);
+	bin = dbconnect(argv[1], atoi(argv[2]), argv[3], 1);
+
+	update(txt, "create table binresult (t tinyint, s smallint, i int,"
+	       " l bigint, b boolean, r real, d double, d1 decimal(4,1),"
+	       " d2 decimal(9,2), d4 decimal(18,4), v varchar(20), c char(5),"
+	       " dt date, tm time, ts timestamp, iv interval second)");
+	update(txt, "insert into binresult values"
+	       " (1, 2, 3, 4, true, 1.5, 2.25, 1.5, 1234567.89,"
+	       " 12345678901234.5678, 'abc', 'x', date '2015-07-01',"
+	       " time '12:34:56', timestamp '2015-07-01 12:34:56.789',"
+	       " interval '90' second),"
+	       " (-127, -32767, -2147483647, -9223372036854775807, false,"
+	       " -0.125, -1e300, -999.9, -0.01, -0.0001, '', '',"
+	       " date '0001-01-01', time '00:00:00',"
+	       " timestamp '1970-01-01 00:00:00', interval '0' second),"
+	       " (null, null, null, null, null, null, null, null, null,"
+	       " null, null, null, null, null, null, null),"
+	       " (0, 0, 0, 0, true, 3.4e38, 1.7976931348623157e308, 0, 0,"
+	       " 0, 'tab\tquote''s\\\\', 'abc', null, null, null, null),"
+	       " (127, 32767, 2147483647, 9223372036854775807, null,"
+	       " 1e-30, 4.9e-324, 999.9, 9999999.99, 99999999999999.9999,"
+	       " 'line\nbreak', null, date '9999-12-31', time '23:59:59',"
+	       " timestamp '2015-12-31 23:59:59', interval '86400' second)");
+
+	/* all types, with NULLs and extreme values */
+	compare(txt, bin, "select * from binresult", 1);
+	compare(txt, bin, "select i, v, d2 from binresult where i > 0 order by i", 1);
+	/* computed columns */
+	compare(txt, bin, "select i % 1000 + 1, d2 * 2, r / 2, v || '!', b = false from binresult", 1);
+	/* an empty result */
+	compare(txt, bin, "select * from binresult where i = 42", 1);
+	/* many blocks */
+	compare(txt, bin, "select cast(value as int), cast(value as bigint) * 1000000007,"
+		" case when value % 7 = 0 then null else cast(value as double) / 8 end,"
+		" cast(value % 100 as decimal(5,2)), 'v' || cast(value as varchar(10))"
+		" from sys.generate_series(cast(0 as int), 12345)", 0);
+	/* an error, after which both connections are still usable */
+	compare(txt, bin, "select 1 / (i - i) from binresult", 0);
+	/* single values are always sent as text */
+	compare(txt, bin, "select count(*), sum(i) from binresult", 1);
+
+	update(txt, "drop table binresult");
+	mapi_destroy(txt);
+	mapi_destroy(bin);
+
+	return 0;
+}
@@ -0,0 +1,132 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2008-2015 MonetDB B.V.
+ */
+
+/* Fetch a result set received in binary in rowsets the way the ODBC
+ * driver does: the rows of a rowset are fetched first and their
+ * values are then read from the binary columns in one go.  The
+ * rowsets are larger than the blocks of the row cache and not a
+ * multiple of them, so rowsets are split over several blocks. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <mapi.h>
+#ifdef _MSC_VER
+#define LLFMT "%I64d"
+#else
+#define LLFMT "%lld"
+#endif
+
+#define NROWS		2500
+#define CACHESIZE	100
+#define ROWSETSIZE	130
+
+#define die(dbh,hdl)	do {						\
+				if (hdl)				\
+					mapi_explain_result(hdl,stderr); \
+				else if (dbh)				\
+					mapi_explain(dbh,stderr);	\
+				else					\
+					fprintf(stderr,"command failed\n"); \
+				exit(-1);				\
+			} while (0)
+
+static mapi_int64
+intval(const void *data, int width, mapi_int64 r)
+{
+	switch (width) {
+	case 1:
+		return ((const signed char *) data)[r];
+	case 2:
+		return ((const short *) data)[r];
+	case 4:
+		return ((const int *) data)[r];
+	case 8:
+		return ((const mapi_int64 *) data)[r];
+	}
+	return -1;
+}
+
+int
+main(int argc, char **argv)
+{
+	Mapi dbh;
+	MapiHdl hdl = NULL;
+	mapi_int64 rows[ROWSETSIZE], first, r, n = 0, wrong = 0;
+	const void *data[3];
+	const char *nulls[3];
+	const mapi_int64 *offsets;
+	int width[3], i, k, cnt;
+
+	if (argc != 4) {
+		printf("usage:%s <host> <port> <language>\n", argv[0]);
+		exit(-1);
+	}
+
+	/* ask for binary result sets before connecting */
+	dbh = mapi_mapi(argv[1], atoi(argv[2]), "monetdb", "monetdb", argv[3], NULL);
+	if (dbh == NULL || mapi_error(dbh))
+		die(dbh, hdl);
+	mapi_set_binary(dbh, 1);
+	if (mapi_reconnect(dbh) != MOK || mapi_error(dbh))
+		die(dbh, hdl);
+
+	mapi_cache_limit(dbh, CACHESIZE);
+	if ((hdl = mapi_query(dbh, "select cast(value as int),"
+			      " case when value % 3 = 0 then null"
+			      " else cast(value * 7 as bigint) end,"
+			      " cast(value as varchar(10))"
+			      " from sys.generate_series(cast(0 as int), 2500)")) == NULL ||
+	    mapi_error(dbh))
+		die(dbh, hdl);
+
+	for (;;) {
+		for (cnt = 0; cnt < ROWSETSIZE; cnt++) {
+			if (!mapi_fetch_row(hdl))
+				break;
+			rows[cnt] = mapi_fetch_column_row(hdl);
+			if (rows[cnt] < 0) {
+				fprintf(stderr, "row " LLFMT " not received in binary\n", n + cnt);
+				exit(1);
+			}
+			/* the rows of the rowset must survive the
+			 * next block */
+			if (cnt == 0 && mapi_keep_column_rows(hdl, rows[0]) != MOK)
+				die(dbh, hdl);
+		}
+		if (mapi_error(dbh))
+			die(dbh, hdl);
+		if (cnt == 0)
+			break;
+		for (i = 0; i < 3; i++)
+			if ((data[i] = mapi_fetch_column(hdl, i, &first, NULL, &width[i], &nulls[i], i == 2 ? &offsets : NULL)) == NULL)
+				die(dbh, hdl);
+		for (k = 0; k < cnt; k++, n++) {
+			char buf[24];
+
+			r = rows[k] - first;
+			snprintf(buf, sizeof(buf), LLFMT, n);
+			if (r < 0 ||
+			    nulls[0][r] || intval(data[0], width[0], r) != n ||
+			    (n % 3 == 0) != (nulls[1][r] != 0) ||
+			    (n % 3 != 0 && intval(data[1], width[1], r) != n * 7) ||
+			    nulls[2][r] ||
+			    strcmp((const char *) data[2] + offsets[r], buf) != 0)
+				wrong++;
+		}
+		if (mapi_keep_column_rows(hdl, -1) != MOK)
+			die(dbh, hdl);
+	}
+	printf("rows received " LLFMT ", wrong " LLFMT "\n", n, wrong);
+
+	if (mapi_close_handle(hdl) != MOK)
+		die(dbh, hdl);
+	mapi_destroy(dbh);
+
+	return 0;
+}
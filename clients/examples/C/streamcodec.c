@@ -0,0 +1,223 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2008-2015 MonetDB B.V.
+ */
+
+/* Write messages through a compressing block stream into a file and
+ * read them back.  Each message must come back unchanged, whether the
+ * block stream compressed it or, because it is too short or doesn't
+ * shrink, sent it as ordinary blocks. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stream.h>
+
+#define MAXLEN		300000
+#define WCHUNK		1000	/* size of the writes */
+#define RCHUNK		777	/* size of the reads */
+
+static char src[MAXLEN], dst[MAXLEN + RCHUNK];
+static unsigned int seed;
+
+/* a fixed pseudo-random sequence, so that the output is stable */
+static void
+randfill(char *p, size_t n)
+{
+	while (n-- > 0) {
+		seed = seed * 1103515245 + 12345;
+		*p++ = (char) (seed >> 16);
+	}
+}
+
+static size_t
+mkempty(char *p)
+{
+	(void) p;
+	return 0;
+}
+
+static size_t
+mkshort(char *p)
+{
+	/* shorter than the least a block stream compresses */
+	strcpy(p, "a short reply, sent as it is, a short reply, sent as it is\n");
+	return strlen(p);
+}
+
+static size_t
+mkzeros(char *p)
+{
+	/* just long enough to be compressed, a single long match
+	 * that overlaps with what it produces */
+	memset(p, 0, 1024);
+	return 1024;
+}
+
+static size_t
+mktext(char *p)
+{
+	/* several compressed frames */
+	size_t n = 0;
+	int i;
+
+	for (i = 0; n + 40 < MAXLEN; i++)
+		n += (size_t) snprintf(p + n, 40, "%d\t\"row %d\"\t%d.%02d\n", i, i % 100, i * 3, i % 100);
+	return n;
+}
+
+static size_t
+mkrandom(char *p)
+{
+	/* incompressible */
+	randfill(p, 100000);
+	return 100000;
+}
+
+static size_t
+mkrepeat(char *p)
+{
+	/* incompressible data that repeats within reach of a back
+	 * reference */
+	randfill(p, 40000);
+	memcpy(p + 40000, p, 40000);
+	return 80000;
+}
+
+static size_t
+mkfar(char *p)
+{
+	/* incompressible data that repeats out of reach */
+	randfill(p, 70000);
+	memcpy(p + 70000, p, 70000);
+	return 140000;
+}
+
+static struct msg {
+	const char *name;
+	size_t (*make)(char *);
+} msgs[] = {
+	{"empty", mkempty},
+	{"short", mkshort},
+	{"zeros", mkzeros},
+	{"text", mktext},
+	{"random", mkrandom},
+	{"random repeated", mkrepeat},
+	{"random repeated far away", mkfar},
+};
+
+#define NMSGS	((int) (sizeof(msgs) / sizeof(msgs[0])))
+
+static void
+die(const char *msg, const char *fname)
+{
+	fprintf(stderr, "%s %s\n", msg, fname);
+	exit(1);
+}
+
+static long
+filesize(const char *fname)
+{
+	FILE *f;
+	long n;
+
+	if ((f = fopen(fname, "rb")) == NULL || fseek(f, 0, SEEK_END) != 0)
+		die("cannot open", fname);
+	n = ftell(f);
+	fclose(f);
+	return n;
+}
+
+/* write the messages from..to-1 into fname, each one flushed */
+static void
+writemsgs(const char *fname, int from, int to)
+{
+	stream *s;
+	size_t n, i;
+	int m;
+
+	if ((s = block_stream(open_wstream(fname))) == NULL ||
+	    mnstr_errnr(s) ||
+	    block_stream_compress(s, 1) < 0)
+		die("cannot create", fname);
+	for (m = from; m < to; m++) {
+		seed = (unsigned int) m;
+		n = (*msgs[m].make)(src);
+		for (i = 0; i < n; i += WCHUNK)
+			if (mnstr_write(s, src + i, 1, n - i < WCHUNK ? n - i : WCHUNK) < 0)
+				die("cannot write", fname);
+		if (mnstr_flush(s) < 0)
+			die("cannot flush", fname);
+	}
+	mnstr_close(s);
+	mnstr_destroy(s);
+}
+
+/* read the messages back from fname and compare them */
+static int
+readmsgs(const char *fname, int from, int to)
+{
+	stream *s;
+	size_t n, got;
+	ssize_t r;
+	int m, ok = 1;
+
+	if ((s = block_stream(open_rstream(fname))) == NULL || mnstr_errnr(s))
+		die("cannot open", fname);
+	for (m = from; m < to; m++) {
+		seed = (unsigned int) m;
+		n = (*msgs[m].make)(src);
+		got = 0;
+		while ((r = mnstr_read(s, dst + got, 1, RCHUNK)) > 0) {
+			got += (size_t) r;
+			if (got > MAXLEN)
+				break;
+		}
+		if (r < 0 || got != n || memcmp(src, dst, n) != 0)
+			ok = 0;
+	}
+	/* and nothing follows */
+	if (mnstr_read(s, dst, 1, RCHUNK) != 0)
+		ok = 0;
+	mnstr_close(s);
+	mnstr_destroy(s);
+	return ok;
+}
+
+int
+main(int argc, char **argv)
+{
+	char fname[1024];
+	int m;
+
+	if (argc != 2) {
+		printf("usage:%s <directory>\n", argv[0]);
+		exit(-1);
+	}
+
+	for (m = 0; m < NMSGS; m++) {
+		size_t n;
+
+		snprintf(fname, sizeof(fname), "%s/streamcodec%d", argv[1], m);
+		writemsgs(fname, m, m + 1);
+		seed = (unsigned int) m;
+		n = (*msgs[m].make)(src);
+		printf("%s: %ld bytes, compressed %s, round trip %s\n",
+		       msgs[m].name, (long) n,
+		       filesize(fname) < (long) n ? "yes" : "no",
+		       readmsgs(fname, m, m + 1) ? "ok" : "FAILED");
+		remove(fname);
+	}
+
+	/* all messages one after the other in a single stream */
+	snprintf(fname, sizeof(fname), "%s/streamcodec", argv[1]);
+	writemsgs(fname, 0, NMSGS);
+	printf("all in one stream: round trip %s\n",
+	       readmsgs(fname, 0, NMSGS) ? "ok" : "FAILED");
+	remove(fname);
+
+	return 0;
+}
@@ -271,6 +271,8 @@
  * @item mapi_explain()	@tab	Display error message and context on stream
  * @item mapi_explain_query()	@tab	Display error message and context on stream
  * @item mapi_fetch_all_rows()	@tab	Fetch all answers from server into cache
+ * @item mapi_fetch_column()	@tab Fetch a column of a binary result set
+ * @item mapi_fetch_column_row()	@tab Number of the current row in the binary columns
  * @item mapi_fetch_field()	@tab Fetch a field from the current row
  * @item mapi_fetch_field_len()	@tab Fetch the length of a field from the current row
  * @item mapi_fetch_field_array()	@tab Fetch all fields from the current row
@@ -292,6 +294,7 @@
  * @item mapi_get_to()	@tab	Get the stream 'to'
  * @item mapi_get_trace()	@tab	Get trace flag
  * @item mapi_get_user()	@tab	Current user name
+ * @item mapi_keep_column_rows()	@tab Keep rows in the binary columns
  * @item mapi_log()	@tab Keep log of client/server interaction
  * @item mapi_next_result()	@tab	Go to next result set
  * @item mapi_needmore()	@tab	Return whether more data is needed
@@ -309,6 +312,8 @@
  * @item mapi_rows_affected()	@tab Obtain number of rows changed
  * @item mapi_seek_row()	@tab	Move row reader to specific location in cache
  * @item mapi_setAutocommit()	@tab	Set auto-commit flag
+ * @item mapi_set_binary()	@tab	Ask for binary result sets
+ * @item mapi_set_compression()	@tab	Compress the connection
  * @item mapi_stream_query()	@tab Send query and prepare for reading tuple stream
  * @item mapi_table()	@tab	Get current table name
  * @item mapi_timeout()	@tab	Set timeout for long-running queries[TODO]
@@ -550,6 +555,35 @@
  * @code{mapi_fetch_row()} will take the row from the cache. The number or
  * rows cached is returned.
  *
+ * @item const void *mapi_fetch_column(MapiHdl hdl, int fnr, mapi_int64 *first, mapi_int64 *nrows, int *width, const char **nulls, const mapi_int64 **offsets)
+ *
+ * Access a column of a result set that the server shipped in binary
+ * (see @code{mapi_set_binary()}) without converting it to strings.
+ * It returns the values of the rows received so far that are still
+ * in the row cache, their number is stored in @code{*nrows} and the
+ * number of the first of them in @code{*first}; use
+ * @code{mapi_fetch_all_rows()} first to get the complete result.  Numbers and booleans are returned as
+ * @code{*width} byte native integers or floats, decimals as integers
+ * scaled by @code{mapi_get_scale()}.  For all other types
+ * @code{*width} is zero and the result is a heap of zero-terminated
+ * strings, @code{(*offsets)[i]} being the start of row
+ * @code{*first} + i.  @code{(*nulls)[i]} is set if row @code{*first} + i
+ * is NULL.
+ *
+ * @item mapi_int64 mapi_fetch_column_row(MapiHdl hdl)
+ *
+ * Return the number of the row last retrieved with
+ * @code{mapi_fetch_row()} in the binary columns, or -1 if that row was
+ * not received in binary.  A row keeps its number when the rows before
+ * it are dropped from the cache.
+ *
+ * @item MapiMsg mapi_keep_column_rows(MapiHdl hdl, mapi_int64 row)
+ *
+ * Keep the binary values of the rows from number @code{row} on when
+ * @code{mapi_fetch_row()} reads the next block of the result, so that
+ * all rows fetched since can still be accessed through
+ * @code{mapi_fetch_column()}.  A @code{row} of -1 lets them go again.
+ *
  * @item int mapi_quick_response(MapiHdl hdl, FILE *fd)
  *
  * Read the answer to a query and pass the results verbatim to a
@@ -688,6 +722,22 @@
  * when the language is SQL.  In that case, the server commits after each
  * statement sent to the server.
  *
+ * @item MapiMsg mapi_set_binary(Mapi mid, int value)
+ *
+ * Ask the server to ship SQL result sets column-wise in binary instead
+ * of as text.  It is negotiated when connecting, so it has to be set
+ * before @code{mapi_connect()}, and it is silently ignored by servers
+ * that don't support it.  Rows can still be retrieved with
+ * @code{mapi_fetch_row()} and friends, @code{mapi_fetch_column()}
+ * gives direct access to the received columns.
+ *
+ * @item MapiMsg mapi_set_compression(Mapi mid, int value)
+ *
+ * Compress large blocks sent over the connection, which is the default
+ * for TCP connections to servers that support it.  Small replies are
+ * never compressed.  Like @code{mapi_set_binary()} it takes effect
+ * when connecting.
+ *
  * @item MapiMsg mapi_cache_limit(Mapi mid, int maxrows)
  *
  * A limited number of tuples are pre-fetched after each @code{execute()}.  If
@@ -870,9 +920,27 @@ struct MapiRowBuf {
 		mapi_int64 tuplerev;	/* reverse map of tupleindex */
 		char **anchors;	/* corresponding field pointers */
 		size_t *lens;	/* corresponding field lenghts */
+		mapi_int64 binrow;	/* row # in the binary columns or -1 */
 	} *line;
 };
 
+/*
+ * A result column received through the binary result set protocol.
+ * Successive blocks of a result set are appended (after dropping the
+ * rows that left the row cache), the cache lines refer to their row by
+ * binrow and are only turned into strings when the application asks
+ * for them.
+ */
+struct MapiBinColumn {
+	int kind;		/* 'i', 'd', 'f', 'b' or 's' */
+	int width;		/* bytes per value, 0 for strings */
+	int scale;		/* scale of decimals */
+	char *nulls;		/* one byte per row, set if NULL */
+	char *data;		/* fixed width values or string heap */
+	mapi_int64 *offsets;	/* start of each string in data */
+	mapi_int64 heapsize;	/* bytes used in the string heap */
+};
+
 struct BlockCache {
 	char *buf;
 	int lim;
@@ -900,6 +968,9 @@ struct MapiStruct {
 
 	int trace;		/* Trace Mapi interaction */
 	int auto_commit;
+	int wantbinary;		/* ask for binary result sets */
+	int binary;		/* server agreed to send them */
+	int wantcompress;	/* compress the connection if possible */
 	char *noexplain;	/* on error, don't explain, only print result */
 	MapiMsg error;		/* Error occurred */
 	char *errorstr;		/* error from server */
@@ -935,6 +1006,11 @@ struct MapiResultSet {
 	struct MapiColumn *fields;
 	struct MapiRowBuf cache;
 	int commentonly;	/* only comments seen so far */
+	struct MapiBinColumn *bincols;	/* columns received in binary */
+	int bincnt;		/* number of binary columns */
+	mapi_int64 binfirst;	/* row # of first row in the binary columns */
+	mapi_int64 binrows;	/* number of rows in the binary columns */
+	mapi_int64 binkeep;	/* row # from which on rows are kept or -1 */
 };
 
 struct MapiStatement {
@@ -1524,6 +1600,12 @@ new_result(MapiHdl hdl)
 
 	result->commentonly = 1;
 
+	result->bincols = NULL;
+	result->bincnt = 0;
+	result->binfirst = 0;
+	result->binrows = 0;
+	result->binkeep = -1;
+
 	return result;
 }
 
@@ -1638,6 +1720,18 @@ close_result(MapiHdl hdl)
 		result->cache.line = NULL;
 		result->cache.tuplecount = 0;
 	}
+	if (result->bincols) {
+		for (i = 0; i < result->bincnt; i++) {
+			if (result->bincols[i].nulls)
+				free(result->bincols[i].nulls);
+			if (result->bincols[i].data)
+				free(result->bincols[i].data);
+			if (result->bincols[i].offsets)
+				free(result->bincols[i].offsets);
+		}
+		free(result->bincols);
+		result->bincols = NULL;
+	}
 	if (result->errorstr)
 		free(result->errorstr);
 	result->errorstr = NULL;
@@ -1876,6 +1970,7 @@ mapi_new(void)
 	/* then fill in some details */
 	mid->index = index++;	/* for distinctions in log records */
 	mid->auto_commit = 1;
+	mid->wantcompress = 1;
 	mid->error = MOK;
 	mid->hostname = strdup("localhost");
 	mid->server = NULL;
@@ -2544,6 +2639,7 @@ mapi_start_talking(Mapi mid)
 	char *server;
 	char *protover;
 	char *rest;
+	int compress = 0;
 
 	if (!isa_block_stream(mid->to)) {
 		mid->to = block_stream(mid->to);
@@ -2585,6 +2681,7 @@ mapi_start_talking(Mapi mid)
 		char *hashes = NULL;
 		char *byteo = NULL;
 		char *serverhash = NULL;
+		char *features = NULL;
 		char *algsv[] = {
 			"RIPEMD160",
 			"SHA1",
@@ -2635,6 +2732,12 @@ mapi_start_talking(Mapi mid)
 		if (hash) {
 			*hash = '\0';
 			rest = hash + 1;
+			/* newer servers list the optional protocol
+			 * features they support in the 7th field */
+			features = rest;
+			hash = strchr(features, ':');
+			if (hash)
+				*hash = '\0';
 		}
 		hash = NULL;
 		/* hash password, if not already */
@@ -2700,16 +2803,30 @@ mapi_start_talking(Mapi mid)
 
 		mnstr_set_byteorder(mid->from, strcmp(byteo, "BIG") == 0);
 
+		/* only ask for binary result sets if the server offers them */
+		mid->binary = mid->wantbinary &&
+			strcmp(mid->language, "sql") == 0 &&
+			features != NULL && strstr(features, "BINARY") != NULL;
+		/* compressing a local connection doesn't pay off */
+		compress = mid->wantcompress &&
+			(mid->hostname == NULL || mid->hostname[0] != '/') &&
+			features != NULL && strstr(features, "COMPRESS") != NULL;
+
 		/* note: if we make the database field an empty string, it
-		 * means we want the default.  However, it *should* be there. */
-		if (snprintf(buf, BLOCK, "%s:%s:%s:%s:%s:\n",
+		 * means we want the default.  However, it *should* be there.
+		 * The features we want follow the database. */
+		if (snprintf(buf, BLOCK, "%s:%s:%s:%s:%s:%s%s%s%s\n",
 #ifdef WORDS_BIGENDIAN
 			     "BIG",
 #else
 			     "LIT",
 #endif
 			     mid->username, hash, mid->language,
-			     mid->database == NULL ? "" : mid->database) >= BLOCK) {;
+			     mid->database == NULL ? "" : mid->database,
+			     mid->binary ? "BINARY" : "",
+			     mid->binary && compress ? "," : "",
+			     compress ? "COMPRESS" : "",
+			     mid->binary || compress ? ":" : "") >= BLOCK) {;
 			mapi_setError(mid, "combination of database name and user name too long", "mapi_start_talking", MERROR);
 			free(hash);
 			return mid->error;
@@ -2735,6 +2852,9 @@ mapi_start_talking(Mapi mid)
 	check_stream(mid, mid->to, "Could not send initial byte sequence", "mapi_start_talking", mid->error);
 	mnstr_flush(mid->to);
 	check_stream(mid, mid->to, "Could not send initial byte sequence", "mapi_start_talking", mid->error);
+	/* the server compresses its replies from now on, and so do we */
+	if (compress)
+		block_stream_compress(mid->to, 1);
 
 	/* consume the welcome message from the server */
 	hdl = mapi_new_handle(mid);
@@ -3518,6 +3638,22 @@ mapi_set_size_header(Mapi mid, int value)
 		return mapi_Xcommand(mid, "sizeheader", "0");
 }
 
+MapiMsg
+mapi_set_binary(Mapi mid, int value)
+{
+	/* negotiated when (re)connecting */
+	mid->wantbinary = value != 0;
+	return MOK;
+}
+
+MapiMsg
+mapi_set_compression(Mapi mid, int value)
+{
+	/* negotiated when (re)connecting */
+	mid->wantcompress = value != 0;
+	return MOK;
+}
+
 MapiMsg
 mapi_release_id(Mapi mid, int id)
 {
@@ -3609,6 +3745,7 @@ mapi_cache_freeup_internal(struct MapiResultSet *result, int k)
 		result->cache.line[i].lens = result->cache.line[i + k].lens;
 		result->cache.line[i + k].lens = 0;
 		result->cache.line[i].fldcnt = result->cache.line[i + k].fldcnt;
+		result->cache.line[i].binrow = result->cache.line[i + k].binrow;
 		if (result->cache.line[i].rows &&
 		    (result->cache.line[i].rows[0] == '[' ||
 		     result->cache.line[i].rows[0] == '=')) {
@@ -3640,6 +3777,7 @@ mapi_cache_freeup_internal(struct MapiResultSet *result, int k)
 		result->cache.line[i].anchors = 0;
 		result->cache.line[i].lens = 0;
 		result->cache.line[i].fldcnt = 0;
+		result->cache.line[i].binrow = -1;
 	}
 	result->cache.reader -= k;
 	if (result->cache.reader < 0)
@@ -3694,6 +3832,7 @@ mapi_extend_cache(struct MapiResultSet *result, int cacheall)
 		result->cache.line[i].tuplerev = -1;
 		result->cache.line[i].anchors = NULL;
 		result->cache.line[i].lens = NULL;
+		result->cache.line[i].binrow = -1;
 	}
 	result->cache.limit = newsize;
 }
@@ -3707,6 +3846,7 @@ add_cache(struct MapiResultSet *result, char *line, int cacheall)
 		mapi_extend_cache(result, cacheall);
 
 	result->cache.line[result->cache.writer].rows = line;
+	result->cache.line[result->cache.writer].binrow = -1;
 	result->cache.line[result->cache.writer].tuplerev = result->cache.tuplecount;
 	result->cache.line[result->cache.writer + 1].tuplerev = result->cache.tuplecount + 1;
 	if (*line == '[' || *line == '=') {
@@ -3861,6 +4001,346 @@ parse_header_line(MapiHdl hdl, char *line, struct MapiResultSet *result)
 	return result;
 }
 
+/* Read exactly n bytes of binary data, first taking whatever
+   read_line already buffered. */
+static MapiMsg
+read_bytes(Mapi mid, void *buf, size_t n)
+{
+	char *p = buf;
+	size_t avail = (size_t) (mid->blk.end - mid->blk.nxt);
+
+	if (avail > n)
+		avail = n;
+	memcpy(p, mid->blk.buf + mid->blk.nxt, avail);
+	mid->blk.nxt += (int) avail;
+	p += avail;
+	n -= avail;
+	while (n > 0) {
+		ssize_t len = mnstr_read(mid->from, p, 1, n);
+
+		if (len <= 0) {
+			close_connection(mid);
+			return mapi_setError(mid, "Connection terminated", "read_bytes", MTIMEOUT);
+		}
+		if (mid->tracelog) {
+			mapi_log_header(mid, "R");
+			mnstr_write(mid->tracelog, p, 1, len);
+			mnstr_flush(mid->tracelog);
+		}
+		p += len;
+		n -= (size_t) len;
+	}
+	return MOK;
+}
+
+static void
+swap_bytes(void *data, int width, mapi_int64 n)
+{
+	char *p = data, c;
+	int i;
+
+	if (width <= 1)
+		return;
+	for (; n > 0; n--, p += width) {
+		for (i = 0; i < width / 2; i++) {
+			c = p[i];
+			p[i] = p[width - 1 - i];
+			p[width - 1 - i] = c;
+		}
+	}
+}
+
+/* Drop the binary values of the rows that are no longer in the row
+   cache, so that, as for rows received as text, only the cached rows
+   are kept in memory and the rows of a large result set that was
+   fetched block by block don't pile up.  The rows from binkeep on are
+   kept as well, see mapi_keep_column_rows.  Rows keep their number,
+   only binfirst moves up. */
+static void
+mapi_binary_freeup(struct MapiResultSet *result)
+{
+	mapi_int64 minrow = result->binfirst + result->binrows, k, n, r, start;
+	int i;
+
+	if (result->bincols == NULL || result->binrows == 0)
+		return;
+	for (i = 0; i < result->cache.writer; i++)
+		if (result->cache.line[i].binrow >= 0 &&
+		    result->cache.line[i].binrow < minrow)
+			minrow = result->cache.line[i].binrow;
+	if (result->binkeep >= 0 && result->binkeep < minrow)
+		minrow = result->binkeep;
+	if (minrow <= result->binfirst)
+		return;
+	k = minrow - result->binfirst;
+	n = result->binrows - k;
+	for (i = 0; i < result->bincnt; i++) {
+		struct MapiBinColumn *col = result->bincols + i;
+
+		memmove(col->nulls, col->nulls + k, (size_t) n);
+		if (col->width > 0) {
+			memmove(col->data, col->data + k * col->width,
+				(size_t) (n * col->width));
+			continue;
+		}
+		/* keep the heap from the first string still referred to
+		   (including the terminating zero at the end) */
+		start = col->heapsize;
+		for (r = k; r < result->binrows; r++)
+			if (col->offsets[r] < start)
+				start = col->offsets[r];
+		memmove(col->data, col->data + start,
+			(size_t) (col->heapsize - start + 1));
+		col->heapsize -= start;
+		for (r = 0; r < n; r++)
+			col->offsets[r] = col->offsets[k + r] - start;
+	}
+	result->binfirst = minrow;
+	result->binrows = n;
+}
+
+/* Read a block of binary columns announced by a "^ rows" line (see
+   sql_result.c for the layout) and add a cache line for each row.
+   The rows are only turned into strings when they are sliced. */
+static MapiMsg
+read_binary_block(Mapi mid, struct MapiResultSet *result, mapi_int64 nrows, int cacheall)
+{
+	int swap = mnstr_byteorder(mid->from) != 1234;
+	mapi_int64 first, r;
+	size_t nbytes = (size_t) ((nrows + 7) / 8);
+	unsigned char *bitmap = NULL;
+	mapi_int64 *offsets = NULL;
+	int i, hdr[3];
+
+	if (nrows < 0 || result->fieldcnt <= 0)
+		return mapi_setError(mid, "Invalid binary result block", "read_binary_block", MERROR);
+	if (result->bincols == NULL) {
+		result->bincols = calloc(result->fieldcnt, sizeof(*result->bincols));
+		if (result->bincols == NULL)
+			return mapi_setError(mid, "Memory allocation failure", "read_binary_block", MERROR);
+		result->bincnt = result->fieldcnt;
+	} else if (result->bincnt != result->fieldcnt) {
+		return mapi_setError(mid, "Invalid binary result block", "read_binary_block", MERROR);
+	}
+	mapi_binary_freeup(result);
+	first = result->binrows;
+	bitmap = malloc(nbytes + 1);
+	offsets = malloc((size_t) (nrows + 1) * sizeof(*offsets));
+	if (bitmap == NULL || offsets == NULL)
+		goto nomem;
+
+	for (i = 0; i < result->bincnt; i++) {
+		struct MapiBinColumn *col = result->bincols + i;
+
+		if (read_bytes(mid, hdr, sizeof(hdr)) != MOK)
+			goto bailout;
+		if (swap)
+			swap_bytes(hdr, (int) sizeof(int), 3);
+		if ((col->kind != 0 && (col->kind != hdr[0] || col->width != hdr[1])) ||
+		    (hdr[0] == 's') != (hdr[1] == 0) ||
+		    (hdr[1] != 0 && hdr[1] != 1 && hdr[1] != 2 && hdr[1] != 4 && hdr[1] != 8)) {
+			mapi_setError(mid, "Invalid binary result block", "read_binary_block", MERROR);
+			goto bailout;
+		}
+		col->kind = hdr[0];
+		col->width = hdr[1];
+		col->scale = hdr[2];
+		if (col->kind == 'd' && i < result->maxfields)
+			result->fields[i].scale = col->scale;
+
+		/* the NULL bitmap becomes one byte per row */
+		if (read_bytes(mid, bitmap, nbytes) != MOK)
+			goto bailout;
+		REALLOC(col->nulls, first + nrows + 1);
+		if (col->nulls == NULL)
+			goto nomem;
+		for (r = 0; r < nrows; r++)
+			col->nulls[first + r] = (bitmap[r >> 3] & (1 << (r & 7))) != 0;
+
+		if (col->width > 0) {
+			REALLOC(col->data, (size_t) (first + nrows + 1) * col->width);
+			if (col->data == NULL)
+				goto nomem;
+			if (read_bytes(mid, col->data + first * col->width, (size_t) nrows * col->width) != MOK)
+				goto bailout;
+			if (swap)
+				swap_bytes(col->data + first * col->width, col->width, nrows);
+		} else {
+			mapi_int64 heaplen;
+
+			if (read_bytes(mid, offsets, (size_t) (nrows + 1) * sizeof(*offsets)) != MOK)
+				goto bailout;
+			if (swap)
+				swap_bytes(offsets, (int) sizeof(*offsets), nrows + 1);
+			heaplen = offsets[nrows];
+			REALLOC(col->data, (size_t) (col->heapsize + heaplen + 1));
+			REALLOC(col->offsets, first + nrows + 1);
+			if (col->data == NULL || col->offsets == NULL)
+				goto nomem;
+			if (read_bytes(mid, col->data + col->heapsize, (size_t) heaplen) != MOK)
+				goto bailout;
+			for (r = 0; r < nrows; r++) {
+				if (offsets[r] < 0 || offsets[r] >= heaplen) {
+					mapi_setError(mid, "Invalid binary result block", "read_binary_block", MERROR);
+					goto bailout;
+				}
+				col->offsets[first + r] = col->heapsize + offsets[r];
+			}
+			/* the server zero-terminates each string, make
+			 * sure we don't run off the end of the heap */
+			col->data[col->heapsize + heaplen] = 0;
+			col->heapsize += heaplen;
+		}
+	}
+	free(bitmap);
+	free(offsets);
+
+	for (r = 0; r < nrows; r++) {
+		add_cache(result, strdup("[ ]"), cacheall);
+		result->cache.line[result->cache.writer - 1].binrow = result->binfirst + first + r;
+	}
+	result->binrows = first + nrows;
+	return MOK;
+
+  nomem:
+	mapi_setError(mid, "Memory allocation failure", "read_binary_block", MERROR);
+  bailout:
+	/* we lost track of the stream, so give up on it */
+	if (bitmap)
+		free(bitmap);
+	if (offsets)
+		free(offsets);
+	if (mid->connected)
+		close_connection(mid);
+	return mid->error;
+}
+
+/* Turn a row received in binary into the strings the text protocol
+   would have produced. */
+static MapiMsg
+mapi_slice_binrow(struct MapiResultSet *result, int cr)
+{
+	mapi_int64 row = result->cache.line[cr].binrow - result->binfirst;
+	char **anchors;
+	size_t *lens;
+	char buf[64];
+	int i;
+
+	anchors = calloc(result->bincnt, sizeof(*anchors));
+	lens = calloc(result->bincnt, sizeof(*lens));
+	if (anchors == NULL || lens == NULL)
+		goto nomem;
+	for (i = 0; i < result->bincnt; i++) {
+		struct MapiBinColumn *col = result->bincols + i;
+		const char *p = col->data + row * col->width;
+		mapi_int64 v = 0;
+
+		if (col->nulls[row]) {
+			anchors[i] = NULL;
+			lens[i] = 0;
+			continue;
+		}
+		switch (col->kind) {
+		case 's':
+			if ((anchors[i] = strdup(col->data + col->offsets[row])) == NULL)
+				goto nomem;
+			lens[i] = strlen(anchors[i]);
+			continue;
+		case 'f':
+			if (col->width == 4) {
+				float f;
+				int d;
+
+				memcpy(&f, p, sizeof(f));
+				for (d = 4; d < 10; d++) {
+					snprintf(buf, sizeof(buf), "%.*g", d, f);
+					if ((float) strtod(buf, NULL) == f)
+						break;
+				}
+			} else {
+				double f;
+				int d;
+
+				memcpy(&f, p, sizeof(f));
+				for (d = 4; d < 18; d++) {
+					snprintf(buf, sizeof(buf), "%.*g", d, f);
+					if (strtod(buf, NULL) == f)
+						break;
+				}
+			}
+			if ((anchors[i] = strdup(buf)) == NULL)
+				goto nomem;
+			lens[i] = strlen(buf);
+			continue;
+		}
+		switch (col->width) {
+		case 1: {
+			signed char x;
+			memcpy(&x, p, sizeof(x));
+			v = x;
+			break;
+		}
+		case 2: {
+			short x;
+			memcpy(&x, p, sizeof(x));
+			v = x;
+			break;
+		}
+		case 4: {
+			int x;
+			memcpy(&x, p, sizeof(x));
+			v = x;
+			break;
+		}
+		case 8:
+			memcpy(&v, p, sizeof(v));
+			break;
+		}
+		if (col->kind == 'b') {
+			snprintf(buf, sizeof(buf), "%s", v ? "true" : "false");
+		} else if (col->kind == 'd' && col->scale > 0) {
+			/* scaled integer, as the server's dec_tostr */
+			mapi_uint64 u = v < 0 ? (mapi_uint64) -(v + 1) + 1 : (mapi_uint64) v;
+			char tmp[64], *t = tmp + sizeof(tmp) - 1;
+			int s;
+
+			*t = 0;
+			for (s = 0; s < col->scale; s++) {
+				*--t = (char) ('0' + u % 10);
+				u /= 10;
+			}
+			*--t = '.';
+			do {
+				*--t = (char) ('0' + u % 10);
+				u /= 10;
+			} while (u);
+			if (v < 0)
+				*--t = '-';
+			snprintf(buf, sizeof(buf), "%s", t);
+		} else {
+			snprintf(buf, sizeof(buf), LLFMT, v);
+		}
+		if ((anchors[i] = strdup(buf)) == NULL)
+			goto nomem;
+		lens[i] = strlen(buf);
+	}
+	result->cache.line[cr].anchors = anchors;
+	result->cache.line[cr].lens = lens;
+	result->cache.line[cr].fldcnt = result->bincnt;
+	return MOK;
+
+  nomem:
+	if (anchors) {
+		for (i = 0; i < result->bincnt; i++)
+			if (anchors[i])
+				free(anchors[i]);
+		free(anchors);
+	}
+	if (lens)
+		free(lens);
+	return mapi_setError(result->hdl->mid, "Memory allocation failure", "mapi_slice_binrow", MERROR);
+}
+
 /* Read ahead and cache data read.  Depending on the second argument,
    reading may stop at the first non-header and non-error line, or at
    a prompt.
@@ -3941,6 +4421,17 @@ read_into_cache(MapiHdl hdl, int lookahead)
 			if (result && *line != '&')
 				add_cache(result, strdup(line), !lookahead);
 			break;
+		case '^':
+			/* binary columns, only if we asked for them */
+			if (mid->binary && result != NULL &&
+			    result->querytype == Q_TABLE) {
+				if (read_binary_block(mid, result, strtoll(line + 1, NULL, 10), !lookahead) != MOK)
+					return mid->error;
+				if (lookahead > 0)
+					return mid->error;
+				break;
+			}
+			/* fall through */
 		default:
 			if (result == NULL) {
 				result = new_result(hdl);
@@ -5003,6 +5494,10 @@ mapi_store_field(MapiHdl hdl, int fnr, int outtype, void *dst)
 		return mapi_setError(hdl->mid, "Illegal field number", "mapi_store_field", MERROR);
 	}
 
+	if (result->cache.reader >= 0 &&
+	    result->cache.line[result->cache.reader].fldcnt == 0)
+		mapi_slice_row(result, result->cache.reader);
+
 	return store_field(result, result->cache.reader, fnr, outtype, dst);
 }
 
@@ -5036,6 +5531,11 @@ mapi_slice_row(struct MapiResultSet *result, int cr)
 		return mapi_setError(result->hdl->mid, "Current row missing", "mapi_slice_row", MERROR);
 	if (result->cache.line[cr].fldcnt)
 		return result->cache.line[cr].fldcnt;	/* already sliced */
+	if (result->cache.line[cr].binrow >= 0) {
+		if (mapi_slice_binrow(result, cr) != MOK)
+			return result->hdl->mid->error;
+		return result->cache.line[cr].fldcnt;
+	}
 
 	if (*p != '[') {
 		/* nothing to slice */
@@ -5106,6 +5606,10 @@ mapi_fetch_row(MapiHdl hdl)
 	result = hdl->result;
 	assert(result != NULL);
 	if ((n = result->cache.line[result->cache.reader].fldcnt) == 0) {
+		/* rows received in binary are only turned into
+		   strings when a field is asked for */
+		if (result->cache.line[result->cache.reader].binrow >= 0)
+			return result->bincnt;
 		n = mapi_slice_row(result, result->cache.reader);
 		/* no need to call mapi_store_bind since
 		   mapi_fetch_line would have done that if needed */
@@ -5179,6 +5683,74 @@ mapi_fetch_field(MapiHdl hdl, int fnr)
 	return 0;
 }
 
+/*
+ * Direct access to the columns of a result set received in binary.
+ * Returns the fixed width values, or the string heap if *width is 0,
+ * for the rows received so far that are still in the row cache: the
+ * arrays hold the rows numbered *first up to *first + *nrows.
+ */
+const void *
+mapi_fetch_column(MapiHdl hdl, int fnr, mapi_int64 *first, mapi_int64 *nrows, int *width, const char **nulls, const mapi_int64 **offsets)
+{
+	struct MapiResultSet *result;
+	struct MapiBinColumn *col;
+
+	mapi_hdl_check0(hdl, "mapi_fetch_column");
+
+	if ((result = hdl->result) == NULL || result->bincols == NULL) {
+		mapi_setError(hdl->mid, "No binary result available", "mapi_fetch_column", MERROR);
+		return 0;
+	}
+	if (fnr < 0 || fnr >= result->bincnt) {
+		mapi_setError(hdl->mid, "Illegal field number", "mapi_fetch_column", MERROR);
+		return 0;
+	}
+	col = result->bincols + fnr;
+	if (first)
+		*first = result->binfirst;
+	if (nrows)
+		*nrows = result->binrows;
+	if (width)
+		*width = col->width;
+	if (nulls)
+		*nulls = col->nulls;
+	if (offsets)
+		*offsets = col->offsets;
+	return col->data;
+}
+
+/*
+ * The number of the row last fetched in the binary columns, or -1 if
+ * that row was not received in binary.
+ */
+mapi_int64
+mapi_fetch_column_row(MapiHdl hdl)
+{
+	struct MapiResultSet *result;
+	int cr;
+
+	assert(hdl);
+	if ((result = hdl->result) == NULL ||
+	    (cr = result->cache.reader) < 0)
+		return -1;
+	return result->cache.line[cr].binrow;
+}
+
+/*
+ * Keep the binary values of the rows from row on, also when they are
+ * no longer in the row cache, so that the rows of a rowset that spans
+ * more than one block can be accessed through mapi_fetch_column after
+ * the last one was fetched.  A row of -1 stops keeping them.
+ */
+MapiMsg
+mapi_keep_column_rows(MapiHdl hdl, mapi_int64 row)
+{
+	mapi_hdl_check(hdl, "mapi_keep_column_rows");
+	if (hdl->result)
+		hdl->result->binkeep = row;
+	return MOK;
+}
+
 size_t
 mapi_fetch_field_len(MapiHdl hdl, int fnr)
 {
@@ -156,6 +156,8 @@ mapi_export int mapi_get_autocommit(Mapi mid);
 mapi_export MapiMsg mapi_log(Mapi mid, const char *nme);
 mapi_export MapiMsg mapi_setAutocommit(Mapi mid, int autocommit);
 mapi_export MapiMsg mapi_set_size_header(Mapi mid, int value);
+mapi_export MapiMsg mapi_set_binary(Mapi mid, int value);
+mapi_export MapiMsg mapi_set_compression(Mapi mid, int value);
 mapi_export MapiMsg mapi_release_id(Mapi mid, int id);
 mapi_export char *mapi_result_error(MapiHdl hdl);
 mapi_export MapiMsg mapi_next_result(MapiHdl hdl);
@@ -206,6 +208,9 @@ mapi_export mapi_int64 mapi_get_last_id(MapiHdl hdl);
 mapi_export mapi_int64 mapi_rows_affected(MapiHdl hdl);
 
 mapi_export char *mapi_fetch_field(MapiHdl hdl, int fnr);
+mapi_export const void *mapi_fetch_column(MapiHdl hdl, int fnr, mapi_int64 *first, mapi_int64 *nrows, int *width, const char **nulls, const mapi_int64 **offsets);
+mapi_export mapi_int64 mapi_fetch_column_row(MapiHdl hdl);
+mapi_export MapiMsg mapi_keep_column_rows(MapiHdl hdl, mapi_int64 row);
 mapi_export size_t mapi_fetch_field_len(MapiHdl hdl, int fnr);
 mapi_export MapiMsg mapi_store_field(MapiHdl hdl, int fnr, int outtype, void *outparam);
 mapi_export char **mapi_fetch_field_array(MapiHdl hdl);
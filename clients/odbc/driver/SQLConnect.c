@@ -224,7 +224,14 @@ MNDBConnect(ODBCDbc *dbc,
 
 	/* connect to a server on host via port */
 	/* FIXME: use dbname/catalog from ODBC connect string/options here */
-	mid = mapi_connect(host, port, uid, pwd, "sql", catalog);
+	mid = mapi_mapi(host, port, uid, pwd, "sql", catalog);
+	if (mid && mapi_error(mid) == MOK) {
+		/* numeric columns bound column-wise are then
+		 * converted straight from the binary columns, see
+		 * MNDBFetch */
+		mapi_set_binary(mid, 1);
+		mapi_reconnect(mid);
+	}
 	if (mid == NULL || mapi_error(mid)) {
 		/* Client unable to establish connection */
 		addDbcError(dbc, "08001", NULL, 0);
@@ -32,6 +32,206 @@
 #ifdef HAVE_STRINGS_H
 #include <strings.h>		/* for strncasecmp */
 #endif
+#include <float.h>		/* for FLT_MAX */
+#include <limits.h>
+
+/* Column-wise bound numeric columns of a result set that was
+ * received in binary (see mapi_set_binary) are not converted row by
+ * row through ODBCFetch, but a whole column slice at a time straight
+ * from the binary column once all rows of the rowset have been
+ * fetched.  Only conversions that cannot lose information other than
+ * by overflowing the target take this route. */
+#define COLWISE_NO	0	/* convert row by row */
+#define COLWISE_MAYBE	1	/* types fit, binary column not seen yet */
+#define COLWISE_YES	2	/* convert from the binary column */
+
+static int
+ODBCColumnwise(ODBCDescRec *irdrec, ODBCDescRec *ardrec)
+{
+	switch (irdrec->sql_desc_concise_type) {
+	case SQL_TINYINT:
+	case SQL_SMALLINT:
+	case SQL_INTEGER:
+	case SQL_BIGINT:
+	case SQL_BIT:
+		switch (ardrec->sql_desc_concise_type) {
+		case SQL_C_BIT:
+		case SQL_C_STINYINT:
+		case SQL_C_TINYINT:
+		case SQL_C_SSHORT:
+		case SQL_C_SHORT:
+		case SQL_C_SLONG:
+		case SQL_C_LONG:
+		case SQL_C_SBIGINT:
+		case SQL_C_FLOAT:
+		case SQL_C_DOUBLE:
+			return COLWISE_MAYBE;
+		}
+		break;
+	case SQL_REAL:
+	case SQL_DOUBLE:
+		/* conversions of floating point values to integers
+		 * may involve fractional truncation */
+		switch (ardrec->sql_desc_concise_type) {
+		case SQL_C_FLOAT:
+		case SQL_C_DOUBLE:
+			return COLWISE_MAYBE;
+		}
+		break;
+	}
+	return COLWISE_NO;
+}
+
+/* check that column col was received in binary in a width we can
+ * deal with */
+static int
+ODBCColumnwiseWidth(ODBCStmt *stmt, ODBCDescRec *irdrec, int col)
+{
+	int width;
+
+	if (mapi_fetch_column(stmt->hdl, col - 1, NULL, NULL, &width, NULL, NULL) == NULL)
+		return COLWISE_NO;
+	switch (irdrec->sql_desc_concise_type) {
+	case SQL_BIT:
+		return width == 1 ? COLWISE_YES : COLWISE_NO;
+	case SQL_REAL:
+	case SQL_DOUBLE:
+		return width == 4 || width == 8 ? COLWISE_YES : COLWISE_NO;
+	default:
+		return width == 1 || width == 2 || width == 4 || width == 8 ? COLWISE_YES : COLWISE_NO;
+	}
+}
+
+#define FETCHCOLUMN(STYPE, VTYPE, DTYPE, INRANGE)			\
+	do {								\
+		const STYPE *src = (const STYPE *) data;		\
+		DTYPE *dst = (DTYPE *) ptr;				\
+									\
+		for (row = 0; row < nrows; row++) {			\
+			mapi_int64 r = binrows[row];			\
+			VTYPE v;					\
+									\
+			if (r < 0)					\
+				continue;				\
+			r -= first;					\
+			if (nulls[r]) {					\
+				if (nullp == NULL) {			\
+					/* Indicator variable required	\
+					 * but not supplied */		\
+					addStmtError(stmt, "22002", NULL, 0); \
+					if (RowStatusArray)		\
+						WriteValue(&RowStatusArray[row], SQL_ROW_SUCCESS_WITH_INFO); \
+					continue;			\
+				}					\
+				nullp[row] = SQL_NULL_DATA;		\
+				if (lenp)				\
+					lenp[row] = SQL_NULL_DATA;	\
+				continue;				\
+			}						\
+			if (nullp)					\
+				nullp[row] = 0;				\
+			if (lenp)					\
+				lenp[row] = (SQLLEN) sizeof(DTYPE);	\
+			v = (VTYPE) src[r];				\
+			if (!(INRANGE)) {				\
+				/* Numeric value out of range */	\
+				addStmtError(stmt, "22003", NULL, 0);	\
+				if (RowStatusArray)			\
+					WriteValue(&RowStatusArray[row], SQL_ROW_SUCCESS_WITH_INFO); \
+				continue;				\
+			}						\
+			dst[row] = (DTYPE) v;				\
+		}							\
+	} while (0)
+
+#define FETCHCOLUMNINT(DTYPE, INRANGE)					\
+	do {								\
+		switch (width) {					\
+		case 1:							\
+			FETCHCOLUMN(signed char, SQLBIGINT, DTYPE, INRANGE); \
+			break;						\
+		case 2:							\
+			FETCHCOLUMN(short, SQLBIGINT, DTYPE, INRANGE);	\
+			break;						\
+		case 4:							\
+			FETCHCOLUMN(int, SQLBIGINT, DTYPE, INRANGE);	\
+			break;						\
+		case 8:							\
+			FETCHCOLUMN(SQLBIGINT, SQLBIGINT, DTYPE, INRANGE); \
+			break;						\
+		}							\
+	} while (0)
+
+static void
+ODBCFetchColumn(ODBCStmt *stmt,
+		int col,
+		const mapi_int64 *binrows,
+		SQLULEN nrows,
+		SQLLEN offset,
+		SQLUSMALLINT *RowStatusArray)
+{
+	ODBCDescRec *ardrec = &stmt->ApplRowDescr->descRec[col];
+	SQLSMALLINT sql_type = stmt->ImplRowDescr->descRec[col].sql_desc_concise_type;
+	SQLLEN *lenp = ardrec->sql_desc_octet_length_ptr;
+	SQLLEN *nullp = ardrec->sql_desc_indicator_ptr;
+	char *ptr = (char *) ardrec->sql_desc_data_ptr + offset;
+	const char *data;
+	const char *nulls;
+	mapi_int64 first;
+	int width;
+	SQLULEN row;
+
+	/* fetch the column only now, it may have grown (and moved)
+	 * while the rows of the rowset were being fetched */
+	data = mapi_fetch_column(stmt->hdl, col - 1, &first, NULL, &width, &nulls, NULL);
+	assert(data != NULL);
+	if (lenp)
+		lenp = (SQLLEN *) ((char *) lenp + offset);
+	if (nullp)
+		nullp = (SQLLEN *) ((char *) nullp + offset);
+
+	if (sql_type == SQL_REAL || sql_type == SQL_DOUBLE) {
+		if (ardrec->sql_desc_concise_type == SQL_C_FLOAT) {
+			if (width == 4)
+				FETCHCOLUMN(float, double, float, 1);
+			else
+				FETCHCOLUMN(double, double, float, v >= -FLT_MAX && v <= FLT_MAX);
+		} else {
+			if (width == 4)
+				FETCHCOLUMN(float, double, double, 1);
+			else
+				FETCHCOLUMN(double, double, double, 1);
+		}
+		return;
+	}
+
+	switch (ardrec->sql_desc_concise_type) {
+	case SQL_C_BIT:
+		FETCHCOLUMNINT(unsigned char, v == 0 || v == 1);
+		break;
+	case SQL_C_STINYINT:
+	case SQL_C_TINYINT:
+		FETCHCOLUMNINT(signed char, v >= SCHAR_MIN && v <= SCHAR_MAX);
+		break;
+	case SQL_C_SSHORT:
+	case SQL_C_SHORT:
+		FETCHCOLUMNINT(short, v >= SHRT_MIN && v <= SHRT_MAX);
+		break;
+	case SQL_C_SLONG:
+	case SQL_C_LONG:
+		FETCHCOLUMNINT(int, v >= INT_MIN && v <= INT_MAX);
+		break;
+	case SQL_C_SBIGINT:
+		FETCHCOLUMNINT(SQLBIGINT, 1);
+		break;
+	case SQL_C_FLOAT:
+		FETCHCOLUMNINT(float, 1);
+		break;
+	case SQL_C_DOUBLE:
+		FETCHCOLUMNINT(double, 1);
+		break;
+	}
+}
 
 SQLRETURN
 MNDBFetch(ODBCStmt *stmt, SQLUSMALLINT *RowStatusArray)
@@ -41,6 +241,11 @@ MNDBFetch(ODBCStmt *stmt, SQLUSMALLINT *RowStatusArray)
 	int i;
 	SQLULEN row;
 	SQLLEN offset;
+	SQLUSMALLINT *statusArray = RowStatusArray;
+	char *colwise = NULL;
+	mapi_int64 *binrows = NULL;
+	mapi_int64 binrow = -1;
+	int kept = 0;
 
 	/* stmt->startRow is the (0 based) index of the first row we
 	 * stmt->need to fetch */
@@ -90,12 +295,42 @@ MNDBFetch(ODBCStmt *stmt, SQLUSMALLINT *RowStatusArray)
 		offset = *ard->sql_desc_bind_offset_ptr;
 	else
 		offset = 0;
+
+	if (ard->sql_desc_bind_type == SQL_BIND_BY_COLUMN &&
+	    ard->sql_desc_array_size > 1) {
+		int n = 0;
+
+		colwise = malloc(ard->sql_desc_count + 1);
+		if (colwise) {
+			for (i = 1; i <= ard->sql_desc_count; i++) {
+				rec = &ard->descRec[i];
+				if (rec->sql_desc_data_ptr == NULL ||
+				    i > ird->sql_desc_count)
+					colwise[i] = COLWISE_NO;
+				else
+					colwise[i] = ODBCColumnwise(&ird->descRec[i], rec);
+				n += colwise[i] != COLWISE_NO;
+			}
+			if (n > 0)
+				binrows = malloc(ard->sql_desc_array_size * sizeof(*binrows));
+			if (binrows == NULL) {
+				free(colwise);
+				colwise = NULL;
+			}
+		}
+	}
+
 	for (row = 0; row < ard->sql_desc_array_size; row++) {
 		if (mapi_fetch_row(stmt->hdl) == 0) {
 			switch (mapi_error(stmt->Dbc->mid)) {
 			case MOK:
-				if (row == 0)
+				if (row == 0) {
+					if (colwise) {
+						free(colwise);
+						free(binrows);
+					}
 					return SQL_NO_DATA;
+				}
 				break;
 			case MTIMEOUT:
 				if (RowStatusArray)
@@ -103,12 +338,22 @@ MNDBFetch(ODBCStmt *stmt, SQLUSMALLINT *RowStatusArray)
 				/* Timeout expired / Communication
 				 * link failure */
 				addStmtError(stmt, stmt->Dbc->sql_attr_connection_timeout ? "HYT00" : "08S01", mapi_error_str(stmt->Dbc->mid), 0);
+				if (colwise) {
+					mapi_keep_column_rows(stmt->hdl, -1);
+					free(colwise);
+					free(binrows);
+				}
 				return SQL_ERROR;
 			default:
 				if (RowStatusArray)
 					WriteValue(RowStatusArray, SQL_ROW_ERROR);
 				/* General error */
 				addStmtError(stmt, "HY000", mapi_error_str(stmt->Dbc->mid), 0);
+				if (colwise) {
+					mapi_keep_column_rows(stmt->hdl, -1);
+					free(colwise);
+					free(binrows);
+				}
 				return SQL_ERROR;
 			}
 			break;
@@ -121,10 +366,27 @@ MNDBFetch(ODBCStmt *stmt, SQLUSMALLINT *RowStatusArray)
 		for (i = 1; i <= ird->sql_desc_count; i++)
 			ird->descRec[i].already_returned = 0;
 
+		if (colwise) {
+			binrow = mapi_fetch_column_row(stmt->hdl);
+			binrows[row] = binrow;
+			/* the next row may be in a new block, keep the
+			 * rows of the rowset until they are converted */
+			if (binrow >= 0 && !kept)
+				kept = mapi_keep_column_rows(stmt->hdl, binrow) == MOK;
+		}
+
 		for (i = 1; i <= ard->sql_desc_count; i++) {
 			rec = &ard->descRec[i];
 			if (rec->sql_desc_data_ptr == NULL)
 				continue;
+			if (binrow >= 0 && colwise[i] != COLWISE_NO) {
+				/* the first row received in binary
+				 * decides for the whole column */
+				if (colwise[i] == COLWISE_MAYBE)
+					colwise[i] = ODBCColumnwiseWidth(stmt, &ird->descRec[i], i);
+				if (colwise[i] == COLWISE_YES)
+					continue;
+			}
 			stmt->retrieved = 0;
 			if (ODBCFetch(stmt, i,
 				      rec->sql_desc_concise_type,
@@ -143,6 +405,16 @@ MNDBFetch(ODBCStmt *stmt, SQLUSMALLINT *RowStatusArray)
 		if (RowStatusArray)
 			RowStatusArray++;
 	}
+
+	if (colwise) {
+		for (i = 1; i <= ard->sql_desc_count; i++)
+			if (colwise[i] == COLWISE_YES)
+				ODBCFetchColumn(stmt, i, binrows, (SQLULEN) stmt->rowSetSize, offset, statusArray);
+		mapi_keep_column_rows(stmt->hdl, -1);
+		free(colwise);
+		free(binrows);
+	}
+
 	if (ird->sql_desc_rows_processed_ptr)
 		*ird->sql_desc_rows_processed_ptr = (SQLULEN) stmt->rowSetSize;
 
@@ -88,6 +88,9 @@ check(SQLRETURN ret, SQLSMALLINT tpe, SQLHANDLE hnd, const char *func)
 #define NRECORD		2000
 #define NRECORD2	(NRECORD / 2)
 #define STRSIZE		200
+#define NROWSET		130	/* more than and not a multiple of the
+				 * 100 rows of a block of the row cache */
+#define NCROSS		12	/* rows of arraytest in the cross product */
 
 struct record {
 	short int i;
@@ -105,6 +108,7 @@ main(int argc, char **argv)
 	SQLHANDLE env;
 	SQLHANDLE dbc;
 	SQLHANDLE stmt;
+	SQLHANDLE stmt2;
 	char *dsn = "MonetDB";
 	char *user = "monetdb";
 	char *pass = "monetdb";
@@ -122,6 +126,11 @@ main(int argc, char **argv)
 	float *data_f;
 	SQL_DATE_STRUCT *data_d;
 	SQL_TIME_STRUCT *data_t;
+	SQLBIGINT *data_k;
+	SQLLEN *data_inull;
+	double *data_g;
+	SQLULEN fetched;
+	int n;
 
 	if (argc > 1)
 		dsn = argv[1];
@@ -369,6 +378,74 @@ main(int argc, char **argv)
 		}
 	}
 
+	/* fetch a result of many blocks of the row cache in rowsets
+	 * that are larger than a block and do not fit blocks exactly,
+	 * so that rowsets are split over two or three blocks; the
+	 * integer and floating point columns are converted a rowset at
+	 * a time; with a second statement handle the driver asks for
+	 * blocks of 100 rows */
+	ret = SQLAllocHandle(SQL_HANDLE_STMT, dbc, &stmt2);
+	check(ret, SQL_HANDLE_DBC, dbc, "SQLAllocHandle (STMT)");
+	ret = SQLFreeStmt(stmt, SQL_UNBIND);
+	check(ret, SQL_HANDLE_STMT, stmt, "SQLFreeStmt");
+	ret = SQLSetStmtAttr(stmt, SQL_ATTR_ROW_ARRAY_SIZE,
+			     (SQLPOINTER) (uintptr_t) NROWSET, 0);
+	check(ret, SQL_HANDLE_STMT, stmt, "SQLSetStmtAttr");
+	ret = SQLSetStmtAttr(stmt, SQL_ATTR_ROWS_FETCHED_PTR,
+			     (SQLPOINTER) &fetched, 0);
+	check(ret, SQL_HANDLE_STMT, stmt, "SQLSetStmtAttr");
+
+	data_k = malloc(NROWSET * sizeof(*data_k));
+	data_inull = malloc(NROWSET * sizeof(*data_inull));
+	data_g = malloc(NROWSET * sizeof(*data_g));
+
+	ret = SQLBindCol(stmt, 1, SQL_C_SBIGINT, data_k, sizeof(*data_k),
+			 NULL);
+	check(ret, SQL_HANDLE_STMT, stmt, "SQLBindCol");
+	ret = SQLBindCol(stmt, 2, SQL_C_LONG, data_i, sizeof(*data_i),
+			 data_inull);
+	check(ret, SQL_HANDLE_STMT, stmt, "SQLBindCol");
+	ret = SQLBindCol(stmt, 3, SQL_C_DOUBLE, data_g, sizeof(*data_g),
+			 NULL);
+	check(ret, SQL_HANDLE_STMT, stmt, "SQLBindCol");
+
+	ret = SQLExecDirect(stmt, (SQLCHAR *)
+			    "SELECT CAST(a.i AS BIGINT) * 2000 + b.i,"
+			    " CASE WHEN b.i % 3 = 0 THEN NULL ELSE b.i END,"
+			    " a.f"
+			    " FROM arraytest a, arraytest b"
+			    " WHERE a.i < 12"	/* NCROSS */
+			    " ORDER BY 1", SQL_NTS);
+	check(ret, SQL_HANDLE_STMT, stmt, "SQLExecDirect");
+
+	n = 0;
+	while ((ret = SQLFetch(stmt)) != SQL_NO_DATA) {
+		check(ret, SQL_HANDLE_STMT, stmt, "SQLFetch");
+		for (i = 0; i < (int) fetched; i++, n++) {
+			int b = n % NRECORD;
+
+			if (data_k[i] != n ||
+			    (b % 3 == 0 ?
+			     data_inull[i] != SQL_NULL_DATA :
+			     data_inull[i] == SQL_NULL_DATA ||
+			     data_i[i] != b) ||
+			    data_g[i] != data[n / NRECORD].f) {
+				fprintf(stderr,
+					"Received incorrect data on row %d\n",
+					n);
+				exit(1);
+			}
+		}
+	}
+	if (n != NCROSS * NRECORD) {
+		fprintf(stderr, "Received %d rows instead of %d\n",
+			n, NCROSS * NRECORD);
+		exit(1);
+	}
+
+	ret = SQLFreeHandle(SQL_HANDLE_STMT, stmt2);
+	check(ret, SQL_HANDLE_STMT, stmt2, "SQLFreeHandle 1");
+
 	ret = SQLFreeHandle(SQL_HANDLE_STMT, stmt);
 	check(ret, SQL_HANDLE_STMT, stmt, "SQLFreeHandle 2");
 
@@ -60,6 +60,9 @@
 #include <errno.h>
 #include <stdarg.h>		/* va_alist.. */
 #include <assert.h>
+#if defined(__SSE4_2__) && defined(__x86_64__)
+#include <nmmintrin.h>	/* _mm_crc32_u64 */
+#endif
 
 #ifdef HAVE_SYS_TYPES_H
 # include <sys/types.h>
@@ -2759,13 +2762,31 @@ buffer_wastream(buffer *b, const char *name)
 /* A buffered stream consists of a sequence of blocks.  Each block
  * consists of a count followed by the data in the block.  A flush is
  * indicated by an empty block (i.e. just a count of 0).
+ *
+ * When both ends agreed on it (see block_stream_compress), the writer
+ * collects up to BS_BATCH bytes and ships them as a single compressed
+ * frame: a count with the BS_COMPRESSED bit set, followed by the
+ * compressed and the uncompressed size as ints and the compressed
+ * data.  Batches smaller than BS_COMPRESS_MIN, typically interactive
+ * replies, and batches that don't shrink are sent as ordinary blocks.
+ * The reader accepts both kinds of blocks at any time.
  */
+#define BS_COMPRESSED	0x4000	/* count of a compressed frame */
+#define BS_BATCH	(16 * BLOCK)
+#define BS_COMPRESS_MIN	1024
+#define BS_ZBOUND(n)	((n) + (n) / 255 + 16)
+
 typedef struct bs {
 	stream *s;		/* underlying stream */
 	unsigned nr;		/* how far we got in buf */
 	unsigned itotal;	/* amount available in current read block */
 	size_t blks;		/* read/writen blocks (possibly partial) */
 	size_t bytes;		/* read/writen bytes */
+	int compress;		/* compress what we write */
+	char *zbuf;		/* batch to be written or uncompressed frame */
+	size_t znr;		/* amount collected in zbuf */
+	size_t zlen;		/* size of the frame in zbuf being read */
+	char *ztmp;		/* compressed frame */
 	char buf[BLOCK];	/* the buffered data (minus the size of
 				 * size-short */
 } bs;
@@ -2783,9 +2804,231 @@ bs_create(stream *s)
 	ns->itotal = 0;
 	ns->blks = 0;
 	ns->bytes = 0;
+	ns->compress = 0;
+	ns->zbuf = NULL;
+	ns->znr = 0;
+	ns->zlen = 0;
+	ns->ztmp = NULL;
 	return ns;
 }
 
+/* A fast LZ77 codec in the spirit of LZ4: a sequence of tokens, each
+ * holding a run of literals followed by a back reference of at least
+ * four bytes into the last 64KB.  The high nibble of the token is the
+ * literal length, the low nibble the match length minus four, with a
+ * value of 15 continued in bytes of 255 and a final smaller byte.  The
+ * match offset is stored as two bytes, low order first.  The last
+ * token only holds literals. */
+#define LZ_HASHLOG	12
+#define LZ_MINMATCH	4
+#define LZ_HASH(v)	(((v) * 2654435761U) >> (32 - LZ_HASHLOG))
+
+static unsigned char *
+lz_putlen(unsigned char *op, size_t len)
+{
+	while (len >= 255) {
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = (unsigned char) len;
+	return op;
+}
+
+/* return the compressed size, or 0 if it doesn't fit in cap bytes */
+static size_t
+lz_compress(const unsigned char *src, size_t n, unsigned char *dst, size_t cap)
+{
+	unsigned int table[1 << LZ_HASHLOG];
+	const unsigned char *ip = src, *anchor = src, *end = src + n;
+	const unsigned char *mflimit = n > 12 ? end - 12 : src;
+	unsigned char *op = dst, *oend = dst + cap, *token;
+	size_t litlen;
+
+	memset(table, 0, sizeof(table));
+	while (ip < mflimit) {
+		const unsigned char *ref, *mp, *rp;
+		unsigned int v, h;
+		size_t mlen, off;
+
+		memcpy(&v, ip, sizeof(v));
+		h = LZ_HASH(v);
+		ref = src + table[h];
+		table[h] = (unsigned int) (ip - src);
+		if (ref >= ip || ip - ref > 65535 ||
+		    memcmp(ref, ip, LZ_MINMATCH) != 0) {
+			ip++;
+			continue;
+		}
+		/* the last five bytes are always literals */
+		mp = ip + LZ_MINMATCH;
+		rp = ref + LZ_MINMATCH;
+		while (mp < end - 5 && *mp == *rp) {
+			mp++;
+			rp++;
+		}
+		litlen = (size_t) (ip - anchor);
+		mlen = (size_t) (mp - ip) - LZ_MINMATCH;
+		off = (size_t) (ip - ref);
+		if ((size_t) (oend - op) < 1 + litlen / 255 + 1 + litlen + 2 + mlen / 255 + 1)
+			return 0;
+		token = op++;
+		if (litlen >= 15) {
+			*token = 15 << 4;
+			op = lz_putlen(op, litlen - 15);
+		} else {
+			*token = (unsigned char) (litlen << 4);
+		}
+		memcpy(op, anchor, litlen);
+		op += litlen;
+		*op++ = (unsigned char) (off & 0xFF);
+		*op++ = (unsigned char) (off >> 8);
+		if (mlen >= 15) {
+			*token |= 15;
+			op = lz_putlen(op, mlen - 15);
+		} else {
+			*token |= (unsigned char) mlen;
+		}
+		ip = anchor = mp;
+	}
+	litlen = (size_t) (end - anchor);
+	if ((size_t) (oend - op) < 1 + litlen / 255 + 1 + litlen)
+		return 0;
+	token = op++;
+	if (litlen >= 15) {
+		*token = 15 << 4;
+		op = lz_putlen(op, litlen - 15);
+	} else {
+		*token = (unsigned char) (litlen << 4);
+	}
+	memcpy(op, anchor, litlen);
+	op += litlen;
+	return (size_t) (op - dst);
+}
+
+/* return the uncompressed size, or -1 if the input is corrupt */
+static ssize_t
+lz_decompress(const unsigned char *src, size_t n, unsigned char *dst, size_t cap)
+{
+	const unsigned char *ip = src, *iend = src + n;
+	unsigned char *op = dst, *oend = dst + cap;
+
+	while (ip < iend) {
+		unsigned int token = *ip++;
+		size_t len = token >> 4, off;
+		unsigned char c;
+		const unsigned char *ref;
+
+		if (len == 15) {
+			do {
+				if (ip >= iend)
+					return -1;
+				c = *ip++;
+				len += c;
+			} while (c == 255);
+		}
+		if (len > (size_t) (iend - ip) || len > (size_t) (oend - op))
+			return -1;
+		memcpy(op, ip, len);
+		op += len;
+		ip += len;
+		if (ip == iend)
+			break;	/* last literals */
+		if (iend - ip < 2)
+			return -1;
+		off = ip[0] | ((size_t) ip[1] << 8);
+		ip += 2;
+		if (off == 0 || off > (size_t) (op - dst))
+			return -1;
+		len = token & 15;
+		if (len == 15) {
+			do {
+				if (ip >= iend)
+					return -1;
+				c = *ip++;
+				len += c;
+			} while (c == 255);
+		}
+		len += LZ_MINMATCH;
+		if (len > (size_t) (oend - op))
+			return -1;
+		/* the match may overlap with what it produces */
+		for (ref = op - off; len > 0; len--)
+			*op++ = *ref++;
+	}
+	return (ssize_t) (op - dst);
+}
+
+/* Write a series of ordinary blocks, the last one marked final if
+ * requested. */
+static int
+bs_write_blocks(stream *ss, const char *buf, size_t len, int final)
+{
+	bs *s = (bs *) ss->stream_data.p;
+
+	do {
+		size_t n = len < sizeof(s->buf) ? len : sizeof(s->buf);
+		short blksize = (short) (n << 1);
+
+		if (final && n == len)
+			blksize |= (short) 1;
+#ifdef WORDS_BIGENDIAN
+		blksize = short_int_SWAP(blksize);
+#endif
+		if (!mnstr_writeSht(s->s, blksize) ||
+		    (n > 0 && s->s->write(s->s, buf, 1, n) != (ssize_t) n)) {
+			ss->errnr = MNSTR_WRITE_ERROR;
+			return -1;
+		}
+		s->bytes += n;
+		s->blks++;
+		buf += n;
+		len -= n;
+	} while (len > 0);
+	return 0;
+}
+
+/* Write the collected batch, compressed if that pays off. */
+static int
+bs_write_batch(stream *ss, int final)
+{
+	bs *s = (bs *) ss->stream_data.p;
+	size_t clen = 0;
+
+	if (s->znr >= BS_COMPRESS_MIN) {
+		if (s->ztmp == NULL &&
+		    (s->ztmp = malloc(BS_ZBOUND(BS_BATCH))) == NULL) {
+			ss->errnr = MNSTR_WRITE_ERROR;
+			return -1;
+		}
+		clen = lz_compress((unsigned char *) s->zbuf, s->znr,
+				   (unsigned char *) s->ztmp, s->znr - s->znr / 16);
+	}
+	if (clen > 0) {
+		short blksize = BS_COMPRESSED | (final ? 1 : 0);
+		int zlen = (int) clen, rlen = (int) s->znr;
+
+#ifdef WORDS_BIGENDIAN
+		blksize = short_int_SWAP(blksize);
+		zlen = normal_int_SWAP(zlen);
+		rlen = normal_int_SWAP(rlen);
+#endif
+		if (!mnstr_writeSht(s->s, blksize) ||
+		    !mnstr_writeInt(s->s, zlen) ||
+		    !mnstr_writeInt(s->s, rlen) ||
+		    s->s->write(s->s, s->ztmp, 1, clen) != (ssize_t) clen) {
+			ss->errnr = MNSTR_WRITE_ERROR;
+			return -1;
+		}
+		s->bytes += s->znr;
+		s->blks++;
+	} else if (s->znr > 0 || final) {
+		if (bs_write_blocks(ss, s->zbuf, s->znr, final) < 0)
+			return -1;
+	}
+	s->znr = 0;
+	return 0;
+}
+
 /* Collect data until the internal buffer is filled, then write the
  * filled buffer to the underlying stream.
  * Struct field usage:
@@ -2808,6 +3051,18 @@ bs_write(stream *ss, const void *buf, size_t elmsize, size_t cnt)
 		return -1;
 	assert(ss->access == ST_WRITE);
 	assert(s->nr < sizeof(s->buf));
+	while (s->compress && todo > 0) {
+		size_t n = BS_BATCH - s->znr;
+
+		if (todo < n)
+			n = todo;
+		memcpy(s->zbuf + s->znr, buf, n);
+		s->znr += n;
+		todo -= n;
+		buf = ((const char *) buf + n);
+		if (s->znr == BS_BATCH && bs_write_batch(ss, 0) < 0)
+			return -1;
+	}
 	while (todo > 0) {
 		size_t n = sizeof(s->buf) - s->nr;
 
@@ -2869,6 +3124,8 @@ bs_flush(stream *ss)
 		return -1;
 	assert(ss->access == ST_WRITE);
 	assert(s->nr < sizeof(s->buf));
+	if (s->compress)
+		return bs_write_batch(ss, 1);
 	if (ss->access == ST_WRITE) {
 		/* flush the rest of buffer (if s->nr > 0), then set the
 		 * last bit to 1 to to indicate user-instigated flush */
@@ -2907,6 +3164,75 @@ bs_flush(stream *ss)
 	return 0;
 }
 
+/* Read the count of the next block, and if it is a compressed frame,
+ * the frame itself, which is uncompressed into zbuf.  Returns -1 on
+ * error, 0 at end of file and 1 otherwise. */
+static int
+bs_readhdr(stream *ss)
+{
+	bs *s = (bs *) ss->stream_data.p;
+	short blksize = 0;
+
+	switch (mnstr_readSht(s->s, &blksize)) {
+	case -1:
+		ss->errnr = s->s->errnr;
+		return -1;
+	case 0:
+		return 0;
+	case 1:
+		break;
+	}
+	if (blksize < 0) {
+		ss->errnr = MNSTR_READ_ERROR;
+		return -1;
+	}
+#ifdef BSTREAM_DEBUG
+	fprintf(stderr, "RC size: %d, final: %s, compressed: %s\n", (blksize & ~BS_COMPRESSED) >> 1, blksize & 1 ? "true" : "false", blksize & BS_COMPRESSED ? "true" : "false");
+	fprintf(stderr, "RC %s %d\n", ss->name, blksize);
+#endif
+	s->zlen = 0;
+	if (blksize & BS_COMPRESSED) {
+		int zlen = 0, rlen = 0;
+		size_t got = 0;
+
+		if (mnstr_readInt(s->s, &zlen) != 1 ||
+		    mnstr_readInt(s->s, &rlen) != 1 ||
+		    zlen <= 0 || zlen > BS_ZBOUND(BS_BATCH) ||
+		    rlen <= 0 || rlen > BS_BATCH) {
+			ss->errnr = MNSTR_READ_ERROR;
+			return -1;
+		}
+		if ((s->zbuf == NULL && (s->zbuf = malloc(BS_BATCH)) == NULL) ||
+		    (s->ztmp == NULL && (s->ztmp = malloc(BS_ZBOUND(BS_BATCH))) == NULL)) {
+			ss->errnr = MNSTR_READ_ERROR;
+			return -1;
+		}
+		while (got < (size_t) zlen) {
+			ssize_t m = s->s->read(s->s, s->ztmp + got, 1, (size_t) zlen - got);
+
+			if (m <= 0) {
+				ss->errnr = s->s->errnr ? s->s->errnr : MNSTR_READ_ERROR;
+				return -1;
+			}
+			got += (size_t) m;
+		}
+		if (lz_decompress((unsigned char *) s->ztmp, (size_t) zlen,
+				  (unsigned char *) s->zbuf, (size_t) rlen) != rlen) {
+			ss->errnr = MNSTR_READ_ERROR;
+			return -1;
+		}
+		s->zlen = (size_t) rlen;
+		s->itotal = (unsigned) rlen;
+	} else {
+		s->itotal = (unsigned) (blksize >> 1);	/* amount readable */
+	}
+	/* store whether this was the last block or not */
+	s->nr = blksize & 1;
+	s->bytes += s->itotal;
+	s->blks++;
+	return 1;
+}
+
 /* Read buffered data and return the number of items read.  At the
  * flush boundary we will return 0 to indicate the end of a block.
  *
@@ -2931,8 +3257,6 @@ bs_read(stream *ss, void *buf, size_t elmsize, size_t cnt)
 	assert(s->nr <= 1);
 
 	if (s->itotal == 0) {
-		short blksize = 0;
-
 		if (s->nr) {
 			/* We read the closing block but hadn't
 			 * returned that yet. Return it now, and note
@@ -2946,28 +3270,14 @@ bs_read(stream *ss, void *buf, size_t elmsize, size_t cnt)
 
 		/* There is nothing more to read in the current block,
 		 * so read the count for the next block */
-		switch (mnstr_readSht(s->s, &blksize)) {
+		switch (bs_readhdr(ss)) {
 		case -1:
-			ss->errnr = s->s->errnr;
 			return -1;
 		case 0:
 			return 0;
 		case 1:
 			break;
 		}
-		if (blksize < 0) {
-			ss->errnr = MNSTR_READ_ERROR;
-			return -1;
-		}
-#ifdef BSTREAM_DEBUG
-		fprintf(stderr, "RC size: %d, final: %s\n", blksize >> 1, blksize & 1 ? "true" : "false");
-		fprintf(stderr, "RC %s %d\n", ss->name, blksize);
-#endif
-		s->itotal = (unsigned) (blksize >> 1);	/* amount readable */
-		/* store whether this was the last block or not */
-		s->nr = blksize & 1;
-		s->bytes += s->itotal;
-		s->blks++;
 	}
 
 	/* Fill the caller's buffer. */
@@ -2977,7 +3287,14 @@ bs_read(stream *ss, void *buf, size_t elmsize, size_t cnt)
 		 * read it */
 		n = todo < s->itotal ? todo : s->itotal;
 		while (n > 0) {
-			ssize_t m = s->s->read(s->s, buf, 1, n);
+			ssize_t m;
+
+			if (s->zlen > 0) {
+				/* serve from the uncompressed frame */
+				memcpy(buf, s->zbuf + (s->zlen - s->itotal), n);
+				m = (ssize_t) n;
+			} else
+				m = s->s->read(s->s, buf, 1, n);
 
 			if (m <= 0) {
 				ss->errnr = s->s->errnr;
@@ -3004,36 +3321,20 @@ bs_read(stream *ss, void *buf, size_t elmsize, size_t cnt)
 		}
 
 		if (s->itotal == 0) {
-			short blksize = 0;
-
 			/* The current block has been completely read,
 			 * so read the count for the next block, only
 			 * if the previous was not the last one */
+			s->zlen = 0;
 			if (s->nr)
 				break;
-			switch (mnstr_readSht(s->s, &blksize)) {
+			switch (bs_readhdr(ss)) {
 			case -1:
-				ss->errnr = s->s->errnr;
 				return -1;
 			case 0:
 				return 0;
 			case 1:
 				break;
 			}
-			if (blksize < 0) {
-				ss->errnr = MNSTR_READ_ERROR;
-				return -1;
-			}
-#ifdef BSTREAM_DEBUG
-			fprintf(stderr, "RC size: %d, final: %s\n", blksize >> 1, blksize & 1 ? "true" : "false");
-			fprintf(stderr, "RC %s %d\n", ss->name, s->nr);
-			fprintf(stderr, "RC %s %d\n", ss->name, blksize);
-#endif
-			s->itotal = (unsigned) (blksize >> 1);	/* amount readable */
-			/* store whether this was the last block or not */
-			s->nr = blksize & 1;
-			s->bytes += s->itotal;
-			s->blks++;
 		}
 	}
 	/* if we got an empty block with the end-of-sequence marker
@@ -3083,6 +3384,10 @@ bs_destroy(stream *ss)
 		assert(s->s);
 		if (s->s)
 			s->s->destroy(s->s);
+		if (s->zbuf)
+			free(s->zbuf);
+		if (s->ztmp)
+			free(s->ztmp);
 		free(s);
 	}
 	destroy(ss);
@@ -3137,6 +3442,33 @@ isa_block_stream(stream *s)
 	return s && (s->read == bs_read || s->write == bs_write);
 }
 
+/* Switch compression of the data written to a block stream on or
+ * off.  The other end must be able to read compressed frames, i.e.
+ * this is only done after both agreed on it during the handshake. */
+int
+block_stream_compress(stream *ss, int compress)
+{
+	bs *s;
+
+	if (ss == NULL || ss->write != bs_write || ss->access != ST_WRITE)
+		return -1;
+	s = (bs *) ss->stream_data.p;
+	if (compress && s->zbuf == NULL &&
+	    (s->zbuf = malloc(BS_BATCH)) == NULL)
+		return -1;
+	if (compress && !s->compress && s->nr > 0) {
+		/* move what was buffered so far into the batch */
+		memcpy(s->zbuf, s->buf, s->nr);
+		s->znr = s->nr;
+		s->nr = 0;
+	} else if (!compress && s->compress && s->znr > 0) {
+		if (bs_write_batch(ss, 0) < 0)
+			return -1;
+	}
+	s->compress = compress != 0;
+	return 0;
+}
+
 /* ------------------------------------------------------------------ */
 
 ssize_t
@@ -3608,6 +3940,373 @@ bstream_destroy(bstream *s)
 
 /* ------------------------------------------------------------------ */
 
+/* A frame stream stores the data written to it in checksummed frames,
+ * so that a reader can tell where a file stops being valid, e.g. when
+ * the system crashed while the file was being written.  A frame is
+ * written when FS_FRAME bytes were collected and on every flush.  It
+ * consists of a twelve byte header followed by the data: the size of
+ * the data as stored, the size of the data uncompressed, and the
+ * CRC32C (Castagnoli) checksum of both sizes and the stored data, all
+ * three little endian.  The data is compressed with the codec of the
+ * block streams, unless that doesn't pay off, in which case both
+ * sizes are equal.
+ *
+ * The reader stops at the end of the file and at a header of zeros,
+ * which is what space that was preallocated by the writer looks like.
+ * A frame that is incomplete or doesn't match its checksum is a read
+ * error. */
+#define FS_FRAME	(64 * 1024)
+#define FS_HEADER	12
+#define FS_COMPRESS_MIN	1024
+
+/* CRC32C lookup table, reflected polynomial 0x82F63B78 */
+static const unsigned int crc32c_table[256] = {
+	0x00000000, 0xF26B8303, 0xE13B70F7, 0x1350F3F4,
+	0xC79A971F, 0x35F1141C, 0x26A1E7E8, 0xD4CA64EB,
+	0x8AD958CF, 0x78B2DBCC, 0x6BE22838, 0x9989AB3B,
+	0x4D43CFD0, 0xBF284CD3, 0xAC78BF27, 0x5E133C24,
+	0x105EC76F, 0xE235446C, 0xF165B798, 0x030E349B,
+	0xD7C45070, 0x25AFD373, 0x36FF2087, 0xC494A384,
+	0x9A879FA0, 0x68EC1CA3, 0x7BBCEF57, 0x89D76C54,
+	0x5D1D08BF, 0xAF768BBC, 0xBC267848, 0x4E4DFB4B,
+	0x20BD8EDE, 0xD2D60DDD, 0xC186FE29, 0x33ED7D2A,
+	0xE72719C1, 0x154C9AC2, 0x061C6936, 0xF477EA35,
+	0xAA64D611, 0x580F5512, 0x4B5FA6E6, 0xB93425E5,
+	0x6DFE410E, 0x9F95C20D, 0x8CC531F9, 0x7EAEB2FA,
+	0x30E349B1, 0xC288CAB2, 0xD1D83946, 0x23B3BA45,
+	0xF779DEAE, 0x05125DAD, 0x1642AE59, 0xE4292D5A,
+	0xBA3A117E, 0x4851927D, 0x5B016189, 0xA96AE28A,
+	0x7DA08661, 0x8FCB0562, 0x9C9BF696, 0x6EF07595,
+	0x417B1DBC, 0xB3109EBF, 0xA0406D4B, 0x522BEE48,
+	0x86E18AA3, 0x748A09A0, 0x67DAFA54, 0x95B17957,
+	0xCBA24573, 0x39C9C670, 0x2A993584, 0xD8F2B687,
+	0x0C38D26C, 0xFE53516F, 0xED03A29B, 0x1F682198,
+	0x5125DAD3, 0xA34E59D0, 0xB01EAA24, 0x42752927,
+	0x96BF4DCC, 0x64D4CECF, 0x77843D3B, 0x85EFBE38,
+	0xDBFC821C, 0x2997011F, 0x3AC7F2EB, 0xC8AC71E8,
+	0x1C661503, 0xEE0D9600, 0xFD5D65F4, 0x0F36E6F7,
+	0x61C69362, 0x93AD1061, 0x80FDE395, 0x72966096,
+	0xA65C047D, 0x5437877E, 0x4767748A, 0xB50CF789,
+	0xEB1FCBAD, 0x197448AE, 0x0A24BB5A, 0xF84F3859,
+	0x2C855CB2, 0xDEEEDFB1, 0xCDBE2C45, 0x3FD5AF46,
+	0x7198540D, 0x83F3D70E, 0x90A324FA, 0x62C8A7F9,
+	0xB602C312, 0x44694011, 0x5739B3E5, 0xA55230E6,
+	0xFB410CC2, 0x092A8FC1, 0x1A7A7C35, 0xE811FF36,
+	0x3CDB9BDD, 0xCEB018DE, 0xDDE0EB2A, 0x2F8B6829,
+	0x82F63B78, 0x709DB87B, 0x63CD4B8F, 0x91A6C88C,
+	0x456CAC67, 0xB7072F64, 0xA457DC90, 0x563C5F93,
+	0x082F63B7, 0xFA44E0B4, 0xE9141340, 0x1B7F9043,
+	0xCFB5F4A8, 0x3DDE77AB, 0x2E8E845F, 0xDCE5075C,
+	0x92A8FC17, 0x60C37F14, 0x73938CE0, 0x81F80FE3,
+	0x55326B08, 0xA759E80B, 0xB4091BFF, 0x466298FC,
+	0x1871A4D8, 0xEA1A27DB, 0xF94AD42F, 0x0B21572C,
+	0xDFEB33C7, 0x2D80B0C4, 0x3ED04330, 0xCCBBC033,
+	0xA24BB5A6, 0x502036A5, 0x4370C551, 0xB11B4652,
+	0x65D122B9, 0x97BAA1BA, 0x84EA524E, 0x7681D14D,
+	0x2892ED69, 0xDAF96E6A, 0xC9A99D9E, 0x3BC21E9D,
+	0xEF087A76, 0x1D63F975, 0x0E330A81, 0xFC588982,
+	0xB21572C9, 0x407EF1CA, 0x532E023E, 0xA145813D,
+	0x758FE5D6, 0x87E466D5, 0x94B49521, 0x66DF1622,
+	0x38CC2A06, 0xCAA7A905, 0xD9F75AF1, 0x2B9CD9F2,
+	0xFF56BD19, 0x0D3D3E1A, 0x1E6DCDEE, 0xEC064EED,
+	0xC38D26C4, 0x31E6A5C7, 0x22B65633, 0xD0DDD530,
+	0x0417B1DB, 0xF67C32D8, 0xE52CC12C, 0x1747422F,
+	0x49547E0B, 0xBB3FFD08, 0xA86F0EFC, 0x5A048DFF,
+	0x8ECEE914, 0x7CA56A17, 0x6FF599E3, 0x9D9E1AE0,
+	0xD3D3E1AB, 0x21B862A8, 0x32E8915C, 0xC083125F,
+	0x144976B4, 0xE622F5B7, 0xF5720643, 0x07198540,
+	0x590AB964, 0xAB613A67, 0xB831C993, 0x4A5A4A90,
+	0x9E902E7B, 0x6CFBAD78, 0x7FAB5E8C, 0x8DC0DD8F,
+	0xE330A81A, 0x115B2B19, 0x020BD8ED, 0xF0605BEE,
+	0x24AA3F05, 0xD6C1BC06, 0xC5914FF2, 0x37FACCF1,
+	0x69E9F0D5, 0x9B8273D6, 0x88D28022, 0x7AB90321,
+	0xAE7367CA, 0x5C18E4C9, 0x4F48173D, 0xBD23943E,
+	0xF36E6F75, 0x0105EC76, 0x12551F82, 0xE03E9C81,
+	0x34F4F86A, 0xC69F7B69, 0xD5CF889D, 0x27A40B9E,
+	0x79B737BA, 0x8BDCB4B9, 0x988C474D, 0x6AE7C44E,
+	0xBE2DA0A5, 0x4C4623A6, 0x5F16D052, 0xAD7D5351
+};
+
+static unsigned int
+crc32c(unsigned int crc, const unsigned char *p, size_t n)
+{
+	crc = ~crc;
+#if defined(__SSE4_2__) && defined(__x86_64__)
+	for (; n >= 8; n -= 8, p += 8) {
+		unsigned long long v;
+
+		memcpy(&v, p, sizeof(v));
+		crc = (unsigned int) _mm_crc32_u64(crc, v);
+	}
+	for (; n > 0; n--)
+		crc = _mm_crc32_u8(crc, *p++);
+#else
+	for (; n > 0; n--)
+		crc = crc32c_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+#endif
+	return ~crc;
+}
+
+static void
+fs_put(unsigned char *p, unsigned int v)
+{
+	p[0] = (unsigned char) v;
+	p[1] = (unsigned char) (v >> 8);
+	p[2] = (unsigned char) (v >> 16);
+	p[3] = (unsigned char) (v >> 24);
+}
+
+static unsigned int
+fs_get(const unsigned char *p)
+{
+	return p[0] | (unsigned int) p[1] << 8 |
+		(unsigned int) p[2] << 16 | (unsigned int) p[3] << 24;
+}
+
+typedef struct fs {
+	stream *s;		/* underlying stream */
+	size_t nr;		/* amount of data in buf */
+	size_t pos;		/* how far we got reading buf */
+	char *ztmp;		/* compressed frame */
+	char buf[FS_FRAME];	/* uncompressed frame */
+} fs;
+
+/* Write the collected data as a frame. */
+static int
+fs_write_frame(stream *ss)
+{
+	fs *s = (fs *) ss->stream_data.p;
+	unsigned char hdr[FS_HEADER];
+	const char *data = s->buf;
+	size_t len = s->nr, clen = 0;
+	unsigned int crc;
+
+	if (s->nr == 0)
+		return 0;
+	if (s->nr >= FS_COMPRESS_MIN)
+		clen = lz_compress((unsigned char *) s->buf, s->nr,
+				   (unsigned char *) s->ztmp, s->nr - s->nr / 16);
+	if (clen > 0) {
+		data = s->ztmp;
+		len = clen;
+	}
+	fs_put(hdr, (unsigned int) len);
+	fs_put(hdr + 4, (unsigned int) s->nr);
+	crc = crc32c(0, hdr, 8);
+	crc = crc32c(crc, (const unsigned char *) data, len);
+	fs_put(hdr + 8, crc);
+	if (s->s->write(s->s, hdr, 1, FS_HEADER) != FS_HEADER ||
+	    s->s->write(s->s, data, 1, len) != (ssize_t) len) {
+		ss->errnr = MNSTR_WRITE_ERROR;
+		return -1;
+	}
+	s->nr = 0;
+	return 0;
+}
+
+static ssize_t
+fs_write(stream *ss, const void *buf, size_t elmsize, size_t cnt)
+{
+	fs *s = (fs *) ss->stream_data.p;
+	size_t todo = cnt * elmsize;
+
+	assert(ss->access == ST_WRITE);
+	while (todo > 0) {
+		size_t n = FS_FRAME - s->nr;
+
+		if (todo < n)
+			n = todo;
+		memcpy(s->buf + s->nr, buf, n);
+		s->nr += n;
+		todo -= n;
+		buf = ((const char *) buf + n);
+		if (s->nr == FS_FRAME && fs_write_frame(ss) < 0)
+			return -1;
+	}
+	return (ssize_t) cnt;
+}
+
+static int
+fs_flush(stream *ss)
+{
+	fs *s = (fs *) ss->stream_data.p;
+
+	assert(ss->access == ST_WRITE);
+	if (fs_write_frame(ss) < 0)
+		return -1;
+	if (mnstr_flush(s->s)) {
+		ss->errnr = MNSTR_WRITE_ERROR;
+		return -1;
+	}
+	return 0;
+}
+
+/* like for files, only what was flushed is synced, so that syncing
+ * needn't wait for writers */
+static int
+fs_fsync(stream *ss)
+{
+	fs *s = (fs *) ss->stream_data.p;
+
+	if (mnstr_fsync(s->s)) {
+		ss->errnr = MNSTR_WRITE_ERROR;
+		return -1;
+	}
+	return 0;
+}
+
+/* read exactly n bytes from the underlying stream, return how many
+ * were read */
+static size_t
+fs_readall(fs *s, void *buf, size_t n)
+{
+	size_t got = 0;
+
+	while (got < n) {
+		ssize_t m = s->s->read(s->s, (char *) buf + got, 1, n - got);
+
+		if (m <= 0)
+			break;
+		got += (size_t) m;
+	}
+	return got;
+}
+
+/* Read the next frame into buf.  Returns -1 on error, 0 at the end
+ * of the data and 1 otherwise. */
+static int
+fs_read_frame(stream *ss)
+{
+	fs *s = (fs *) ss->stream_data.p;
+	unsigned char hdr[FS_HEADER];
+	size_t got, len, rlen;
+	char *data;
+
+	s->nr = s->pos = 0;
+	got = fs_readall(s, hdr, FS_HEADER);
+	if (got == 0 && s->s->errnr == MNSTR_NO__ERROR)
+		return 0;
+	if (got == FS_HEADER &&
+	    fs_get(hdr) == 0 && fs_get(hdr + 4) == 0 && fs_get(hdr + 8) == 0)
+		return 0;	/* preallocated space */
+	len = fs_get(hdr);
+	rlen = fs_get(hdr + 4);
+	if (got < FS_HEADER || len == 0 || len > rlen || rlen > FS_FRAME) {
+		ss->errnr = MNSTR_READ_ERROR;
+		return -1;
+	}
+	data = len < rlen ? s->ztmp : s->buf;
+	if (fs_readall(s, data, len) != len ||
+	    crc32c(crc32c(0, hdr, 8), (unsigned char *) data, len) != fs_get(hdr + 8) ||
+	    (len < rlen &&
+	     lz_decompress((unsigned char *) s->ztmp, len,
+			   (unsigned char *) s->buf, rlen) != (ssize_t) rlen)) {
+		ss->errnr = MNSTR_READ_ERROR;
+		return -1;
+	}
+	s->nr = rlen;
+	return 1;
+}
+
+static ssize_t
+fs_read(stream *ss, void *buf, size_t elmsize, size_t cnt)
+{
+	fs *s = (fs *) ss->stream_data.p;
+	size_t todo = cnt * elmsize, got = 0;
+
+	assert(ss->access == ST_READ);
+	while (todo > 0) {
+		size_t n;
+
+		if (s->pos == s->nr) {
+			int r = fs_read_frame(ss);
+
+			if (r < 0)
+				return -1;
+			if (r == 0)
+				break;
+		}
+		n = s->nr - s->pos;
+		if (todo < n)
+			n = todo;
+		memcpy((char *) buf + got, s->buf + s->pos, n);
+		s->pos += n;
+		got += n;
+		todo -= n;
+	}
+	return (ssize_t) (elmsize > 0 ? got / elmsize : 0);
+}
+
+static void
+fs_close(stream *ss)
+{
+	fs *s = (fs *) ss->stream_data.p;
+
+	if (s == NULL)
+		return;
+	if (ss->access == ST_WRITE)
+		(void) fs_write_frame(ss);
+	s->s->close(s->s);
+}
+
+static void
+fs_destroy(stream *ss)
+{
+	fs *s = (fs *) ss->stream_data.p;
+
+	if (s) {
+		s->s->destroy(s->s);
+		free(s->ztmp);
+		free(s);
+	}
+	destroy(ss);
+}
+
+static void
+fs_clrerr(stream *s)
+{
+	if (s->stream_data.p)
+		mnstr_clearerr(((fs *) s->stream_data.p)->s);
+}
+
+stream *
+frame_stream(stream *s)
+{
+	stream *ns;
+	fs *f;
+
+	if (s == NULL)
+		return NULL;
+#ifdef STREAM_DEBUG
+	fprintf(stderr, "frame_stream %s\n", s->name ? s->name : "<unnamed>");
+#endif
+	if ((ns = create_stream(s->name)) == NULL)
+		return NULL;
+	if ((f = malloc(sizeof(*f))) == NULL ||
+	    (f->ztmp = malloc(BS_ZBOUND(FS_FRAME))) == NULL) {
+		free(f);
+		destroy(ns);
+		return NULL;
+	}
+	f->s = s;
+	f->nr = 0;
+	f->pos = 0;
+	ns->byteorder = s->byteorder;
+	ns->type = s->type;
+	ns->access = s->access;
+	ns->close = fs_close;
+	ns->clrerr = fs_clrerr;
+	ns->destroy = fs_destroy;
+	ns->flush = fs_flush;
+	ns->fsync = fs_fsync;
+	ns->read = fs_read;
+	ns->write = fs_write;
+	ns->stream_data.p = (void *) f;
+	return ns;
+}
+
+/* ------------------------------------------------------------------ */
+
 /*
  * Buffered write stream batches subsequent write requests in order to
  * optimize write bandwidth
@@ -214,6 +214,9 @@ stream_export buffer *mnstr_get_buffer(stream *s);
 stream_export stream *wbstream(stream *s, size_t buflen);
 stream_export stream *block_stream(stream *s);
 stream_export int isa_block_stream(stream *s);
+stream_export int block_stream_compress(stream *s, int compress);
+/* checksummed and compressed frames, see stream.c */
+stream_export stream *frame_stream(stream *s);
 /* read block of data including the end of block marker */
 stream_export ssize_t mnstr_read_block(stream *s, void *buf, size_t elmsize, size_t cnt);
 
@@ -675,6 +675,8 @@ typedef struct {
 } Hash;
 
 typedef struct Imprints Imprints;
+typedef struct Compress Compress;
+typedef struct Zonemap Zonemap;
 
 
 /*
@@ -797,6 +799,8 @@ gdk_export int VALisnil(const ValRecord *v);
  *           Heap   *hheap;           // heap for varsized head values
  *           Hash   *hhash;           // linear chained hash table on head
  *           Imprints *himprints;     // column imprints index on head
+ *           Compress *hcompress;     // compressed copy of head
+ *           Zonemap *hzonemap;       // per-zone min/max of head
  *           // Tail properties
  *           int    ttype;            // Tail type number
  *           str    tident;           // name for tail column
@@ -810,6 +814,8 @@ gdk_export int VALisnil(const ValRecord *v);
  *           Heap   *theap;           // heap for varsized tail values
  *           Hash   *thash;           // linear chained hash table on tail
  *           Imprints *timprints;     // column imprints index on tail
+ *           Compress *tcompress;     // compressed copy of tail
+ *           Zonemap *tzonemap;       // per-zone min/max of tail
  *  } BAT;
  * @end verbatim
  *
@@ -889,6 +895,8 @@ typedef struct {
 	Heap *vheap;		/* space for the varsized data. */
 	Hash *hash;		/* hash table */
 	Imprints *imprints;	/* column imprints index */
+	Compress *compress;	/* compressed copy of the column */
+	Zonemap *zonemap;	/* min/max per zone of the column */
 
 	PROPrec *props;		/* list of dynamic properties stored in the bat descriptor */
 } COLrec;
@@ -2092,6 +2100,40 @@ gdk_export gdk_return BAThash(BAT *b, BUN masksize);
 gdk_export gdk_return BATimprints(BAT *b);
 gdk_export lng IMPSimprintsize(BAT *b);
 
+/*
+ * @- Column Compression Functions
+ *
+ * @multitable @columnfractions 0.08 0.7
+ * @item gdk_return
+ * @tab
+ *  BATcompress (BAT *b)
+ * @end multitable
+ *
+ * Create a compressed copy of a read-only integer column, if that
+ * saves at least half the space.  Selections, projections and min/max
+ * use the copy instead of the tail.
+ */
+
+gdk_export gdk_return BATcompress(BAT *b);
+gdk_export lng CMPcompresssize(BAT *b);
+
+/*
+ * @- Zone Map Functions
+ *
+ * @multitable @columnfractions 0.08 0.7
+ * @item gdk_return
+ * @tab
+ *  BATzonemap (BAT *b)
+ * @end multitable
+ *
+ * Create a zone map (the minimum and maximum per block of values) of
+ * a numeric column, or extend it to cover values appended since.
+ * Selections on the column and on slices of it skip the blocks that
+ * cannot contain a match.
+ */
+
+gdk_export gdk_return BATzonemap(BAT *b);
+
 /*
  * @- Multilevel Storage Modes
  *
@@ -521,7 +521,7 @@ BATgroupsum(BAT *b, BAT *g, BAT *e, BAT *s, int tp, int skip_nils, int abort_on_
 	if (BATtdense(g))
 		gids = NULL;
 	else
-		gids = (const oid *) Tloc(g, BUNfirst(g) + start);
+		gids = (const oid *) Tloc(g, BUNfirst(g));
 
 	nils = dosum(Tloc(b, BUNfirst(b)), b->T->nonil, b->hseqbase, start, end,
 		     Tloc(bn, BUNfirst(bn)), ngrp, b->ttype, tp,
@@ -1174,7 +1174,7 @@ BATgroupprod(BAT *b, BAT *g, BAT *e, BAT *s, int tp, int skip_nils, int abort_on
 	if (BATtdense(g))
 		gids = NULL;
 	else
-		gids = (const oid *) Tloc(g, BUNfirst(g) + start);
+		gids = (const oid *) Tloc(g, BUNfirst(g));
 
 	nils = doprod(Tloc(b, BUNfirst(b)), b->hseqbase, start, end,
 		      Tloc(bn, BUNfirst(bn)), ngrp, b->ttype, tp,
@@ -1516,7 +1516,7 @@ BATgroupavg(BAT **bnp, BAT **cntsp, BAT *b, BAT *g, BAT *e, BAT *s, int tp, int
 	if (BATtdense(g))
 		gids = NULL;
 	else
-		gids = (const oid *) Tloc(g, BUNfirst(g) + start);
+		gids = (const oid *) Tloc(g, BUNfirst(g));
 
 	switch (b->ttype) {
 	case TYPE_bte:
@@ -1833,7 +1833,7 @@ BATgroupcount(BAT *b, BAT *g, BAT *e, BAT *s, int tp, int skip_nils, int abort_o
 	if (BATtdense(g))
 		gids = NULL;
 	else
-		gids = (const oid *) Tloc(g, BUNfirst(g) + start);
+		gids = (const oid *) Tloc(g, BUNfirst(g));
 
 	t = b->T->type;
 	nil = ATOMnilptr(t);
@@ -1953,7 +1953,7 @@ BATgroupsize(BAT *b, BAT *g, BAT *e, BAT *s, int tp, int skip_nils, int abort_on
 	if (BATtdense(g))
 		gids = NULL;
 	else
-		gids = (const oid *) Tloc(g, BUNfirst(g) + start);
+		gids = (const oid *) Tloc(g, BUNfirst(g));
 
 	bits = (const bit *) Tloc(b, BUNfirst(b));
 
@@ -2347,7 +2347,7 @@ BATgroupminmax(BAT *b, BAT *g, BAT *e, BAT *s, int tp, int skip_nils,
 	if (g == NULL || BATtdense(g))
 		gids = NULL;
 	else
-		gids = (const oid *) Tloc(g, BUNfirst(g) + start);
+		gids = (const oid *) Tloc(g, BUNfirst(g));
 
 	nils = (*minmax)(oids, b, gids, ngrp, min, max, start, end,
 			 cand, candend, cnt, skip_nils, g && BATtdense(g));
@@ -2371,13 +2371,17 @@ BATminmax(BAT *b, void *aggr,
 {
 	oid pos;
 	void *res;
-	int s;
+	int s, found;
 	int needdecref = 0;
 	BATiter bi;
+	lng v;			/* large enough for any type CMPminmax handles */
 
 	if (!BAThdense(b))
 		return NULL;
-	if ((VIEWtparent(b) == 0 ||
+	if ((found = CMPminmax(b, minmax == do_groupmax, &v)) != 0) {
+		/* the compressed copy knows */
+		pos = oid_nil;
+	} else if ((VIEWtparent(b) == 0 ||
 	     BATcount(b) == BATcount(BBPdescriptor(VIEWtparent(b)))) &&
 	    BATcheckimprints(b)) {
 		Imprints *imprints = VIEWtparent(b) ? BBPdescriptor(-VIEWtparent(b))->T->imprints : b->T->imprints;
@@ -2403,7 +2407,9 @@ BATminmax(BAT *b, void *aggr,
 		(void) (*minmax)(&pos, b, NULL, 1, 0, 0, 0, BATcount(b),
 				 NULL, NULL, BATcount(b), 1, 0);
 	}
-	if (pos == oid_nil) {
+	if (found) {
+		res = &v;
+	} else if (pos == oid_nil) {
 		res = ATOMnilptr(b->ttype);
 	} else {
 		bi = bat_iterator(b);
@@ -2451,6 +2457,536 @@ BATmax(BAT *b, void *aggr)
 }
 
 
+/* ---------------------------------------------------------------------- */
+/* multiple aggregates in one pass */
+
+/* Queries often calculate many aggregates over the same grouping.
+ * Instead of rescanning the group ids (and candidate list) for each
+ * aggregate, BATgroupaggrmulti processes the rows in blocks: for each
+ * block the positions of the candidates and their group ids are
+ * determined once, after which the accumulators of all aggregates are
+ * updated in a tight, type-specific loop over the block.
+ *
+ * Aggregate j is calculated over bs[j] and is one of
+ * - GDK_AGGR_COUNT: like BATgroupcount, result type wrd;
+ * - GDK_AGGR_SUM: like BATgroupsum, result type tps[j];
+ * - GDK_AGGR_MIN, GDK_AGGR_MAX: like BATgroupmin and BATgroupmax,
+ *   i.e. the result contains the *positions* of the minimum and
+ *   maximum values.
+ * All value BATs must be aligned with g.  Aggregates the fused loop
+ * cannot handle (e.g. because of their type) are calculated using
+ * the individual functions. */
+
+#define AGGRMULTI_BLOCK	1024
+
+struct aggrmulti {
+	int op;			/* GDK_AGGR_* */
+	int tp1;		/* (base) type of the input */
+	int tp2;		/* type of the result (sum only) */
+	int skip_nils;
+	const void *vals;	/* input values */
+	BAT *bn;		/* result BAT */
+	unsigned int *seen;	/* sum: bitmask for groups that we've seen */
+	BUN nils;		/* number of nils in the result */
+};
+
+/* rank of the integer types in order of increasing width, 0 if not
+ * an integer type */
+static int
+aggrmulti_rank(int tp)
+{
+	switch (tp) {
+	case TYPE_bte:
+		return 1;
+	case TYPE_sht:
+		return 2;
+	case TYPE_int:
+		return 3;
+	case TYPE_lng:
+		return 4;
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		return 5;
+#endif
+	default:
+		return 0;
+	}
+}
+
+/* can the fused loop calculate aggregate op over b? */
+static int
+aggrmulti_supported(int op, BAT *b, int tp, int skip_nils)
+{
+	int t = ATOMbasetype(b->ttype);
+
+	switch (op) {
+	case GDK_AGGR_COUNT:
+		/* without skipping nils we don't look at the values */
+		return !skip_nils || aggrmulti_rank(t) > 0 ||
+			t == TYPE_flt || t == TYPE_dbl;
+	case GDK_AGGR_SUM:
+		/* the type combinations supported by dosum */
+		t = b->ttype == TYPE_wrd ? ATOMstorage(TYPE_wrd) : b->ttype;
+		tp = tp == TYPE_wrd ? ATOMstorage(TYPE_wrd) : tp;
+		if (aggrmulti_rank(t) > 0)
+			return aggrmulti_rank(t) <= aggrmulti_rank(tp);
+		return (t == TYPE_flt && (tp == TYPE_flt || tp == TYPE_dbl)) ||
+			(t == TYPE_dbl && tp == TYPE_dbl);
+	case GDK_AGGR_MIN:
+	case GDK_AGGR_MAX:
+		return aggrmulti_rank(t) > 0 || t == TYPE_flt || t == TYPE_dbl;
+	default:
+		return 0;
+	}
+}
+
+/* calculate a single aggregate using the individual function */
+static BAT *
+aggrmulti_single(int op, BAT *b, BAT *g, BAT *e, BAT *s, int tp,
+		 int skip_nils, int abort_on_error)
+{
+	switch (op) {
+	case GDK_AGGR_COUNT:
+		return BATgroupcount(b, g, e, s, TYPE_wrd, skip_nils, abort_on_error);
+	case GDK_AGGR_SUM:
+		return BATgroupsum(b, g, e, s, tp, skip_nils, abort_on_error);
+	case GDK_AGGR_MIN:
+		return BATgroupmin(b, g, e, s, TYPE_oid, skip_nils, abort_on_error);
+	case GDK_AGGR_MAX:
+		return BATgroupmax(b, g, e, s, TYPE_oid, skip_nils, abort_on_error);
+	default:
+		GDKerror("BATgroupaggrmulti: unknown aggregate %d\n", op);
+		return NULL;
+	}
+}
+
+#define AGGRMULTI_COUNT(TYPE)						\
+	do {								\
+		const TYPE *restrict vals = (const TYPE *) a->vals;	\
+		for (k = 0; k < n; k++)					\
+			if (vals[pos[k]] != TYPE##_nil)			\
+				cnts[grp[k]]++;				\
+	} while (0)
+
+/* same semantics as AGGR_SUM: ADD_WITH_CHECK looks at abort_on_error
+ * and counts in nils, so on overflow the sum of the group becomes nil,
+ * unless abort_on_error is set, in which case the whole call fails */
+#define AGGRMULTI_SUM(TYPE1, TYPE2)					\
+	do {								\
+		const TYPE1 *restrict vals = (const TYPE1 *) a->vals;	\
+		TYPE2 *restrict sums = (TYPE2 *) Tloc(a->bn, BUNfirst(a->bn)); \
+		for (k = 0; k < n; k++) {				\
+			const TYPE1 x = vals[pos[k]];			\
+			gid = grp[k];					\
+			if (x == TYPE1##_nil) {				\
+				if (!a->skip_nils) {			\
+					seen[gid >> 5] |= 1U << (gid & 0x1F); \
+					sums[gid] = TYPE2##_nil;	\
+					nils++;				\
+				}					\
+				continue;				\
+			}						\
+			if (!(seen[gid >> 5] & (1U << (gid & 0x1F)))) {	\
+				seen[gid >> 5] |= 1U << (gid & 0x1F);	\
+				sums[gid] = 0;				\
+			}						\
+			if (sums[gid] != TYPE2##_nil) {			\
+				ADD_WITH_CHECK(TYPE1, x,		\
+					       TYPE2, sums[gid],	\
+					       TYPE2, sums[gid],	\
+					       goto overflow);		\
+			}						\
+		}							\
+	} while (0)
+
+/* same semantics as AGGR_CMP */
+#define AGGRMULTI_CMP(TYPE, OP)						\
+	do {								\
+		const TYPE *restrict vals = (const TYPE *) a->vals;	\
+		for (k = 0; k < n; k++) {				\
+			const TYPE x = vals[pos[k]];			\
+			gid = grp[k];					\
+			if (a->skip_nils && x == TYPE##_nil)		\
+				continue;				\
+			if (oids[gid] == oid_nil) {			\
+				oids[gid] = pos[k] + seqb;		\
+				a->nils--;				\
+			} else if (vals[oids[gid] - seqb] != TYPE##_nil && \
+				   (x == TYPE##_nil ||			\
+				    OP(x, vals[oids[gid] - seqb])))	\
+				oids[gid] = pos[k] + seqb;		\
+		}							\
+	} while (0)
+
+#define AGGRMULTI_MINMAX(TYPE)						\
+	do {								\
+		if (a->op == GDK_AGGR_MIN)				\
+			AGGRMULTI_CMP(TYPE, LT);			\
+		else							\
+			AGGRMULTI_CMP(TYPE, GT);			\
+	} while (0)
+
+/* update the accumulators of a single aggregate with a block of n
+ * rows at positions pos (relative to the start of the BAT) that
+ * belong to groups grp (relative to the minimum group id); overflow
+ * in a sum is an error if abort_on_error is set, and results in nil
+ * for the group otherwise, as in BATgroupsum */
+static gdk_return
+aggrmulti_block(struct aggrmulti *a, const BUN *restrict pos,
+		const oid *restrict grp, BUN n, oid seqb, int abort_on_error)
+{
+	BUN k, nils = 0;
+	oid gid;
+
+	switch (a->op) {
+	case GDK_AGGR_COUNT: {
+		wrd *restrict cnts = (wrd *) Tloc(a->bn, BUNfirst(a->bn));
+
+		if (!a->skip_nils) {
+			for (k = 0; k < n; k++)
+				cnts[grp[k]]++;
+			break;
+		}
+		switch (a->tp1) {
+		case TYPE_bte:
+			AGGRMULTI_COUNT(bte);
+			break;
+		case TYPE_sht:
+			AGGRMULTI_COUNT(sht);
+			break;
+		case TYPE_int:
+			AGGRMULTI_COUNT(int);
+			break;
+		case TYPE_lng:
+			AGGRMULTI_COUNT(lng);
+			break;
+#ifdef HAVE_HGE
+		case TYPE_hge:
+			AGGRMULTI_COUNT(hge);
+			break;
+#endif
+		case TYPE_flt:
+			AGGRMULTI_COUNT(flt);
+			break;
+		case TYPE_dbl:
+			AGGRMULTI_COUNT(dbl);
+			break;
+		default:
+			assert(0);
+		}
+		break;
+	}
+	case GDK_AGGR_SUM: {
+		unsigned int *restrict seen = a->seen;
+
+		switch (a->tp2) {
+		case TYPE_bte:
+			AGGRMULTI_SUM(bte, bte);
+			break;
+		case TYPE_sht:
+			switch (a->tp1) {
+			case TYPE_bte:
+				AGGRMULTI_SUM(bte, sht);
+				break;
+			default:
+				AGGRMULTI_SUM(sht, sht);
+				break;
+			}
+			break;
+		case TYPE_int:
+			switch (a->tp1) {
+			case TYPE_bte:
+				AGGRMULTI_SUM(bte, int);
+				break;
+			case TYPE_sht:
+				AGGRMULTI_SUM(sht, int);
+				break;
+			default:
+				AGGRMULTI_SUM(int, int);
+				break;
+			}
+			break;
+		case TYPE_lng:
+			switch (a->tp1) {
+			case TYPE_bte:
+				AGGRMULTI_SUM(bte, lng);
+				break;
+			case TYPE_sht:
+				AGGRMULTI_SUM(sht, lng);
+				break;
+			case TYPE_int:
+				AGGRMULTI_SUM(int, lng);
+				break;
+			default:
+				AGGRMULTI_SUM(lng, lng);
+				break;
+			}
+			break;
+#ifdef HAVE_HGE
+		case TYPE_hge:
+			switch (a->tp1) {
+			case TYPE_bte:
+				AGGRMULTI_SUM(bte, hge);
+				break;
+			case TYPE_sht:
+				AGGRMULTI_SUM(sht, hge);
+				break;
+			case TYPE_int:
+				AGGRMULTI_SUM(int, hge);
+				break;
+			case TYPE_lng:
+				AGGRMULTI_SUM(lng, hge);
+				break;
+			default:
+				AGGRMULTI_SUM(hge, hge);
+				break;
+			}
+			break;
+#endif
+		case TYPE_flt:
+			AGGRMULTI_SUM(flt, flt);
+			break;
+		case TYPE_dbl:
+			switch (a->tp1) {
+			case TYPE_flt:
+				AGGRMULTI_SUM(flt, dbl);
+				break;
+			default:
+				AGGRMULTI_SUM(dbl, dbl);
+				break;
+			}
+			break;
+		default:
+			assert(0);
+		}
+		a->nils += nils;
+		break;
+	}
+	case GDK_AGGR_MIN:
+	case GDK_AGGR_MAX: {
+		oid *restrict oids = (oid *) Tloc(a->bn, BUNfirst(a->bn));
+
+		switch (a->tp1) {
+		case TYPE_bte:
+			AGGRMULTI_MINMAX(bte);
+			break;
+		case TYPE_sht:
+			AGGRMULTI_MINMAX(sht);
+			break;
+		case TYPE_int:
+			AGGRMULTI_MINMAX(int);
+			break;
+		case TYPE_lng:
+			AGGRMULTI_MINMAX(lng);
+			break;
+#ifdef HAVE_HGE
+		case TYPE_hge:
+			AGGRMULTI_MINMAX(hge);
+			break;
+#endif
+		case TYPE_flt:
+			AGGRMULTI_MINMAX(flt);
+			break;
+		case TYPE_dbl:
+			AGGRMULTI_MINMAX(dbl);
+			break;
+		default:
+			assert(0);
+		}
+		break;
+	}
+	}
+	return GDK_SUCCEED;
+
+  overflow:
+	/* only reached if abort_on_error is set */
+	assert(abort_on_error);
+	GDKerror("22003!overflow in calculation.\n");
+	return GDK_FAIL;
+}
+
+gdk_return
+BATgroupaggrmulti(BAT **res, int naggr, BAT **bs, const int *ops,
+		  const int *tps, const int *skip_nils, BAT *g, BAT *e, BAT *s,
+		  int abort_on_error)
+{
+	const oid *restrict gids;
+	const oid *cand = NULL, *candend = NULL;
+	oid min, max, gid;
+	BUN i, n, ngrp, start, end, cnt;
+	BUN *pos = NULL;
+	oid *grp = NULL;
+	struct aggrmulti *aggrs = NULL;
+	BAT *b;
+	const char *err;
+	int j, more = 1, fused = naggr > 1;
+
+	for (j = 0; j < naggr; j++)
+		res[j] = NULL;
+	if (naggr == 0)
+		return GDK_SUCCEED;
+	b = bs[0];
+	if ((err = BATgroupaggrinit(b, g, e, s, &min, &max, &ngrp, &start, &end,
+				    &cnt, &cand, &candend)) != NULL) {
+		GDKerror("BATgroupaggrmulti: %s\n", err);
+		return GDK_FAIL;
+	}
+	if (g == NULL) {
+		GDKerror("BATgroupaggrmulti: b and g must be aligned\n");
+		return GDK_FAIL;
+	}
+
+	/* the individual functions deal efficiently with the trivial
+	 * cases: no groups and singleton groups */
+	if (BATcount(b) == 0 || ngrp == 0 ||
+	    ((e == NULL ||
+	      (BATcount(e) == BATcount(b) && e->hseqbase == b->hseqbase)) &&
+	     (BATtdense(g) || (g->tkey && g->T->nonil))))
+		fused = 0;
+	for (j = 0; j < naggr && fused; j++) {
+		if (!BAThdense(bs[j]) ||
+		    BATcount(bs[j]) != BATcount(b) ||
+		    bs[j]->hseqbase != b->hseqbase ||
+		    !aggrmulti_supported(ops[j], bs[j], tps[j], skip_nils[j]))
+			fused = 0;
+	}
+	if (fused &&
+	    ((pos = GDKmalloc(AGGRMULTI_BLOCK * sizeof(BUN))) == NULL ||
+	     (grp = GDKmalloc(AGGRMULTI_BLOCK * sizeof(oid))) == NULL ||
+	     (aggrs = GDKzalloc(naggr * sizeof(struct aggrmulti))) == NULL))
+		goto bailout;
+
+	if (!fused) {
+		ALGODEBUG fprintf(stderr, "#BATgroupaggrmulti: %d aggregates "
+				  "one at a time\n", naggr);
+		for (j = 0; j < naggr; j++) {
+			res[j] = aggrmulti_single(ops[j], bs[j], g, e, s, tps[j],
+						  skip_nils[j], abort_on_error);
+			if (res[j] == NULL)
+				goto bailout;
+		}
+		return GDK_SUCCEED;
+	}
+
+	ALGODEBUG fprintf(stderr, "#BATgroupaggrmulti: %d aggregates over "
+			  BUNFMT " rows and " BUNFMT " groups in one pass\n",
+			  naggr, cnt, ngrp);
+
+	/* initialize the accumulators */
+	for (j = 0; j < naggr; j++) {
+		struct aggrmulti *a = &aggrs[j];
+
+		a->op = ops[j];
+		a->tp1 = ATOMbasetype(bs[j]->ttype);
+		a->skip_nils = skip_nils[j];
+		a->vals = Tloc(bs[j], BUNfirst(bs[j]));
+		switch (a->op) {
+		case GDK_AGGR_COUNT:
+			a->bn = BATnew(TYPE_void, TYPE_wrd, ngrp, TRANSIENT);
+			if (a->bn == NULL)
+				goto bailout;
+			memset(Tloc(a->bn, BUNfirst(a->bn)), 0, ngrp * sizeof(wrd));
+			break;
+		case GDK_AGGR_SUM:
+			a->tp1 = bs[j]->ttype == TYPE_wrd ? ATOMstorage(TYPE_wrd) : bs[j]->ttype;
+			a->tp2 = tps[j] == TYPE_wrd ? ATOMstorage(TYPE_wrd) : tps[j];
+			a->bn = BATconstant(tps[j], ATOMnilptr(tps[j]), ngrp, TRANSIENT);
+			a->seen = GDKzalloc(((ngrp + 31) / 32) * sizeof(int));
+			if (a->bn == NULL || a->seen == NULL)
+				goto bailout;
+			break;
+		default:
+			a->bn = BATnew(TYPE_void, TYPE_oid, ngrp, TRANSIENT);
+			if (a->bn == NULL)
+				goto bailout;
+			for (i = 0; i < ngrp; i++)
+				((oid *) Tloc(a->bn, BUNfirst(a->bn)))[i] = oid_nil;
+			a->nils = ngrp;
+			break;
+		}
+	}
+
+	gids = BATtdense(g) ? NULL : (const oid *) Tloc(g, BUNfirst(g));
+	while (more) {
+		/* collect the next block of candidates with their
+		 * group ids */
+		for (n = 0; n < AGGRMULTI_BLOCK; ) {
+			if (cand) {
+				if (cand == candend ||
+				    (i = *cand++ - b->hseqbase) >= end) {
+					more = 0;
+					break;
+				}
+			} else {
+				if (start == end) {
+					more = 0;
+					break;
+				}
+				i = start++;
+			}
+			gid = gids ? gids[i] : g->tseqbase + i;
+			if (gid >= min && gid <= max) {
+				pos[n] = i;
+				grp[n] = gid - min;
+				n++;
+			}
+		}
+		/* and feed them to all aggregates */
+		for (j = 0; j < naggr; j++)
+			if (aggrmulti_block(&aggrs[j], pos, grp, n,
+					    b->hseqbase, abort_on_error) != GDK_SUCCEED)
+				goto bailout;
+	}
+
+	for (j = 0; j < naggr; j++) {
+		struct aggrmulti *a = &aggrs[j];
+		BAT *bn = a->bn;
+
+		if (a->op == GDK_AGGR_SUM && a->nils == 0) {
+			/* empty groups result in nil */
+			for (i = 0; i < ngrp; i++) {
+				if (!(a->seen[i >> 5] & (1U << (i & 0x1F)))) {
+					a->nils = 1;
+					break;
+				}
+			}
+		}
+		BATsetcount(bn, ngrp);
+		BATseqbase(bn, min);
+		bn->tkey = BATcount(bn) <= 1;
+		bn->tsorted = BATcount(bn) <= 1;
+		bn->trevsorted = BATcount(bn) <= 1;
+		bn->T->nil = a->nils != 0;
+		bn->T->nonil = a->nils == 0;
+		res[j] = bn;
+		a->bn = NULL;
+		GDKfree(a->seen);
+	}
+	GDKfree(aggrs);
+	GDKfree(pos);
+	GDKfree(grp);
+	return GDK_SUCCEED;
+
+  bailout:
+	if (aggrs) {
+		for (j = 0; j < naggr; j++) {
+			if (aggrs[j].bn)
+				BBPunfix(aggrs[j].bn->batCacheid);
+			GDKfree(aggrs[j].seen);
+		}
+		GDKfree(aggrs);
+	}
+	GDKfree(pos);
+	GDKfree(grp);
+	for (j = 0; j < naggr; j++) {
+		if (res[j]) {
+			BBPunfix(res[j]->batCacheid);
+			res[j] = NULL;
+		}
+	}
+	return GDK_FAIL;
+}
+
 /* ---------------------------------------------------------------------- */
 /* quantiles/median */
 
@@ -2872,7 +3408,7 @@ dogroupstdev(BAT **avgb, BAT *b, BAT *g, BAT *e, BAT *s, int tp,
 	if (BATtdense(g))
 		gids = NULL;
 	else
-		gids = (const oid *) Tloc(g, BUNfirst(g) + start);
+		gids = (const oid *) Tloc(g, BUNfirst(g));
 
 	switch (b->ttype) {
 	case TYPE_bte:
@@ -330,6 +330,10 @@ VIEWcreate_(BAT *h, BAT *t, int slice_view)
 	/* imprints are shared, but the check is dynamic */
 	bn->H->imprints = NULL;
 	bn->T->imprints = NULL;
+	bn->H->compress = NULL;
+	bn->T->compress = NULL;
+	bn->H->zonemap = NULL;
+	bn->T->zonemap = NULL;
 	BBPcacheit(bs, 1);	/* enter in BBP */
 	/* View of VIEW combine, ie we need to fix the head of the mirror */
 	if (vc) {
@@ -440,6 +444,7 @@ BATmaterializeh(BAT *b)
 	/* cleanup possible ACC's */
 	HASHdestroy(b);
 	IMPSdestroy(b);
+	CMPdestroy(b);
 
 	b->H->heap.filename = NULL;
 	if (HEAPalloc(&b->H->heap, cnt, sizeof(oid)) != GDK_SUCCEED) {
@@ -545,6 +550,12 @@ VIEWunlink(BAT *b)
 			b->H->imprints = NULL;
 		if (tpb && b->T->imprints && b->T->imprints == tpb->H->imprints)
 			b->T->imprints = NULL;
+
+		/* unlink compressed copies shared with parent */
+		if (hpb && b->H->compress && b->H->compress == hpb->H->compress)
+			b->H->compress = NULL;
+		if (tpb && b->T->compress && b->T->compress == tpb->H->compress)
+			b->T->compress = NULL;
 	}
 }
 
@@ -779,6 +790,7 @@ VIEWdestroy(BAT *b)
 	if (b->T->hash)
 		HASHremove(b);
 	IMPSdestroy(b);
+	CMPdestroy(b);
 	VIEWunlink(b);
 
 	if (b->htype && !b->H->heap.parentid) {
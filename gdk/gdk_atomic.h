@@ -23,6 +23,9 @@
  * ATOMIC_SUB -- subtract a value from a variable, return original value;
  * ATOMIC_INC -- increment a variable's value, return new value;
  * ATOMIC_DEC -- decrement a variable's value, return new value;
+ * ATOMIC_CAS -- compare-and-swap: set a variable to a new value if it
+ *               still has the expected old value, return non-zero if
+ *               it did;
  * These interfaces work on variables of type ATOMIC_TYPE
  * (int or lng depending on architecture).
  *
@@ -53,6 +56,7 @@
 #define ATOMIC_SUB(var, val, lck, fcn)	AO_fetch_and_add(&var, -(val))
 #define ATOMIC_INC(var, lck, fcn)	(AO_fetch_and_add1(&var) + 1)
 #define ATOMIC_DEC(var, lck, fcn)	(AO_fetch_and_sub1(&var) - 1)
+#define ATOMIC_CAS(var, old, new, lck, fcn)	AO_compare_and_swap_full(&var, (old), (new))
 
 #define ATOMIC_INIT(lck, fcn)		((void) 0)
 
@@ -77,6 +81,7 @@
 #define ATOMIC_SUB(var, val, lck, fcn)	_InterlockedExchangeAdd64(&var, -(val))
 #define ATOMIC_INC(var, lck, fcn)	_InterlockedIncrement64(&var)
 #define ATOMIC_DEC(var, lck, fcn)	_InterlockedDecrement64(&var)
+#define ATOMIC_CAS(var, old, new, lck, fcn)	(_InterlockedCompareExchange64(&var, (new), (old)) == (old))
 
 #pragma intrinsic(_InterlockedExchange64)
 #pragma intrinsic(_InterlockedExchangeAdd64)
@@ -94,6 +99,7 @@
 #define ATOMIC_SUB(var, val, lck, fcn)	_InterlockedExchangeAdd(&var, -(val))
 #define ATOMIC_INC(var, lck, fcn)	_InterlockedIncrement(&var)
 #define ATOMIC_DEC(var, lck, fcn)	_InterlockedDecrement(&var)
+#define ATOMIC_CAS(var, old, new, lck, fcn)	(_InterlockedCompareExchange(&var, (new), (old)) == (old))
 
 #pragma intrinsic(_InterlockedExchange)
 #pragma intrinsic(_InterlockedExchangeAdd)
@@ -127,6 +133,7 @@
 #define ATOMIC_SUB(var, val, lck, fcn)	__atomic_fetch_sub(&var, (val), __ATOMIC_SEQ_CST)
 #define ATOMIC_INC(var, lck, fcn)	__atomic_add_fetch(&var, 1, __ATOMIC_SEQ_CST)
 #define ATOMIC_DEC(var, lck, fcn)	__atomic_sub_fetch(&var, 1, __ATOMIC_SEQ_CST)
+#define ATOMIC_CAS(var, old, new, lck, fcn)	__sync_bool_compare_and_swap(&var, (old), (new))
 
 #define ATOMIC_FLAG			char
 #define ATOMIC_FLAG_INIT		{ 0 }
@@ -142,6 +149,7 @@
 #define ATOMIC_SUB(var, val, lck, fcn)	__sync_fetch_and_sub(&var, (val))
 #define ATOMIC_INC(var, lck, fcn)	__sync_add_and_fetch(&var, 1)
 #define ATOMIC_DEC(var, lck, fcn)	__sync_sub_and_fetch(&var, 1)
+#define ATOMIC_CAS(var, old, new, lck, fcn)	__sync_bool_compare_and_swap(&var, (old), (new))
 
 #define ATOMIC_FLAG			int
 #define ATOMIC_FLAG_INIT		{ 0 }
@@ -229,6 +237,20 @@ __ATOMIC_DEC(volatile ATOMIC_TYPE *var, pthread_mutex_t *lck)
 }
 #define ATOMIC_DEC(var, lck, fcn)		__ATOMIC_DEC(&var, &(lck).lock)
 
+static inline int
+__ATOMIC_CAS(volatile ATOMIC_TYPE *var, ATOMIC_TYPE old, ATOMIC_TYPE new, pthread_mutex_t *lck)
+{
+	int ret = 0;
+	pthread_mutex_lock(lck);
+	if (*var == old) {
+		*var = new;
+		ret = 1;
+	}
+	pthread_mutex_unlock(lck);
+	return ret;
+}
+#define ATOMIC_CAS(var, old, new, lck, fcn)	__ATOMIC_CAS(&var, (old), (new), &(lck).lock)
+
 #define USE_PTHREAD_LOCKS	/* must use pthread locks */
 #define ATOMIC_LOCK		/* must use locks for atomic access */
 #define ATOMIC_INIT(lck, fcn)	MT_lock_init(&(lck), fcn)
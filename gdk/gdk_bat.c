@@ -311,6 +311,174 @@ BATnew(int ht, int tt, BUN cap, int role)
 	return bs == NULL ? NULL : &bs->B;
 }
 
+/*
+ * The properties of an attached column are derived while the data is
+ * taken in, in one pass over the values using the native comparison of
+ * the storage type where that is the atom's comparison.  The caller
+ * initializes the properties to true and calls BATattachprops for
+ * consecutive ranges [lo,hi) of the tail; the properties only ever get
+ * downgraded.  Keyness is only known for (reverse) sorted columns.
+ */
+#define ATTACHPROPS(TYPE)						\
+	do {								\
+		const TYPE *v = (const TYPE *) Tloc(b, BUNfirst(b));	\
+		const TYPE nil = * (const TYPE *) ATOMnilptr(b->ttype);	\
+		for (i = lo; i < hi; i++) {				\
+			if (v[i] == nil)				\
+				nils = 1;				\
+			if (i == 0)					\
+				continue;				\
+			if (v[i - 1] < v[i]) {				\
+				if (b->trevsorted) {			\
+					b->trevsorted = 0;		\
+					b->T->norevsorted = BUNfirst(b) + i; \
+				}					\
+			} else if (v[i - 1] > v[i]) {			\
+				if (b->tsorted) {			\
+					b->tsorted = 0;			\
+					b->T->nosorted = BUNfirst(b) + i; \
+				}					\
+			} else if (b->tkey) {				\
+				b->tkey = 0;				\
+				b->T->nokey[0] = BUNfirst(b) + i - 1;	\
+				b->T->nokey[1] = BUNfirst(b) + i;	\
+			}						\
+		}							\
+	} while (0)
+
+static void
+BATattachprops(BAT *b, BUN lo, BUN hi)
+{
+	int tt = b->ttype;
+	int (*cmpf)(const void *, const void *) = ATOMcompare(tt);
+	BUN i;
+	int nils = 0;
+
+	switch (cmpf == ATOMcompare(ATOMstorage(tt)) ? ATOMstorage(tt) : -1) {
+	case TYPE_bte:
+		ATTACHPROPS(bte);
+		break;
+	case TYPE_sht:
+		ATTACHPROPS(sht);
+		break;
+	case TYPE_int:
+		ATTACHPROPS(int);
+		break;
+	case TYPE_lng:
+		ATTACHPROPS(lng);
+		break;
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		ATTACHPROPS(hge);
+		break;
+#endif
+	case TYPE_flt:
+		ATTACHPROPS(flt);
+		break;
+	case TYPE_dbl:
+		ATTACHPROPS(dbl);
+		break;
+	default: {
+		const void *nil = ATOMnilptr(tt);
+		BATiter bi = bat_iterator(b);
+		int c;
+
+		for (i = lo; i < hi; i++) {
+			const void *v = BUNtail(bi, BUNfirst(b) + i);
+
+			if (cmpf(v, nil) == 0)
+				nils = 1;
+			if (i == 0)
+				continue;
+			c = cmpf(BUNtail(bi, BUNfirst(b) + i - 1), v);
+			if (c < 0) {
+				if (b->trevsorted) {
+					b->trevsorted = 0;
+					b->T->norevsorted = BUNfirst(b) + i;
+				}
+			} else if (c > 0) {
+				if (b->tsorted) {
+					b->tsorted = 0;
+					b->T->nosorted = BUNfirst(b) + i;
+				}
+			} else if (b->tkey) {
+				b->tkey = 0;
+				b->T->nokey[0] = BUNfirst(b) + i - 1;
+				b->T->nokey[1] = BUNfirst(b) + i;
+			}
+		}
+		break;
+	}
+	}
+	if (nils) {
+		b->T->nonil = 0;
+		b->T->nil = 1;
+	}
+}
+
+static void
+BATattachinit(BAT *b)
+{
+	b->tsorted = b->trevsorted = 1;
+	b->tkey = 1;
+	b->tdense = 0;
+	b->T->nonil = 1;
+	b->T->nil = 0;
+	b->T->nosorted = b->T->norevsorted = 0;
+	b->T->nokey[0] = b->T->nokey[1] = 0;
+}
+
+static void
+BATattachdone(BAT *b)
+{
+	if (!b->tsorted && !b->trevsorted)
+		b->tkey = 0;
+}
+
+/* the chunk of values that is copied and checked at a time */
+#define ATTACHCHUNK	((BUN) 1 << 16)
+
+/* Take the heapfile in by copying it into a new BAT, computing the
+ * properties as we go while the values are hot in the cache.  Used
+ * when the file cannot be moved into the database. */
+static BAT *
+BATattachcopy(int tt, const char *heapfile, BUN cap, int role)
+{
+	BAT *bn;
+	char *src;
+	int atomsize = ATOMsize(tt);
+	size_t size = (size_t) cap * atomsize;
+	BUN p, q;
+
+	bn = BATnew(TYPE_void, tt, cap, role);
+	if (bn == NULL)
+		return NULL;
+	BATsetcount(bn, cap);
+	BATseqbase(bn, 0);
+	BATattachinit(bn);
+	if (size > 0) {
+		src = MT_mmap(heapfile, MMAP_READ | MMAP_SEQUENTIAL, size);
+		if (src == NULL) {
+			GDKsyserror("BATattach: cannot map heapfile\n");
+			BBPreclaim(bn);
+			return NULL;
+		}
+		for (p = 0; p < cap; p = q) {
+			q = cap - p > ATTACHCHUNK ? p + ATTACHCHUNK : cap;
+			memcpy(Tloc(bn, BUNfirst(bn) + p), src + (size_t) p * atomsize, (size_t) (q - p) * atomsize);
+			BATattachprops(bn, p, q);
+		}
+		MT_munmap(src, size);
+	}
+	BATattachdone(bn);
+	bn->batRestricted = BAT_READ;
+	return bn;
+}
+
+/* Attach a file of raw (native byte order) fixed-size values as a new
+ * BAT.  The file is moved into the database and adopted as the tail
+ * heap without copying; if it cannot be moved (it lives on another file
+ * system or it has other links) or it is empty, it is copied instead. */
 BAT *
 BATattach(int tt, const char *heapfile, int role)
 {
@@ -330,11 +498,12 @@ BATattach(int tt, const char *heapfile, int role)
 		return NULL;
 	}
 	ERRORcheck(!S_ISREG(st.st_mode), "BATattach: heapfile must be a regular file\n", NULL);
-	ERRORcheck(st.st_nlink != 1, "BATattach: heapfile must have only one link\n", NULL);
 	atomsize = ATOMsize(tt);
 	ERRORcheck(st.st_size % atomsize != 0, "BATattach: heapfile size not integral number of atoms\n", NULL);
 	ERRORcheck((size_t) (st.st_size / atomsize) > (size_t) BUN_MAX, "BATattach: heapfile too large\n", NULL);
 	cap = (BUN) (st.st_size / atomsize);
+	if (st.st_nlink != 1 || cap == 0)
+		return BATattachcopy(tt, heapfile, cap, role);
 	bs = BATcreatedesc(TYPE_void, tt, 1, role);
 	if (bs == NULL)
 		return NULL;
@@ -343,23 +512,21 @@ BATattach(int tt, const char *heapfile, int role)
 	path = GDKfilepath(bn->T->heap.farmid, BATDIR, bn->T->heap.filename, "new");
 	GDKcreatedir(path);
 	if (rename(heapfile, path) < 0) {
-		GDKsyserror("BATattach: cannot rename heapfile\n");
+		int err = errno;
+
 		GDKfree(path);
 		HEAPfree(&bn->T->heap, 1);
 		GDKfree(bs);
+		if (err == EXDEV)
+			return BATattachcopy(tt, heapfile, cap, role);
+		errno = err;
+		GDKsyserror("BATattach: cannot rename heapfile\n");
 		return NULL;
 	}
 	GDKfree(path);
-	bn->hseqbase = 0;
-	BATkey(bn, TRUE);
 	BATsetcapacity(bn, cap);
 	BATsetcount(bn, cap);
-	if (cap > 1) {
-		bn->tsorted = 0;
-		bn->trevsorted = 0;
-		bn->tdense = 0;
-		bn->tkey = 0;
-	}
+	BATseqbase(bn, 0);
 	bn->batRestricted = BAT_READ;
 	bn->T->heap.size = (size_t) st.st_size;
 	bn->T->heap.newstorage = bn->T->heap.storage = (bn->T->heap.size < GDK_mmap_minsize) ? STORE_MEM : STORE_MMAP;
@@ -368,6 +535,9 @@ BATattach(int tt, const char *heapfile, int role)
 		GDKfree(bs);
 		return NULL;
 	}
+	BATattachinit(bn);
+	BATattachprops(bn, 0, cap);
+	BATattachdone(bn);
 	BBPcacheit(bs, 1);
 	return bn;
 }
@@ -473,6 +643,7 @@ BATextend(BAT *b, BUN newcap)
 		return GDK_FAIL;
 	HASHdestroy(b);
 	IMPSdestroy(b);
+	CMPdestroy(b);
 	return GDK_SUCCEED;
 }
 
@@ -516,6 +687,8 @@ BATclear(BAT *b, int force)
 	/* kill all search accelerators */
 	HASHdestroy(b);
 	IMPSdestroy(b);
+	CMPdestroy(b);
+	ZMAPdestroy(b);
 
 	/* we must dispose of all inserted atoms */
 	if ((b->batDeleted == b->batInserted || force) &&
@@ -616,6 +789,8 @@ BATfree(BAT *b)
 	b->T->props = NULL;
 	HASHdestroy(b);
 	IMPSdestroy(b);
+	CMPfree(b);
+	ZMAPdestroy(b);
 	if (b->htype)
 		HEAPfree(&b->H->heap, 0);
 	else
@@ -1229,6 +1404,7 @@ BUNins(BAT *b, const void *h, const void *t, bit force)
 		}
 	}
 	IMPSdestroy(b); /* no support for inserts in imprints yet */
+	CMPdestroy(b);
 	return GDK_SUCCEED;
       bunins_failed:
 	return GDK_FAIL;
@@ -1322,6 +1498,7 @@ BUNappend(BAT *b, const void *t, bit force)
 
 
 	IMPSdestroy(b); /* no support for inserts in imprints yet */
+	CMPdestroy(b);
 
 	/* first adapt the hashes; then the user-defined accelerators.
 	 * REASON: some accelerator updates (qsignature) use the hashes!
@@ -1500,6 +1677,8 @@ BUNdelete_(BAT *b, BUN p, bit force)
 	b->batCount--;
 	b->batDirty = 1;	/* bat is dirty */
 	IMPSdestroy(b); /* no support for inserts in imprints yet */
+	CMPdestroy(b);
+	ZMAPdestroy(b);
 	return p;
 }
 
@@ -1601,6 +1780,8 @@ BUNinplace(BAT *b, BUN p, const void *h, const void *t, bit force)
 			b->T->nil = 0;
 		}
 		HASHremove(b);
+		CMPdestroy(b);
+		ZMAPdestroy(b);
 		Treplacevalue(b, BUNtloc(bi, p), t);
 
 		tt = b->ttype;
@@ -1716,6 +1897,7 @@ void_replace_bat(BAT *b, BAT *p, BAT *u, bit force)
 	BATiter uii = bat_iterator(p);
 	BATiter uvi = bat_iterator(u);
 
+	CMPdestroy(b);
 	BATloop(u, r, s) {
 		oid updid = *(oid *) BUNtail(uii, r);
 		const void *val = BUNtail(uvi, r);
@@ -2631,6 +2813,13 @@ BATsetaccess(BAT *b, int newmode)
 		    m2 == STORE_INVALID || m3 == STORE_INVALID)
 			return GDK_FAIL;
 
+		/* compressed copies are only valid as long as the
+		 * column can't change; drop them (also the ones on
+		 * disk that were not loaded) while the column is
+		 * still read-only */
+		if (bakmode == BAT_READ && newmode != BAT_READ)
+			CMPdestroy(b);
+
 		/* set new access mode and mmap modes */
 		b->batRestricted = newmode;
 		b->batDirtydesc = TRUE;
@@ -694,6 +694,7 @@ BATappend(BAT *b, BAT *n, bit force)
 	}
 
 	IMPSdestroy(b);		/* imprints do not support updates yet */
+	CMPdestroy(b);
 	/* a hash is useless for void bats */
 	if (b->H->hash)
 		HASHremove(BATmirror(b));
@@ -1098,6 +1099,215 @@ BATordered_rev(BAT *b)
 	return b->hrevsorted;
 }
 
+/* LSD radix sort for the fixed-width numeric types.  The values are
+ * mapped onto unsigned keys that sort in the same order as the
+ * values, with nil (the smallest value of each type) first.  Sorting
+ * is done RADIX_BITS bits at a time, from the least significant
+ * digit up, and passes in which all keys have the same digit are
+ * skipped.  Each pass is stable, so the sort as a whole is stable
+ * and can be used for both stable and unstable sorts.  Large inputs
+ * are split over multiple threads: each thread counts the digits of
+ * its part, and then scatters its part to the offsets computed from
+ * the counts of all parts. */
+#define RADIX_BITS	8
+#define RADIX_BUCKETS	(1 << RADIX_BITS)
+#define RADIX_MINSIZE	((size_t) 1 << 14) /* smaller inputs are quicksorted */
+#define RADIX_PARALLEL	((size_t) 1 << 20) /* minimum number of values per thread */
+
+struct radixsort {
+	const char *src;	/* values to be distributed */
+	char *dst;
+	const char *tsrc;	/* values carried along, or NULL */
+	char *tdst;
+	size_t lo, hi;		/* the part of this thread */
+	size_t *cnt;		/* RADIX_BUCKETS counters/offsets */
+	int width, ts;
+	int tpe;		/* base type of the values */
+	int reverse;
+	int shift;		/* digit to distribute on */
+	int phase;		/* 0: count digits, 1: scatter */
+};
+
+static inline ulng
+radix_key(const char *v, int tpe, int reverse)
+{
+	ulng k;
+
+	switch (tpe) {
+	case TYPE_int:
+		k = (unsigned int) * (const int *) v ^ 0x80000000U;
+		return reverse ? ~k & 0xFFFFFFFFU : k;
+	case TYPE_flt: {
+		flt f = * (const flt *) v;
+		unsigned int u;
+
+		if (f == 0)
+			f = 0;	/* -0 sorts equal to +0 */
+		memcpy(&u, &f, sizeof(u));
+		u = u & 0x80000000U ? ~u : u | 0x80000000U;
+		return reverse ? ~u : u;
+	}
+	case TYPE_lng:
+		k = (ulng) * (const lng *) v ^ ((ulng) 1 << 63);
+		return reverse ? ~k : k;
+	case TYPE_dbl: {
+		dbl d = * (const dbl *) v;
+
+		if (d == 0)
+			d = 0;
+		memcpy(&k, &d, sizeof(k));
+		k = k & ((ulng) 1 << 63) ? ~k : k | ((ulng) 1 << 63);
+		return reverse ? ~k : k;
+	}
+	default:
+		assert(0);
+		return 0;
+	}
+}
+
+static inline void
+radix_move(char *dst, size_t d, const char *src, size_t i, int width)
+{
+	if (width == 4)
+		((int *) dst)[d] = ((const int *) src)[i];
+	else
+		((lng *) dst)[d] = ((const lng *) src)[i];
+}
+
+static void
+radixpart(void *arg)
+{
+	struct radixsort *rs = arg;
+	size_t i, *cnt = rs->cnt;
+	int shift = rs->shift;
+
+	if (rs->phase == 0) {
+		memset(cnt, 0, RADIX_BUCKETS * sizeof(size_t));
+		for (i = rs->lo; i < rs->hi; i++)
+			cnt[(radix_key(rs->src + i * rs->width, rs->tpe, rs->reverse) >> shift) & (RADIX_BUCKETS - 1)]++;
+		return;
+	}
+	for (i = rs->lo; i < rs->hi; i++) {
+		size_t d = cnt[(radix_key(rs->src + i * rs->width, rs->tpe, rs->reverse) >> shift) & (RADIX_BUCKETS - 1)]++;
+
+		radix_move(rs->dst, d, rs->src, i, rs->width);
+		if (rs->tsrc)
+			radix_move(rs->tdst, d, rs->tsrc, i, rs->ts);
+	}
+}
+
+/* run one phase of the radix sort in all parts */
+static void
+radixphase(struct radixsort *rs, MT_Id *tids, int nthreads, int phase)
+{
+	int i;
+
+	for (i = 0; i < nthreads; i++)
+		rs[i].phase = phase;
+	/* the calling thread takes care of the first part */
+	for (i = 1; i < nthreads; i++) {
+		if (MT_create_thread(&tids[i], radixpart, &rs[i],
+				     MT_THR_JOINABLE) < 0) {
+			/* couldn't create thread, do the work ourselves */
+			tids[i] = 0;
+			radixpart(&rs[i]);
+		}
+	}
+	radixpart(&rs[0]);
+	for (i = 1; i < nthreads; i++)
+		if (tids[i])
+			MT_join_thread(tids[i]);
+}
+
+/* radix sort h and carry t along; returns GDK_FAIL without touching
+ * the data if the radix sort cannot be used */
+static gdk_return
+do_radixsort(void *h, void *t, size_t n, int hs, int ts, int tpe, int reverse)
+{
+	int nthreads, i, shift, b, swapped = 0;
+	char *hbuf = NULL, *tbuf = NULL;
+	size_t *cnt = NULL, sum, c;
+	struct radixsort *rs = NULL;
+	MT_Id *tids = NULL;
+	lng t0 = 0;
+
+	/* types that are stored, compared and nil-ed like int or lng
+	 * sort like them; this includes oid, whose nil (the smallest
+	 * lng or int value) sorts first, as with lngCmp/intCmp */
+	tpe = ATOMbasetype(tpe);
+	if ((tpe != TYPE_int && tpe != TYPE_lng &&
+	     tpe != TYPE_flt && tpe != TYPE_dbl) ||
+	    hs != ATOMsize(tpe) ||
+	    (t != NULL && ts != 4 && ts != 8))
+		return GDK_FAIL;
+
+	ALGODEBUG t0 = GDKusec();
+	nthreads = GDKnr_threads > 1 ? GDKnr_threads : 1;
+	if ((size_t) nthreads > n / RADIX_PARALLEL)
+		nthreads = (int) (n / RADIX_PARALLEL) > 0 ? (int) (n / RADIX_PARALLEL) : 1;
+	if ((hbuf = GDKmalloc(n * hs)) == NULL ||
+	    (t && (tbuf = GDKmalloc(n * ts)) == NULL) ||
+	    (cnt = GDKmalloc(nthreads * RADIX_BUCKETS * sizeof(size_t))) == NULL ||
+	    (rs = GDKmalloc(nthreads * sizeof(struct radixsort))) == NULL ||
+	    (tids = GDKmalloc(nthreads * sizeof(MT_Id))) == NULL) {
+		GDKfree(hbuf);
+		GDKfree(tbuf);
+		GDKfree(cnt);
+		GDKfree(rs);
+		GDKfree(tids);
+		/* fall back to the comparison based sorts */
+		return GDK_FAIL;
+	}
+	for (i = 0; i < nthreads; i++) {
+		rs[i].lo = n / nthreads * i;
+		rs[i].hi = i == nthreads - 1 ? n : n / nthreads * (i + 1);
+		rs[i].cnt = cnt + i * RADIX_BUCKETS;
+		rs[i].width = hs;
+		rs[i].ts = ts;
+		rs[i].tpe = tpe;
+		rs[i].reverse = reverse;
+	}
+	for (shift = 0; shift < hs * 8; shift += RADIX_BITS) {
+		for (i = 0; i < nthreads; i++) {
+			rs[i].src = swapped ? hbuf : h;
+			rs[i].dst = swapped ? h : hbuf;
+			rs[i].tsrc = t ? swapped ? tbuf : t : NULL;
+			rs[i].tdst = t ? swapped ? t : tbuf : NULL;
+			rs[i].shift = shift;
+		}
+		radixphase(rs, tids, nthreads, 0);
+		/* turn counts into offsets, in the order bucket,
+		 * part; skip the pass if all values fall in a
+		 * single bucket */
+		for (b = 0, sum = 0; b < RADIX_BUCKETS; b++) {
+			for (i = 0; i < nthreads; i++) {
+				c = cnt[i * RADIX_BUCKETS + b];
+				cnt[i * RADIX_BUCKETS + b] = sum;
+				sum += c;
+			}
+			if (cnt[b] == 0 && sum == n)
+				break;
+		}
+		if (b < RADIX_BUCKETS)
+			continue;
+		radixphase(rs, tids, nthreads, 1);
+		swapped = !swapped;
+	}
+	if (swapped) {
+		memcpy(h, hbuf, n * hs);
+		if (t)
+			memcpy(t, tbuf, n * ts);
+	}
+	GDKfree(hbuf);
+	GDKfree(tbuf);
+	GDKfree(cnt);
+	GDKfree(rs);
+	GDKfree(tids);
+	ALGODEBUG fprintf(stderr, "#do_radixsort(n=" SZFMT ",tpe=%s,reverse=%d): %d threads (" LLFMT " usec)\n",
+			  n, ATOMname(tpe), reverse, nthreads, GDKusec() - t0);
+	return GDK_SUCCEED;
+}
+
 /* figure out which sort function is to be called
  * stable sort can produce an error (not enough memory available),
  * "quick" sort does not produce errors */
@@ -1107,6 +1317,10 @@ do_sort(void *h, void *t, const void *base, size_t n, int hs, int ts, int tpe,
 {
 	if (n <= 1)		/* trivially sorted */
 		return GDK_SUCCEED;
+	/* the radix sort is stable, so it can always be used */
+	if (base == NULL && n >= RADIX_MINSIZE &&
+	    do_radixsort(h, t, n, hs, ts, tpe, reverse) == GDK_SUCCEED)
+		return GDK_SUCCEED;
 	if (reverse) {
 		if (stable) {
 			if (GDKssort_rev(h, t, base, n, hs, ts, tpe) < 0) {
@@ -1127,6 +1341,183 @@ do_sort(void *h, void *t, const void *base, size_t n, int hs, int ts, int tpe,
 	return GDK_SUCCEED;
 }
 
+/* External sort.  If the data to be sorted does not comfortably fit
+ * in memory, sorting it in one go results in random I/O all over the
+ * (memory mapped) heaps.  Instead, we sort runs that fit in a fraction
+ * of the memory in place, and then merge the runs with a loser tree
+ * into temporary heaps, which are written sequentially, and which are
+ * backed by files in the farm if they are large.  The result is copied
+ * back into the original heaps.  Ties are broken on the run number, so
+ * that the merge is stable if the runs were sorted stably. */
+#define EXTSORT_TRIGGER	2	/* sort externally if more than 1/2 of memory needed */
+#define EXTSORT_RUN	8	/* each run uses at most 1/8 of memory */
+#define EXTSORT_MINRUN	((BUN) 1 << 16)	/* but don't make runs too small */
+
+static inline size_t
+extsort_footprint(BAT *bn, BAT *on)
+{
+	return (size_t) BATcount(bn) * (Tsize(bn) + (on ? Tsize(on) : 0)) +
+		(bn->T->vheap ? bn->T->vheap->free : 0);
+}
+
+struct extsort {
+	const char *vals;	/* tail of the values */
+	const char *base;	/* var heap, or NULL */
+	int width;
+	int reverse;
+	int (*cmp)(const void *, const void *);
+	BUN *cur, *end;		/* cursors of the runs */
+};
+
+#define extsort_val(es, p)						\
+	((es)->base ?							\
+	 (const void *) ((es)->base + VarHeapVal((es)->vals, (p), (es)->width)) : \
+	 (const void *) ((es)->vals + (p) * (es)->width))
+
+/* does run a deliver its next value before run b? */
+static inline int
+extsort_before(const struct extsort *es, int a, int b)
+{
+	int c;
+
+	if (es->cur[a] == es->end[a])
+		return 0;
+	if (es->cur[b] == es->end[b])
+		return 1;
+	c = es->cmp(extsort_val(es, es->cur[a]), extsort_val(es, es->cur[b]));
+	if (es->reverse)
+		c = -c;
+	return c < 0 || (c == 0 && a < b);
+}
+
+static gdk_return
+do_extsort(BAT *bn, BAT *on, int reverse, int stable)
+{
+	BUN n = BATcount(bn), runsize, p;
+	int tw = Tsize(bn), ow = on ? Tsize(on) : 0;
+	int nruns, i, w, t;
+	char *vals = Tloc(bn, BUNfirst(bn));
+	char *ords = on ? Tloc(on, BUNfirst(on)) : NULL;
+	const char *nme = BBP_physical(bn->batCacheid);
+	int *tree = NULL, *win = NULL;
+	BUN *cur = NULL, *end = NULL;
+	Heap th, oh;
+	struct extsort es;
+	lng t0 = 0;
+
+	ALGODEBUG t0 = GDKusec();
+	runsize = (BUN) (GDK_mem_maxsize / EXTSORT_RUN / (tw + ow));
+	if (runsize < EXTSORT_MINRUN)
+		runsize = EXTSORT_MINRUN;
+	if (runsize >= n)
+		return do_sort(vals, ords,
+			       bn->T->vheap ? bn->T->vheap->base : NULL,
+			       n, tw, ow, bn->ttype, reverse, stable);
+	nruns = (int) ((n + runsize - 1) / runsize);
+
+	memset(&th, 0, sizeof(th));
+	memset(&oh, 0, sizeof(oh));
+	if ((tree = GDKmalloc(nruns * sizeof(int))) == NULL ||
+	    (win = GDKmalloc(nruns * sizeof(int))) == NULL ||
+	    (cur = GDKmalloc(nruns * sizeof(BUN))) == NULL ||
+	    (end = GDKmalloc(nruns * sizeof(BUN))) == NULL)
+		goto bailout;
+
+	/* create the sorted runs */
+	for (i = 0; i < nruns; i++) {
+		cur[i] = (BUN) i * runsize;
+		end[i] = cur[i] + runsize < n ? cur[i] + runsize : n;
+		if (do_sort(vals + cur[i] * tw,
+			    ords ? ords + cur[i] * ow : NULL,
+			    bn->T->vheap ? bn->T->vheap->base : NULL,
+			    end[i] - cur[i], tw, ow, bn->ttype,
+			    reverse, stable) != GDK_SUCCEED)
+			goto bailout;
+	}
+
+	/* the merge targets; large ones are spilled to the farm */
+	th.farmid = BBPselectfarm(TRANSIENT, bn->ttype, offheap);
+	if ((th.filename = GDKmalloc(strlen(nme) + 12)) == NULL)
+		goto bailout;
+	sprintf(th.filename, "%s.tsort", nme);
+	if (HEAPalloc(&th, n, tw) != GDK_SUCCEED)
+		goto bailout;
+	if (on) {
+		oh.farmid = BBPselectfarm(TRANSIENT, TYPE_oid, offheap);
+		if ((oh.filename = GDKmalloc(strlen(nme) + 12)) == NULL)
+			goto bailout;
+		sprintf(oh.filename, "%s.osort", nme);
+		if (HEAPalloc(&oh, n, ow) != GDK_SUCCEED)
+			goto bailout;
+	}
+
+	es.vals = vals;
+	es.base = bn->T->vheap ? bn->T->vheap->base : NULL;
+	es.width = tw;
+	es.reverse = reverse;
+	es.cmp = ATOMcompare(bn->ttype);
+	es.cur = cur;
+	es.end = end;
+
+	/* build the loser tree: the runs are the leaves nruns..2*nruns-1,
+	 * tree[t] is the loser of the match at node t, win[t] the
+	 * winner, tree[0] the overall winner */
+	for (t = nruns - 1; t > 0; t--) {
+		int l = 2 * t < nruns ? win[2 * t] : 2 * t - nruns;
+		int r = 2 * t + 1 < nruns ? win[2 * t + 1] : 2 * t + 1 - nruns;
+
+		if (extsort_before(&es, r, l)) {
+			win[t] = r;
+			tree[t] = l;
+		} else {
+			win[t] = l;
+			tree[t] = r;
+		}
+	}
+	tree[0] = nruns > 1 ? win[1] : 0;
+
+	for (p = 0; p < n; p++) {
+		w = tree[0];
+		assert(cur[w] < end[w]);
+		memcpy(th.base + p * tw, vals + cur[w] * tw, tw);
+		if (on)
+			memcpy(oh.base + p * ow, ords + cur[w] * ow, ow);
+		cur[w]++;
+		/* replay the matches on the path from the leaf to the root */
+		for (t = (w + nruns) / 2; t > 0; t /= 2) {
+			if (extsort_before(&es, tree[t], w)) {
+				i = tree[t];
+				tree[t] = w;
+				w = i;
+			}
+		}
+		tree[0] = w;
+	}
+
+	memcpy(vals, th.base, (size_t) n * tw);
+	if (on)
+		memcpy(ords, oh.base, (size_t) n * ow);
+	HEAPfree(&th, 1);
+	HEAPfree(&oh, 1);
+	GDKfree(tree);
+	GDKfree(win);
+	GDKfree(cur);
+	GDKfree(end);
+	ALGODEBUG fprintf(stderr, "#BATsubsort(b=%s#" BUNFMT ",reverse=%d,stable=%d): external sort with %d runs of " BUNFMT " (" LLFMT " usec)\n",
+			  BATgetId(bn), n, reverse, stable, nruns, runsize,
+			  GDKusec() - t0);
+	return GDK_SUCCEED;
+
+  bailout:
+	HEAPfree(&th, 1);
+	HEAPfree(&oh, 1);
+	GDKfree(tree);
+	GDKfree(win);
+	GDKfree(cur);
+	GDKfree(end);
+	return GDK_FAIL;
+}
+
 /* Sort b according to stable and reverse, do it in-place if copy is
  * unset, otherwise do it on a copy */
 static BAT *
@@ -1186,6 +1577,8 @@ BATorder_internal(BAT *b, int stable, int reverse, int copy, const char *func)
 	b->tsorted = b->trevsorted = 0;
 	HASHdestroy(b);
 	IMPSdestroy(b);
+	CMPdestroy(b);
+	ZMAPdestroy(b);
 	ALIGNdel(b, func, FALSE, NULL);
 	b->hdense = 0;
 	b->tdense = 0;
@@ -1466,11 +1859,13 @@ BATsubsort(BAT **sorted, BAT **order, BAT **groups,
 			b->tsorted = b->trevsorted = 1;
 		}
 		if (!(reverse ? bn->trevsorted : bn->tsorted) &&
-		    do_sort(Tloc(bn, BUNfirst(bn)),
-			    on ? Tloc(on, BUNfirst(on)) : NULL,
-			    bn->T->vheap ? bn->T->vheap->base : NULL,
-			    BATcount(bn), Tsize(bn), on ? Tsize(on) : 0,
-			    bn->ttype, reverse, stable) != GDK_SUCCEED)
+		    (extsort_footprint(bn, on) > GDK_mem_maxsize / EXTSORT_TRIGGER ?
+		     do_extsort(bn, on, reverse, stable) :
+		     do_sort(Tloc(bn, BUNfirst(bn)),
+			     on ? Tloc(on, BUNfirst(on)) : NULL,
+			     bn->T->vheap ? bn->T->vheap->base : NULL,
+			     BATcount(bn), Tsize(bn), on ? Tsize(on) : 0,
+			     bn->ttype, reverse, stable)) != GDK_SUCCEED)
 			goto error;
 		bn->tsorted = !reverse;
 		bn->trevsorted = reverse;
@@ -1560,6 +1955,8 @@ BATrevert(BAT *b)
 	}
 	HASHdestroy(b);
 	IMPSdestroy(b);
+	CMPdestroy(b);
+	ZMAPdestroy(b);
 	/* interchange sorted and revsorted */
 	x = b->hrevsorted;
 	b->hrevsorted = b->hsorted;
@@ -122,6 +122,13 @@ gdk_export BAT *BATgroupmax(BAT *b, BAT *g, BAT *e, BAT *s, int tp, int skip_nil
 gdk_export BAT *BATgroupmedian(BAT *b, BAT *g, BAT *e, BAT *s, int tp, int skip_nils, int abort_on_error);
 gdk_export BAT *BATgroupquantile(BAT *b, BAT *g, BAT *e, BAT *s, int tp, double quantile, int skip_nils, int abort_on_error);
 
+/* aggregates for BATgroupaggrmulti */
+#define GDK_AGGR_COUNT	1
+#define GDK_AGGR_SUM	2
+#define GDK_AGGR_MIN	3
+#define GDK_AGGR_MAX	4
+gdk_export gdk_return BATgroupaggrmulti(BAT **res, int naggr, BAT **bs, const int *ops, const int *tps, const int *skip_nils, BAT *g, BAT *e, BAT *s, int abort_on_error);
+
 /* helper function for grouped aggregates */
 gdk_export const char *BATgroupaggrinit(
 	BAT *b, BAT *g, BAT *e, BAT *s,
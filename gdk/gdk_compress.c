@@ -0,0 +1,1234 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2008-2015 MonetDB B.V.
+ */
+
+/*
+ * Lightweight column compression.
+ *
+ * A column of a fixed-size integer type (or of a type that is stored
+ * as one and compares like one, such as date and timestamp) can carry
+ * a compressed copy of its values next to its tail heap.  The copy is
+ * managed like the column imprints: it is created by BATcompress,
+ * persisted in a "tcompress" heap, and destroyed whenever the column
+ * changes.  Since a copy is only made of a read-only column, the file
+ * is also removed (loaded or not) when the column is made writable
+ * again or is changed in place, so a persisted copy always matches
+ * the tail.  Three encodings are considered and the smallest is used,
+ * provided it is at most half the size of the tail:
+ *
+ * CMP_FOR	frame of reference: code value - min + 1, bit packed;
+ * CMP_DICT	sorted dictionary of the distinct values: code index + 1
+ *		into the dictionary, bit packed;
+ * CMP_RLE	run-length encoding: value and end position of each run.
+ *
+ * In the bit packed encodings code 0 stands for nil.  Codes are 1, 2,
+ * 4, 8, 16 or 32 bits wide and never straddle a 64-bit word.  Since
+ * both code mappings are order preserving, a range predicate on the
+ * values translates into a range predicate on the codes.
+ *
+ * String columns only get a dictionary: the entries are offsets into
+ * the string heap, sorted on the strings they point to, so that the
+ * codes are dense and compare like the strings do.  Since the column
+ * doesn't change, the heap offsets stay valid.  Such a copy is kept if
+ * it is not larger than the tail, since the gain is mostly in not
+ * having to look at the strings at all.
+ *
+ * Range selections, projections and min/max work directly on the
+ * compressed copy, so that the (typically memory mapped) tail heap of
+ * a large persistent column does not need to be brought in for them.
+ * Grouping on a dictionary encoded column uses the codes.  Everything
+ * else keeps using the tail.
+ */
+
+#include "monetdb_config.h"
+#include "gdk.h"
+#include "gdk_private.h"
+
+#define COMPRESS_VERSION	1
+#define COMPRESS_HEADER_SIZE	8 /* nr of size_t fields in header */
+#define COMPRESS_OFFSET		(COMPRESS_HEADER_SIZE * SIZEOF_SIZE_T + 2 * SIZEOF_LNG)
+
+#define CMP_MINCOUNT	1024		/* don't bother for smaller columns */
+#define CMP_DICTMAX	((BUN) 1 << 16)	/* maximum dictionary size */
+
+#define CMPcode(c, i)							\
+	((unsigned int) ((c)->codes[(i) >> (c)->lgper] >>		\
+			 (((i) & (c)->permask) << (c)->lgbits)) & (c)->mask)
+
+/* the value stored at position i of a tail of storage type tpe */
+static inline lng
+cmp_value(const void *vals, int tpe, BUN i)
+{
+	switch (tpe) {
+	case TYPE_bte:
+		return ((const bte *) vals)[i];
+	case TYPE_sht:
+		return ((const sht *) vals)[i];
+	case TYPE_int:
+		return ((const int *) vals)[i];
+	default:
+		return ((const lng *) vals)[i];
+	}
+}
+
+static lng
+cmp_nil(int tpe)
+{
+	switch (tpe) {
+	case TYPE_bte:
+		return bte_nil;
+	case TYPE_sht:
+		return sht_nil;
+	case TYPE_int:
+		return int_nil;
+	default:
+		return lng_nil;
+	}
+}
+
+/* the storage type used for compressing b, or -1 if b's type cannot
+ * be compressed */
+static int
+cmp_type(BAT *b)
+{
+	int tt = b->ttype, st = ATOMstorage(tt);
+
+	switch (st) {
+	case TYPE_bte:
+	case TYPE_sht:
+	case TYPE_int:
+	case TYPE_lng:
+		break;
+	case TYPE_str:
+		return tt == TYPE_str ? TYPE_str : -1;
+	default:
+		return -1;
+	}
+	if (tt != st &&
+	    (ATOMcompare(tt) != ATOMcompare(st) ||
+	     memcmp(ATOMnilptr(tt), ATOMnilptr(st), ATOMsize(st)) != 0))
+		return -1;
+	return st;
+}
+
+/* smallest of 1, 2, 4, 8, 16, 32 bits that can hold codes 0..n;
+ * returns 0 if n does not fit in 32 bits */
+static int
+cmp_bits(ulng n)
+{
+	int bits = 1;
+
+	while (bits <= 32 && (n >> bits) != 0)
+		bits <<= 1;
+	return bits <= 32 ? bits : 0;
+}
+
+static int
+cmp_log2(int bits)
+{
+	int lg = 0;
+
+	while ((1 << lg) < bits)
+		lg++;
+	return lg;
+}
+
+static size_t
+cmp_codesize(BUN cnt, int bits)
+{
+	BUN per = 64 / bits;
+
+	return (size_t) ((cnt + per - 1) / per) * sizeof(ulng);
+}
+
+/* set up the pointers into the heap from the header */
+static void
+cmp_init(Compress *c)
+{
+	size_t *hdr = (size_t *) c->heap->base;
+	char *data = c->heap->base + COMPRESS_OFFSET;
+
+	c->method = (int) (hdr[0] & 0xFF);
+	c->cnt = (BUN) hdr[1];
+	c->bits = (int) hdr[2];
+	c->n = (BUN) hdr[3];
+	c->nils = (BUN) hdr[4];
+	c->min = ((lng *) (hdr + COMPRESS_HEADER_SIZE))[0];
+	c->max = ((lng *) (hdr + COMPRESS_HEADER_SIZE))[1];
+	c->vals = NULL;
+	c->ends = NULL;
+	c->codes = NULL;
+	switch (c->method) {
+	case CMP_FOR:
+		c->codes = (const ulng *) data;
+		break;
+	case CMP_DICT:
+		c->vals = (const lng *) data;
+		c->codes = (const ulng *) (c->vals + c->n);
+		break;
+	case CMP_RLE:
+		c->vals = (const lng *) data;
+		c->ends = (const BUN *) (c->vals + c->n);
+		break;
+	}
+	if (c->codes) {
+		c->lgbits = cmp_log2(c->bits);
+		c->lgper = 6 - c->lgbits;
+		c->permask = ((BUN) 1 << c->lgper) - 1;
+		c->mask = c->bits == 32 ? ~0U : (1U << c->bits) - 1;
+	}
+}
+
+static size_t
+cmp_heapsize(int method, BUN cnt, int bits, BUN n)
+{
+	switch (method) {
+	case CMP_FOR:
+		return COMPRESS_OFFSET + cmp_codesize(cnt, bits);
+	case CMP_DICT:
+		return COMPRESS_OFFSET + (size_t) n * sizeof(lng) + cmp_codesize(cnt, bits);
+	default:
+		return COMPRESS_OFFSET + (size_t) n * (sizeof(lng) + sizeof(BUN));
+	}
+}
+
+/* Check whether we have a compressed copy of b (and return true if we
+ * do).  It may be that the copy was made persistent, but we hadn't
+ * seen that yet, so check the file system.  This also returns true if
+ * b is a view and there is a compressed copy of b's parent. */
+int
+BATcheckcompress(BAT *b)
+{
+	int ret;
+
+	if (VIEWtparent(b)) {
+		assert(b->T->compress == NULL);
+		b = BBPdescriptor(-VIEWtparent(b));
+	}
+
+	MT_lock_set(&GDKcompressLock(abs(b->batCacheid)), "BATcheckcompress");
+	if (b->T->compress == NULL && cmp_type(b) >= 0 &&
+	    b->batRestricted == BAT_READ) {
+		Compress *c;
+		Heap *hp;
+		str nme = BBP_physical(b->batCacheid);
+		const char *ext = b->batCacheid > 0 ? "tcompress" : "hcompress";
+
+		if ((hp = GDKzalloc(sizeof(Heap))) != NULL &&
+		    (hp->farmid = BBPselectfarm(b->batRole, b->ttype, compressheap)) >= 0 &&
+		    (hp->filename = GDKmalloc(strlen(nme) + 12)) != NULL) {
+			int fd;
+
+			sprintf(hp->filename, "%s.%s", nme, ext);
+			/* check whether a persisted compressed copy
+			 * can be found */
+			if ((fd = GDKfdlocate(hp->farmid, nme, "rb", ext)) >= 0) {
+				size_t hdata[COMPRESS_HEADER_SIZE];
+				struct stat st;
+
+				if ((c = GDKzalloc(sizeof(Compress))) != NULL &&
+				    read(fd, hdata, sizeof(hdata)) == sizeof(hdata) &&
+				    hdata[0] & ((size_t) 1 << 16) &&
+				    ((hdata[0] & 0xFF00) >> 8) == COMPRESS_VERSION &&
+				    hdata[1] == (size_t) BATcount(b) &&
+				    fstat(fd, &st) == 0 &&
+				    st.st_size >= (off_t) (hp->size =
+							   hp->free =
+							   cmp_heapsize((int) (hdata[0] & 0xFF), (BUN) hdata[1], (int) hdata[2], (BUN) hdata[3])) &&
+				    HEAPload(hp, nme, ext, 0) == GDK_SUCCEED) {
+					/* usable */
+					c->heap = hp;
+					cmp_init(c);
+					close(fd);
+					b->T->compress = c;
+					ALGODEBUG fprintf(stderr, "#BATcheckcompress: reusing persisted compressed copy %d\n", b->batCacheid);
+					MT_lock_unset(&GDKcompressLock(abs(b->batCacheid)), "BATcheckcompress");
+					return 1;
+				}
+				GDKfree(c);
+				close(fd);
+				/* unlink unusable file */
+				GDKunlink(hp->farmid, BATDIR, nme, ext);
+			}
+			GDKfree(hp->filename);
+		}
+		GDKfree(hp);
+	}
+	ret = b->T->compress != NULL;
+	MT_lock_unset(&GDKcompressLock(abs(b->batCacheid)), "BATcheckcompress");
+	return ret;
+}
+
+/* The distinct non-nil values of b, sorted, in *dict; returns the
+ * number of values, or BUN_NONE if there are more than CMP_DICTMAX. */
+static BUN
+cmp_distinct(BAT *b, int tpe, lng nil, lng **dict)
+{
+	const void *vals = Tloc(b, BUNfirst(b));
+	BUN cnt = BATcount(b), i, n = 0;
+	size_t mask = 2 * CMP_DICTMAX - 1, h;
+	lng *tab, *d;
+	bit *used;
+
+	*dict = NULL;
+	tab = GDKmalloc((mask + 1) * sizeof(lng));
+	used = GDKzalloc((mask + 1) * sizeof(bit));
+	if (tab == NULL || used == NULL) {
+		GDKfree(tab);
+		GDKfree(used);
+		return BUN_NONE;
+	}
+	for (i = 0; i < cnt; i++) {
+		lng v = cmp_value(vals, tpe, i);
+
+		if (v == nil)
+			continue;
+		for (h = (size_t) (((ulng) v * 0x9E3779B97F4A7C15ULL) >> 40) & mask;
+		     used[h] && tab[h] != v;
+		     h = (h + 1) & mask)
+			;
+		if (!used[h]) {
+			if (n == CMP_DICTMAX) {
+				n = BUN_NONE;
+				break;
+			}
+			used[h] = 1;
+			tab[h] = v;
+			n++;
+		}
+	}
+	if (n != BUN_NONE && (d = GDKmalloc((n + 1) * sizeof(lng))) != NULL) {
+		BUN k = 0;
+
+		for (h = 0; h <= mask; h++)
+			if (used[h])
+				d[k++] = tab[h];
+		assert(k == n);
+		GDKqsort(d, NULL, NULL, (size_t) n, sizeof(lng), 0, TYPE_lng);
+		*dict = d;
+	} else {
+		n = BUN_NONE;
+	}
+	GDKfree(tab);
+	GDKfree(used);
+	return n;
+}
+
+/* index of the first dictionary entry >= v */
+static BUN
+cmp_lower(const lng *dict, BUN n, lng v)
+{
+	BUN lo = 0, hi = n;
+
+	while (lo < hi) {
+		BUN m = (lo + hi) / 2;
+
+		if (dict[m] < v)
+			lo = m + 1;
+		else
+			hi = m;
+	}
+	return lo;
+}
+
+/* index of the first dictionary entry > v */
+static BUN
+cmp_upper(const lng *dict, BUN n, lng v)
+{
+	BUN lo = 0, hi = n;
+
+	while (lo < hi) {
+		BUN m = (lo + hi) / 2;
+
+		if (dict[m] <= v)
+			lo = m + 1;
+		else
+			hi = m;
+	}
+	return lo;
+}
+
+/* The distinct non-nil strings of b in *dict, as heap offsets sorted
+ * on the strings; returns the number of strings, or BUN_NONE if there
+ * are more than CMP_DICTMAX.  Also counts the nils and remembers where
+ * one of them is. */
+static BUN
+cmp_strdistinct(BAT *b, lng **dict, BUN *nils, lng *nilpos)
+{
+	const void *vals = Tloc(b, BUNfirst(b));
+	const char *base = b->T->vheap->base;
+	BUN cnt = BATcount(b), i, n = 0;
+	size_t mask = 2 * CMP_DICTMAX - 1, h;
+	int width = b->T->width;
+	var_t *tab, *d;
+	bit *used;
+
+	*dict = NULL;
+	*nils = 0;
+	*nilpos = 0;
+	tab = GDKmalloc((mask + 1) * sizeof(var_t));
+	used = GDKzalloc((mask + 1) * sizeof(bit));
+	if (tab == NULL || used == NULL) {
+		GDKfree(tab);
+		GDKfree(used);
+		return BUN_NONE;
+	}
+	for (i = 0; i < cnt; i++) {
+		var_t o = VarHeapVal(vals, i, width);
+		const char *v = base + o;
+		BUN hv;
+
+		if (GDK_STRNIL(v)) {
+			if ((*nils)++ == 0)
+				*nilpos = (lng) o;
+			continue;
+		}
+		GDK_STRHASH(v, hv);
+		for (h = (size_t) hv & mask;
+		     used[h] && tab[h] != o && strcmp(base + tab[h], v) != 0;
+		     h = (h + 1) & mask)
+			;
+		if (!used[h]) {
+			if (n == CMP_DICTMAX) {
+				n = BUN_NONE;
+				break;
+			}
+			used[h] = 1;
+			tab[h] = o;
+			n++;
+		}
+	}
+	if (n != BUN_NONE && (d = GDKmalloc((n + 1) * sizeof(var_t))) != NULL) {
+		BUN k = 0;
+
+		for (h = 0; h <= mask; h++)
+			if (used[h])
+				d[k++] = tab[h];
+		assert(k == n);
+		GDKqsort(d, NULL, base, (size_t) n, (int) sizeof(var_t), 0, TYPE_str);
+		/* the dictionary is kept as lng, whatever the size of
+		 * var_t */
+		if (sizeof(var_t) == sizeof(lng)) {
+			*dict = (lng *) d;
+		} else if ((*dict = GDKmalloc((n + 1) * sizeof(lng))) != NULL) {
+			for (k = 0; k < n; k++)
+				(*dict)[k] = (lng) d[k];
+			GDKfree(d);
+		} else {
+			GDKfree(d);
+			n = BUN_NONE;
+		}
+	} else {
+		n = BUN_NONE;
+	}
+	GDKfree(tab);
+	GDKfree(used);
+	return n;
+}
+
+/* index of the first dictionary string >= v (upper == 0), or of the
+ * first dictionary string > v (upper != 0) */
+static BUN
+cmp_strbound(const lng *dict, BUN n, const char *base, const char *v, int upper)
+{
+	BUN lo = 0, hi = n;
+
+	while (lo < hi) {
+		BUN m = (lo + hi) / 2;
+		int r = strcmp(base + dict[m], v);
+
+		if (r < 0 || (upper && r == 0))
+			lo = m + 1;
+		else
+			hi = m;
+	}
+	return lo;
+}
+
+/* the code of each string; many rows share heap offsets (the string
+ * heap eliminates doubles), so remember the codes of recently seen
+ * offsets */
+#define CMP_STRCACHE	4096
+
+static void
+cmp_strfill(Compress *c, BAT *b)
+{
+	const void *vals = Tloc(b, BUNfirst(b));
+	const char *base = b->T->vheap->base;
+	BUN cnt = BATcount(b), i;
+	int width = b->T->width;
+	ulng *codes = (ulng *) c->codes, w = 0;
+	var_t coff[CMP_STRCACHE];
+	unsigned int ccode[CMP_STRCACHE];
+
+	for (i = 0; i < CMP_STRCACHE; i++)
+		coff[i] = (var_t) -1;
+	for (i = 0; i < cnt; i++) {
+		var_t o = VarHeapVal(vals, i, width);
+		size_t h = (size_t) (o >> 3) & (CMP_STRCACHE - 1);
+		ulng code;
+
+		if (coff[h] == o) {
+			code = ccode[h];
+		} else {
+			if (GDK_STRNIL(base + o))
+				code = 0;
+			else
+				code = cmp_strbound(c->vals, c->n, base, base + o, 0) + 1;
+			coff[h] = o;
+			ccode[h] = (unsigned int) code;
+		}
+		w |= code << ((i & c->permask) << c->lgbits);
+		if ((i & c->permask) == c->permask) {
+			codes[i >> c->lgper] = w;
+			w = 0;
+		}
+	}
+	if (cnt & c->permask)
+		codes[cnt >> c->lgper] = w;
+}
+
+static void
+cmp_fill(Compress *c, BAT *b, int tpe, lng nil)
+{
+	const void *vals = Tloc(b, BUNfirst(b));
+	BUN cnt = BATcount(b), i, r = 0;
+	ulng *codes = (ulng *) c->codes, w = 0;
+	lng *vp = (lng *) c->vals;
+	BUN *ep = (BUN *) c->ends;
+
+	if (c->method == CMP_RLE) {
+		for (i = 0; i < cnt; i++) {
+			lng v = cmp_value(vals, tpe, i);
+
+			if (i == 0 || v != vp[r - 1])
+				vp[r++] = v;
+			ep[r - 1] = i + 1;
+		}
+		assert(r == c->n);
+		return;
+	}
+	for (i = 0; i < cnt; i++) {
+		lng v = cmp_value(vals, tpe, i);
+		ulng code;
+
+		if (v == nil)
+			code = 0;
+		else if (c->method == CMP_FOR)
+			code = (ulng) v - (ulng) c->min + 1;
+		else
+			code = cmp_lower(c->vals, c->n, v) + 1;
+		w |= code << ((i & c->permask) << c->lgbits);
+		if ((i & c->permask) == c->permask) {
+			codes[i >> c->lgper] = w;
+			w = 0;
+		}
+	}
+	if (cnt & c->permask)
+		codes[cnt >> c->lgper] = w;
+}
+
+gdk_return
+BATcompress(BAT *b)
+{
+	BAT *o = NULL;
+	Compress *c;
+	int tpe;
+	lng t0 = 0, t1 = 0;
+
+	assert(BAThdense(b));	/* assert void head */
+
+	BATcheck(b, "BATcompress", GDK_FAIL);
+
+	/* we only compress types that look like integers and
+	 * strings, and only columns that don't change */
+	if ((tpe = cmp_type(b)) < 0 || b->batRestricted != BAT_READ)
+		return GDK_FAIL;
+
+	if (BATcheckcompress(b))
+		return GDK_SUCCEED;
+
+	if (VIEWtparent(b)) {
+		bat p = VIEWtparent(b);
+		o = b;
+		b = BATmirror(BATdescriptor(p));
+	}
+	if (b->batFirst > 0 || BATcount(b) < CMP_MINCOUNT) {
+		if (o)
+			BBPunfix(b->batCacheid);
+		return GDK_FAIL;
+	}
+	MT_lock_set(&GDKcompressLock(abs(b->batCacheid)), "BATcompress");
+	t0 = GDKusec();
+	if (b->T->compress == NULL) {
+		const void *vals = Tloc(b, BUNfirst(b));
+		BUN cnt = BATcount(b), i, runs = 0, nils = 0, n = BUN_NONE;
+		lng nil = cmp_nil(tpe), min = GDK_lng_max, max = GDK_lng_min, prev = 0;
+		lng *dict = NULL;
+		size_t tailsize = (size_t) cnt << b->T->shift, size, sz;
+		int method = -1, bits = 0, forbits, dictbits = 0;
+		str nme = BBP_physical(b->batCacheid);
+		const char *ext = b->batCacheid > 0 ? "tcompress" : "hcompress";
+		int fd;
+
+		if (tpe == TYPE_str) {
+			/* only a dictionary, and min is where a nil
+			 * is in the string heap */
+			max = 0;
+			size = COMPRESS_OFFSET + tailsize + sizeof(ulng);
+			if ((n = cmp_strdistinct(b, &dict, &nils, &min)) != BUN_NONE &&
+			    (dictbits = cmp_bits(n)) > 0 &&
+			    (sz = cmp_heapsize(CMP_DICT, cnt, dictbits, n)) < size) {
+				method = CMP_DICT;
+				bits = dictbits;
+				size = sz;
+			}
+			goto chosen;
+		}
+		/* statistics for choosing the encoding */
+		for (i = 0; i < cnt; i++) {
+			lng v = cmp_value(vals, tpe, i);
+
+			if (i == 0 || v != prev)
+				runs++;
+			prev = v;
+			if (v == nil) {
+				nils++;
+				continue;
+			}
+			if (v < min)
+				min = v;
+			if (v > max)
+				max = v;
+		}
+		if (nils == cnt)
+			min = max = 0;
+		/* only keep a copy that at least halves the tail (give
+		 * or take rounding to whole words) */
+		size = COMPRESS_OFFSET + tailsize / 2 + sizeof(ulng);
+		forbits = cmp_bits((ulng) max - (ulng) min + 1);
+		if (forbits > 0 &&
+		    (sz = cmp_heapsize(CMP_FOR, cnt, forbits, 0)) < size) {
+			method = CMP_FOR;
+			bits = forbits;
+			size = sz;
+		}
+		if (runs < cnt / 4 &&
+		    (sz = cmp_heapsize(CMP_RLE, cnt, 0, runs)) < size) {
+			method = CMP_RLE;
+			bits = 0;
+			size = sz;
+		}
+		if ((forbits == 0 || forbits > 4) &&
+		    (n = cmp_distinct(b, tpe, nil, &dict)) != BUN_NONE &&
+		    (dictbits = cmp_bits(n)) > 0 &&
+		    (sz = cmp_heapsize(CMP_DICT, cnt, dictbits, n)) < size) {
+			method = CMP_DICT;
+			bits = dictbits;
+			size = sz;
+		}
+	  chosen:
+		if (method < 0) {
+			ALGODEBUG fprintf(stderr, "#BATcompress(b=%s#" BUNFMT "): "
+					  "not compressible\n",
+					  BATgetId(b), BATcount(b));
+			GDKfree(dict);
+			MT_lock_unset(&GDKcompressLock(abs(b->batCacheid)), "BATcompress");
+			if (o)
+				BBPunfix(b->batCacheid);
+			return GDK_FAIL;
+		}
+
+		c = GDKzalloc(sizeof(Compress));
+		if (c == NULL ||
+		    (c->heap = GDKzalloc(sizeof(Heap))) == NULL ||
+		    (c->heap->filename = GDKmalloc(strlen(nme) + 12)) == NULL) {
+			if (c)
+				GDKfree(c->heap);
+			GDKfree(c);
+			GDKfree(dict);
+			GDKerror("#BATcompress: memory allocation error.\n");
+			MT_lock_unset(&GDKcompressLock(abs(b->batCacheid)), "BATcompress");
+			if (o)
+				BBPunfix(b->batCacheid);
+			return GDK_FAIL;
+		}
+		sprintf(c->heap->filename, "%s.%s", nme, ext);
+		c->heap->farmid = BBPselectfarm(b->batRole, b->ttype, compressheap);
+		if (HEAPalloc(c->heap, size, 1) != GDK_SUCCEED) {
+			GDKfree(c->heap->filename);
+			GDKfree(c->heap);
+			GDKfree(c);
+			GDKfree(dict);
+			GDKerror("#BATcompress: memory allocation error.\n");
+			MT_lock_unset(&GDKcompressLock(abs(b->batCacheid)), "BATcompress");
+			if (o)
+				BBPunfix(b->batCacheid);
+			return GDK_FAIL;
+		}
+		c->heap->free = size;
+		memset(c->heap->base, 0, size);
+		((size_t *) c->heap->base)[0] = (size_t) method;
+		((size_t *) c->heap->base)[1] = (size_t) cnt;
+		((size_t *) c->heap->base)[2] = (size_t) bits;
+		((size_t *) c->heap->base)[3] = (size_t) (method == CMP_RLE ? runs : method == CMP_DICT ? n : 0);
+		((size_t *) c->heap->base)[4] = (size_t) nils;
+		((lng *) ((size_t *) c->heap->base + COMPRESS_HEADER_SIZE))[0] = min;
+		((lng *) ((size_t *) c->heap->base + COMPRESS_HEADER_SIZE))[1] = max;
+		cmp_init(c);
+		if (method == CMP_DICT)
+			memcpy((lng *) c->vals, dict, (size_t) n * sizeof(lng));
+		GDKfree(dict);
+		if (tpe == TYPE_str)
+			cmp_strfill(c, b);
+		else
+			cmp_fill(c, b, tpe, nil);
+
+		ALGODEBUG fprintf(stderr, "#BATcompress(b=%s#" BUNFMT "): "
+				  "method %d, %d bits, " SZFMT " of " SZFMT " bytes\n",
+				  BATgetId(b), BATcount(b), method, bits,
+				  size, tailsize);
+
+		if ((BBP_status(b->batCacheid) & BBPEXISTING) &&
+		    HEAPsave(c->heap, nme, ext) == GDK_SUCCEED &&
+		    (fd = GDKfdlocate(c->heap->farmid, nme, "rb+", ext)) >= 0) {
+			ALGODEBUG fprintf(stderr, "#BATcompress: persisting compressed copy\n");
+			/* add version number */
+			((size_t *) c->heap->base)[0] |= (size_t) COMPRESS_VERSION << 8;
+			/* sync-on-disk checked bit */
+			((size_t *) c->heap->base)[0] |= (size_t) 1 << 16;
+			if (write(fd, c->heap->base, sizeof(size_t)) < 0)
+				perror("write compressed copy");
+			if (!(GDKdebug & FORCEMITOMASK)) {
+#if defined(NATIVE_WIN32)
+				_commit(fd);
+#elif defined(HAVE_FDATASYNC)
+				fdatasync(fd);
+#elif defined(HAVE_FSYNC)
+				fsync(fd);
+#endif
+			}
+			close(fd);
+		}
+		b->T->compress = c;
+	}
+
+	t1 = GDKusec();
+	ALGODEBUG fprintf(stderr, "#BATcompress: compression " LLFMT " usec\n", t1 - t0);
+
+	MT_lock_unset(&GDKcompressLock(abs(b->batCacheid)), "BATcompress");
+
+	if (o != NULL) {
+		o->T->compress = NULL;	/* views always keep null pointer and
+					   need to obtain the latest copy
+					   from the parent at query time */
+		BBPunfix(b->batCacheid);
+	}
+	return GDK_SUCCEED;
+}
+
+/* The compressed copy covering b and the position of b's first value
+ * in it; BATcheckcompress(b) must have returned true. */
+static Compress *
+cmp_get(BAT *b, BUN *off)
+{
+	BAT *pb = b;
+
+	*off = 0;
+	if (VIEWtparent(b)) {
+		pb = BBPdescriptor(-VIEWtparent(b));
+		*off = (BUN) ((Tloc(b, BUNfirst(b)) - Tloc(pb, BUNfirst(pb))) / Tsize(b));
+	}
+	assert(pb->T->compress != NULL);
+	assert(*off + BATcount(b) <= pb->T->compress->cnt);
+	return pb->T->compress;
+}
+
+/* index of the run containing position p */
+static BUN
+cmp_run(const Compress *c, BUN p)
+{
+	BUN lo = 0, hi = c->n;
+
+	while (lo < hi) {
+		BUN m = (lo + hi) / 2;
+
+		if (c->ends[m] <= p)
+			lo = m + 1;
+		else
+			hi = m;
+	}
+	return lo;
+}
+
+#define CMPADD(o)							\
+	do {								\
+		if (r == BATcapacity(bn)) {				\
+			BATsetcount(bn, r);				\
+			if (BATextend(bn, BATcapacity(bn) + (BATcapacity(bn) >> 1) + 1024) != GDK_SUCCEED) \
+				goto bailout;				\
+			dst = (oid *) Tloc(bn, BUNfirst(bn));		\
+		}							\
+		dst[r++] = (o);						\
+	} while (0)
+
+/* does code x (bit packed encodings) match? */
+#define CODEMATCH(x)							\
+	(nilsel ? (x) == 0 :						\
+	 (x) != 0 && (((x) >= clo && (x) <= chi) != anti))
+
+/* does value v (run-length encoding) match? */
+#define VALMATCH(v)							\
+	(nilsel ? (v) == nil :						\
+	 (v) != nil && ((!empty && (v) >= lo && (v) <= hi) != anti))
+
+/* Range select on the compressed copy of b.  The arguments are those
+ * of BATsubselect after its normalization; tl and th are of b's type,
+ * lval and hval tell whether they bound the range at all. */
+BAT *
+CMPsubselect(BAT *b, BAT *s, const void *tl, const void *th,
+	     int li, int hi_, int equi, int anti, int lval, int hval,
+	     BUN estimate)
+{
+	Compress *c;
+	BUN off, r = 0, p, q;
+	int tpe = cmp_type(b), nilsel, empty = 0;
+	lng nil, lo = GDK_lng_min, hi = GDK_lng_max;
+	unsigned int clo = 1, chi = 0;
+	const oid *cand = NULL, *candend = NULL;
+	oid *dst;
+	BAT *bn;
+
+	assert(tpe >= 0);
+	c = cmp_get(b, &off);
+	nil = cmp_nil(tpe);
+	nilsel = equi && (tpe == TYPE_str ? GDK_STRNIL(tl) : cmp_value(tl, tpe, 0) == nil);
+	if (nilsel) {
+		/* only looking for nils, i.e. code 0 */
+	} else if (tpe == TYPE_str) {
+		/* find the range of codes by looking up the bounds in
+		 * the dictionary */
+		const char *base = b->T->vheap->base;
+
+		clo = lval ? (unsigned int) cmp_strbound(c->vals, c->n, base, tl, !li) + 1 : 1;
+		chi = hval ? (unsigned int) cmp_strbound(c->vals, c->n, base, th, hi_) : (unsigned int) c->n;
+	} else {
+		if (lval) {
+			lo = cmp_value(tl, tpe, 0);
+			if (!li) {
+				if (lo == GDK_lng_max)
+					empty = 1;
+				else
+					lo++;
+			}
+		}
+		if (hval) {
+			hi = cmp_value(th, tpe, 0);
+			if (!hi_) {
+				if (hi == GDK_lng_min)
+					empty = 1;
+				else
+					hi--;
+			}
+		}
+		if (lo > hi)
+			empty = 1;
+		/* translate the range to codes [clo..chi] */
+		if (empty || c->nils == c->cnt || lo > c->max || hi < c->min) {
+			/* nothing in range */
+		} else if (c->method == CMP_FOR) {
+			clo = lo <= c->min ? 1 : (unsigned int) ((ulng) lo - (ulng) c->min + 1);
+			chi = (unsigned int) ((ulng) (hi >= c->max ? c->max : hi) - (ulng) c->min + 1);
+		} else if (c->method == CMP_DICT) {
+			clo = (unsigned int) cmp_lower(c->vals, c->n, lo) + 1;
+			chi = (unsigned int) cmp_upper(c->vals, c->n, hi);
+		}
+	}
+
+	/* the range [p..q) of positions in b to consider */
+	p = 0;
+	q = BATcount(b);
+	if (s && BATtdense(s)) {
+		if (s->tseqbase > b->hseqbase)
+			p = MIN(q, s->tseqbase - b->hseqbase);
+		if (s->tseqbase + BATcount(s) < b->hseqbase + q)
+			q = s->tseqbase + BATcount(s) <= b->hseqbase ? 0 : s->tseqbase + BATcount(s) - b->hseqbase;
+		if (p > q)
+			p = q;
+	} else if (s) {
+		oid ol = b->hseqbase, oh = ol + q;
+
+		cand = (const oid *) Tloc(s, SORTfndfirst(s, &ol));
+		candend = (const oid *) Tloc(s, SORTfndfirst(s, &oh));
+	}
+
+	bn = BATnew(TYPE_void, TYPE_oid, MIN(estimate, cand ? (BUN) (candend - cand) : q - p), TRANSIENT);
+	if (bn == NULL)
+		return NULL;
+	dst = (oid *) Tloc(bn, BUNfirst(bn));
+
+	if (c->method == CMP_RLE) {
+		const lng *vals = c->vals;
+		const BUN *ends = c->ends;
+		BUN k;
+
+		if (cand) {
+			k = cand < candend ? cmp_run(c, off + (*cand - b->hseqbase)) : 0;
+			for (; cand < candend; cand++) {
+				BUN i = off + (*cand - b->hseqbase);
+
+				while (ends[k] <= i)
+					k++;
+				if (VALMATCH(vals[k]))
+					CMPADD(*cand);
+			}
+		} else if (p < q) {
+			for (k = cmp_run(c, off + p); p < q; k++) {
+				BUN e = MIN(ends[k] - off, q);
+
+				if (VALMATCH(vals[k])) {
+					for (; p < e; p++)
+						CMPADD(b->hseqbase + p);
+				}
+				p = e;
+			}
+		}
+	} else {
+		if (cand) {
+			for (; cand < candend; cand++) {
+				BUN i = off + (*cand - b->hseqbase);
+				unsigned int x = CMPcode(c, i);
+
+				if (CODEMATCH(x))
+					CMPADD(*cand);
+			}
+		} else {
+			for (; p < q; p++) {
+				BUN i = off + p;
+				unsigned int x = CMPcode(c, i);
+
+				if (CODEMATCH(x))
+					CMPADD(b->hseqbase + p);
+			}
+		}
+	}
+	BATsetcount(bn, r);
+	bn->tsorted = 1;
+	bn->trevsorted = r <= 1;
+	bn->tkey = 1;
+	bn->T->nonil = 1;
+	bn->T->nil = 0;
+	bn->hseqbase = 0;
+	bn->hkey = 1;
+	bn->hsorted = 1;
+	bn->hrevsorted = r <= 1;
+	bn->H->nonil = 1;
+	bn->H->nil = 0;
+	ALGODEBUG fprintf(stderr, "#CMPsubselect(b=%s#" BUNFMT ",anti=%d): "
+			  "method %d: " BUNFMT " results\n",
+			  BATgetId(b), BATcount(b), anti, c->method, r);
+	return bn;
+
+  bailout:
+	BBPreclaim(bn);
+	return NULL;
+}
+
+#define CMPPROJECT(TYPE)						\
+	do {								\
+		TYPE *restrict bt = (TYPE *) Tloc(bn, BUNfirst(bn));	\
+		for (i = 0; i < cnt; i++) {				\
+			BUN pos;					\
+			if (o[i] < rseq || o[i] >= rend) {		\
+				if (o[i] != oid_nil) {			\
+					GDKerror("BATproject: does not match always\n"); \
+					return GDK_FAIL;		\
+				}					\
+				bt[i] = TYPE##_nil;			\
+				nils = 1;				\
+				continue;				\
+			}						\
+			pos = off + (o[i] - rseq);			\
+			if (c->method == CMP_RLE) {			\
+				if (pos < start || pos >= c->ends[k]) {	\
+					k = cmp_run(c, pos);		\
+					start = k ? c->ends[k - 1] : 0;	\
+				}					\
+				bt[i] = (TYPE) c->vals[k];		\
+				nils |= c->vals[k] == nil;		\
+			} else {					\
+				unsigned int x = CMPcode(c, pos);	\
+				if (x == 0) {				\
+					bt[i] = TYPE##_nil;		\
+					nils = 1;			\
+				} else if (c->method == CMP_FOR) {	\
+					bt[i] = (TYPE) (c->min + (lng) (x - 1)); \
+				} else {				\
+					bt[i] = (TYPE) c->vals[x - 1];	\
+				}					\
+			}						\
+		}							\
+	} while (0)
+
+/* string offsets, for a string column whose heap is going to be
+ * shared */
+#define CMPPROJECTSTR(TYPE, ADJ)					\
+	do {								\
+		TYPE *restrict bt = (TYPE *) Tloc(bn, BUNfirst(bn));	\
+		for (i = 0; i < cnt; i++) {				\
+			unsigned int x;					\
+			if (o[i] < rseq || o[i] >= rend) {		\
+				GDKerror("BATproject: does not match always\n"); \
+				return GDK_FAIL;			\
+			}						\
+			x = CMPcode(c, off + (o[i] - rseq));		\
+			bt[i] = (TYPE) ((x == 0 ? (var_t) c->min : (var_t) c->vals[x - 1]) - (ADJ)); \
+			nils |= x == 0;					\
+		}							\
+	} while (0)
+
+/* Fill bn, a new BAT of r's type or its storage type, with the values
+ * of r at the positions l; r has a compressed copy.  If r is a string
+ * column, bn instead is of the integer type of r's width and gets the
+ * heap offsets, like in BATproject's "string trick". */
+gdk_return
+CMPproject(BAT *bn, BAT *l, BAT *r)
+{
+	Compress *c;
+	BUN off, cnt = BATcount(l), i, k = 0, start = 0;
+	const oid *o = (const oid *) Tloc(l, BUNfirst(l));
+	oid rseq = r->hseqbase, rend = rseq + BATcount(r);
+	int tpe = cmp_type(r), nils = 0;
+	lng nil;
+
+	assert(tpe >= 0);
+	assert(tpe == TYPE_str ? ATOMsize(bn->ttype) == r->T->width : ATOMstorage(bn->ttype) == tpe);
+	c = cmp_get(r, &off);
+	nil = cmp_nil(tpe);
+	if (tpe == TYPE_str) {
+		switch (r->T->width) {
+		case 1:
+			CMPPROJECTSTR(unsigned char, GDK_VAROFFSET);
+			break;
+		case 2:
+			CMPPROJECTSTR(unsigned short, GDK_VAROFFSET);
+			break;
+#if SIZEOF_VAR_T == 8
+		case 4:
+			CMPPROJECTSTR(unsigned int, 0);
+			break;
+#endif
+		default:
+			CMPPROJECTSTR(var_t, 0);
+			break;
+		}
+	} else switch (tpe) {
+	case TYPE_bte:
+		CMPPROJECT(bte);
+		break;
+	case TYPE_sht:
+		CMPPROJECT(sht);
+		break;
+	case TYPE_int:
+		CMPPROJECT(int);
+		break;
+	default:
+		CMPPROJECT(lng);
+		break;
+	}
+	BATsetcount(bn, cnt);
+	bn->tsorted = 0;
+	bn->trevsorted = 0;
+	bn->tkey = 0;
+	bn->T->nonil = !nils;
+	bn->T->nil = nils;
+	ALGODEBUG fprintf(stderr, "#CMPproject(l=%s,r=%s): method %d\n",
+			  BATgetId(l), BATgetId(r), c->method);
+	return GDK_SUCCEED;
+}
+
+/* Store the minimum (or maximum) value of b in *res and return true,
+ * if b has a compressed copy covering all of it. */
+int
+CMPminmax(BAT *b, int max, void *res)
+{
+	Compress *c;
+	BUN off;
+	int tpe;
+	lng v;
+
+	if (VIEWtparent(b) && BATcount(b) != BATcount(BBPdescriptor(-VIEWtparent(b))))
+		return 0;
+	if ((tpe = cmp_type(b)) < 0 || tpe == TYPE_str || !BATcheckcompress(b))
+		return 0;
+	c = cmp_get(b, &off);
+	(void) off;
+	v = c->nils == c->cnt ? cmp_nil(tpe) : max ? c->max : c->min;
+	switch (tpe) {
+	case TYPE_bte:
+		* (bte *) res = (bte) v;
+		break;
+	case TYPE_sht:
+		* (sht *) res = (sht) v;
+		break;
+	case TYPE_int:
+		* (int *) res = (int) v;
+		break;
+	default:
+		* (lng *) res = v;
+		break;
+	}
+	return 1;
+}
+
+/* The number of distinct codes (including the one for nil) if b has a
+ * dictionary compressed copy, BUN_NONE otherwise. */
+BUN
+CMPdictsize(BAT *b)
+{
+	Compress *c;
+	BUN off;
+
+	if (cmp_type(b) < 0 || !BATcheckcompress(b))
+		return BUN_NONE;
+	c = cmp_get(b, &off);
+	(void) off;
+	return c->method == CMP_DICT ? c->n + 1 : BUN_NONE;
+}
+
+/* Group b on the codes of its dictionary compressed copy: fill ngrps
+ * with group ids in order of first occurrence and, if not NULL, exts
+ * with the first oid and cnts (zeroed by the caller) with the size of
+ * each group; these must have room for CMPdictsize(b) groups.
+ * Returns the number of groups, or BUN_NONE on allocation failure. */
+BUN
+CMPgroup(BAT *b, oid *restrict ngrps, oid *restrict exts, wrd *restrict cnts, int *sorted)
+{
+	Compress *c;
+	BUN off, p, q = BATcount(b);
+	oid *restrict map, ngrp = 0, v;
+
+	c = cmp_get(b, &off);
+	assert(c->method == CMP_DICT);
+	if ((map = GDKmalloc((c->n + 1) * sizeof(oid))) == NULL)
+		return BUN_NONE;
+	for (p = 0; p <= c->n; p++)
+		map[p] = oid_nil;
+	*sorted = 1;
+	for (p = 0; p < q; p++) {
+		unsigned int x = CMPcode(c, off + p);
+
+		if ((v = map[x]) == oid_nil) {
+			map[x] = v = ngrp++;
+			if (exts)
+				exts[v] = b->hseqbase + (oid) p;
+		}
+		ngrps[p] = v;
+		if (p > 0 && v < ngrps[p - 1])
+			*sorted = 0;
+		if (cnts)
+			cnts[v]++;
+	}
+	GDKfree(map);
+	return (BUN) ngrp;
+}
+
+lng
+CMPcompresssize(BAT *b)
+{
+	lng sz = 0;
+
+	if (b->T->compress)
+		sz = (lng) b->T->compress->heap->free;
+	return sz;
+}
+
+static void
+CMPremove(BAT *b)
+{
+	Compress *c;
+
+	assert(BAThdense(b));	/* assert void head */
+	assert(b->T->compress != NULL);
+	assert(!VIEWtparent(b));
+
+	MT_lock_set(&GDKcompressLock(abs(b->batCacheid)), "CMPremove");
+	if ((c = b->T->compress) != NULL) {
+		b->T->compress = NULL;
+
+		if (HEAPdelete(c->heap, BBP_physical(b->batCacheid),
+			       b->batCacheid > 0 ? "tcompress" : "hcompress"))
+			IODEBUG fprintf(stderr, "#CMPremove(%s): compressed heap\n", BATgetId(b));
+
+		GDKfree(c->heap);
+		GDKfree(c);
+	}
+	MT_lock_unset(&GDKcompressLock(abs(b->batCacheid)), "CMPremove");
+}
+
+/* Release the memory of the compressed copy of a column that is being
+ * unloaded.  A persisted copy stays on disk for the next time. */
+void
+CMPfree(BAT *b)
+{
+	Compress *c;
+	int i;
+
+	for (i = 0; i < 2; i++, b = BATmirror(b)) {
+		if (b->T->compress == NULL || VIEWtparent(b))
+			continue;
+		MT_lock_set(&GDKcompressLock(abs(b->batCacheid)), "CMPfree");
+		if ((c = b->T->compress) != NULL) {
+			b->T->compress = NULL;
+			HEAPfree(c->heap, 0);
+			GDKfree(c->heap);
+			GDKfree(c);
+		}
+		MT_lock_unset(&GDKcompressLock(abs(b->batCacheid)), "CMPfree");
+	}
+}
+
+/* Remove a persisted compressed copy that was never loaded.  Only a
+ * read-only column that exists on disk can have one, so other columns
+ * don't pay for the system call. */
+static void
+CMPunlink(BAT *b)
+{
+	int farmid;
+
+	if (b->batRestricted != BAT_READ ||
+	    !(BBP_status(b->batCacheid) & BBPEXISTING) ||
+	    cmp_type(b) < 0)
+		return;
+	MT_lock_set(&GDKcompressLock(abs(b->batCacheid)), "CMPunlink");
+	if (b->T->compress == NULL &&
+	    (farmid = BBPselectfarm(b->batRole, b->ttype, compressheap)) >= 0 &&
+	    GDKunlink(farmid, BATDIR, BBP_physical(b->batCacheid),
+		      b->batCacheid > 0 ? "tcompress" : "hcompress") == GDK_SUCCEED)
+		IODEBUG fprintf(stderr, "#CMPunlink(%s): compressed heap\n", BATgetId(b));
+	MT_lock_unset(&GDKcompressLock(abs(b->batCacheid)), "CMPunlink");
+}
+
+void
+CMPdestroy(BAT *b)
+{
+	if (b) {
+		if (!VIEWtparent(b)) {
+			if (b->T->compress != NULL)
+				CMPremove(b);
+			else
+				CMPunlink(b);
+		}
+
+		if (!VIEWhparent(b)) {
+			if (b->H->compress != NULL)
+				CMPremove(BATmirror(b));
+			else
+				CMPunlink(BATmirror(b));
+		}
+	}
+}
@@ -361,6 +361,475 @@
 	)
 
 
+/* Parallel grouping of a large unsorted column of fixed-size values
+ * without input groups.  The column is split into one contiguous part
+ * per thread, and each thread groups its part with a thread-local
+ * hash table, numbering its groups in order of first occurrence.  The
+ * local groups are then distributed over merge partitions on their
+ * hash value, and for each partition a thread merges the local groups
+ * of all parts (in part order) into a partition-local table.  The
+ * first local group to enter a value is its creator.  Walking the
+ * local groups of all parts in order and numbering the creators gives
+ * the same dense group ids, in order of first occurrence, as the
+ * sequential code.  Finally the threads translate their local group
+ * ids into these global ids. */
+#define GROUP_PARALLEL	((BUN) 1 << 20)	/* minimum number of values per thread */
+#define GRP_CREATOR	((BUN) 1 << (sizeof(BUN) * 8 - 1))
+
+#define GRPmix_int(V)	((BUN) mix_int(*(const unsigned int *) (V)))
+#define GRPmix_lng(V)	((BUN) mix_lng(*(const ulng *) (V)))
+#ifdef HAVE_HGE
+#define GRPmix_hge(V)	((BUN) mix_hge(*(const uhge *) (V)))
+#endif
+
+struct grpmerge {
+	BUN nent;		/* number of distinct values */
+	BUN *bkt, *link;	/* hash table on the entries */
+	BUN *rep;		/* position of a representative value */
+	int *opart;		/* creator of the entry: part ... */
+	BUN *olgid;		/* ... and its local group */
+	wrd *cnt;		/* histogram */
+	BUN mask;
+};
+
+struct grppar;
+
+struct grppart {
+	struct grppar *gp;
+	int idx;
+	/* the part of the input grouped by this thread */
+	BUN lo, hi;
+	BUN ngrp;		/* number of local groups */
+	BUN *rep;		/* per local group: position of first occurrence */
+	wrd *cnt;		/* per local group: histogram */
+	BUN *ent;		/* per local group: merge entry, partition */
+	BUN *gid;		/* per local group: chain link, then group id */
+	BUN *order;		/* local groups ordered on merge partition */
+	BUN *pstart;		/* start of each partition in order */
+	int sorted;		/* group ids non-decreasing in this part */
+	gdk_return res;
+};
+
+struct grppar {
+	const char *vals;
+	oid *ngrps;
+	int tpe;
+	int histo;
+	int nthreads;
+	int nmerge, mbits;	/* number of merge partitions, log2 */
+	int phase;
+	struct grppart *parts;
+	struct grpmerge *merges;
+};
+
+/* phase 0: group a part into local groups */
+#define GRPPAR_local(TYPE, MIX)						\
+	do {								\
+		const TYPE *restrict w = (const TYPE *) gp->vals;	\
+		for (p = pp->lo; p < pp->hi; p++) {			\
+			prb = MIX(&w[p]) & mask;			\
+			for (hb = bkt[prb]; hb != BUN_NONE; hb = pp->gid[hb]) \
+				if (w[pp->rep[hb]] == w[p])		\
+					break;				\
+			if (hb == BUN_NONE) {				\
+				hb = pp->ngrp++;			\
+				pp->rep[hb] = p;			\
+				pp->gid[hb] = bkt[prb];			\
+				bkt[prb] = hb;				\
+				if (gp->histo)				\
+					pp->cnt[hb] = 0;		\
+			}						\
+			gp->ngrps[p] = hb;				\
+			if (gp->histo)					\
+				pp->cnt[hb]++;				\
+		}							\
+	} while (0)
+
+/* phase 1: merge the local groups of all parts that fall in a
+ * partition */
+#define GRPPAR_merge(TYPE, MIX)						\
+	do {								\
+		const TYPE *restrict w = (const TYPE *) gp->vals;	\
+		for (i = 0; i < (BUN) gp->nthreads; i++) {		\
+			struct grppart *op = &gp->parts[i];		\
+			for (j = op->pstart[k]; j < op->pstart[k + 1]; j++) { \
+				BUN lg = op->order[j];			\
+				BUN pos = op->rep[lg];			\
+				prb = (MIX(&w[pos]) >> gp->mbits) & gm->mask; \
+				for (hb = gm->bkt[prb]; hb != BUN_NONE; hb = gm->link[hb]) \
+					if (w[gm->rep[hb]] == w[pos])	\
+						break;			\
+				if (hb == BUN_NONE) {			\
+					hb = gm->nent++;		\
+					gm->rep[hb] = pos;		\
+					gm->opart[hb] = (int) i;	\
+					gm->olgid[hb] = lg;		\
+					gm->link[hb] = gm->bkt[prb];	\
+					gm->bkt[prb] = hb;		\
+					if (gp->histo)			\
+						gm->cnt[hb] = 0;	\
+					op->ent[lg] = (hb << gp->mbits | (BUN) k) | GRP_CREATOR; \
+				} else {				\
+					op->ent[lg] = hb << gp->mbits | (BUN) k; \
+				}					\
+				if (gp->histo)				\
+					gm->cnt[hb] += op->cnt[lg];	\
+			}						\
+		}							\
+	} while (0)
+
+static inline BUN
+GRPmix(const char *vals, BUN p, int tpe)
+{
+	switch (tpe) {
+	case TYPE_int:
+		return GRPmix_int((const int *) vals + p);
+	case TYPE_flt:
+		return GRPmix_int((const flt *) vals + p);
+	case TYPE_lng:
+		return GRPmix_lng((const lng *) vals + p);
+	case TYPE_dbl:
+		return GRPmix_lng((const dbl *) vals + p);
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		return GRPmix_hge((const hge *) vals + p);
+#endif
+	default:
+		assert(0);
+		return 0;
+	}
+}
+
+static void
+GRPparallelpart(void *arg)
+{
+	struct grppart *pp = arg;
+	struct grppar *gp = pp->gp;
+	BUN p, hb, prb, mask, i, j, *bkt;
+	int k;
+
+	switch (gp->phase) {
+	case 0: {
+		/* local grouping */
+		for (mask = 1; mask < (pp->hi - pp->lo) / 2; mask <<= 1)
+			;
+		if ((bkt = GDKmalloc(mask * sizeof(BUN))) == NULL) {
+			pp->res = GDK_FAIL;
+			return;
+		}
+		for (i = 0; i < mask; i++)
+			bkt[i] = BUN_NONE;
+		mask--;
+		pp->ngrp = 0;
+		switch (gp->tpe) {
+		case TYPE_int:
+			GRPPAR_local(int, GRPmix_int);
+			break;
+		case TYPE_flt:
+			GRPPAR_local(flt, GRPmix_int);
+			break;
+		case TYPE_lng:
+			GRPPAR_local(lng, GRPmix_lng);
+			break;
+		case TYPE_dbl:
+			GRPPAR_local(dbl, GRPmix_lng);
+			break;
+#ifdef HAVE_HGE
+		case TYPE_hge:
+			GRPPAR_local(hge, GRPmix_hge);
+			break;
+#endif
+		default:
+			assert(0);
+		}
+		GDKfree(bkt);
+		/* distribute the local groups over the merge
+		 * partitions, keeping their order */
+		memset(pp->pstart, 0, (gp->nmerge + 1) * sizeof(BUN));
+		for (i = 0; i < pp->ngrp; i++)
+			pp->pstart[(GRPmix(gp->vals, pp->rep[i], gp->tpe) & (gp->nmerge - 1)) + 1]++;
+		for (k = 0; k < gp->nmerge; k++)
+			pp->pstart[k + 1] += pp->pstart[k];
+		/* use ent as fill pointers for now */
+		memcpy(pp->ent, pp->pstart, gp->nmerge * sizeof(BUN));
+		for (i = 0; i < pp->ngrp; i++)
+			pp->order[pp->ent[GRPmix(gp->vals, pp->rep[i], gp->tpe) & (gp->nmerge - 1)]++] = i;
+		break;
+	}
+	case 1: {
+		/* merge partition pp->idx */
+		struct grpmerge *gm = &gp->merges[pp->idx];
+		BUN n = 0;
+
+		k = pp->idx;
+		if (k >= gp->nmerge)
+			break;
+		for (i = 0; i < (BUN) gp->nthreads; i++)
+			n += gp->parts[i].pstart[k + 1] - gp->parts[i].pstart[k];
+		for (mask = 1; mask < n / 2; mask <<= 1)
+			;
+		gm->mask = mask - 1;
+		gm->nent = 0;
+		n = MAX(n, 1);
+		if ((gm->bkt = GDKmalloc(mask * sizeof(BUN))) == NULL ||
+		    (gm->link = GDKmalloc(n * sizeof(BUN))) == NULL ||
+		    (gm->rep = GDKmalloc(n * sizeof(BUN))) == NULL ||
+		    (gm->opart = GDKmalloc(n * sizeof(int))) == NULL ||
+		    (gm->olgid = GDKmalloc(n * sizeof(BUN))) == NULL ||
+		    (gp->histo && (gm->cnt = GDKmalloc(n * sizeof(wrd))) == NULL)) {
+			pp->res = GDK_FAIL;
+			return;
+		}
+		for (i = 0; i < mask; i++)
+			gm->bkt[i] = BUN_NONE;
+		switch (gp->tpe) {
+		case TYPE_int:
+			GRPPAR_merge(int, GRPmix_int);
+			break;
+		case TYPE_flt:
+			GRPPAR_merge(flt, GRPmix_int);
+			break;
+		case TYPE_lng:
+			GRPPAR_merge(lng, GRPmix_lng);
+			break;
+		case TYPE_dbl:
+			GRPPAR_merge(dbl, GRPmix_lng);
+			break;
+#ifdef HAVE_HGE
+		case TYPE_hge:
+			GRPPAR_merge(hge, GRPmix_hge);
+			break;
+#endif
+		default:
+			assert(0);
+		}
+		GDKfree(gm->bkt);
+		gm->bkt = NULL;
+		GDKfree(gm->link);
+		gm->link = NULL;
+		break;
+	}
+	case 2: {
+		/* translate local group ids into global ones; the
+		 * creators were numbered already */
+		oid *restrict ngrps = gp->ngrps;
+
+		for (i = 0; i < pp->ngrp; i++) {
+			if (!(pp->ent[i] & GRP_CREATOR)) {
+				struct grpmerge *gm = &gp->merges[pp->ent[i] & (gp->nmerge - 1)];
+				BUN e = pp->ent[i] >> gp->mbits;
+
+				pp->gid[i] = gp->parts[gm->opart[e]].gid[gm->olgid[e]];
+			}
+		}
+		pp->sorted = 1;
+		for (p = pp->lo; p < pp->hi; p++) {
+			ngrps[p] = (oid) pp->gid[ngrps[p]];
+			if (p > pp->lo && ngrps[p] < ngrps[p - 1])
+				pp->sorted = 0;
+		}
+		break;
+	}
+	}
+}
+
+/* run one phase of the parallel grouping */
+static gdk_return
+GRPparallelphase(struct grppar *gp, MT_Id *tids, int nthreads, int phase)
+{
+	int i;
+
+	gp->phase = phase;
+	/* the calling thread takes care of the first part */
+	for (i = 1; i < nthreads; i++) {
+		if (MT_create_thread(&tids[i], GRPparallelpart, &gp->parts[i],
+				     MT_THR_JOINABLE) < 0) {
+			/* couldn't create thread, do the work ourselves */
+			tids[i] = 0;
+			GRPparallelpart(&gp->parts[i]);
+		}
+	}
+	GRPparallelpart(&gp->parts[0]);
+	for (i = 1; i < nthreads; i++)
+		if (tids[i])
+			MT_join_thread(tids[i]);
+	for (i = 0; i < nthreads; i++)
+		if (gp->parts[i].res != GDK_SUCCEED)
+			return GDK_FAIL;
+	return GDK_SUCCEED;
+}
+
+/* group the n values of type tpe starting at vals into ngrps using
+ * nthreads threads; the extents (offset by hseqb) and histogram are
+ * written to en and hn if given, which are extended if they can hold
+ * fewer than the resulting number of groups, returned in *ngrpp */
+static gdk_return
+GRPparallel(const void *vals, BUN n, int tpe, int nthreads, oid *ngrps,
+	    BAT *en, BAT *hn, oid hseqb, BUN maxgrps, oid *ngrpp, int *sortedp)
+{
+	struct grppar gp;
+	MT_Id *tids = NULL;
+	BUN i, psize, total;
+	oid ngrp = 0;
+	oid *restrict exts = NULL;
+	wrd *restrict cnts = NULL;
+	int t, k;
+	gdk_return ret = GDK_FAIL;
+
+	gp.vals = vals;
+	gp.ngrps = ngrps;
+	gp.tpe = tpe;
+	gp.histo = hn != NULL;
+	gp.nthreads = nthreads;
+	for (gp.nmerge = 1, gp.mbits = 0; gp.nmerge * 2 <= nthreads; gp.nmerge <<= 1, gp.mbits++)
+		;
+	gp.parts = GDKzalloc(nthreads * sizeof(struct grppart));
+	gp.merges = GDKzalloc(gp.nmerge * sizeof(struct grpmerge));
+	tids = GDKmalloc(nthreads * sizeof(MT_Id));
+	if (gp.parts == NULL || gp.merges == NULL || tids == NULL)
+		goto bailout;
+	psize = n / nthreads;
+	for (t = 0; t < nthreads; t++) {
+		struct grppart *pp = &gp.parts[t];
+
+		pp->gp = &gp;
+		pp->idx = t;
+		pp->lo = psize * t;
+		pp->hi = t == nthreads - 1 ? n : psize * (t + 1);
+		pp->res = GDK_SUCCEED;
+		if ((pp->rep = GDKmalloc((pp->hi - pp->lo) * sizeof(BUN))) == NULL ||
+		    (pp->ent = GDKmalloc((pp->hi - pp->lo) * sizeof(BUN))) == NULL ||
+		    (pp->gid = GDKmalloc((pp->hi - pp->lo) * sizeof(BUN))) == NULL ||
+		    (pp->order = GDKmalloc((pp->hi - pp->lo) * sizeof(BUN))) == NULL ||
+		    (pp->pstart = GDKmalloc((gp.nmerge + 1) * sizeof(BUN))) == NULL ||
+		    (gp.histo && (pp->cnt = GDKmalloc((pp->hi - pp->lo) * sizeof(wrd))) == NULL))
+			goto bailout;
+	}
+
+	if (GRPparallelphase(&gp, tids, nthreads, 0) != GDK_SUCCEED ||
+	    GRPparallelphase(&gp, tids, nthreads, 1) != GDK_SUCCEED)
+		goto bailout;
+
+	/* number the creators in order of first occurrence */
+	for (k = 0, total = 0; k < gp.nmerge; k++)
+		total += gp.merges[k].nent;
+	if (total > maxgrps) {
+		if ((en && BATextend(en, total) != GDK_SUCCEED) ||
+		    (hn && BATextend(hn, total) != GDK_SUCCEED))
+			goto bailout;
+	}
+	if (en)
+		exts = (oid *) Tloc(en, BUNfirst(en));
+	if (hn)
+		cnts = (wrd *) Tloc(hn, BUNfirst(hn));
+	for (t = 0; t < nthreads; t++) {
+		struct grppart *pp = &gp.parts[t];
+
+		for (i = 0; i < pp->ngrp; i++) {
+			if (pp->ent[i] & GRP_CREATOR) {
+				if (exts)
+					exts[ngrp] = hseqb + (oid) pp->rep[i];
+				if (cnts)
+					cnts[ngrp] = gp.merges[pp->ent[i] & (gp.nmerge - 1)].cnt[(pp->ent[i] & ~GRP_CREATOR) >> gp.mbits];
+				pp->gid[i] = ngrp++;
+			}
+		}
+	}
+	assert(ngrp == total);
+
+	if (GRPparallelphase(&gp, tids, nthreads, 2) != GDK_SUCCEED)
+		goto bailout;
+	*sortedp = 1;
+	for (t = 0; t < nthreads; t++)
+		if (!gp.parts[t].sorted ||
+		    (t > 0 && ngrps[gp.parts[t].lo] < ngrps[gp.parts[t].lo - 1]))
+			*sortedp = 0;
+	*ngrpp = ngrp;
+	ret = GDK_SUCCEED;
+
+  bailout:
+	if (gp.parts) {
+		for (t = 0; t < nthreads; t++) {
+			GDKfree(gp.parts[t].rep);
+			GDKfree(gp.parts[t].ent);
+			GDKfree(gp.parts[t].gid);
+			GDKfree(gp.parts[t].order);
+			GDKfree(gp.parts[t].pstart);
+			GDKfree(gp.parts[t].cnt);
+		}
+		GDKfree(gp.parts);
+	}
+	if (gp.merges) {
+		for (k = 0; k < gp.nmerge; k++) {
+			GDKfree(gp.merges[k].bkt);
+			GDKfree(gp.merges[k].link);
+			GDKfree(gp.merges[k].rep);
+			GDKfree(gp.merges[k].opart);
+			GDKfree(gp.merges[k].olgid);
+			GDKfree(gp.merges[k].cnt);
+		}
+		GDKfree(gp.merges);
+	}
+	GDKfree(tids);
+	return ret;
+}
+
+/* try to group b in parallel; returns 1 if done, 0 if the caller
+ * should fall back to the sequential hash grouping (because the
+ * per-thread administration doesn't fit in memory or couldn't be
+ * allocated) */
+static int
+GRPtryparallel(BAT *b, int t, BAT *gn, BAT *en, BAT *hn, oid hseqb,
+	       BUN maxgrps, oid *ngrpp, oid *restrict *extsp,
+	       wrd *restrict *cntsp, int subsorted)
+{
+	int nthreads = GDKnr_threads, sorted;
+	lng t0 = 0;
+	size_t size;
+
+	/* worst case (all values distinct) administration of
+	 * GRPparallel per row: rep, ent, gid, order and the bucket
+	 * array of the local grouping, link, rep, olgid, opart and the
+	 * bucket array of the merge, and the local and merged counts;
+	 * like BATsubjoin for its radix join, only go parallel if that
+	 * fits in the per-thread share of the memory */
+	size = (size_t) BATcount(b) *
+		(9 * sizeof(BUN) + sizeof(int) + (hn ? 2 * sizeof(wrd) : 0));
+	if (size > GDK_mem_maxsize / (GDKnr_threads ? GDKnr_threads : 1)) {
+		ALGODEBUG fprintf(stderr, "#BATgroup(b=%s#" BUNFMT ",g=NULL,"
+				  "subsorted=%d): parallel hash needs " SZFMT
+				  " bytes, using sequential hash\n",
+				  BATgetId(b), BATcount(b), subsorted, size);
+		return 0;
+	}
+	if ((BUN) nthreads > BATcount(b) / GROUP_PARALLEL)
+		nthreads = (int) (BATcount(b) / GROUP_PARALLEL);
+	ALGODEBUG fprintf(stderr, "#BATgroup(b=%s#" BUNFMT ",g=NULL,"
+			  "subsorted=%d): parallel hash with %d threads\n",
+			  BATgetId(b), BATcount(b), subsorted, nthreads);
+	ALGODEBUG t0 = GDKusec();
+	if (GRPparallel(Tloc(b, BUNfirst(b)), BATcount(b), t, nthreads,
+			(oid *) Tloc(gn, BUNfirst(gn)), en, hn, hseqb, maxgrps,
+			ngrpp, &sorted) != GDK_SUCCEED) {
+		/* the sequential code overwrites everything written
+		 * so far, but en and hn may have been extended (and
+		 * thus moved); don't let the failed allocation turn
+		 * into an error of the whole operation */
+		if (en)
+			*extsp = (oid *) Tloc(en, BUNfirst(en));
+		if (hn)
+			*cntsp = (wrd *) Tloc(hn, BUNfirst(hn));
+		GDKclrerr();
+		ALGODEBUG fprintf(stderr, "#BATgroup: parallel grouping "
+				  "failed, falling back to sequential\n");
+		return 0;
+	}
+	gn->tsorted = sorted;
+	ALGODEBUG fprintf(stderr, "#BATgroup: " OIDFMT " groups (" LLFMT " usec)\n",
+			  *ngrpp, GDKusec() - t0);
+	return 1;
+}
+
 gdk_return
 BATgroup_internal(BAT **groups, BAT **extents, BAT **histo,
 		  BAT *b, BAT *g, BAT *e, BAT *h, int subsorted)
@@ -378,7 +847,7 @@ BATgroup_internal(BAT **groups, BAT **extents, BAT **histo,
 	char *ext = NULL;
 	Hash *hs = NULL;
 	BUN hb;
-	BUN maxgrps;
+	BUN maxgrps, maxdict;
 #ifndef DISABLE_PARENT_HASH
 	bat parent;
 #endif
@@ -760,6 +1229,41 @@ BATgroup_internal(BAT **groups, BAT **extents, BAT **histo,
 				cnts[v]++;
 		}
 		GDKfree(sgrps);
+	} else if (g == NULL && (maxdict = CMPdictsize(b)) != BUN_NONE) {
+		/* the column has a dictionary compressed copy, so
+		 * there are at most maxdict groups and we can group
+		 * on the codes instead of the values */
+		int sorted;
+
+		ALGODEBUG fprintf(stderr, "#BATgroup(b=%s#" BUNFMT ","
+				  "g=%s#" BUNFMT ","
+				  "e=%s#" BUNFMT ","
+				  "h=%s#" BUNFMT ",subsorted=%d): "
+				  "use dictionary codes\n",
+				  BATgetId(b), BATcount(b),
+				  g ? BATgetId(g) : "NULL", g ? BATcount(g) : 0,
+				  e ? BATgetId(e) : "NULL", e ? BATcount(e) : 0,
+				  h ? BATgetId(h) : "NULL", h ? BATcount(h) : 0,
+				  subsorted);
+		if (maxgrps < maxdict) {
+			maxgrps = maxdict;
+			if (extents) {
+				if (BATextend(en, maxgrps) != GDK_SUCCEED)
+					goto error;
+				exts = (oid *) Tloc(en, BUNfirst(en));
+			}
+			if (histo) {
+				if (BATextend(hn, maxgrps) != GDK_SUCCEED)
+					goto error;
+				cnts = (wrd *) Tloc(hn, BUNfirst(hn));
+			}
+		}
+		if (histo)
+			memset(cnts, 0, maxgrps * sizeof(wrd));
+		if ((r = CMPgroup(b, ngrps, exts, cnts, &sorted)) == BUN_NONE)
+			goto error;
+		ngrp = (oid) r;
+		gn->tsorted = sorted;
 	} else if (BATcheckhash(b) ||
 		   (b->batPersistence == PERSISTENT &&
 		    BAThash(b, 0) == GDK_SUCCEED)
@@ -831,6 +1335,17 @@ BATgroup_internal(BAT **groups, BAT **extents, BAT **histo,
 			GRP_use_existing_hash_table_any();
 			break;
 		}
+	} else if (g == NULL && GDKnr_threads > 1 &&
+		   BATcount(b) >= 2 * GROUP_PARALLEL &&
+		   (t == TYPE_int || t == TYPE_lng ||
+		    t == TYPE_flt || t == TYPE_dbl
+#ifdef HAVE_HGE
+		    || t == TYPE_hge
+#endif
+			   ) &&
+		   GRPtryparallel(b, t, gn, en, hn, hseqb, maxgrps, &ngrp,
+				  &exts, &cnts, subsorted)) {
+		/* done: groups, extents and histogram were filled in */
 	} else {
 		bit gc = g && (g->tsorted || g->trevsorted);
 		const char *nme;
@@ -398,15 +398,14 @@
 
 /* end of binary search */
 
-#define IMPS_CREATE(TYPE,B)						\
+#define IMPS_CREATE_LOOP(TYPE,B,VAL,NONNIL,LESS,WIDTH)		\
 do {									\
 	uint##B##_t mask, prvmask;					\
 	uint##B##_t *restrict im = (uint##B##_t *) imps;		\
-	const TYPE *restrict col = (TYPE *) Tloc(b, b->batFirst);	\
 	const TYPE *restrict bins = (TYPE *) inbins;			\
-	TYPE nil = TYPE##_nil;						\
+	TYPE val;							\
 	prvmask = mask = 0;						\
-	new = (IMPS_PAGE/sizeof(TYPE))-1;				\
+	new = (IMPS_PAGE/(WIDTH))-1;					\
 	for (i = 0; i < b->batCount; i++) {				\
 		if (!(i&new) && i>0) {					\
 			/* same mask as previous and enough count to add */ \
@@ -443,15 +442,16 @@ do {									\
 			/* new mask */					\
 			mask = 0;					\
 		}							\
-		GETBIN##B(bin,col[i]);					\
+		val = VAL(i);						\
+		GETBIN##B(bin,val);					\
 		mask = IMPSsetBit(B,mask,bin);				\
-		if (col[i] != nil) { /* do not count nils */		\
+		if (NONNIL(i)) { /* do not count nils */			\
 			if (!cnt_bins[bin]++) {				\
 				min_bins[bin] = max_bins[bin] = i;	\
 			} else {					\
-				if (col[i] < col[min_bins[bin]])	\
+				if (LESS(i, min_bins[bin]))		\
 					min_bins[bin] = i;		\
-				if (col[i] > col[max_bins[bin]])	\
+				if (LESS(max_bins[bin], i))		\
 					max_bins[bin] = i;		\
 			}						\
 		}							\
@@ -484,6 +484,60 @@ do {									\
 	}								\
 } while (0)
 
+#define IMPScolval(i)		col[i]
+#define IMPScolnonnil(i)	(col[i] != nil)
+#define IMPScolless(i, j)	(col[i] < col[j])
+
+#define IMPS_CREATE(TYPE,B)						\
+do {									\
+	const TYPE *restrict col = (TYPE *) Tloc(b, b->batFirst);	\
+	const TYPE nil = TYPE##_nil;					\
+	IMPS_CREATE_LOOP(TYPE, B, IMPScolval, IMPScolnonnil,		\
+			 IMPScolless, sizeof(TYPE));			\
+} while (0)
+
+/* Strings are binned on an order-preserving prefix: the first eight
+ * bytes of the string, taken big-endian as an unsigned integer (and
+ * padded with zero bytes).  If strcmp(x, y) <= 0 then also
+ * IMPSstrprefix(x) <= IMPSstrprefix(y), so the bins can be used to
+ * exclude pages, but values that fall into a candidate page must
+ * still be compared in full.  The page size is determined by the
+ * width of the offset heap, not by the string values. */
+static inline ulng
+IMPSstrprefix(const char *s)
+{
+	const unsigned char *u = (const unsigned char *) s;
+	ulng pfx = 0;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		pfx <<= 8;
+		if (*u)
+			pfx |= *u++;
+	}
+	return pfx;
+}
+
+#define IMPSstrval(i)		IMPSstrprefix((const char *) BUNtvar(bi, b->batFirst + (i)))
+#define IMPSstrnonnil(i)	(!GDK_STRNIL((const char *) BUNtvar(bi, b->batFirst + (i))))
+/* the positions of the smallest and largest value per bin are used
+ * by BATmin and BATmax, so they compare the whole strings */
+#define IMPSstrless(i, j)						\
+	(strcmp((const char *) BUNtvar(bi, b->batFirst + (i)),		\
+		(const char *) BUNtvar(bi, b->batFirst + (j))) < 0)
+
+#define IMPS_CREATE_STR(TYPE,B)						\
+do {									\
+	BATiter bi = bat_iterator(b);					\
+	IMPS_CREATE_LOOP(TYPE, B, IMPSstrval, IMPSstrnonnil,		\
+			 IMPSstrless, b->T->width);			\
+} while (0)
+
+/* the bins of string imprints hold prefixes, all other bins hold
+ * values of the column type */
+#define IMPS_BINWIDTH(b)						\
+	(ATOMbasetype((b)->T->type) == TYPE_str ? (int) sizeof(ulng) : (b)->T->width)
+
 static int
 imprints_create(BAT *b, void *inbins, BUN *stats, bte bits,
 		void *imps, BUN *impcnt, cchdc_t *dict, BUN *dictcnt)
@@ -522,6 +576,9 @@ imprints_create(BAT *b, void *inbins, BUN *stats, bte bits,
 	case TYPE_dbl:
 		BINSIZE(bits, IMPS_CREATE, dbl);
 		break;
+	case TYPE_str:
+		BINSIZE(bits, IMPS_CREATE_STR, ulng);
+		break;
 	default:
 		/* should never reach here */
 		assert(0);
@@ -533,13 +590,13 @@ imprints_create(BAT *b, void *inbins, BUN *stats, bte bits,
 	return 1;
 }
 
-#define FILL_HISTOGRAM(TYPE)						\
+#define FILL_BINS(TYPE, SRC, MAX)					\
 do {									\
 	BUN k;								\
-	TYPE *restrict s = (TYPE *) Tloc(smp, smp->batFirst);		\
+	const TYPE *restrict s = (SRC);					\
 	TYPE *restrict h = imprints->bins;				\
 	if (cnt < 64-1) {						\
-		TYPE max = GDK_##TYPE##_max;				\
+		TYPE max = (MAX);					\
 		for (k = 0; k < cnt; k++)				\
 			h[k] = s[k];					\
 		while (k < (BUN) imprints->bits)			\
@@ -553,6 +610,9 @@ do {									\
 	}								\
 } while (0)
 
+#define FILL_HISTOGRAM(TYPE)						\
+	FILL_BINS(TYPE, (TYPE *) Tloc(smp, smp->batFirst), GDK_##TYPE##_max)
+
 /* Check whether we have imprints on b (and return true if we do).  It
  * may be that the imprints were made persistent, but we hadn't seen
  * that yet, so check the file system.  This also returns true if b is
@@ -596,7 +656,7 @@ BATcheckimprints(BAT *b)
 				    fstat(fd, &st) == 0 &&
 				    st.st_size >= (off_t) (hp->size =
 							   hp->free =
-							   64 * b->T->width +
+							   64 * IMPS_BINWIDTH(b) +
 							   64 * 2 * SIZEOF_OID +
 							   64 * SIZEOF_BUN +
 							   pages * ((bte) hdata[0] / 8) +
@@ -610,7 +670,7 @@ BATcheckimprints(BAT *b)
 					imprints->impcnt = (BUN) hdata[1];
 					imprints->dictcnt = (BUN) hdata[2];
 					imprints->bins = hp->base + 4 * SIZEOF_SIZE_T;
-					imprints->stats = (BUN *) ((char *) imprints->bins + 64 * b->T->width);
+					imprints->stats = (BUN *) ((char *) imprints->bins + 64 * IMPS_BINWIDTH(b));
 					imprints->imps = (void *) (imprints->stats + 64 * 3);
 					imprints->dict = (void *) ((uintptr_t) ((char *) imprints->imps + pages * (imprints->bits / 8) + sizeof(uint64_t)) & ~(sizeof(uint64_t) - 1));
 					close(fd);
@@ -654,6 +714,7 @@ BATimprints(BAT *b)
 #endif
 	case TYPE_flt:
 	case TYPE_dbl:
+	case TYPE_str:
 		break;
 	default:		/* type not supported */
 		/* doesn't look enough like base type: do nothing */
@@ -682,6 +743,7 @@ BATimprints(BAT *b)
 	if (b->T->imprints == NULL) {
 		BAT *smp, *s;
 		BUN cnt;
+		ulng *pfx = NULL;
 		str nme = BBP_physical(b->batCacheid);
 		size_t pages;
 		int fd;
@@ -750,6 +812,30 @@ BATimprints(BAT *b)
 		/* smp now is ordered and unique on tail */
 		assert(smp->tkey && smp->tsorted);
 		cnt = BATcount(smp);
+		if (ATOMbasetype(b->T->type) == TYPE_str) {
+			/* bin on the distinct non-nil prefixes; since
+			 * the sample is sorted, so are the prefixes */
+			BATiter si = bat_iterator(smp);
+			BUN k, n = 0;
+
+			pfx = GDKmalloc((cnt + 1) * sizeof(ulng));
+			if (pfx == NULL) {
+				MT_lock_unset(&GDKimprintsLock(abs(b->batCacheid)),
+					      "BATimprints");
+				BBPunfix(smp->batCacheid);
+				GDKfree(imprints);
+				return GDK_FAIL;
+			}
+			for (k = 0; k < cnt; k++) {
+				const char *v = BUNtail(si, BUNfirst(smp) + k);
+				if (GDK_STRNIL(v))
+					continue;
+				pfx[n] = IMPSstrprefix(v);
+				if (n == 0 || pfx[n] != pfx[n - 1])
+					n++;
+			}
+			cnt = n;
+		}
 		imprints->bits = 64;
 		if (cnt < 32)
 			imprints->bits = 32;
@@ -759,7 +845,8 @@ BATimprints(BAT *b)
 			imprints->bits = 8;
 
 		/* The heap we create here consists of four parts:
-		 * bins, max 64 entries with bin boundaries, domain of b;
+		 * bins, max 64 entries with bin boundaries, domain of b
+		 *   (for strings, their 8-byte prefixes);
 		 * stats, min/max/count for each bin, min/max are oid, and count BUN;
 		 * imps, max one entry per "page", entry is "bits" wide;
 		 * dict, max two entries per three "pages".
@@ -768,7 +855,7 @@ BATimprints(BAT *b)
 		 * trust the imprints when encountered on startup (including
 		 * a version number -- CURRENT VERSION is 2). */
 		if (HEAPalloc(imprints->imprints,
-			      64 * b->T->width +
+			      64 * IMPS_BINWIDTH(b) +
 			      64 * 2 * SIZEOF_OID +
 			      64 * SIZEOF_BUN +
 			      pages * (imprints->bits / 8) +
@@ -778,13 +865,14 @@ BATimprints(BAT *b)
 			      1) != GDK_SUCCEED) {
 			GDKfree(imprints->imprints);
 			GDKfree(imprints);
+			GDKfree(pfx);
 			GDKerror("#BATimprints: memory allocation error");
 			MT_lock_unset(&GDKimprintsLock(abs(b->batCacheid)),
 				      "BATimprints");
 			return GDK_FAIL;
 		}
 		imprints->bins = imprints->imprints->base + IMPRINTS_HEADER_SIZE * SIZEOF_SIZE_T;
-		imprints->stats = (BUN *) ((char *) imprints->bins + 64 * b->T->width);
+		imprints->stats = (BUN *) ((char *) imprints->bins + 64 * IMPS_BINWIDTH(b));
 		imprints->imps = (void *) (imprints->stats + 64 * 3);
 		imprints->dict = (void *) ((uintptr_t) ((char *) imprints->imps + pages * (imprints->bits / 8) + sizeof(uint64_t)) & ~(sizeof(uint64_t) - 1));
 
@@ -812,12 +900,16 @@ BATimprints(BAT *b)
 		case TYPE_dbl:
 			FILL_HISTOGRAM(dbl);
 			break;
+		case TYPE_str:
+			FILL_BINS(ulng, pfx, ~(ulng) 0);
+			break;
 		default:
 			/* should never reach here */
 			assert(0);
 		}
 
 		BBPunfix(smp->batCacheid);
+		GDKfree(pfx);
 
 		if (!imprints_create(b,
 				     imprints->bins,
@@ -885,6 +977,7 @@ BATimprints(BAT *b)
 }
 
 #define getbin(TYPE,B) GETBIN##B(ret, *(TYPE *)v);
+#define getbinpfx(TYPE,B) GETBIN##B(ret, pfx);
 
 int
 IMPSgetbin(int tpe, bte bits, const char *restrict inbins, const void *restrict v)
@@ -936,6 +1029,14 @@ IMPSgetbin(int tpe, bte bits, const char *restrict inbins, const void *restrict
 		BINSIZE(bits, getbin, dbl);
 	}
 		break;
+	case TYPE_str:
+	{
+		/* v is the string itself, the bins hold prefixes */
+		const ulng *restrict bins = (ulng *) inbins;
+		ulng pfx = IMPSstrprefix((const char *) v);
+		BINSIZE(bits, getbinpfx, ulng);
+	}
+		break;
 	default:
 		assert(0);
 		(void) inbins;
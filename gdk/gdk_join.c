@@ -2159,6 +2159,384 @@ hashjoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr, int nil_matches, in
 	return GDK_FAIL;
 }
 
+/* Radix-partitioned hash join.
+ *
+ * If the inner (right) input is much larger than the CPU cache, the
+ * random accesses into the hash table built by hashjoin cause a cache
+ * and TLB miss for almost every probe.  Instead, we first cluster both
+ * inputs on the lower bits of a hash of the join value into
+ * partitions whose inner part fits in the cache, and then do a hash
+ * join on each pair of corresponding partitions separately.  In order
+ * not to thrash the TLB during the clustering itself, clustering is
+ * done in (at most) two passes of at most RADIX_PASS_BITS bits each.
+ *
+ * The join values are compared bitwise, so this only works for the
+ * fixed-size numeric types.  The result is produced partition by
+ * partition, so in contrast to hashjoin, r1 is not sorted.  This join
+ * can therefore not be used for the left join variants. */
+
+#define RADIX_CACHE_SIZE	(256 * 1024) /* target partition size */
+#define RADIX_PASS_BITS		8 /* max number of bits per pass */
+#define RADIX_MAX_BITS		(2 * RADIX_PASS_BITS)
+#define RADIX_MIN_BITS		4 /* fewer partitions: use hashjoin */
+
+#define RADIXHASH_int(v)						\
+	((unsigned int) (((ulng) (unsigned int) (v) * 0x9E3779B97F4A7C15ULL) >> 32))
+#define RADIXHASH_lng(v)						\
+	((unsigned int) (((ulng) (v) * 0x9E3779B97F4A7C15ULL) >> 32))
+#ifdef HAVE_HGE
+#define RADIXHASH_hge(v)						\
+	RADIXHASH_lng((ulng) ((uhge) (v) ^ ((uhge) (v) >> 64)))
+#endif
+
+#define radixjoin_impl(TYPE)						\
+struct radix_##TYPE {							\
+	TYPE v;								\
+	oid o;								\
+};									\
+									\
+/* collect the (value, oid) pairs of the candidates of b into dst;	\
+ * nils are skipped unless they can match */				\
+static BUN								\
+radix_collect_##TYPE(struct radix_##TYPE *restrict dst, BAT *b,	\
+		     BUN start, BUN end,				\
+		     const oid *cand, const oid *candend,		\
+		     int nil_matches)					\
+{									\
+	const TYPE *restrict vals = (const TYPE *) Tloc(b, BUNfirst(b)); \
+	TYPE nil;							\
+	BUN n = 0;							\
+	oid o;								\
+									\
+	memcpy(&nil, ATOMnilptr(b->ttype), sizeof(TYPE));		\
+	if (cand) {							\
+		while (cand < candend) {				\
+			o = *cand++;					\
+			dst[n].v = vals[o - b->hseqbase];		\
+			dst[n].o = o;					\
+			n += nil_matches || dst[n].v != nil;		\
+		}							\
+	} else {							\
+		for (o = b->hseqbase + start; start < end; start++, o++) { \
+			dst[n].v = vals[start];				\
+			dst[n].o = o;					\
+			n += nil_matches || dst[n].v != nil;		\
+		}							\
+	}								\
+	return n;							\
+}									\
+									\
+/* stable cluster of n tuples from src into dst on hash bits	\
+ * shift..shift+bits-1; on return, pos[i] is the end of cluster i */	\
+static void								\
+radix_cluster_##TYPE(const struct radix_##TYPE *restrict src,		\
+		     struct radix_##TYPE *restrict dst, BUN n,		\
+		     int shift, int bits, BUN *restrict pos)		\
+{									\
+	BUN i, j, c;							\
+	BUN np = (BUN) 1 << bits, mask = np - 1;			\
+									\
+	memset(pos, 0, np * sizeof(BUN));				\
+	for (i = 0; i < n; i++)						\
+		pos[(RADIXHASH_##TYPE(src[i].v) >> shift) & mask]++;	\
+	for (i = 0, j = 0; i < np; i++) {				\
+		c = pos[i];						\
+		pos[i] = j;						\
+		j += c;							\
+	}								\
+	for (i = 0; i < n; i++)						\
+		dst[pos[(RADIXHASH_##TYPE(src[i].v) >> shift) & mask]++] = src[i]; \
+}									\
+									\
+/* cluster the n tuples in *bufp on the lower nbits bits of the hash; \
+ * the result ends up in *bufp (the buffers may be swapped, so both	\
+ * must be able to hold the tuples of either input), and partition i	\
+ * is bounds[i]..bounds[i+1]-1 */					\
+static void								\
+radix_partition_##TYPE(struct radix_##TYPE **bufp,			\
+		       struct radix_##TYPE **tmpp, BUN n, int nbits,	\
+		       BUN *restrict pos1, BUN *restrict pos2,		\
+		       BUN *restrict bounds)				\
+{									\
+	struct radix_##TYPE *a = *bufp, *b = *tmpp;			\
+	int bits2 = nbits > RADIX_PASS_BITS ? nbits / 2 : 0;		\
+	int bits1 = nbits - bits2;					\
+	BUN i, j, start;						\
+									\
+	radix_cluster_##TYPE(a, b, n, bits2, bits1, pos1);		\
+	bounds[0] = 0;							\
+	if (bits2 == 0) {						\
+		for (i = 0; i < (BUN) 1 << bits1; i++)			\
+			bounds[i + 1] = pos1[i];			\
+		*bufp = b;						\
+		*tmpp = a;						\
+		return;							\
+	}								\
+	for (i = 0, start = 0; i < (BUN) 1 << bits1; i++) {		\
+		radix_cluster_##TYPE(b + start, a + start,		\
+				     pos1[i] - start, 0, bits2, pos2);	\
+		for (j = 0; j < (BUN) 1 << bits2; j++)			\
+			bounds[(i << bits2) + j + 1] = start + pos2[j];	\
+		start = pos1[i];					\
+	}								\
+}									\
+									\
+static gdk_return							\
+radixjoin_##TYPE(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr,	\
+		 int nil_matches, int nil_on_miss, int semi,		\
+		 int must_match, BUN maxsize, int nbits, int *nomem)	\
+{									\
+	BUN lstart, lend, lcnt;						\
+	const oid *lcand, *lcandend;					\
+	BUN rstart, rend, rcnt;						\
+	const oid *rcand, *rcandend;					\
+	struct radix_##TYPE *lt = NULL, *rt = NULL, *tmp = NULL;	\
+	BUN *lbounds = NULL, *rbounds = NULL, *bkt = NULL, *nxt = NULL;	\
+	BUN pos1[(BUN) 1 << RADIX_PASS_BITS];				\
+	BUN pos2[(BUN) 1 << RADIX_PASS_BITS];				\
+	BUN np = (BUN) 1 << nbits;					\
+	BUN p, i, j, maxpart, nbkt, bmask, nr, newcap, maxcnt;		\
+	oid lo, ro;							\
+	TYPE v;								\
+									\
+	CANDINIT(l, sl, lstart, lend, lcnt, lcand, lcandend);		\
+	CANDINIT(r, sr, rstart, rend, rcnt, rcand, rcandend);		\
+	lcnt = lcand ? (BUN) (lcandend - lcand) : lend - lstart;	\
+	rcnt = rcand ? (BUN) (rcandend - rcand) : rend - rstart;	\
+	/* radix_partition swaps buffers, so after the outer input has	\
+	 * been partitioned, the inner one is clustered into what was	\
+	 * the outer input's buffer: all three must be equally large */ \
+	maxcnt = MAX(lcnt, rcnt);					\
+	if ((lt = GDKmalloc(maxcnt * sizeof(*lt))) == NULL ||		\
+	    (rt = GDKmalloc(maxcnt * sizeof(*rt))) == NULL ||		\
+	    (tmp = GDKmalloc(maxcnt * sizeof(*tmp))) == NULL ||	\
+	    (lbounds = GDKmalloc((np + 1) * sizeof(BUN))) == NULL ||	\
+	    (rbounds = GDKmalloc((np + 1) * sizeof(BUN))) == NULL) {	\
+		*nomem = 1;						\
+		goto bailout;						\
+	}								\
+	lcnt = radix_collect_##TYPE(lt, l, lstart, lend, lcand, lcandend, \
+				    nil_matches);			\
+	rcnt = radix_collect_##TYPE(rt, r, rstart, rend, rcand, rcandend, \
+				    nil_matches);			\
+	radix_partition_##TYPE(&lt, &tmp, lcnt, nbits, pos1, pos2, lbounds); \
+	radix_partition_##TYPE(&rt, &tmp, rcnt, nbits, pos1, pos2, rbounds); \
+									\
+	/* allocate the per-partition hash table for the largest	\
+	 * partition of the inner input */				\
+	for (p = 0, maxpart = 1; p < np; p++)				\
+		if (rbounds[p + 1] - rbounds[p] > maxpart)		\
+			maxpart = rbounds[p + 1] - rbounds[p];		\
+	for (nbkt = 1;							\
+	     nbkt < maxpart && nbkt < ((BUN) 1 << (32 - nbits));	\
+	     nbkt <<= 1)						\
+		;							\
+	if ((bkt = GDKmalloc(nbkt * sizeof(BUN))) == NULL ||		\
+	    (nxt = GDKmalloc(maxpart * sizeof(BUN))) == NULL) {		\
+		*nomem = 1;						\
+		goto bailout;						\
+	}								\
+									\
+	for (p = 0; p < np; p++) {					\
+		const struct radix_##TYPE *restrict rp = rt + rbounds[p]; \
+		BUN rn = rbounds[p + 1] - rbounds[p];			\
+									\
+		if (lbounds[p] == lbounds[p + 1])			\
+			continue;					\
+		for (bmask = 1; bmask < rn && bmask < nbkt; bmask <<= 1) \
+			;						\
+		bmask--;						\
+		for (i = 0; i <= bmask; i++)				\
+			bkt[i] = BUN_NONE;				\
+		/* insert back to front so that chains are in order */	\
+		for (i = rn; i > 0; i--) {				\
+			j = (RADIXHASH_##TYPE(rp[i - 1].v) >> nbits) & bmask; \
+			nxt[i - 1] = bkt[j];				\
+			bkt[j] = i - 1;					\
+		}							\
+		for (i = lbounds[p]; i < lbounds[p + 1]; i++) {		\
+			v = lt[i].v;					\
+			lo = lt[i].o;					\
+			nr = 0;						\
+			for (j = bkt[(RADIXHASH_##TYPE(v) >> nbits) & bmask]; \
+			     j != BUN_NONE;				\
+			     j = nxt[j]) {				\
+				if (rp[j].v != v)			\
+					continue;			\
+				ro = rp[j].o;				\
+				HASHLOOPBODY();				\
+				if (semi)				\
+					break;				\
+			}						\
+			if (nr == 0) {					\
+				if (nil_on_miss) {			\
+					r2->T->nil = 1;			\
+					r2->T->nonil = 0;		\
+					r2->tkey = 0;			\
+					ro = oid_nil;			\
+					HASHLOOPBODY();			\
+				} else if (must_match) {		\
+					GDKerror("radixjoin(%s,%s) does not hit always => can't use fetchjoin.\n", BATgetId(l), BATgetId(r)); \
+					goto bailout;			\
+				}					\
+			} else if (nr > 1) {				\
+				r1->tkey = 0;				\
+			}						\
+		}							\
+	}								\
+	GDKfree(lt);							\
+	GDKfree(rt);							\
+	GDKfree(tmp);							\
+	GDKfree(lbounds);						\
+	GDKfree(rbounds);						\
+	GDKfree(bkt);							\
+	GDKfree(nxt);							\
+	return GDK_SUCCEED;						\
+									\
+  bailout:								\
+	GDKfree(lt);							\
+	GDKfree(rt);							\
+	GDKfree(tmp);							\
+	GDKfree(lbounds);						\
+	GDKfree(rbounds);						\
+	GDKfree(bkt);							\
+	GDKfree(nxt);							\
+	return GDK_FAIL;						\
+}
+
+radixjoin_impl(int)
+radixjoin_impl(lng)
+#ifdef HAVE_HGE
+radixjoin_impl(hge)
+#endif
+
+/* Return the number of radix bits to use for joining l with r (the
+ * inner input), or 0 if the radix join should not be used.  The
+ * partitioned copies of both inputs (plus a scratch buffer), each as
+ * large as the larger input, must fit in mem_size. */
+static int
+radixjoin_bits(BAT *l, BAT *r, BUN lcount, BUN rcount, size_t mem_size)
+{
+	int nbits = 0;
+	size_t size, tsize;
+
+	switch (ATOMbasetype(r->ttype)) {
+	case TYPE_int:
+	case TYPE_lng:
+#ifdef HAVE_HGE
+	case TYPE_hge:
+#endif
+	case TYPE_flt:
+	case TYPE_dbl:
+	case TYPE_oid:
+		break;
+	default:
+		return 0;
+	}
+	if (ATOMbasetype(l->ttype) != ATOMbasetype(r->ttype))
+		return 0;
+	/* a (value, oid) pair, including padding */
+	tsize = 2 * MAX(Tsize(r), sizeof(oid));
+	if ((size_t) 3 * MAX(lcount, rcount) * tsize > mem_size)
+		return 0;
+	size = (size_t) rcount * (Tsize(r) + sizeof(oid));
+	while (nbits < RADIX_MAX_BITS && (size >> nbits) > RADIX_CACHE_SIZE)
+		nbits++;
+	return nbits < RADIX_MIN_BITS ? 0 : nbits;
+}
+
+static gdk_return
+radixjoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr, int nil_matches, int nil_on_miss, int semi, int must_match, BUN maxsize, int nbits)
+{
+	gdk_return rc;
+	int nomem = 0;
+
+	ALGODEBUG fprintf(stderr, "#radixjoin(l=%s#" BUNFMT "[%s],"
+			  "r=%s#" BUNFMT "[%s],sl=%s#" BUNFMT ","
+			  "sr=%s#" BUNFMT ",nil_matches=%d,"
+			  "nil_on_miss=%d,semi=%d,must_match=%d,nbits=%d)\n",
+			  BATgetId(l), BATcount(l), ATOMname(l->ttype),
+			  BATgetId(r), BATcount(r), ATOMname(r->ttype),
+			  sl ? BATgetId(sl) : "NULL", sl ? BATcount(sl) : 0,
+			  sr ? BATgetId(sr) : "NULL", sr ? BATcount(sr) : 0,
+			  nil_matches, nil_on_miss, semi, must_match, nbits);
+
+	assert(BAThdense(l));
+	assert(BAThdense(r));
+	assert(!nil_on_miss || !must_match); /* can't have both */
+
+	/* r1 is produced partition by partition */
+	r1->tkey = r->tkey != 0;
+	r1->tsorted = 0;
+	r1->trevsorted = 0;
+	r1->tdense = 0;
+	r2->tkey = l->tkey != 0;
+	r2->tsorted = 0;
+	r2->trevsorted = 0;
+	r2->tdense = 0;
+
+	switch (Tsize(r)) {
+	case 4:
+		rc = radixjoin_int(r1, r2, l, r, sl, sr, nil_matches,
+				   nil_on_miss, semi, must_match, maxsize,
+				   nbits, &nomem);
+		break;
+	case 8:
+		rc = radixjoin_lng(r1, r2, l, r, sl, sr, nil_matches,
+				   nil_on_miss, semi, must_match, maxsize,
+				   nbits, &nomem);
+		break;
+#ifdef HAVE_HGE
+	case 16:
+		rc = radixjoin_hge(r1, r2, l, r, sl, sr, nil_matches,
+				   nil_on_miss, semi, must_match, maxsize,
+				   nbits, &nomem);
+		break;
+#endif
+	default:
+		assert(0);
+		rc = GDK_FAIL;
+		break;
+	}
+	if (rc != GDK_SUCCEED && nomem) {
+		/* couldn't allocate the partitions; nothing was
+		 * produced yet, so do a plain hash join instead */
+		GDKclrerr();
+		ALGODEBUG fprintf(stderr, "#radixjoin(l=%s,r=%s): "
+				  "out of memory, using hashjoin\n",
+				  BATgetId(l), BATgetId(r));
+		return hashjoin(r1, r2, l, r, sl, sr, nil_matches,
+				nil_on_miss, semi, must_match, maxsize);
+	}
+	if (rc != GDK_SUCCEED) {
+		BBPreclaim(r1);
+		BBPreclaim(r2);
+		return GDK_FAIL;
+	}
+	assert(BATcount(r1) == BATcount(r2));
+	BATsetcount(r1, BATcount(r1));
+	BATsetcount(r2, BATcount(r2));
+	if (BATcount(r1) <= 1) {
+		r1->tsorted = 1;
+		r1->trevsorted = 1;
+		r1->tkey = 1;
+		r1->tdense = 1;
+		r2->tsorted = 1;
+		r2->trevsorted = 1;
+		r2->tkey = 1;
+		r2->tdense = 1;
+		if (BATcount(r1) == 1) {
+			r1->tseqbase = ((oid *) r1->T->heap.base)[r1->batFirst];
+			r2->tseqbase = ((oid *) r2->T->heap.base)[r2->batFirst];
+		}
+	}
+	ALGODEBUG fprintf(stderr, "#radixjoin(l=%s,r=%s)=(%s#"BUNFMT",%s#"BUNFMT")\n",
+		  BATgetId(l), BATgetId(r),
+		  BATgetId(r1), BATcount(r1),
+		  BATgetId(r2), BATcount(r2));
+	return GDK_SUCCEED;
+}
+
 #define MASK_EQ		1
 #define MASK_LT		2
 #define MASK_GT		4
@@ -3062,6 +3440,19 @@ BATsubjoin(BAT **r1p, BAT **r2p, BAT *l, BAT *r, BAT *sl, BAT *sr, int nil_match
 		/* no hashes, not sorted, create hash on smallest BAT */
 		swap = 1;
 	}
+	if (!lhash && !rhash) {
+		/* no hash to reuse; if the hash table would be much
+		 * larger than the cache, use a partitioned join */
+		int nbits;
+
+		if (swap) {
+			if ((nbits = radixjoin_bits(r, l, rcount, lcount, mem_size)) > 0)
+				return radixjoin(r2, r1, r, l, sr, sl, nil_matches, 0, 0, 0, maxsize, nbits);
+		} else {
+			if ((nbits = radixjoin_bits(l, r, lcount, rcount, mem_size)) > 0)
+				return radixjoin(r1, r2, l, r, sl, sr, nil_matches, 0, 0, 0, maxsize, nbits);
+		}
+	}
 	if (swap) {
 		return hashjoin(r2, r1, r, l, sr, sl, nil_matches, 0, 0, 0, maxsize);
 	} else {
@@ -3404,7 +3795,15 @@ BATproject(BAT *l, BAT *r)
 	}
 	bn->T->nil = 0;
 
-	switch (tpe) {
+	if (r->T->heap.storage == STORE_MMAP &&
+	    (stringtrick ||
+	     (ATOMstorage(tpe) == tpe && !ATOMvarsized(tpe))) &&
+	    BATcheckcompress(r)) {
+		/* decode from the compressed copy, leaving the
+		 * memory mapped tail alone; with the string trick
+		 * this produces offsets into r's string heap */
+		res = CMPproject(bn, l, r);
+	} else switch (tpe) {
 	case TYPE_bte:
 		res = project_bte(bn, l, r, nilcheck, sortcheck);
 		break;
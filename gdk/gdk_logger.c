@@ -23,11 +23,15 @@
  * file stores information about the version of the logger and the
  * transaction log files. This file is a simple ascii file with the
  * following format:
- *  {6DIGIT-VERSION\n[log file number \n]*]*}
+ *  {6DIGIT-VERSION LOG-FORMAT\n[log file number \n]*]*}
  * The transaction log files have a binary format, which stores fixed
  * size logformat headers (flag,nr,bid), where the flag is the type of
  * update logged.  The nr field indicates how many changes there were
  * (in case of inserts/deletes).  The bid stores the bid identifier.
+ * Since log format 2 the records are written through a frame stream,
+ * which compresses them in blocks and protects each block with a
+ * checksum, so that a log that ends in a partially written block (a
+ * torn tail) is read up to that block.
  *
  * The key decision to be made by the user is the location of the log
  * file.  Ideally, it should be stored in fail-safe environment, or at
@@ -98,8 +102,47 @@ typedef struct logformat_t {
 
 #define LOGFILE "log"
 
+/* format of the log files: 1 are plain records, which is assumed when
+ * the log file doesn't say, 2 are records in a frame stream */
+#define LOG_FORMAT	2
+
+/* parallel replay, see tr_commit */
+#define REPLAY_MINSIZE	((off_t) 1 << 20) /* smaller logs are replayed sequentially */
+#define REPLAY_QUEUE	256	/* changes queued per worker */
+#define REPLAY_BARRIER	(-1)	/* queue entries that aren't changes */
+#define REPLAY_QUIT	(-2)
+
+typedef struct replay replay;
+
+typedef struct replayworker {
+	replay *rp;
+	MT_Id tid;
+	MT_Sema todo;		/* queued entries */
+	MT_Sema room;		/* free places in the queue */
+	int head, tail;
+	logaction q[REPLAY_QUEUE];
+} replayworker;
+
+/* the types of a bat as needed to decode its changes */
+typedef struct replaytypes {
+	unsigned char known, ht, tt, seq;
+} replaytypes;
+
+struct replay {
+	logger *lg;
+	int nworkers;
+	MT_Sema done;		/* workers that reached a barrier */
+	replayworker *w;
+	replaytypes *types;	/* by bat id, see log_read_types */
+	bat ntypes;
+};
+
+int logger_commits = 0;		/* transaction commits */
+int logger_flushes = 0;		/* fsyncs of the log at commit */
+
 static int bm_commit(logger *lg);
 static int tr_grow(trans *tr);
+static void replay_barrier(replay *rp, int quit);
 
 static BUN
 log_find(BAT *b, BAT *d, int val)
@@ -245,20 +288,31 @@ avoid_snapshot( logger *lg, log_bid bid )
 	return 0;
 }
 
+/* the bat a clear, insert, delete or update applies to, or 0 if the
+ * action is to be skipped */
+static log_bid
+la_bat_find(logger *lg, logaction *la)
+{
+	log_bid bid = logger_find_bat(lg, la->name);
+
+	if (bid == 0)
+		return 0;	/* ignore bats no longer in the catalog */
+
+	/* do we need to skip these old updates */
+	if (avoid_snapshot(lg, bid)) 
+		return 0;
+	return bid;
+}
+
 static void
 la_bat_clear(logger *lg, logaction *la)
 {
-	log_bid bid = logger_find_bat(lg, la->name);
 	BAT *b;
 
 	if (lg->debug & 1)
 		fprintf(stderr, "#la_bat_clear %s\n", la->name);
 
-	/* do we need to skip these old updates */
-	if (avoid_snapshot(lg, bid)) 
-		return;
-
-	b = BATdescriptor(bid);
+	b = BATdescriptor((bat) la->id);
 	if (b) {
 		int access = b->batRestricted;
 		b->batRestricted = BAT_WRITE;
@@ -295,8 +349,53 @@ log_read_seq(logger *lg, logformat *l)
 	return LOG_OK;
 }
 
+/* The types of bat b.  When replaying in parallel, a worker may be
+ * changing b (and appending strings temporarily changes its type), so
+ * the types are remembered from the first time b is seen, which is
+ * before any of its changes are handed to a worker. */
+static void
+log_read_types(replay *rp, BAT *b, int *ht, int *tt, int *hseq, int *tseq)
+{
+	replaytypes *t = NULL;
+	bat bid = b->batCacheid;
+
+	if (rp && bid >= rp->ntypes) {
+		bat n = MAX(bid + 1, 2 * rp->ntypes);
+
+		if ((t = GDKrealloc(rp->types, n * sizeof(replaytypes))) != NULL) {
+			memset(t + rp->ntypes, 0, (n - rp->ntypes) * sizeof(replaytypes));
+			rp->types = t;
+			rp->ntypes = n;
+		} else {
+			/* can't remember, so make sure the bat is
+			 * left alone */
+			replay_barrier(rp, 0);
+		}
+	}
+	if (rp && bid < rp->ntypes) {
+		t = &rp->types[bid];
+		if (t->known) {
+			*ht = t->ht;
+			*tt = t->tt;
+			*hseq = t->seq & 1;
+			*tseq = (t->seq & 2) != 0;
+			return;
+		}
+	}
+	*ht = b->htype;
+	*hseq = *ht == TYPE_void && b->hseqbase != oid_nil;
+	*tt = b->ttype;
+	*tseq = *tt == TYPE_void && b->tseqbase != oid_nil;
+	if (t) {
+		t->known = 1;
+		t->ht = (unsigned char) *ht;
+		t->tt = (unsigned char) *tt;
+		t->seq = (unsigned char) (*hseq | *tseq << 1);
+	}
+}
+
 static int
-log_read_updates(logger *lg, trans *tr, logformat *l, char *name)
+log_read_updates(logger *lg, trans *tr, logformat *l, char *name, replay *rp)
 {
 	log_bid bid = logger_find_bat(lg, name);
 	BAT *b = BATdescriptor(bid);
@@ -307,12 +406,7 @@ log_read_updates(logger *lg, trans *tr, logformat *l, char *name)
 		fprintf(stderr, "#logger found log_read_updates %s %s " LLFMT "\n", name, l->flag == LOG_INSERT ? "insert" : l->flag == LOG_DELETE ? "delete" : "update", l->nr);
 
 	if (b) {
-		ht = b->htype;
-		if (ht == TYPE_void && b->hseqbase != oid_nil)
-			hseq = 1;
-		tt = b->ttype;
-		if (tt == TYPE_void && b->tseqbase != oid_nil)
-			tseq = 1;
+		log_read_types(rp, b, &ht, &tt, &hseq, &tseq);
 	} else {		/* search trans action for create statement */
 		int i;
 
@@ -363,7 +457,32 @@ log_read_updates(logger *lg, trans *tr, logformat *l, char *name)
 		if (tseq)
 			BATseqbase(BATmirror(r), 0);
 
-		if (ht == TYPE_void && l->flag == LOG_INSERT) {
+		if (r == NULL) {
+			res = LOG_ERR;
+		} else if (ht == TYPE_void && l->flag != LOG_UPDATE &&
+			   tt > TYPE_void && tt < TYPE_str &&
+			   tt != TYPE_ptr
+#if SIZEOF_OID == 8
+			   && !(tt == TYPE_oid && lg->read32bitoid)
+#endif
+			) {
+			/* fixed-size values are read straight into the
+			 * bat instead of being appended one by one */
+			if (l->nr > 0 &&
+			    rt(Tloc(r, BUNfirst(r)), lg->log, (size_t) l->nr) == NULL) {
+				res = LOG_ERR;
+			} else {
+				BATsetcount(r, (BUN) l->nr);
+				if (l->nr > 1) {
+					r->tsorted = r->trevsorted = 0;
+					r->tkey = 0;
+					r->tdense = 0;
+				}
+				r->T->nonil = 0;
+				r->T->nil = 0;
+				l->nr = 0;
+			}
+		} else if (ht == TYPE_void && l->flag == LOG_INSERT) {
 			for (; l->nr > 0; l->nr--) {
 				void *t = rt(tv, lg->log, 1);
 
@@ -471,17 +590,10 @@ log_read_updates(logger *lg, trans *tr, logformat *l, char *name)
 static void
 la_bat_updates(logger *lg, logaction *la)
 {
-	log_bid bid = logger_find_bat(lg, la->name);
 	BAT *b;
 
-	if (bid == 0)
-		return;		/* ignore bats no longer in the catalog */
-
-	/* do we need to skip these old updates */
-	if (avoid_snapshot(lg, bid)) 
-		return;
-
-	b = BATdescriptor(bid);
+	(void) lg;
+	b = BATdescriptor((bat) la->id);
 	assert(b);
 	if (b) {
 		if (b->htype == TYPE_void && la->type == LOG_INSERT) {
@@ -737,7 +849,8 @@ la_apply(logger *lg, logaction *c)
 	case LOG_INSERT:
 	case LOG_DELETE:
 	case LOG_UPDATE:
-		la_bat_updates(lg, c);
+		if ((c->id = la_bat_find(lg, c)) != 0)
+			la_bat_updates(lg, c);
 		break;
 	case LOG_CREATE:
 		la_bat_create(lg, c);
@@ -749,7 +862,8 @@ la_apply(logger *lg, logaction *c)
 		la_bat_destroy(lg, c);
 		break;
 	case LOG_CLEAR:
-		la_bat_clear(lg, c);
+		if ((c->id = la_bat_find(lg, c)) != 0)
+			la_bat_clear(lg, c);
 		break;
 	}
 	lg->changes++;
@@ -789,8 +903,130 @@ tr_destroy(trans *tr)
 	return r;
 }
 
+/*
+ * Parallel replay.
+ *
+ * Reading (decoding) the log is sequential, but the changes of the
+ * committed transactions to different bats are independent.  When
+ * replaying a large log, the reader hands the inserts, deletes,
+ * updates and clears to a number of worker threads, choosing the
+ * worker by bat id, so that the changes to a bat are applied in log
+ * order.  Whether a change is to be applied at all (see la_bat_find)
+ * is decided by the reader, as that depends on the state of the
+ * logger at the time of the commit.  Changes to the logger's catalog
+ * (create, use and destroy) are applied by the reader itself after
+ * the workers have applied everything handed to them before.
+ */
+static void
+replay_worker(void *arg)
+{
+	replayworker *w = arg;
+
+	for (;;) {
+		logaction la;
+
+		MT_sema_down(&w->todo, "replay_worker");
+		la = w->q[w->head];
+		w->head = (w->head + 1) % REPLAY_QUEUE;
+		MT_sema_up(&w->room, "replay_worker");
+		if (la.type == REPLAY_BARRIER || la.type == REPLAY_QUIT) {
+			MT_sema_up(&w->rp->done, "replay_worker");
+			if (la.type == REPLAY_QUIT)
+				break;
+			continue;
+		}
+		if (la.type == LOG_CLEAR)
+			la_bat_clear(w->rp->lg, &la);
+		else
+			la_bat_updates(w->rp->lg, &la);
+		la_destroy(&la);
+	}
+}
+
+static void
+replay_queue(replayworker *w, logaction *la)
+{
+	MT_sema_down(&w->room, "replay_queue");
+	w->q[w->tail] = *la;
+	w->tail = (w->tail + 1) % REPLAY_QUEUE;
+	MT_sema_up(&w->todo, "replay_queue");
+}
+
+/* wait until the workers have applied all changes handed to them; if
+ * quit is set they also stop */
+static void
+replay_barrier(replay *rp, int quit)
+{
+	logaction la;
+	int i;
+
+	memset(&la, 0, sizeof(la));
+	la.type = quit ? REPLAY_QUIT : REPLAY_BARRIER;
+	for (i = 0; i < rp->nworkers; i++)
+		replay_queue(&rp->w[i], &la);
+	for (i = 0; i < rp->nworkers; i++)
+		MT_sema_down(&rp->done, "replay_barrier");
+	/* the workers are idle now, and as the catalog may change,
+	 * forget the types of the bats */
+	if (rp->types)
+		memset(rp->types, 0, rp->ntypes * sizeof(replaytypes));
+}
+
+static void
+replay_stop(replay *rp)
+{
+	int i;
+
+	replay_barrier(rp, 1);
+	for (i = 0; i < rp->nworkers; i++) {
+		MT_join_thread(rp->w[i].tid);
+		MT_sema_destroy(&rp->w[i].todo);
+		MT_sema_destroy(&rp->w[i].room);
+	}
+	MT_sema_destroy(&rp->done);
+	GDKfree(rp->types);
+	GDKfree(rp->w);
+	GDKfree(rp);
+}
+
+static replay *
+replay_start(logger *lg, int nworkers)
+{
+	replay *rp;
+	int i;
+
+	if ((rp = GDKzalloc(sizeof(replay))) == NULL)
+		return NULL;
+	if ((rp->w = GDKzalloc(nworkers * sizeof(replayworker))) == NULL) {
+		GDKfree(rp);
+		return NULL;
+	}
+	rp->lg = lg;
+	MT_sema_init(&rp->done, 0, "replay_done");
+	for (i = 0; i < nworkers; i++) {
+		replayworker *w = &rp->w[i];
+
+		w->rp = rp;
+		MT_sema_init(&w->todo, 0, "replay_todo");
+		MT_sema_init(&w->room, REPLAY_QUEUE, "replay_room");
+		if (MT_create_thread(&w->tid, replay_worker, w,
+				     MT_THR_JOINABLE) < 0) {
+			MT_sema_destroy(&w->todo);
+			MT_sema_destroy(&w->room);
+			break;
+		}
+		rp->nworkers++;
+	}
+	if (rp->nworkers < 2) {
+		/* not worth it */
+		replay_stop(rp);
+		return NULL;
+	}
+	return rp;
+}
+
 static trans *
-tr_commit(logger *lg, trans *tr)
+tr_commit(logger *lg, trans *tr, replay *rp)
 {
 	int i;
 
@@ -798,8 +1034,24 @@ tr_commit(logger *lg, trans *tr)
 		fprintf(stderr, "#tr_commit\n");
 
 	for (i = 0; i < tr->nr; i++) {
-		la_apply(lg, &tr->changes[i]);
-		la_destroy(&tr->changes[i]);
+		logaction *c = &tr->changes[i];
+
+		if (rp == NULL) {
+			la_apply(lg, c);
+		} else if (c->type == LOG_CREATE || c->type == LOG_USE ||
+			   c->type == LOG_DESTROY) {
+			replay_barrier(rp, 0);
+			la_apply(lg, c);
+		} else {
+			if ((c->id = la_bat_find(lg, c)) != 0) {
+				/* the worker owns the change now */
+				replay_queue(&rp->w[c->id % rp->nworkers], c);
+				c->name = NULL;
+				c->b = NULL;
+			}
+			lg->changes++;
+		}
+		la_destroy(c);
 	}
 	return tr_destroy(tr);
 }
@@ -826,10 +1078,16 @@ logger_open(logger *lg)
 
 	snprintf(filename, sizeof(filename), "%s%s." LLFMT, lg->dir, LOGFILE, lg->id);
 
-	lg->log = open_wstream(filename);
+	lg->file = open_wstream(filename);
+	lg->log = NULL;
 	lg->end = 0;
 
-	if (lg->log == NULL || mnstr_errnr(lg->log) || log_sequence_nrs(lg) != LOG_OK) { 
+	if (lg->file != NULL && mnstr_errnr(lg->file) == 0 &&
+	    (lg->log = frame_stream(lg->file)) == NULL) {
+		close_stream(lg->file);
+		lg->file = NULL;
+	}
+	if (lg->log == NULL || log_sequence_nrs(lg) != LOG_OK) { 
 		fprintf(stderr, "!ERROR: logger_open: creating %s failed\n", filename);
 		return LOG_ERR;
 	}
@@ -842,9 +1100,25 @@ logger_close(logger *lg)
 	stream *log = lg->log;
 
 	if (log) {
+		/* wait for a running group flush, and make the
+		 * transactions that still wait for one durable */
+		MT_lock_set(&lg->flush_lock, "logger_close");
+		while (lg->flushing) {
+			MT_lock_unset(&lg->flush_lock, "logger_close");
+			MT_sleep_ms(1);
+			MT_lock_set(&lg->flush_lock, "logger_close");
+		}
+		if (lg->flushed < lg->tends) {
+			if (mnstr_flush(log) || mnstr_fsync(log))
+				fprintf(stderr, "!ERROR: logger_close: flush failed\n");
+			lg->flushed = lg->tends;
+			logger_flushes++;
+		}
 		close_stream(log);
+		lg->log = NULL;
+		lg->file = NULL;
+		MT_lock_unset(&lg->flush_lock, "logger_close");
 	}
-	lg->log = NULL;
 }
 
 static int
@@ -853,28 +1127,40 @@ logger_readlog(logger *lg, char *filename)
 	trans *tr = NULL;
 	logformat l;
 	int err = 0;
-	time_t t0, t1;
+	time_t t0, t1, tstart;
 	struct stat sb;
 	lng fpos;
+	replay *rp = NULL;
+	int ntrans = 0;
 
-	lg->log = open_rstream(filename);
+	lg->file = open_rstream(filename);
 
 	/* if the file doesn't exist, there is nothing to be read back */
-	if (!lg->log || mnstr_errnr(lg->log)) {
-		if (lg->log)
-			mnstr_destroy(lg->log);
-		lg->log = NULL;
+	if (!lg->file || mnstr_errnr(lg->file)) {
+		if (lg->file)
+			mnstr_destroy(lg->file);
+		lg->file = NULL;
 		return 0;
 	}
-	if (fstat(fileno(getFile(lg->log)), &sb) < 0) {
+	if (fstat(fileno(getFile(lg->file)), &sb) < 0) {
 		fprintf(stderr, "!ERROR: logger_readlog: fstat on opened file %s failed\n", filename);
-		mnstr_destroy(lg->log);
-		lg->log = NULL;
+		mnstr_destroy(lg->file);
+		lg->file = NULL;
 		return 0;
 	}
-	t0 = time(NULL);
+	if (lg->format < 2)
+		lg->log = lg->file;
+	else if ((lg->log = frame_stream(lg->file)) == NULL) {
+		fprintf(stderr, "!ERROR: logger_readlog: reading %s failed\n", filename);
+		mnstr_destroy(lg->file);
+		lg->file = NULL;
+		return 0;
+	}
+	tstart = t0 = time(NULL);
 	printf("# Start reading the write-ahead log '%s'\n", filename);
 	fflush(stdout);
+	if (sb.st_size >= REPLAY_MINSIZE && GDKnr_threads > 1)
+		rp = replay_start(lg, GDKnr_threads);
 	while (!err && log_read_format(lg, &l)) {
 		char *name = NULL;
 
@@ -882,8 +1168,8 @@ logger_readlog(logger *lg, char *filename)
 		if (t1 - t0 > 10) {
 			t0 = t1;
 			/* not more than once every 10 seconds */
-			if (mnstr_fgetpos(lg->log, &fpos) == 0) {
-				printf("# still reading write-ahead log \"%s\" (%d%% done)\n", filename, (int) ((fpos * 100 + 50) / sb.st_size));
+			if (mnstr_fgetpos(lg->file, &fpos) == 0 && fpos > 0) {
+				printf("# still reading write-ahead log \"%s\" (%d%% done, %d transactions replayed, about " LLFMT " seconds left)\n", filename, (int) ((fpos * 100 + 50) / sb.st_size), ntrans, (lng) (t1 - tstart) * (sb.st_size - fpos) / fpos);
 				fflush(stdout);
 			}
 		}
@@ -924,8 +1210,10 @@ logger_readlog(logger *lg, char *filename)
 				err = 1;
 			else if (l.tid != l.nr)	/* abort record */
 				tr = tr_abort(lg, tr);
-			else
-				tr = tr_commit(lg, tr);
+			else {
+				tr = tr_commit(lg, tr, rp);
+				ntrans++;
+			}
 			break;
 		case LOG_SEQ:
 			err = (log_read_seq(lg, &l) != LOG_OK);
@@ -936,7 +1224,7 @@ logger_readlog(logger *lg, char *filename)
 			if (name == NULL || tr == NULL)
 				err = 1;
 			else
-				err = (log_read_updates(lg, tr, &l, name) != LOG_OK);
+				err = (log_read_updates(lg, tr, &l, name, rp) != LOG_OK);
 			break;
 		case LOG_CREATE:
 			if (name == NULL || tr == NULL)
@@ -968,6 +1256,14 @@ logger_readlog(logger *lg, char *filename)
 		if (name)
 			GDKfree(name);
 	}
+	if (rp)
+		replay_stop(rp);
+	if (lg->format >= 2 && mnstr_errnr(lg->log)) {
+		/* typically the last block was being written when
+		 * the server stopped */
+		printf("# the write-ahead log '%s' ends in a damaged or incomplete block, which is ignored\n", filename);
+		fflush(stdout);
+	}
 	logger_close(lg);
 
 	/* remaining transactions are not committed, ie abort */
@@ -1048,6 +1344,7 @@ static gdk_return
 check_version(logger *lg, FILE *fp)
 {
 	int version = 0;
+	int c;
 
 	if (fscanf(fp, "%6d", &version) != 1) {
 		GDKerror("Could not read the version number from the file '%s/log'.\n",
@@ -1067,7 +1364,20 @@ check_version(logger *lg, FILE *fp)
 		}
 	} else
 		lg->postfuncp = NULL;	 /* don't call */
-	if (fgetc(fp) != '\n' ||	 /* skip \n */
+	/* older versions didn't write the log format */
+	lg->format = 1;
+	if ((c = fgetc(fp)) == ' ') {
+		if (fscanf(fp, "%d", &lg->format) != 1)
+			return GDK_FAIL;
+		c = fgetc(fp);
+	}
+	if (lg->format < 1 || lg->format > LOG_FORMAT) {
+		GDKerror("Unknown log format %d in the file '%s/log', "
+			 "this server supports up to format %d.\n",
+			 lg->format, lg->dir, LOG_FORMAT);
+		return GDK_FAIL;
+	}
+	if (c != '\n' ||		 /* skip \n */
 	    fgetc(fp) != '\n')		 /* skip \n */
 		return GDK_FAIL;
 	return GDK_SUCCEED;
@@ -1208,12 +1518,28 @@ logger_new(int debug, const char *fn, const char *logdir, int version, preversio
 
 	lg->changes = 0;
 	lg->version = version;
+	lg->format = LOG_FORMAT;
 	lg->id = 1;
 
 	lg->tid = 0;
 #if SIZEOF_OID == 8
 	lg->read32bitoid = 0;
 #endif
+	MT_lock_init(&lg->flush_lock, "logger_flush");
+	MT_sema_init(&lg->flush_sema, 0, "logger_flush");
+	lg->flushing = 0;
+	lg->flushwaiters = 0;
+	lg->flush_delay = -1;
+	if (GDKgetenv_istrue("gdk_groupcommit") ||
+	    GDKgetenv_isyes("gdk_groupcommit")) {
+		lg->flush_delay = GDKgetenv_int("gdk_groupcommit_delay", 0);
+		if (lg->flush_delay < 0)
+			lg->flush_delay = 0;
+		lg->flush_batch = GDKgetenv_int("gdk_groupcommit_batch", 32);
+	} else {
+		lg->flush_batch = 1;
+	}
+	lg->tends = lg->flushed = 0;
 
 	snprintf(filename, sizeof(filename), "%s%c%s%c", logdir, DIR_SEP, fn, DIR_SEP);
 	lg->fn = GDKstrdup(fn);
@@ -1231,6 +1557,7 @@ logger_new(int debug, const char *fn, const char *logdir, int version, preversio
 	lg->prefuncp = prefuncp;
 	lg->postfuncp = postfuncp;
 	lg->log = NULL;
+	lg->file = NULL;
 	lg->end = 0;
 	lg->catalog_bid = NULL;
 	lg->catalog_nme = NULL;
@@ -1325,7 +1652,7 @@ logger_new(int debug, const char *fn, const char *logdir, int version, preversio
 			goto error;
 		}
 		lg->id ++;
-		if (fprintf(fp, "%06d\n\n" LLFMT "\n", lg->version, lg->id) < 0) {
+		if (fprintf(fp, "%06d %d\n\n" LLFMT "\n", lg->version, LOG_FORMAT, lg->id) < 0) {
 			fclose(fp);
 			unlink(filename);
 			logger_fatal("logger_new: writing log file %s failed",
@@ -1701,7 +2028,9 @@ logger_create(int debug, const char *fn, const char *logdir, int version, prever
 	printf("# Finished processing logs %s/%s\n",fn,logdir);
 	GDKsetenv("recovery","finished");
 	fflush(stdout);
-	if (lg->changes &&
+	/* logs in an older format are replaced by one in the current
+	 * format */
+	if ((lg->changes || lg->format != LOG_FORMAT) &&
 	    (logger_restart(lg) != LOG_OK ||
 	     logger_cleanup(lg) != LOG_OK)) {
 		logger_destroy(lg);
@@ -1740,6 +2069,8 @@ logger_destroy(logger *lg)
 	GDKfree(lg->fn);
 	GDKfree(lg->dir);
 	logger_close(lg);
+	MT_lock_destroy(&lg->flush_lock);
+	MT_sema_destroy(&lg->flush_sema);
 	GDKfree(lg);
 }
 
@@ -1760,7 +2091,7 @@ logger_exit(logger *lg)
 	if ((fp = fopen(filename, "w")) != NULL) {
 		char ext[BUFSIZ];
 
-		if (fprintf(fp, "%06d\n\n", lg->version) < 0) {
+		if (fprintf(fp, "%06d %d\n\n", lg->version, LOG_FORMAT) < 0) {
 			(void) fclose(fp);
 			fprintf(stderr, "!ERROR: logger_exit: write to %s failed\n",
 				filename);
@@ -1798,6 +2129,7 @@ logger_exit(logger *lg)
 		}
 
 		lg->changes = 0;
+		lg->format = LOG_FORMAT;
 	} else {
 		fprintf(stderr, "!ERROR: logger_exit: could not create %s\n",
 			filename);
@@ -2189,7 +2521,7 @@ pre_allocate(logger *lg)
 {
 	lng p;
 
-	if (mnstr_fgetpos(lg->log, &p) != 0)
+	if (mnstr_fgetpos(lg->file, &p) != 0)
 		return GDK_FAIL;
 	if (p + DBLKSZ > lg->end) {
 		lng s = p;
@@ -2201,16 +2533,16 @@ pre_allocate(logger *lg)
 		}
 		if (p < lg->end) {
 			p = (lg->end - p);
-			if (mnstr_write(lg->log, zeros, (size_t) p, 1) < 0)
+			if (mnstr_write(lg->file, zeros, (size_t) p, 1) < 0)
 				return GDK_FAIL;
 			lg->end += p;
 			p = 0;
 		}
 		for (; p < SEGSZ; p += DBLKSZ, lg->end += DBLKSZ) {
-			if (mnstr_write(lg->log, zeros, DBLKSZ, 1) < 0)
+			if (mnstr_write(lg->file, zeros, DBLKSZ, 1) < 0)
 				return GDK_FAIL;
 		}
-		if (mnstr_fsetpos(lg->log, s) < 0)
+		if (mnstr_fsetpos(lg->file, s) < 0)
 			return GDK_FAIL;
 	}
 	return GDK_SUCCEED;
@@ -2250,17 +2582,88 @@ log_tend(logger *lg)
 	l.flag = LOG_END;
 	l.tid = lg->tid;
 	l.nr = lg->tid;
+	/* with group commit the fsync is left to log_tflush */
 	if (res != GDK_SUCCEED ||
 	    log_write_format(lg, &l) == LOG_ERR ||
 	    mnstr_flush(lg->log) ||
-	    mnstr_fsync(lg->log) ||
+	    (lg->flush_delay < 0 && mnstr_fsync(lg->log)) ||
 	    pre_allocate(lg) != GDK_SUCCEED) {
 		fprintf(stderr, "!ERROR: log_tend: write failed\n");
 		return LOG_ERR;
 	}
+	/* only count the transaction end once it was handed to the
+	 * OS, so that a flush covers all ends it has seen */
+	lg->tends++;
+	logger_commits++;
+	if (lg->flush_delay < 0) {
+		lg->flushed = lg->tends;
+		logger_flushes++;
+	}
 	return LOG_OK;
 }
 
+/* Wait until the log is on disk up to the tend'th transaction end.
+ * If no flush is running, the caller becomes the leader: it waits (at
+ * most flush_delay ms) for other commits to come in, and then does a
+ * single fsync for all transaction ends written so far.  Commits that
+ * arrive during a flush wait for it, and the first of them to find
+ * its commit still not on disk leads the next flush. */
+int
+log_tflush(logger *lg, lng tend)
+{
+	lng upto, n;
+	int ms, res = LOG_OK;
+
+	if (lg->flush_delay < 0)
+		return LOG_OK;	/* log_tend did the fsync */
+	MT_lock_set(&lg->flush_lock, "log_tflush");
+	while (lg->flushed < tend && lg->log != NULL) {
+		if (lg->flushing) {
+			/* wait for the running flush */
+			lg->flushwaiters++;
+			MT_lock_unset(&lg->flush_lock, "log_tflush");
+			MT_sema_down(&lg->flush_sema, "log_tflush");
+			MT_lock_set(&lg->flush_lock, "log_tflush");
+			continue;
+		}
+		lg->flushing = 1;
+		MT_lock_unset(&lg->flush_lock, "log_tflush");
+
+		/* wait while more commits come in */
+		for (upto = lg->tends, ms = 0;
+		     ms < lg->flush_delay && upto - tend < lg->flush_batch;
+		     ms++) {
+			MT_sleep_ms(1);
+			if ((n = lg->tends) == upto)
+				break;	/* no one else is committing */
+			upto = n;
+		}
+		/* log_tend counts a transaction end after handing it
+		 * to the OS, so the fsync covers all of them */
+		upto = lg->tends;
+		if (mnstr_fsync(lg->log))
+			res = LOG_ERR;
+
+		MT_lock_set(&lg->flush_lock, "log_tflush");
+		if (res == LOG_OK) {
+			if (lg->debug & 1)
+				fprintf(stderr, "#log_tflush " LLFMT " commits\n",
+					upto - lg->flushed);
+			lg->flushed = upto;
+			logger_flushes++;
+		}
+		lg->flushing = 0;
+		for (; lg->flushwaiters > 0; lg->flushwaiters--)
+			MT_sema_up(&lg->flush_sema, "log_tflush");
+		if (res != LOG_OK) {
+			fprintf(stderr, "!ERROR: log_tflush: fsync failed\n");
+			break;
+		}
+	}
+	MT_lock_unset(&lg->flush_lock, "log_tflush");
+	return res;
+}
+
 int
 log_abort(logger *lg)
 {
@@ -41,6 +41,7 @@ typedef struct logger {
 	int debug;
 	lng changes;
 	int version;
+	int format;		/* format of the log files, see LOG_FORMAT */
 	lng id;
 	int tid;
 #if SIZEOF_OID == 8
@@ -52,7 +53,8 @@ typedef struct logger {
 	char *dir;
 	preversionfix_fptr prefuncp;
 	postversionfix_fptr postfuncp;
-	stream *log;
+	stream *log;		/* the log records, framed into file */
+	stream *file;		/* the log file */
 	lng end;		/* end of pre-allocated blocks for faster f(data)sync */
 	/* Store log_bids (int) to circumvent trouble with reference counting */
 	BAT *catalog_bid;	/* int bid column */
@@ -71,6 +73,17 @@ typedef struct logger {
 				   commit). */
 	void *buf;
 	size_t bufsize;
+	/* group commit: log_tend only hands the log to the OS, and
+	 * log_tflush does a single fsync for all transactions ended
+	 * so far */
+	MT_Lock flush_lock;	/* protects the flush administration */
+	MT_Sema flush_sema;	/* to wait for a running flush */
+	int flushing;		/* a flush is running */
+	int flushwaiters;	/* number of commits waiting for it */
+	int flush_delay;	/* ms to wait for more commits to join a flush, -1: no group commit */
+	int flush_batch;	/* don't wait if this many commits are pending */
+	lng tends;		/* number of transaction ends written */
+	lng flushed;		/* number of transaction ends on disk */
 } logger;
 
 #define BATSIZE 0
@@ -109,8 +122,14 @@ gdk_export int log_bat_persists(logger *lg, BAT *b, const char *n);
 gdk_export int log_bat_transient(logger *lg, const char *n);
 gdk_export int log_delta(logger *lg, BAT *uid, BAT *uval, const char *n);
 
+/* With group commit (gdk_groupcommit=yes) log_tend writes the end
+ * of the transaction, but doesn't wait for the log to be on disk.
+ * The caller passes the value of lg->tends after log_tend to
+ * log_tflush, preferably after releasing its locks, so that
+ * concurrent commits share a single fsync. */
 gdk_export int log_tstart(logger *lg);	/* TODO return transaction id */
 gdk_export int log_tend(logger *lg);
+gdk_export int log_tflush(logger *lg, lng tend);
 gdk_export int log_abort(logger *lg);
 
 gdk_export int log_sequence(logger *lg, int seq, lng id);
@@ -119,4 +138,8 @@ gdk_export log_bid logger_add_bat(logger *lg, BAT *b, const char *name);
 gdk_export void logger_del_bat(logger *lg, log_bid bid);
 gdk_export log_bid logger_find_bat(logger *lg, const char *name);
 
+/* number of transaction commits and of log flushes (fsyncs) */
+gdk_export int logger_commits;
+gdk_export int logger_flushes;
+
 #endif /*_LOGGER_H_*/
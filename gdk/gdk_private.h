@@ -20,7 +20,8 @@ enum heaptype {
 	offheap,
 	varheap,
 	hashheap,
-	imprintsheap
+	imprintsheap,
+	compressheap
 };
 
 /*
@@ -51,6 +52,8 @@ __hidden str ATOMunknown_name(int a)
 	__attribute__((__visibility__("hidden")));
 __hidden int BATcheckhash(BAT *b)
 	__attribute__((__visibility__("hidden")));
+__hidden int BATcheckcompress(BAT *b)
+	__attribute__((__visibility__("hidden")));
 __hidden int BATcheckimprints(BAT *b)
 	__attribute__((__visibility__("hidden")));
 __hidden gdk_return BATcheckmodes(BAT *b, int persistent)
@@ -159,6 +162,20 @@ __hidden gdk_return HEAPshrink(Heap *h, size_t size)
 	__attribute__((__visibility__("hidden")));
 __hidden int HEAPwarm(Heap *h)
 	__attribute__((__visibility__("hidden")));
+__hidden void CMPdestroy(BAT *b)
+	__attribute__((__visibility__("hidden")));
+__hidden BUN CMPdictsize(BAT *b)
+	__attribute__((__visibility__("hidden")));
+__hidden void CMPfree(BAT *b)
+	__attribute__((__visibility__("hidden")));
+__hidden BUN CMPgroup(BAT *b, oid *restrict ngrps, oid *restrict exts, wrd *restrict cnts, int *sorted)
+	__attribute__((__visibility__("hidden")));
+__hidden int CMPminmax(BAT *b, int max, void *res)
+	__attribute__((__visibility__("hidden")));
+__hidden gdk_return CMPproject(BAT *bn, BAT *l, BAT *r)
+	__attribute__((__visibility__("hidden")));
+__hidden BAT *CMPsubselect(BAT *b, BAT *s, const void *tl, const void *th, int li, int hi, int equi, int anti, int lval, int hval, BUN estimate)
+	__attribute__((__visibility__("hidden")));
 __hidden void IMPSdestroy(BAT *b)
 	__attribute__((__visibility__("hidden")));
 __hidden int IMPSgetbin(int tpe, bte bits, const char *restrict bins, const void *restrict v)
@@ -203,6 +220,10 @@ __hidden gdk_return VIEWreset(BAT *b)
 	__attribute__((__visibility__("hidden")));
 __hidden BAT *virtualize(BAT *bn)
 	__attribute__((__visibility__("hidden")));
+__hidden void ZMAPdestroy(BAT *b)
+	__attribute__((__visibility__("hidden")));
+__hidden BAT *ZMAPsubselect(BAT *b, BAT *s, const void *tl, const void *th, int anti, int *done)
+	__attribute__((__visibility__("hidden")));
 
 #define BBP_BATMASK	511
 #define BBP_THREADMASK	63
@@ -224,10 +245,41 @@ struct Imprints {
 	BUN dictcnt;		/* counter for cache dictionary               */
 };
 
+/* encodings of a compressed copy, see gdk_compress.c */
+#define CMP_FOR		1	/* frame of reference, bit packed */
+#define CMP_DICT	2	/* sorted dictionary, bit packed */
+#define CMP_RLE		3	/* run-length encoded */
+
+struct Compress {
+	Heap *heap;
+	int method;		/* CMP_FOR, CMP_DICT or CMP_RLE */
+	int bits;		/* width of a code (bit packed encodings) */
+	int lgbits, lgper;	/* log2 of bits and of codes per word */
+	BUN permask;		/* codes per word - 1 */
+	unsigned int mask;	/* (1 << bits) - 1 */
+	BUN cnt;		/* number of values */
+	BUN n;			/* dictionary size or number of runs */
+	BUN nils;		/* number of nils */
+	lng min, max;		/* smallest and largest non-nil value */
+	const lng *vals;	/* pointer into heap (dictionary or run values) */
+	const BUN *ends;	/* pointer into heap (run end positions) */
+	const ulng *codes;	/* pointer into heap (bit packed codes) */
+};
+
+/* min/max per zone of a column, see gdk_zonemap.c */
+struct Zonemap {
+	int type;		/* type of the values in min and max */
+	BUN nzones;		/* number of (complete) zones covered */
+	BUN maxzones;		/* allocated size of min and max */
+	void *min, *max;	/* smallest and largest non-nil value per zone */
+};
+
 typedef struct {
 	MT_Lock swap;
 	MT_Lock hash;
 	MT_Lock imprints;
+	MT_Lock compress;
+	MT_Lock zonemap;
 } batlock_t;
 
 typedef struct {
@@ -302,6 +354,8 @@ extern MT_Lock MT_system_lock;
 #define GDKswapLock(x)  GDKbatLock[(x)&BBP_BATMASK].swap
 #define GDKhashLock(x)  GDKbatLock[(x)&BBP_BATMASK].hash
 #define GDKimprintsLock(x)  GDKbatLock[(x)&BBP_BATMASK].imprints
+#define GDKcompressLock(x)  GDKbatLock[(x)&BBP_BATMASK].compress
+#define GDKzonemapLock(x)  GDKbatLock[(x)&BBP_BATMASK].zonemap
 #if SIZEOF_SIZE_T == 8
 #define threadmask(y)	((int) ((mix_int((unsigned int) y) ^ mix_int((unsigned int) (y >> 32))) & BBP_THREADMASK))
 #else
@@ -202,6 +202,193 @@ HASHnew(Heap *hp, int tpe, BUN size, BUN mask, BUN count)
 		}						\
 	} while (0)
 
+/* Parallel hash construction.
+ *
+ * The values are inserted into the hash table by several threads in
+ * three phases.  The hash buckets are divided into nparts partitions
+ * of consecutive buckets.  In the first phase, each thread counts for
+ * its own part of the values how many fall into each bucket
+ * partition.  In the second phase, each thread copies the positions
+ * of its values into a list that is ordered on bucket partition and
+ * within a partition on position.  In the third phase, each thread
+ * takes a range of bucket partitions and inserts the positions from
+ * the list into the hash table.  Since the values of a bucket are
+ * inserted in the same order as in the serial code, and since the
+ * link entry of a value is only written by the thread that owns the
+ * value's bucket, the resulting Hash is byte for byte the same as the
+ * one built serially. */
+#define HASH_PARALLEL_MIN	((BUN) 1 << 20) /* min #values to insert */
+#define HASH_PARALLEL_BUCKETS	((BUN) 1 << 12) /* min #buckets per part */
+
+struct hashbuild {
+	BAT *b;
+	Hash *h;
+	int tpe;		/* storage type used for hashing */
+	int phase;
+	BUN p, q;		/* range of BUNs (phase 1 and 2), or
+				 * range in list (phase 3) */
+	int pshift;		/* bucket >> pshift is the partition */
+	BUN *cnt;		/* per partition count (phase 1), or next
+				 * position in list (phase 2) */
+	BUN *list;		/* BUNs ordered on partition */
+};
+
+#define parthash(TYPE)							\
+	do {								\
+		const TYPE *v = (const TYPE *) Tloc(hb->b, 0);		\
+		BUN p, c;						\
+									\
+		switch (hb->phase) {					\
+		case 1:							\
+			for (p = hb->p; p < hb->q; p++)			\
+				hb->cnt[hash_##TYPE(h, v + p) >> hb->pshift]++; \
+			break;						\
+		case 2:							\
+			for (p = hb->p; p < hb->q; p++)			\
+				hb->list[hb->cnt[hash_##TYPE(h, v + p) >> hb->pshift]++] = p; \
+			break;						\
+		case 3:							\
+			for (i = hb->p; i < hb->q; i++) {		\
+				p = hb->list[i];			\
+				c = (BUN) hash_##TYPE(h, v + p);	\
+				HASHputlink(h, p, HASHget(h, c));	\
+				HASHput(h, c, p);			\
+			}						\
+			break;						\
+		}							\
+	} while (0)
+
+static void
+BAThashpart(void *arg)
+{
+	struct hashbuild *hb = arg;
+	Hash *h = hb->h;
+	BUN i;
+
+	switch (hb->tpe) {
+	case TYPE_int:
+		parthash(int);
+		break;
+	case TYPE_lng:
+		parthash(lng);
+		break;
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		parthash(hge);
+		break;
+#endif
+	default:
+		assert(0);
+	}
+}
+
+/* run one phase of the parallel hash construction */
+static void
+BAThashphase(struct hashbuild *hb, MT_Id *tids, int nthreads, int phase)
+{
+	int i;
+
+	for (i = 0; i < nthreads; i++)
+		hb[i].phase = phase;
+	/* the calling thread takes care of the first part */
+	for (i = 1; i < nthreads; i++) {
+		if (MT_create_thread(&tids[i], BAThashpart, &hb[i],
+				     MT_THR_JOINABLE) < 0) {
+			/* couldn't create thread, do the work ourselves */
+			tids[i] = 0;
+			BAThashpart(&hb[i]);
+		}
+	}
+	BAThashpart(&hb[0]);
+	for (i = 1; i < nthreads; i++)
+		if (tids[i])
+			MT_join_thread(tids[i]);
+}
+
+/* insert the values at positions p..q-1 of b into h using multiple
+ * threads; tpe is the storage type used for hashing */
+static gdk_return
+BAThashparallel(BAT *b, Hash *h, int tpe, BUN p, BUN q)
+{
+	int t, k, nthreads = GDKnr_threads;
+	int nparts, pshift;
+	BUN nbuckets = h->mask + 1;
+	BUN n, *cnt, *list, *pstart;
+	struct hashbuild *hb;
+	MT_Id *tids;
+
+	/* nparts is the smallest power of two not smaller than
+	 * nthreads, but partitions should not become too small */
+	for (nparts = 1, pshift = 0; (BUN) 1 << pshift < nbuckets; pshift++)
+		;
+	while (nparts < nthreads &&
+	       nbuckets / (BUN) nparts > HASH_PARALLEL_BUCKETS) {
+		nparts <<= 1;
+		pshift--;
+	}
+	if (nparts == 1)
+		return GDK_FAIL;
+	if (nthreads > nparts)
+		nthreads = nparts;
+
+	hb = GDKmalloc(nthreads * sizeof(*hb));
+	tids = GDKmalloc(nthreads * sizeof(*tids));
+	cnt = GDKzalloc(nthreads * nparts * sizeof(BUN));
+	pstart = GDKmalloc((nparts + 1) * sizeof(BUN));
+	list = GDKmalloc((q - p) * sizeof(BUN));
+	if (hb == NULL || tids == NULL || cnt == NULL || pstart == NULL ||
+	    list == NULL) {
+		GDKfree(hb);
+		GDKfree(tids);
+		GDKfree(cnt);
+		GDKfree(pstart);
+		GDKfree(list);
+		return GDK_FAIL;
+	}
+	ALGODEBUG fprintf(stderr, "#BAThash: parallel construction using %d threads, %d partitions\n", nthreads, nparts);
+
+	n = q - p;
+	for (t = 0; t < nthreads; t++) {
+		hb[t].b = b;
+		hb[t].h = h;
+		hb[t].tpe = tpe;
+		hb[t].p = p + n / nthreads * t;
+		hb[t].q = t == nthreads - 1 ? q : p + n / nthreads * (t + 1);
+		hb[t].pshift = pshift;
+		hb[t].cnt = cnt + t * nparts;
+		hb[t].list = list;
+	}
+	BAThashphase(hb, tids, nthreads, 1);
+
+	/* turn the counts into positions in list: partition by
+	 * partition, and within a partition thread by thread */
+	for (k = 0, n = 0; k < nparts; k++) {
+		pstart[k] = n;
+		for (t = 0; t < nthreads; t++) {
+			BUN c = cnt[t * nparts + k];
+			cnt[t * nparts + k] = n;
+			n += c;
+		}
+	}
+	pstart[nparts] = n;
+	assert(n == q - p);
+	BAThashphase(hb, tids, nthreads, 2);
+
+	/* each thread inserts a range of partitions */
+	for (t = 0; t < nthreads; t++) {
+		hb[t].p = pstart[nparts / nthreads * t];
+		hb[t].q = pstart[t == nthreads - 1 ? nparts : nparts / nthreads * (t + 1)];
+	}
+	BAThashphase(hb, tids, nthreads, 3);
+
+	GDKfree(hb);
+	GDKfree(tids);
+	GDKfree(cnt);
+	GDKfree(pstart);
+	GDKfree(list);
+	return GDK_SUCCEED;
+}
+
 /* collect HASH statistics for analysis */
 static void
 HASHcollisions(BAT *b, Hash *h)
@@ -468,6 +655,40 @@ BAThash(BAT *b, BUN masksize)
 
 		/* finish the hashtable with the current mask */
 		p = r;
+		if (q - p >= HASH_PARALLEL_MIN && GDKnr_threads > 1) {
+			switch (tpe) {
+			case TYPE_int:
+			case TYPE_flt:
+#if SIZEOF_OID == SIZEOF_INT
+			case TYPE_oid:
+#endif
+#if SIZEOF_WRD == SIZEOF_INT
+			case TYPE_wrd:
+#endif
+				if (BAThashparallel(b, h, TYPE_int, p, q) == GDK_SUCCEED)
+					p = q;
+				break;
+			case TYPE_dbl:
+			case TYPE_lng:
+#if SIZEOF_OID == SIZEOF_LNG
+			case TYPE_oid:
+#endif
+#if SIZEOF_WRD == SIZEOF_LNG
+			case TYPE_wrd:
+#endif
+				if (BAThashparallel(b, h, TYPE_lng, p, q) == GDK_SUCCEED)
+					p = q;
+				break;
+#ifdef HAVE_HGE
+			case TYPE_hge:
+				if (BAThashparallel(b, h, TYPE_hge, p, q) == GDK_SUCCEED)
+					p = q;
+				break;
+#endif
+			default:
+				break;
+			}
+		}
 		switch (tpe) {
 		case TYPE_bte:
 			finishhash(bte);
@@ -512,13 +512,16 @@ do {									\
 #define MAXVALUEflt	GDK_flt_max
 #define MAXVALUEdbl	GDK_dbl_max
 
-#define choose(NAME, CAND, TEST)			\
-	do {						\
-		if (use_imprints) {			\
-			bitswitch(CAND, TEST);		\
-		} else {				\
-			scanloop(NAME, CAND, TEST);	\
-		}					\
+#define choose(NAME, TYPE, CAND, TEST, MODE)				\
+	do {								\
+		if (use_imprints) {					\
+			bitswitch(CAND, TEST);				\
+		} else {						\
+			if (candlist == NULL && simdscan_avail_##TYPE) { \
+				simdscan(TYPE, MODE);			\
+			}						\
+			scanloop(NAME, CAND, TEST);			\
+		}							\
 	} while (0)
 
 /* definition of type-specific core scan select function */
@@ -566,19 +569,19 @@ NAME##_##TYPE(BAT *b, BAT *s, BAT *bn, const TYPE *tl, const TYPE *th,	\
 	END;								\
 	if (equi) {							\
 		assert(!use_imprints);					\
-		scanloop(NAME, CAND, v == vl);				\
+		choose(NAME,TYPE,CAND,v == vl,SIMD_EQ);			\
 	} else if (anti) {						\
 		if (b->T->nonil) {					\
-			choose(NAME,CAND,(v <= vl || v >= vh));		\
+			choose(NAME,TYPE,CAND,(v <= vl || v >= vh),SIMD_ANTI); \
 		} else {						\
-			choose(NAME,CAND,(v <= vl || v >= vh) && v != nil); \
+			choose(NAME,TYPE,CAND,(v <= vl || v >= vh) && v != nil,SIMD_ANTINIL); \
 		}							\
 	} else if (b->T->nonil && vl == minval) {			\
-		choose(NAME,CAND,v <= vh);				\
+		choose(NAME,TYPE,CAND,v <= vh,SIMD_LE);			\
 	} else if (vh == maxval) {					\
-		choose(NAME,CAND,v >= vl);				\
+		choose(NAME,TYPE,CAND,v >= vl,SIMD_GE);			\
 	} else {							\
-		choose(NAME,CAND,v >= vl && v <= vh);			\
+		choose(NAME,TYPE,CAND,v >= vl && v <= vh,SIMD_RANGE);	\
 	}								\
 	return cnt;							\
 }
@@ -848,6 +851,349 @@ fullscan_str(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
 	return cnt;
 }
 
+/* imprints select on strings
+ *
+ * The imprints of a string column are built on the order-preserving
+ * 8-byte prefixes of the values (see gdk_imprints.c), so an imprint
+ * vector can tell us that none of the values in a page can be in
+ * range, but never that all of them are: the values in the pages
+ * that are not skipped are compared in full.  Used for range selects
+ * only, with and without candidate list. */
+static BUN
+impsscan_str(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
+	     int li, int hi, int equi, int anti, int lval, int hval,
+	     BUN r, BUN q, BUN cnt, wrd off, oid *restrict dst,
+	     const oid *candlist, BUN maximum, int use_imprints)
+{
+	int (*cmp)(const void *, const void *) = ATOMcompare(b->ttype);
+	BATiter bi = bat_iterator(b);
+	Imprints *imprints;
+	const cchdc_t *restrict d;
+	const char *v;
+	BUN dcnt, icnt, k, n, pg, e, first, pr_off = 0, p = r;
+	ulng mask, vec;
+	int lbin, hbin, c;
+	bte rpp;
+	oid o;
+
+	(void) maximum;
+	assert(use_imprints);
+	assert(!equi && !anti);
+	(void) equi;
+	(void) anti;
+	(void) use_imprints;
+	if (VIEWtparent(b)) {
+		BAT *parent = BATmirror(BATdescriptor(VIEWtparent(b)));
+		imprints = parent->T->imprints;
+		first = BUNfirst(parent);
+		pr_off = (BUN) ((Tloc(b, 0) - Tloc(parent, 0)) >> b->T->shift);
+		BBPunfix(parent->batCacheid);
+	} else {
+		imprints = b->T->imprints;
+		first = BUNfirst(b);
+	}
+	assert(imprints);
+	ALGODEBUG fprintf(stderr,
+			  "#BATsubselect(b=%s#"BUNFMT",s=%s%s,anti=%d): "
+			  "imprints select str\n", BATgetId(b), BATcount(b),
+			  s ? BATgetId(s) : "NULL",
+			  s && BATtdense(s) ? "(dense)" : "", anti);
+
+	lbin = lval ? IMPSgetbin(TYPE_str, imprints->bits, imprints->bins, tl) : 0;
+	hbin = hval ? IMPSgetbin(TYPE_str, imprints->bits, imprints->bins, th) : imprints->bits - 1;
+	/* bits lbin..hbin inclusive, see impsmask */
+	mask = (((((ulng) 1 << hbin) - 1) << 1) | 1) - (((ulng) 1 << lbin) - 1);
+	rpp = ATOMelmshift(IMPS_PAGE >> b->T->shift);
+	d = (const cchdc_t *) imprints->dict;
+
+/* position in b of the p'th value we need to look at */
+#define impsstrpos(p)	((BUN) ((candlist ? candlist[(p) - r] : (oid) ((p) + off)) - off))
+
+	for (dcnt = 0, icnt = 0, pg = 0; dcnt < imprints->dictcnt && p < q; dcnt++) {
+		/* a repeat entry is one vector for cnt pages, otherwise
+		 * there are cnt vectors for one page each */
+		n = d[dcnt].repeat ? (BUN) d[dcnt].cnt : 1;
+		for (k = d[dcnt].repeat ? 1 : d[dcnt].cnt; k > 0 && p < q; k--) {
+			switch (imprints->bits) {
+			case 8: vec = ((const uint8_t *) imprints->imps)[icnt]; break;
+			case 16: vec = ((const uint16_t *) imprints->imps)[icnt]; break;
+			case 32: vec = ((const uint32_t *) imprints->imps)[icnt]; break;
+			default: vec = ((const uint64_t *) imprints->imps)[icnt]; break;
+			}
+			icnt++;
+			pg += n;
+			/* end of these pages as position in b: the imprints
+			 * start at the first BUN of the bat they were built
+			 * on, which for a view starts pr_off BUNs before b */
+			e = (pg << rpp) + first;
+			if (e <= pr_off)
+				continue;
+			e -= pr_off;
+			if ((vec & mask) == 0) {
+				if (candlist == NULL) {
+					if (p < e)
+						p = e;
+				} else {
+					while (p < q && impsstrpos(p) < e)
+						p++;
+				}
+				continue;
+			}
+			while (p < q && impsstrpos(p) < e) {
+				o = (oid) (impsstrpos(p) + off);
+				v = BUNtail(bi, (BUN) (o - off));
+				if (!GDK_STRNIL(v) &&
+				    (!lval ||
+				     (c = (*cmp)(tl, v)) < 0 ||
+				     (li && c == 0)) &&
+				    (!hval ||
+				     (c = (*cmp)(th, v)) > 0 ||
+				     (hi && c == 0))) {
+					buninsfix(bn, dst, cnt, o,
+						  (BUN) ((dbl) cnt / (dbl) (p-r)
+							 * (dbl) (q-p) * 1.1 + 1024),
+						  BATcapacity(bn) + q - p, BUN_NONE);
+					cnt++;
+				}
+				p++;
+			}
+		}
+	}
+	/* all of b is covered by the imprints */
+	assert(p >= q);
+#undef impsstrpos
+	return cnt;
+}
+
+/* vectorized scan select
+ *
+ * For full scans (no candidate list) over the fixed-width numeric
+ * types we evaluate the predicate on blocks of SIMDSCAN_BLOCK values
+ * using AVX2 instructions, producing a bit mask of qualifying
+ * positions, and then compress the set bits into the result.  Whether
+ * the CPU supports AVX2 is determined at run time; if it doesn't (or
+ * if the compiler can't generate the code), we fall back to the
+ * scalar scanloop.  The vectorized code only handles whole blocks, the
+ * scalar code takes care of the remainder.
+ *
+ * The predicates are those of scanfunc after the bounds have been
+ * normalized to be inclusive, so they need to produce exactly the
+ * same results as the corresponding TEST expressions. */
+enum simdmode {
+	SIMD_EQ,		/* v == vl */
+	SIMD_LE,		/* v <= vh */
+	SIMD_GE,		/* v >= vl */
+	SIMD_RANGE,		/* v >= vl && v <= vh */
+	SIMD_ANTI,		/* v <= vl || v >= vh */
+	SIMD_ANTINIL,		/* (v <= vl || v >= vh) && v != nil */
+};
+
+#define SIMDSCAN_BLOCK	64	/* number of values per mask */
+
+#if (defined(__x86_64__) || defined(__i386__)) &&			\
+	(__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9) ||	\
+	 defined(__clang__))
+#define HAVE_SIMDSCAN 1
+#include <immintrin.h>
+
+static int simdscan_level = -1;	/* -1: unknown; 0: none; 1: AVX2 */
+
+static int
+simdscan_init(void)
+{
+	if (simdscan_level < 0) {
+		__builtin_cpu_init();
+		simdscan_level = __builtin_cpu_supports("avx2") != 0;
+	}
+	return simdscan_level;
+}
+
+/* integer predicates; AVX2 only has signed greater-than and equal
+ * comparisons, which is all we need since GDK's nil is the smallest
+ * value of each type */
+#define SIMDINTPRED(V, MODE, L, H, N, GT, EQ)				\
+	((MODE) == SIMD_EQ ? EQ(V, L) :					\
+	 (MODE) == SIMD_LE ? _mm256_andnot_si256(GT(V, H), ones) :	\
+	 (MODE) == SIMD_GE ? _mm256_andnot_si256(GT(L, V), ones) :	\
+	 (MODE) == SIMD_RANGE ?						\
+		_mm256_andnot_si256(_mm256_or_si256(GT(L, V), GT(V, H)), ones) : \
+	 (MODE) == SIMD_ANTI ?						\
+		_mm256_andnot_si256(_mm256_and_si256(GT(V, L), GT(H, V)), ones) : \
+	 _mm256_andnot_si256(_mm256_or_si256(EQ(V, N),			\
+					     _mm256_and_si256(GT(V, L), GT(H, V))), \
+			     ones))
+
+/* floating point predicates; use ordered comparisons so that the
+ * result is the same as that of the C comparison operators */
+#define SIMDFLTPRED(V, MODE, L, H, N, CMP, AND, OR, ANDNOT)		\
+	((MODE) == SIMD_EQ ? CMP(V, L, _CMP_EQ_OQ) :			\
+	 (MODE) == SIMD_LE ? CMP(V, H, _CMP_LE_OQ) :			\
+	 (MODE) == SIMD_GE ? CMP(V, L, _CMP_GE_OQ) :			\
+	 (MODE) == SIMD_RANGE ?						\
+		AND(CMP(V, L, _CMP_GE_OQ), CMP(V, H, _CMP_LE_OQ)) :	\
+	 (MODE) == SIMD_ANTI ?						\
+		OR(CMP(V, L, _CMP_LE_OQ), CMP(V, H, _CMP_GE_OQ)) :	\
+	 ANDNOT(CMP(V, N, _CMP_EQ_OQ),					\
+		OR(CMP(V, L, _CMP_LE_OQ), CMP(V, H, _CMP_GE_OQ))))
+
+/* per type: vector width in values, and how to get from a comparison
+ * result to a bit mask with one bit per value */
+#define SIMDLANES_bte	32
+#define SIMDLANES_sht	16
+#define SIMDLANES_int	8
+#define SIMDLANES_lng	4
+#define SIMDLANES_flt	8
+#define SIMDLANES_dbl	4
+
+#define SIMDMASK_bte(M)	((uint64_t) (unsigned int) _mm256_movemask_epi8(M))
+/* pack the 16-bit results into bytes, move the two halves together,
+ * and the low 16 bits of the byte mask are what we need */
+#define SIMDMASK_sht(M)							\
+	((uint64_t) (unsigned int) _mm256_movemask_epi8(		\
+		_mm256_permute4x64_epi64(				\
+			_mm256_packs_epi16((M), _mm256_setzero_si256()), \
+			0xD8)) & 0xFFFF)
+#define SIMDMASK_int(M)							\
+	((uint64_t) (unsigned int) _mm256_movemask_ps(_mm256_castsi256_ps(M)))
+#define SIMDMASK_lng(M)							\
+	((uint64_t) (unsigned int) _mm256_movemask_pd(_mm256_castsi256_pd(M)))
+#define SIMDMASK_flt(M)	((uint64_t) (unsigned int) _mm256_movemask_ps(M))
+#define SIMDMASK_dbl(M)	((uint64_t) (unsigned int) _mm256_movemask_pd(M))
+
+#define SIMDLOADI(P)	_mm256_loadu_si256((const __m256i *) (P))
+
+/* compute the bit mask for one block of values */
+#define simdblockint(TYPE, SET1, GT, EQ)				\
+static __attribute__((__target__("avx2"))) uint64_t			\
+simdblock_##TYPE(const TYPE *restrict src, enum simdmode mode,		\
+		 TYPE vl, TYPE vh, TYPE nil)				\
+{									\
+	const __m256i ones = _mm256_set1_epi32(-1);			\
+	const __m256i l = SET1(vl);					\
+	const __m256i h = SET1(vh);					\
+	const __m256i n = SET1(nil);					\
+	uint64_t mask = 0;						\
+	int i;								\
+									\
+	for (i = 0; i < SIMDSCAN_BLOCK; i += SIMDLANES_##TYPE) {	\
+		__m256i v = SIMDLOADI(src + i);				\
+		__m256i m = SIMDINTPRED(v, mode, l, h, n, GT, EQ);	\
+		mask |= SIMDMASK_##TYPE(m) << i;			\
+	}								\
+	return mask;							\
+}
+
+#define simdblockflt(TYPE, VEC, SET1, LOAD, CMP, AND, OR, ANDNOT)	\
+static __attribute__((__target__("avx2"))) uint64_t			\
+simdblock_##TYPE(const TYPE *restrict src, enum simdmode mode,		\
+		 TYPE vl, TYPE vh, TYPE nil)				\
+{									\
+	const VEC l = SET1(vl);						\
+	const VEC h = SET1(vh);						\
+	const VEC n = SET1(nil);					\
+	uint64_t mask = 0;						\
+	int i;								\
+									\
+	for (i = 0; i < SIMDSCAN_BLOCK; i += SIMDLANES_##TYPE) {	\
+		VEC v = LOAD(src + i);					\
+		VEC m = SIMDFLTPRED(v, mode, l, h, n, CMP, AND, OR, ANDNOT); \
+		mask |= SIMDMASK_##TYPE(m) << i;			\
+	}								\
+	return mask;							\
+}
+
+simdblockint(bte, _mm256_set1_epi8, _mm256_cmpgt_epi8, _mm256_cmpeq_epi8)
+simdblockint(sht, _mm256_set1_epi16, _mm256_cmpgt_epi16, _mm256_cmpeq_epi16)
+simdblockint(int, _mm256_set1_epi32, _mm256_cmpgt_epi32, _mm256_cmpeq_epi32)
+simdblockint(lng, _mm256_set1_epi64x, _mm256_cmpgt_epi64, _mm256_cmpeq_epi64)
+simdblockflt(flt, __m256, _mm256_set1_ps, _mm256_loadu_ps, _mm256_cmp_ps,
+	     _mm256_and_ps, _mm256_or_ps, _mm256_andnot_ps)
+simdblockflt(dbl, __m256d, _mm256_set1_pd, _mm256_loadu_pd, _mm256_cmp_pd,
+	     _mm256_and_pd, _mm256_or_pd, _mm256_andnot_pd)
+
+/* Scan the whole blocks starting at *pp (index into src), and append
+ * the OIDs of the qualifying values to bn.  On return *pp points to
+ * the first value not yet looked at.  Return the new count, or
+ * BUN_NONE on allocation failure (bn has been reclaimed then). */
+#define simdscanfunc(TYPE)						\
+static BUN								\
+simdscan_##TYPE(BAT *b, BAT *s, BAT *bn, const TYPE *src, BUN r,	\
+		BUN *pp, BUN q, BUN cnt, wrd off, enum simdmode mode,	\
+		TYPE vl, TYPE vh, TYPE nil, BUN maximum)		\
+{									\
+	BUN p = *pp;							\
+	oid *restrict dst = (oid *) Tloc(bn, BUNfirst(bn));		\
+	uint64_t mask;							\
+									\
+	(void) maximum;							\
+									\
+	ALGODEBUG fprintf(stderr,					\
+			  "#BATsubselect(b=%s#"BUNFMT",s=%s%s): "	\
+			  "simdscan %s mode=%d\n",			\
+			  BATgetId(b), BATcount(b),			\
+			  s ? BATgetId(s) : "NULL",			\
+			  s && BATtdense(s) ? "(dense)" : "",		\
+			  #TYPE, (int) mode);				\
+	while (p + SIMDSCAN_BLOCK <= q) {				\
+		mask = simdblock_##TYPE(src + p, mode, vl, vh, nil);	\
+		while (mask) {						\
+			buninsfix(bn, dst, cnt,				\
+				  (oid) (p + off + __builtin_ctzll(mask)), \
+				  (BUN) ((dbl) cnt / (dbl) (p + SIMDSCAN_BLOCK - r) \
+					 * (dbl) (q - p) * 1.1 + 1024),	\
+				  BATcapacity(bn) + q - p, BUN_NONE);	\
+			cnt++;						\
+			mask &= mask - 1;				\
+		}							\
+		p += SIMDSCAN_BLOCK;					\
+	}								\
+	*pp = p;							\
+	return cnt;							\
+}
+
+simdscanfunc(bte)
+simdscanfunc(sht)
+simdscanfunc(int)
+simdscanfunc(lng)
+simdscanfunc(flt)
+simdscanfunc(dbl)
+
+#define simdscan_avail_bte	(simdscan_init() > 0)
+#define simdscan_avail_sht	(simdscan_init() > 0)
+#define simdscan_avail_int	(simdscan_init() > 0)
+#define simdscan_avail_lng	(simdscan_init() > 0)
+#define simdscan_avail_flt	(simdscan_init() > 0)
+#define simdscan_avail_dbl	(simdscan_init() > 0)
+#else
+#define simdscan_avail_bte	0
+#define simdscan_avail_sht	0
+#define simdscan_avail_int	0
+#define simdscan_avail_lng	0
+#define simdscan_avail_flt	0
+#define simdscan_avail_dbl	0
+#define simdscan_bte(b, s, bn, src, r, pp, q, cnt, off, mode, vl, vh, nil, maximum)	(cnt)
+#define simdscan_sht(b, s, bn, src, r, pp, q, cnt, off, mode, vl, vh, nil, maximum)	(cnt)
+#define simdscan_int(b, s, bn, src, r, pp, q, cnt, off, mode, vl, vh, nil, maximum)	(cnt)
+#define simdscan_lng(b, s, bn, src, r, pp, q, cnt, off, mode, vl, vh, nil, maximum)	(cnt)
+#define simdscan_flt(b, s, bn, src, r, pp, q, cnt, off, mode, vl, vh, nil, maximum)	(cnt)
+#define simdscan_dbl(b, s, bn, src, r, pp, q, cnt, off, mode, vl, vh, nil, maximum)	(cnt)
+#endif
+#ifdef HAVE_HGE
+#define simdscan_avail_hge	0
+#define simdscan_hge(b, s, bn, src, r, pp, q, cnt, off, mode, vl, vh, nil, maximum)	(cnt)
+#endif
+
+/* invoke the vectorized scan from within scanfunc; continue with the
+ * scalar scanloop for the values that are left */
+#define simdscan(TYPE, MODE)						\
+	do {								\
+		cnt = simdscan_##TYPE(b, s, bn, src, r, &p, q, cnt, off, \
+				      MODE, vl, vh, nil, maximum);	\
+		if (cnt == BUN_NONE)					\
+			return BUN_NONE;				\
+		dst = (oid *) Tloc(bn, BUNfirst(bn));			\
+	} while (0)
+
 /* scan select type switch */
 #ifdef HAVE_HGE
 #define scanfunc_hge(NAME, CAND, END)	\
@@ -956,6 +1302,12 @@ BAT_scanselect(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
 			cnt = candscan_hge(scanargs);
 			break;
 #endif
+		case TYPE_str:
+			if (use_imprints) {
+				cnt = impsscan_str(scanargs);
+				break;
+			}
+			/* fall through */
 		default:
 			cnt = candscan_any(scanargs);
 			break;
@@ -1002,7 +1354,10 @@ BAT_scanselect(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
 			break;
 #endif
 		case TYPE_str:
-			cnt = fullscan_str(scanargs);
+			if (use_imprints)
+				cnt = impsscan_str(scanargs);
+			else
+				cnt = fullscan_str(scanargs);
 			break;
 		default:
 			cnt = fullscan_any(scanargs);
@@ -1691,6 +2046,32 @@ BATsubselect(BAT *b, BAT *s, const void *tl, const void *th,
 	/* limit estimation by upper limit */
 	estimate = MIN(estimate, maximum);
 
+	if (!(equi && hash) && !(equi && lnil)) {
+		/* skip the zones that cannot contain a match */
+		int done;
+
+		bn = ZMAPsubselect(b, s, tl, th, anti, &done);
+		if (done) {
+			ALGODEBUG fprintf(stderr, "#BATsubselect(b=%s#" BUNFMT
+					  ",s=%s%s,anti=%d): zone map select\n",
+					  BATgetId(b), BATcount(b),
+					  s ? BATgetId(s) : "NULL",
+					  s && BATtdense(s) ? "(dense)" : "", anti);
+			return virtualize(bn);
+		}
+	}
+
+	if (!(equi && hash) && BATcheckcompress(b)) {
+		/* scan the compressed copy instead of the tail */
+		ALGODEBUG fprintf(stderr, "#BATsubselect(b=%s#" BUNFMT
+				  ",s=%s%s,anti=%d): compressed select\n",
+				  BATgetId(b), BATcount(b),
+				  s ? BATgetId(s) : "NULL",
+				  s && BATtdense(s) ? "(dense)" : "", anti);
+		return virtualize(CMPsubselect(b, s, tl, th, li, hi, equi,
+					       anti, lval, hval, estimate));
+	}
+
 	bn = BATnew(TYPE_void, TYPE_oid, estimate, TRANSIENT);
 	if (bn == NULL)
 		return NULL;
@@ -1705,14 +2086,16 @@ BATsubselect(BAT *b, BAT *s, const void *tl, const void *th,
 	} else {
 		int use_imprints = 0;
 		if (!equi &&
-		    !b->tvarsized &&
+		    (!b->tvarsized ||
+		     (ATOMbasetype(b->ttype) == TYPE_str && !anti)) &&
 		    (b->batPersistence == PERSISTENT ||
 		     (parent != 0 &&
 		      BBPquickdesc(abs(parent),0)->batPersistence == PERSISTENT))) {
 			/* use imprints if
 			 *   i) bat is persistent, or parent is persistent
 			 *  ii) it is not an equi-select, and
-			 * iii) is not var-sized.
+			 * iii) is not var-sized, or is a string range
+			 *      select (not anti).
 			 */
 			use_imprints = 1;
 		}
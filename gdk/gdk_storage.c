@@ -958,6 +958,8 @@ BATdelete(BAT *b)
 		b = loaded;
 		HASHdestroy(b);
 		IMPSdestroy(b);
+		CMPdestroy(b);
+		ZMAPdestroy(b);
 	}
 	assert(!b->H->heap.base || !b->T->heap.base || b->H->heap.base != b->T->heap.base);
 	if (b->batCopiedtodisk || (b->H->heap.storage != STORE_MEM)) {
@@ -0,0 +1,365 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2008-2015 MonetDB B.V.
+ */
+
+/*
+ * Zone maps.
+ *
+ * A zone map records for each consecutive block ("zone") of
+ * ZMAP_ZONE values of a numeric column the smallest and the largest
+ * non-nil value in it.  A zone that consists of nils only has nil as
+ * both its minimum and its maximum.  Only complete zones are
+ * recorded, so appending to the column does not invalidate the zone
+ * map: the new values are simply not covered until BATzonemap is
+ * called again (or a selection extends the zone map).  Anything that
+ * changes or removes existing values destroys it.
+ *
+ * Zone maps are cheap to build (a single pass computing min and max)
+ * and small (two values per zone), so they are not saved on disk.
+ * BATsubselect uses them to skip the zones that cannot contain a
+ * match, both for the column itself and for slices (views) of it.
+ */
+
+#include "monetdb_config.h"
+#include "gdk.h"
+#include "gdk_private.h"
+
+#define ZMAP_ZONE	((BUN) 1 << 16)	/* values per zone */
+
+/* the type of the values in b's zone map, or -1 if b can't have one */
+static int
+zmap_type(BAT *b)
+{
+	int t;
+
+	if (b->ttype == TYPE_void)
+		return -1;
+	if (ATOMtype(b->ttype) == TYPE_oid)
+#if SIZEOF_OID == SIZEOF_INT
+		return TYPE_int;
+#else
+		return TYPE_lng;
+#endif
+	switch ((t = ATOMbasetype(b->ttype))) {
+	case TYPE_bte:
+	case TYPE_sht:
+	case TYPE_int:
+	case TYPE_lng:
+#ifdef HAVE_HGE
+	case TYPE_hge:
+#endif
+	case TYPE_flt:
+	case TYPE_dbl:
+		return t;
+	default:
+		return -1;
+	}
+}
+
+#define ZMAPBUILD(TYPE)							\
+	do {								\
+		const TYPE *restrict vals = (const TYPE *) Tloc(b, BUNfirst(b)); \
+		TYPE *restrict mins = (TYPE *) zm->min;			\
+		TYPE *restrict maxs = (TYPE *) zm->max;			\
+		const TYPE nil = TYPE##_nil;				\
+		for (z = zm->nzones; z < nzones; z++) {			\
+			TYPE mn = nil, mx = nil;			\
+			BUN i, e = (z + 1) * ZMAP_ZONE;			\
+			for (i = z * ZMAP_ZONE; i < e; i++) {		\
+				TYPE v = vals[i];			\
+				if (v == nil)				\
+					continue;			\
+				if (mn == nil || v < mn)		\
+					mn = v;				\
+				if (mx == nil || v > mx)		\
+					mx = v;				\
+			}						\
+			mins[z] = mn;					\
+			maxs[z] = mx;					\
+		}							\
+	} while (0)
+
+/* Make the zone map of b cover all its complete zones; the caller
+ * holds the zone map lock. */
+static gdk_return
+zmap_extend(BAT *b, int tpe)
+{
+	Zonemap *zm = b->T->zonemap;
+	BUN nzones = BATcount(b) / ZMAP_ZONE, z;
+	lng t0 = 0;
+
+	ALGODEBUG t0 = GDKusec();
+	if (zm == NULL) {
+		if ((zm = GDKzalloc(sizeof(Zonemap))) == NULL)
+			return GDK_FAIL;
+		zm->type = tpe;
+		b->T->zonemap = zm;
+	}
+	if (nzones <= zm->nzones)
+		return GDK_SUCCEED;
+	if (nzones > zm->maxzones) {
+		BUN maxzones = MAX(nzones, zm->maxzones + (zm->maxzones >> 1) + 16);
+		void *mn, *mx;
+
+		mn = GDKrealloc(zm->min, (size_t) maxzones * ATOMsize(tpe));
+		if (mn == NULL)
+			return GDK_FAIL;
+		zm->min = mn;
+		mx = GDKrealloc(zm->max, (size_t) maxzones * ATOMsize(tpe));
+		if (mx == NULL)
+			return GDK_FAIL;
+		zm->max = mx;
+		zm->maxzones = maxzones;
+	}
+	switch (tpe) {
+	case TYPE_bte:
+		ZMAPBUILD(bte);
+		break;
+	case TYPE_sht:
+		ZMAPBUILD(sht);
+		break;
+	case TYPE_int:
+		ZMAPBUILD(int);
+		break;
+	case TYPE_lng:
+		ZMAPBUILD(lng);
+		break;
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		ZMAPBUILD(hge);
+		break;
+#endif
+	case TYPE_flt:
+		ZMAPBUILD(flt);
+		break;
+	case TYPE_dbl:
+		ZMAPBUILD(dbl);
+		break;
+	}
+	ALGODEBUG fprintf(stderr, "#BATzonemap(b=%s#" BUNFMT "): zones "
+			  BUNFMT " to " BUNFMT " in " LLFMT " usec\n",
+			  BATgetId(b), BATcount(b), zm->nzones, nzones,
+			  GDKusec() - t0);
+	zm->nzones = nzones;
+	return GDK_SUCCEED;
+}
+
+/* the zone map of b can't be trusted if values were removed from
+ * under it */
+static int
+zmap_valid(BAT *b)
+{
+	Zonemap *zm = b->T->zonemap;
+
+	return b->batFirst == 0 && zm->nzones * ZMAP_ZONE <= BATcount(b);
+}
+
+static void
+zmap_free(Zonemap *zm)
+{
+	GDKfree(zm->min);
+	GDKfree(zm->max);
+	GDKfree(zm);
+}
+
+/* Create a zone map for b, or extend the one it has to cover the
+ * values appended since. */
+gdk_return
+BATzonemap(BAT *b)
+{
+	int tpe;
+	gdk_return ret;
+
+	BATcheck(b, "BATzonemap", GDK_FAIL);
+	assert(BAThdense(b));	/* assert void head */
+
+	if ((tpe = zmap_type(b)) < 0 || VIEWtparent(b) || b->batFirst != 0)
+		return GDK_FAIL;
+	MT_lock_set(&GDKzonemapLock(abs(b->batCacheid)), "BATzonemap");
+	if (b->T->zonemap && !zmap_valid(b)) {
+		zmap_free(b->T->zonemap);
+		b->T->zonemap = NULL;
+	}
+	ret = zmap_extend(b, tpe);
+	MT_lock_unset(&GDKzonemapLock(abs(b->batCacheid)), "BATzonemap");
+	return ret;
+}
+
+#define ZMAPCHECK(TYPE)							\
+	do {								\
+		const TYPE *restrict mins = (const TYPE *) zm->min;	\
+		const TYPE *restrict maxs = (const TYPE *) zm->max;	\
+		const TYPE lo = * (const TYPE *) tl;			\
+		const TYPE hi = * (const TYPE *) th;			\
+		for (z = zlo; z < zhi; z++) {				\
+			if (mins[z] == TYPE##_nil)			\
+				skip[z - zlo] = 1;			\
+			else if (anti)					\
+				skip[z - zlo] = mins[z] > lo && maxs[z] < hi; \
+			else						\
+				skip[z - zlo] = maxs[z] < lo || mins[z] > hi; \
+			nskip += skip[z - zlo];				\
+		}							\
+	} while (0)
+
+/* Select using the zone map of b (or of its parent if b is a view).
+ * The arguments are those of BATsubselect after normalization: not
+ * anti means tl <= x <= th, anti means x <= tl || x >= th (and in
+ * either case x not nil).  If the zone map allows skipping part of b,
+ * the selection is done on the remaining parts and *done is set;
+ * otherwise NULL is returned and *done is cleared. */
+BAT *
+ZMAPsubselect(BAT *b, BAT *s, const void *tl, const void *th, int anti, int *done)
+{
+	BAT *pb = b, *bn = NULL;
+	Zonemap *zm;
+	BUN off = 0, cnt = BATcount(b), zlo, zhi, zend, z, e, nskip = 0, p, q;
+	bit *skip;
+	int tpe;
+
+	*done = 0;
+	if (VIEWtparent(b)) {
+		pb = BBPdescriptor(-VIEWtparent(b));
+		off = (BUN) ((Tloc(b, BUNfirst(b)) - Tloc(pb, BUNfirst(pb))) / Tsize(b));
+	}
+	if ((tpe = zmap_type(pb)) < 0 || cnt < 2 * ZMAP_ZONE)
+		return NULL;
+
+	MT_lock_set(&GDKzonemapLock(abs(pb->batCacheid)), "ZMAPsubselect");
+	if (pb->T->zonemap && !zmap_valid(pb)) {
+		zmap_free(pb->T->zonemap);
+		pb->T->zonemap = NULL;
+	}
+	/* build the zone map on the fly for persistent columns, and
+	 * keep it up to date with appends */
+	if ((pb->T->zonemap == NULL &&
+	     (pb->batPersistence != PERSISTENT || pb->batFirst != 0)) ||
+	    zmap_extend(pb, tpe) != GDK_SUCCEED) {
+		MT_lock_unset(&GDKzonemapLock(abs(pb->batCacheid)), "ZMAPsubselect");
+		return NULL;
+	}
+	zm = pb->T->zonemap;
+	/* the zones that overlap with b */
+	zlo = off / ZMAP_ZONE;
+	zhi = MIN(zm->nzones, (off + cnt + ZMAP_ZONE - 1) / ZMAP_ZONE);
+	if (zlo >= zhi ||
+	    (skip = GDKmalloc(zhi - zlo)) == NULL) {
+		MT_lock_unset(&GDKzonemapLock(abs(pb->batCacheid)), "ZMAPsubselect");
+		return NULL;
+	}
+	switch (tpe) {
+	case TYPE_bte:
+		ZMAPCHECK(bte);
+		break;
+	case TYPE_sht:
+		ZMAPCHECK(sht);
+		break;
+	case TYPE_int:
+		ZMAPCHECK(int);
+		break;
+	case TYPE_lng:
+		ZMAPCHECK(lng);
+		break;
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		ZMAPCHECK(hge);
+		break;
+#endif
+	case TYPE_flt:
+		ZMAPCHECK(flt);
+		break;
+	case TYPE_dbl:
+		ZMAPCHECK(dbl);
+		break;
+	}
+	MT_lock_unset(&GDKzonemapLock(abs(pb->batCacheid)), "ZMAPsubselect");
+
+	ALGODEBUG fprintf(stderr, "#ZMAPsubselect(b=%s#" BUNFMT ",anti=%d): "
+			  "skipping " BUNFMT " of " BUNFMT " zones\n",
+			  BATgetId(b), cnt, anti, nskip, zhi - zlo);
+	if (nskip == 0) {
+		GDKfree(skip);
+		return NULL;
+	}
+	*done = 1;
+
+	bn = BATnew(TYPE_void, TYPE_oid, 0, TRANSIENT);
+	if (bn == NULL)
+		goto bailout;
+	/* select from each stretch of zones that isn't skipped; the
+	 * values of b beyond the zone map are never skipped */
+	zend = (off + cnt + ZMAP_ZONE - 1) / ZMAP_ZONE;
+	for (z = zlo; z < zend; z = e) {
+		BAT *v, *sv = NULL, *r;
+
+		if (z < zhi && skip[z - zlo]) {
+			e = z + 1;
+			continue;
+		}
+		for (e = z + 1; e < zend && !(e < zhi && skip[e - zlo]); e++)
+			;
+		/* the stretch is [p..q) in positions of b */
+		p = z * ZMAP_ZONE <= off ? 0 : z * ZMAP_ZONE - off;
+		q = MIN(cnt, e * ZMAP_ZONE - off);
+		if ((v = BATslice(b, p, q)) == NULL)
+			goto bailout;
+		if (s && !BATtdense(s)) {
+			oid o = b->hseqbase + p;
+			BUN lo = SORTfndfirst(s, &o) - BUNfirst(s);
+
+			o = b->hseqbase + q;
+			sv = BATslice(s, lo, SORTfndfirst(s, &o) - BUNfirst(s));
+			if (sv == NULL) {
+				BBPunfix(v->batCacheid);
+				goto bailout;
+			}
+		}
+		r = BATsubselect(v, sv ? sv : s, tl, th, !anti, !anti, anti);
+		BBPunfix(v->batCacheid);
+		if (sv)
+			BBPunfix(sv->batCacheid);
+		if (r == NULL)
+			goto bailout;
+		if (BATappend(bn, r, FALSE) != GDK_SUCCEED) {
+			BBPunfix(r->batCacheid);
+			goto bailout;
+		}
+		BBPunfix(r->batCacheid);
+	}
+	GDKfree(skip);
+	bn->tsorted = 1;
+	bn->trevsorted = BATcount(bn) <= 1;
+	bn->tkey = 1;
+	bn->T->nonil = 1;
+	bn->T->nil = 0;
+	bn->hseqbase = 0;
+	bn->hkey = 1;
+	bn->hsorted = 1;
+	bn->hrevsorted = BATcount(bn) <= 1;
+	bn->H->nonil = 1;
+	bn->H->nil = 0;
+	return bn;
+
+  bailout:
+	GDKfree(skip);
+	if (bn)
+		BBPreclaim(bn);
+	return NULL;
+}
+
+void
+ZMAPdestroy(BAT *b)
+{
+	if (b && b->T->zonemap && !VIEWtparent(b)) {
+		MT_lock_set(&GDKzonemapLock(abs(b->batCacheid)), "ZMAPdestroy");
+		if (b->T->zonemap) {
+			zmap_free(b->T->zonemap);
+			b->T->zonemap = NULL;
+		}
+		MT_lock_unset(&GDKzonemapLock(abs(b->batCacheid)), "ZMAPdestroy");
+	}
+}
@@ -228,6 +228,10 @@ MCinitClientRecord(Client c, oid user, bstream *fin, stream *fout)
 	c->session = GDKusec();
 	c->qtimeout = 0;
 	c->stimeout = 0;
+	c->memorylimit = 0;
+	c->memoryclaim = 0;
+	c->memorydelayed = 0;
+	c->protocol = 0;
 	c->stage = 0;
 	c->itrace = 0;
 	c->debugOptimizer = c->debugScheduler = 0;
@@ -372,6 +376,10 @@ freeClient(Client c)
 	//c->active = 0;
 	c->qtimeout = 0;
 	c->stimeout = 0;
+	c->memorylimit = 0;
+	c->memoryclaim = 0;
+	c->memorydelayed = 0;
+	c->protocol = 0;
 	c->user = oid_nil;
 	c->mythread = 0;
 	c->mode = MCshutdowninprogress()? BLOCKCLIENT: FREECLIENT;
@@ -25,6 +25,11 @@
 
 #define PROCESSTIMEOUT  2   /* seconds */
 
+/* optional MAPI protocol features, advertised in the challenge */
+#define PROTOCOL_FEATURES	"BINARY,COMPRESS"
+#define PROTOCOL_BINARY	1	/* columnar binary result sets */
+#define PROTOCOL_COMPRESS	2	/* compressed blocks on the wire */
+
 /*
  * The prompt structure is designed to simplify recognition of the
  * language framework for interaction. For direct console access it is a
@@ -83,6 +88,14 @@ typedef struct CLIENT {
 	lng 		session;	/* usec since start of server */
 	lng 	    qtimeout;	/* query abort after x usec*/
 	lng	        stimeout;	/* session abort after x usec */
+	/*
+	 * The memory budget of a query, enforced by the dataflow
+	 * admission control (see mal_resource.c).  The claim is the
+	 * memory estimated for the instructions running for this client.
+	 */
+	lng	memorylimit;	/* in MB, 0 means use the user's budget */
+	lng	memoryclaim;	/* in bytes */
+	int	memorydelayed;	/* an instruction waits for the budget */
 	/*
 	 * Communication channels for the interconnect are stored here.
 	 * It is perfectly legal to have a client without input stream.
@@ -106,6 +119,12 @@ typedef struct CLIENT {
 	ClientInput *bak;   /* used for recursive script and string execution */
 
 	stream   *fdout;    /* streams from and to user. */
+	/*
+	 * Optional MAPI protocol features are negotiated during the
+	 * challenge: the server lists what it supports, the client
+	 * picks from that list in its response (see MSscheduleClient).
+	 */
+	int       protocol; /* PROTOCOL_* features agreed upon */
 	/*
 	 * In interactive mode, reading one line at a time, we should be
 	 * aware of parsing compound structures, such as functions and
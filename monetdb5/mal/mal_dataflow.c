@@ -52,12 +52,28 @@ typedef struct FLOWEVENT {
 typedef struct queue {
 	int size;	/* size of queue */
 	int last;	/* last element in the queue */
-	int exitcount;	/* how many threads should exit */
 	FlowEvent *data;
 	MT_Lock l;	/* it's a shared resource, ie we need locks */
 	MT_Sema s;	/* threads wait on empty queues */
 } Queue;
 
+/* The instructions of a block that are ready to run are kept in a
+ * work-stealing deque (Chase and Lev, "Dynamic circular work-stealing
+ * deque", SPAA 2005).  The scheduler of the block is the only one
+ * adding to it, at the bottom, and the workers take from the top with
+ * a compare-and-swap on the top index, so neither side needs a lock.
+ * An instruction is in the deque at most once, so a buffer with room
+ * for all instructions of the block never fills up. */
+typedef struct deque {
+	volatile ATOMIC_TYPE top;	/* next entry to be taken */
+	volatile ATOMIC_TYPE bottom;	/* next entry to be filled */
+	ATOMIC_TYPE mask;		/* size of data - 1 */
+	FlowEvent *data;
+#ifdef ATOMIC_LOCK
+	MT_Lock lock;
+#endif
+} Deque;
+
 /*
  * The dataflow dependency is administered in a graph list structure.
  * For each instruction we keep the list of instructions that
@@ -74,6 +90,7 @@ typedef struct DATAFLOW {
 	int *edges;         /* dependency graph */
 	MT_Lock flowlock;   /* lock to protect the above */
 	Queue *done;        /* instructions handled */
+	Deque *todo;        /* instructions ready to run */
 } *DataFlow, DataFlowRec;
 
 static struct worker {
@@ -81,12 +98,33 @@ static struct worker {
 	enum {IDLE, RUNNING, JOINING, EXITED} flag;
 	Client cntxt;				/* client we do work for (NULL -> any) */
 	MT_Sema s;
+	/* scheduling statistics, only updated by the worker itself */
+	lng executed, stolen, direct, conflicts, misses, requeued;
 } workers[THREADS];
-static Queue *todo = 0;	/* pending instructions */
+
+/* The blocks being executed are registered in the slot of the
+ * specific worker that was created for them.  A worker pins a slot
+ * (increments stealers) before it looks at the deque of the block;
+ * the scheduler closes the slot (sets stealers from 0 to DFLOWclosed)
+ * before it destroys the block, so nobody looks at a deque that is
+ * going away.  The worker of a slot may exit before the block is done
+ * (a worker created for a recursive call from a generic worker is
+ * itself generic), so a slot is only reused once its block has been
+ * unregistered, not when its worker is gone. */
+#define DFLOWclosed	(-((ATOMIC_TYPE) 1 << 30))
+static struct flowslot {
+	DataFlow flow;
+	volatile ATOMIC_TYPE stealers;
+} flows[THREADS];
+static volatile int flowtop = 0; /* flows[flowtop..] are not in use */
+
+static MT_Sema todo;		/* one up per runnable instruction */
+static int todoready = 0;	/* the worker pool was created */
 #ifdef ATOMIC_LOCK
 static MT_Lock exitingLock MT_LOCK_INITIALIZER("exitingLock");
 #endif
 static volatile ATOMIC_TYPE exiting = 0;
+static volatile ATOMIC_TYPE exitcount = 0; /* how many generic workers should exit */
 
 static MT_Lock dataflowLock MT_LOCK_INITIALIZER("dataflowLock");
 
@@ -124,7 +162,6 @@ q_create(int sz, const char *name)
 		GDKfree(q);
 		return NULL;
 	}
-	q->exitcount = 0;
 
 	MT_lock_init(&q->l, name);
 	MT_sema_init(&q->s, 0, name);
@@ -166,118 +203,201 @@ q_enqueue(Queue *q, FlowEvent d)
 	MT_sema_up(&q->s, "q_enqueue");
 }
 
-/*
- * A priority queue over the hot claims of memory may
- * be more effective. It priorizes those instructions
- * that want to use a big recent result
- */
-
-#ifdef USE_MAL_ADMISSION
-static void
-q_requeue_(Queue *q, FlowEvent d)
+static FlowEvent
+q_dequeue(Queue *q)
 {
-	int i;
+	FlowEvent r = NULL;
 
 	assert(q);
-	assert(d);
-	if (q->last == q->size) {
-		/* enlarge buffer */
-		q->size <<= 1;
-		q->data = (FlowEvent*) GDKrealloc(q->data, sizeof(FlowEvent) * q->size);
-		assert(q->data);
+	MT_sema_down(&q->s, "q_dequeue");
+	if (ATOMIC_GET(exiting, exitingLock, "q_dequeue"))
+		return NULL;
+	MT_lock_set(&q->l, "q_dequeue");
+	assert(q->last > 0);
+	if (q->last > 0)
+		r = q->data[--q->last];
+	MT_lock_unset(&q->l, "q_dequeue");
+	assert(r);
+	return r;
+}
+
+static Deque *
+dq_create(int sz)
+{
+	Deque *d = (Deque *) GDKmalloc(sizeof(Deque));
+	ATOMIC_TYPE size = 16;
+
+	if (d == NULL)
+		return NULL;
+	while (size < sz)
+		size <<= 1;
+	d->data = (FlowEvent *) GDKmalloc(sizeof(FlowEvent) * size);
+	if (d->data == NULL) {
+		GDKfree(d);
+		return NULL;
 	}
-	for (i = q->last; i > 0; i--)
-		q->data[i] = q->data[i - 1];
-	q->data[0] = d;
-	q->last++;
+	d->mask = size - 1;
+	d->top = d->bottom = 0;
+#ifdef ATOMIC_LOCK
+	MT_lock_init(&d->lock, "dq_create");
+#endif
+	return d;
 }
+
 static void
-q_requeue(Queue *q, FlowEvent d)
+dq_destroy(Deque *d)
 {
-	assert(q);
 	assert(d);
-	MT_lock_set(&q->l, "q_requeue");
-	q_requeue_(q, d);
-	MT_lock_unset(&q->l, "q_requeue");
-	MT_sema_up(&q->s, "q_requeue");
-}
+#ifdef ATOMIC_LOCK
+	MT_lock_destroy(&d->lock);
 #endif
+	GDKfree(d->data);
+	GDKfree(d);
+}
 
-static FlowEvent
-q_dequeue(Queue *q, Client cntxt)
+/* Only called by the owner of the deque; incrementing bottom
+ * publishes the new entry to the workers. */
+static void
+dq_push(Deque *d, FlowEvent fe)
 {
-	FlowEvent r = NULL, s = NULL;
-	int i;
+	ATOMIC_TYPE b = d->bottom;
 
-	assert(q);
-	MT_sema_down(&q->s, "q_dequeue");
-	if (ATOMIC_GET(exiting, exitingLock, "q_dequeue"))
-		return NULL;
-	MT_lock_set(&q->l, "q_dequeue");
-	if (cntxt) {
-		int i, minpc = -1;
+	assert(fe);
+	assert(b - d->top <= d->mask);
+	d->data[b & d->mask] = fe;
+	(void) ATOMIC_INC(d->bottom, d->lock, "dq_push");
+}
 
-		for (i = q->last - 1; i >= 0; i--) {
-			if (q->data[i]->flow->cntxt == cntxt) {
-				if(minpc < 0){
-					minpc = i;
-					s = q->data[i];
-				}
-				r = q->data[i];
-				if( s && r && s->pc > r->pc){
-					minpc = i;
-					s = r;
-				}
-			}
-		}
-		if( minpc >= 0){
-			r = q->data[minpc];
-			i = minpc;
-			q->last--;
-			while (i < q->last) {
-				q->data[i] = q->data[i + 1];
-				i++;
-			}
-		} else r = NULL;
+/* Take the oldest entry.  Returns NULL if the deque is empty or if
+ * another worker took the entry first (in which case *conflict is
+ * set). */
+static FlowEvent
+dq_steal(Deque *d, int *conflict)
+{
+	ATOMIC_TYPE t, b;
+	FlowEvent fe;
 
-		MT_lock_unset(&q->l, "q_dequeue");
-		return r;
-	}
-	if (q->exitcount > 0) {
-		q->exitcount--;
-		MT_lock_unset(&q->l, "q_dequeue");
+	t = ATOMIC_GET(d->top, d->lock, "dq_steal");
+	b = ATOMIC_GET(d->bottom, d->lock, "dq_steal");
+	if (t >= b)
+		return NULL;
+	fe = d->data[t & d->mask];
+	if (!ATOMIC_CAS(d->top, t, t + 1, d->lock, "dq_steal")) {
+		*conflict = 1;
 		return NULL;
 	}
-	assert(q->last > 0);
-	if (q->last > 0) {
-		/* LIFO favors garbage collection */
-		r = q->data[--q->last];
-		for(i= q->last-1; r &&  i>=0; i--){
-			s= q->data[i];
-			if( s && s->flow && s->flow->stk &&
-			    r && r->flow && r->flow->stk &&
-			    s->flow->stk->tag < r->flow->stk->tag){
-				q->data[i]= r;
-				r = s;
+	return fe;
+}
+
+static int
+dq_empty(Deque *d)
+{
+	return ATOMIC_GET(d->top, d->lock, "dq_empty") >=
+		ATOMIC_GET(d->bottom, d->lock, "dq_empty");
+}
+
+/* make an instruction of the block available to the workers; only
+ * called by the scheduler of the block */
+static void
+DFLOWenqueue(DataFlow flow, FlowEvent fe)
+{
+	dq_push(flow->todo, fe);
+	MT_sema_up(&todo, "DFLOWenqueue");
+}
+
+/* Find an instruction for a worker to run.  A specific worker only
+ * takes work for its own client, a generic worker takes work from
+ * any block.  Each worker starts looking at a different block to
+ * spread the contention over the deques. */
+static FlowEvent
+DFLOWsteal(struct worker *t, Client cntxt)
+{
+	int i, j, n, conflict;
+	int start = (int) (t - workers);
+	DataFlow flow;
+	FlowEvent fe;
+
+	do {
+		conflict = 0;
+		n = flowtop;
+		for (i = 0; i < n; i++) {
+			j = (start + i) % n;
+			if (flows[j].flow == NULL)
+				continue;
+			fe = NULL;
+			if (ATOMIC_INC(flows[j].stealers, exitingLock, "DFLOWsteal") > 0 &&
+			    (flow = flows[j].flow) != NULL &&
+			    (cntxt == NULL || flow->cntxt == cntxt))
+				fe = dq_steal(flow->todo, &conflict);
+			(void) ATOMIC_DEC(flows[j].stealers, exitingLock, "DFLOWsteal");
+			if (fe) {
+				t->stolen++;
+				return fe;
 			}
 		}
-		q->data[q->last] = 0;
-	}
-	/* else: terminating */
-	/* try out random draw *
-	{
-		int i;
-		i = rand() % q->last;
-		r = q->data[i];
-		for (i++; i < q->last; i++)
-			q->data[i - 1] = q->data[i];
-		q->last--; i
-	}
-	 */
+		if (conflict)
+			t->conflicts++;
+	} while (conflict);
+	t->misses++;
+	return NULL;
+}
 
-	MT_lock_unset(&q->l, "q_dequeue");
-	assert(r);
-	return r;
+/* claim one of the requests for a generic worker to exit */
+static int
+DFLOWexitrequest(void)
+{
+	ATOMIC_TYPE n;
+
+	while ((n = ATOMIC_GET(exitcount, exitingLock, "DFLOWexitrequest")) > 0)
+		if (ATOMIC_CAS(exitcount, n, n - 1, exitingLock, "DFLOWexitrequest"))
+			return 1;
+	return 0;
+}
+
+/* register the block in the slot of its specific worker */
+static void
+DFLOWregister(int i, DataFlow flow)
+{
+	MT_lock_set(&dataflowLock, "DFLOWregister");
+	flows[i].flow = flow;
+	if (flowtop <= i)
+		flowtop = i + 1;
+	MT_lock_unset(&dataflowLock, "DFLOWregister");
+	/* open the slot, keeping the pins of workers that looked at
+	 * it while it was closed */
+	(void) ATOMIC_SUB(flows[i].stealers, DFLOWclosed, exitingLock, "DFLOWregister");
+}
+
+/* unregister the block and release its specific worker (turn it into
+ * a generic worker); only then can the slot be claimed again */
+static void
+DFLOWunregister(int i)
+{
+	/* wait until no worker looks at the deque of the block */
+	while (!ATOMIC_CAS(flows[i].stealers, 0, DFLOWclosed, exitingLock, "DFLOWunregister"))
+		MT_sleep_ms(1);
+	MT_lock_set(&dataflowLock, "DFLOWunregister");
+	flows[i].flow = NULL;
+	while (flowtop > 0 && flows[flowtop - 1].flow == NULL)
+		flowtop--;
+	workers[i].cntxt = NULL;
+	MT_lock_unset(&dataflowLock, "DFLOWunregister");
+}
+
+void
+DFLOWstatistics(DFLOWstats *st)
+{
+	int i;
+
+	memset(st, 0, sizeof(*st));
+	for (i = 0; i < THREADS; i++) {
+		st->executed += workers[i].executed;
+		st->stolen += workers[i].stolen;
+		st->direct += workers[i].direct;
+		st->conflicts += workers[i].conflicts;
+		st->misses += workers[i].misses;
+		st->requeued += workers[i].requeued;
+	}
 }
 
 /*
@@ -285,8 +405,9 @@ q_dequeue(Queue *q, Client cntxt)
  * Beware, we assume that variables are assigned a value once, otherwise
  * the order may really create errors.
  * The order of the instructions should be retained as long as possible.
- * Delay processing when we run out of memory.  Push the instruction back
- * on the end of queue, waiting for another attempt. Problem might become
+ * Delay processing when we run out of memory.  Hand the instruction back
+ * to the scheduler of its block, which puts it back in the deque,
+ * waiting for another attempt. Problem might become
  * that all threads but one are cycling through the queue, each time
  * finding an eligible instruction, but without enough space.
  * Therefore, we wait for a few milliseconds as an initial punishment.
@@ -327,26 +448,31 @@ DFLOWworker(void *T)
 	}
 	while (1) {
 		if (fnxt == 0) {
-			MT_lock_set(&dataflowLock, "DFLOWworker");
+			/* no need for dataflowLock here: if we see the
+			 * change to a generic worker late, we just look
+			 * for work of our old client once more */
 			cntxt = t->cntxt;
-			MT_lock_unset(&dataflowLock, "DFLOWworker");
-			fe = q_dequeue(todo, cntxt);
-			if (fe == NULL) {
-				if (cntxt) {
-					/* we're not done yet with work for the current
-					 * client (as far as we know), so give up the CPU
-					 * and let the scheduler enter some more work, but
-					 * first compensate for the down we did in
-					 * dequeue */
-					MT_sema_up(&todo->s, "DFLOWworker");
-					MT_sleep_ms(1);
-					continue;
-				}
-				/* no more work to be done: exit */
+			MT_sema_down(&todo, "DFLOWworker");
+			if (ATOMIC_GET(exiting, exitingLock, "DFLOWworker"))
+				break;
+			/* one generic worker too many: exit */
+			if (cntxt == NULL && DFLOWexitrequest())
 				break;
+			fe = DFLOWsteal(t, cntxt);
+			if (fe == NULL) {
+				/* the instruction we were woken up for is
+				 * not for us (or not visible yet), so give up
+				 * the CPU and let the scheduler enter some
+				 * more work, but first compensate for the
+				 * down we did */
+				MT_sema_up(&todo, "DFLOWworker");
+				MT_sleep_ms(1);
+				continue;
 			}
-		} else
+		} else {
 			fe = fnxt;
+			t->direct++;
+		}
 		if (ATOMIC_GET(exiting, exitingLock, "DFLOWworker")) {
 			break;
 		}
@@ -365,20 +491,44 @@ DFLOWworker(void *T)
 		MT_lock_unset(&flow->flowlock, "DFLOWworker");
 
 #ifdef USE_MAL_ADMISSION
-		if (MALadmission(fe->argclaim, fe->hotclaim)) {
+		if ((i = MALadmission(flow->cntxt, fe->argclaim, fe->hotclaim)) > 0) {
+			/* the instruction does not fit in the memory budget
+			 * of the query, even when running on its own */
+			error = createException(MAL, "dataflow",
+					"Instruction needs " LLFMT " MB, which exceeds the memory budget of " LLFMT " MB",
+					(fe->argclaim + fe->hotclaim) / (1024 * 1024),
+					MALgetMemoryLimit(flow->cntxt));
+			MT_lock_set(&flow->flowlock, "DFLOWworker");
+			fe->state = DFLOWwrapup;
+			if (!flow->error)
+				flow->error = error;
+			else
+				GDKfree(error);
+			MT_lock_unset(&flow->flowlock, "DFLOWworker");
+			q_enqueue(flow->done, fe);
+			continue;
+		}
+		if (i < 0) {
 			fe->hotclaim = 0;   /* don't assume priority anymore */
-			if (todo->last == 0)
+			if (dq_empty(flow->todo))
 				MT_sleep_ms(DELAYUNIT);
-			q_requeue(todo, fe);
+			/* only the scheduler of the block can put it back
+			 * in the deque */
+			MT_lock_set(&flow->flowlock, "DFLOWworker");
+			fe->state = DFLOWretry;
+			MT_lock_unset(&flow->flowlock, "DFLOWworker");
+			t->requeued++;
+			q_enqueue(flow->done, fe);
 			continue;
 		}
 #endif
+		t->executed++;
 		error = runMALsequence(flow->cntxt, flow->mb, fe->pc, fe->pc + 1, flow->stk, 0, 0);
 		PARDEBUG fprintf(stderr, "#executed pc= %d wrk= %d claim= " LLFMT "," LLFMT " %s\n",
 						 fe->pc, id, fe->argclaim, fe->hotclaim, error ? error : "");
 #ifdef USE_MAL_ADMISSION
 		/* release the memory claim */
-		MALadmission(-fe->argclaim, -fe->hotclaim);
+		MALadmission(flow->cntxt, -fe->argclaim, -fe->hotclaim);
 #endif
 		/* update the numa information. keep the thread-id producing the value */
 		p= getInstrPtr(flow->mb,fe->pc);
@@ -429,15 +579,11 @@ DFLOWworker(void *T)
 			}
 		MT_lock_unset(&flow->flowlock, "DFLOWworker");
 
+		/* the block may be gone once fe is handed back */
+		last = fnxt == 0 && dq_empty(flow->todo);
 		q_enqueue(flow->done, fe);
-		if ( fnxt == 0) {
-			int last;
-			MT_lock_set(&todo->l, "DFLOWworker");
-			last = todo->last;
-			MT_lock_unset(&todo->l, "DFLOWworker");
-			if (last == 0)
-				profilerHeartbeatEvent("wait");
-		}
+		if (last)
+			profilerHeartbeatEvent("wait");
 	}
 	GDKfree(GDKerrbuf);
 	GDKsetbuf(0);
@@ -461,18 +607,19 @@ DFLOWinitialize(void)
 	int created = 0;
 
 	MT_lock_set(&mal_contextLock, "DFLOWinitialize");
-	if (todo) {
+	if (todoready) {
 		/* somebody else beat us to it */
 		MT_lock_unset(&mal_contextLock, "DFLOWinitialize");
 		return 0;
 	}
-	todo = q_create(2048, "todo");
-	if (todo == NULL) {
-		MT_lock_unset(&mal_contextLock, "DFLOWinitialize");
-		return -1;
-	}
-	for (i = 0; i < THREADS; i++)
+	MT_sema_init(&todo, 0, "todo");
+	for (i = 0; i < THREADS; i++) {
 		MT_sema_init(&workers[i].s, 0, "DFLOWinitialize");
+		flows[i].flow = NULL;
+		flows[i].stealers = DFLOWclosed;
+	}
+	flowtop = 0;
+	exitcount = 0;
 	limit = GDKnr_threads ? GDKnr_threads - 1 : 0;
 #ifdef NEED_MT_LOCK_INIT
 	ATOMIC_INIT(exitingLock, "exitingLock");
@@ -490,11 +637,11 @@ DFLOWinitialize(void)
 	MT_lock_unset(&dataflowLock, "DFLOWinitialize");
 	if (created == 0) {
 		/* no threads created */
-		q_destroy(todo);
-		todo = NULL;
+		MT_sema_destroy(&todo);
 		MT_lock_unset(&mal_contextLock, "DFLOWinitialize");
 		return -1;
 	}
+	todoready = 1;
 	MT_lock_unset(&mal_contextLock, "DFLOWinitialize");
 	return 0;
 }
@@ -676,8 +823,8 @@ DFLOWscheduler(DataFlow flow, struct worker *w)
 			for (j = p->retc; j < p->argc; j++)
 				fe[i].argclaim = getMemoryClaim(fe[0].flow->mb, fe[0].flow->stk, p, j, FALSE);
 #endif
-			q_enqueue(todo, flow->status + i);
 			flow->status[i].state = DFLOWrunning;
+			DFLOWenqueue(flow, flow->status + i);
 			PARDEBUG fprintf(stderr, "#enqueue pc=%d claim=" LLFMT "\n", flow->status[i].pc, flow->status[i].argclaim);
 		}
 	MT_lock_unset(&flow->flowlock, "DFLOWscheduler");
@@ -686,19 +833,26 @@ DFLOWscheduler(DataFlow flow, struct worker *w)
 	PARDEBUG fprintf(stderr, "#run %d instructions in dataflow block\n", actions);
 
 	while (actions != tasks ) {
-		f = q_dequeue(flow->done, NULL);
+		f = q_dequeue(flow->done);
 		if (ATOMIC_GET(exiting, exitingLock, "DFLOWscheduler"))
 			break;
 		if (f == NULL)
 			throw(MAL, "dataflow", "DFLOWscheduler(): q_dequeue(flow->done) returned NULL");
 
+		MT_lock_set(&flow->flowlock, "DFLOWscheduler");
+		if (f->state == DFLOWretry) {
+			/* refused by admission control, try again */
+			f->state = DFLOWrunning;
+			DFLOWenqueue(flow, f);
+			MT_lock_unset(&flow->flowlock, "DFLOWscheduler");
+			continue;
+		}
+
 		/*
 		 * When an instruction is finished we have to reduce the blocked
 		 * counter for all dependent instructions.  for those where it
 		 * drops to zero we can scheduler it we do it here instead of the scheduler
 		 */
-
-		MT_lock_set(&flow->flowlock, "DFLOWscheduler");
 		tasks++;
 		for (last = f->pc - flow->start; last >= 0 && (i = flow->nodes[last]) > 0; last = flow->edges[last])
 			if (flow->status[i].state == DFLOWpending) {
@@ -706,7 +860,7 @@ DFLOWscheduler(DataFlow flow, struct worker *w)
 				if (flow->status[i].blocks == 1 ) {
 					flow->status[i].state = DFLOWrunning;
 					flow->status[i].blocks--;
-					q_enqueue(todo, flow->status + i);
+					DFLOWenqueue(flow, flow->status + i);
 					PARDEBUG fprintf(stderr, "#enqueue pc=%d claim= " LLFMT "\n", flow->status[i].pc, flow->status[i].argclaim);
 				} else {
 					flow->status[i].blocks--;
@@ -714,11 +868,8 @@ DFLOWscheduler(DataFlow flow, struct worker *w)
 			}
 		MT_lock_unset(&flow->flowlock, "DFLOWscheduler");
 	}
-	/* release the worker from its specific task (turn it into a
-	 * generic worker) */
-	MT_lock_set(&dataflowLock, "DFLOWscheduler");
-	w->cntxt = NULL;
-	MT_lock_unset(&dataflowLock, "DFLOWscheduler");
+	/* the worker is released from its specific task by
+	 * DFLOWunregister */
 	/* wrap up errors */
 	assert(flow->done->last == 0);
 	if (flow->error ) {
@@ -769,7 +920,7 @@ runMALdataflow(Client cntxt, MalBlkPtr mb, int startpc, int stoppc, MalStkPtr st
 	assert(stoppc > startpc);
 
 	/* check existence of workers */
-	if (todo == NULL) {
+	if (!todoready) {
 		/* create thread pool */
 		if (GDKnr_threads <= 1 || DFLOWinitialize() < 0) {
 			/* no threads created, run serially */
@@ -777,7 +928,7 @@ runMALdataflow(Client cntxt, MalBlkPtr mb, int startpc, int stoppc, MalStkPtr st
 			return MAL_SUCCEED;
 		}
 	}
-	assert(todo);
+	assert(todoready);
 	/* in addition, create one more worker that will only execute
 	 * tasks for the current client to compensate for our waiting
 	 * until all work is done */
@@ -801,7 +952,9 @@ runMALdataflow(Client cntxt, MalBlkPtr mb, int startpc, int stoppc, MalStkPtr st
 		} while (joined);
 	}
 	for (i = 0; i < THREADS; i++) {
-		if (workers[i].flag == IDLE) {
+		/* the slot may still hold the block of the worker that
+		 * exited, which is then still being executed */
+		if (workers[i].flag == IDLE && flows[i].flow == NULL) {
 			/* only create specific worker if we are not doing a
 			 * recursive call */
 			if (stk->calldepth > 1) {
@@ -860,8 +1013,17 @@ runMALdataflow(Client cntxt, MalBlkPtr mb, int startpc, int stoppc, MalStkPtr st
 		throw(MAL, "dataflow", "runMALdataflow(): Failed to create flow->done queue");
 	}
 
+	flow->todo = dq_create(stoppc - startpc + 1);
+	if (flow->todo == NULL) {
+		q_destroy(flow->done);
+		MT_lock_destroy(&flow->flowlock);
+		GDKfree(flow);
+		throw(MAL, "dataflow", "runMALdataflow(): Failed to create flow->todo deque");
+	}
+
 	flow->status = (FlowEvent)GDKzalloc((stoppc - startpc + 1) * sizeof(FlowEventRec));
 	if (flow->status == NULL) {
+		dq_destroy(flow->todo);
 		q_destroy(flow->done);
 		MT_lock_destroy(&flow->flowlock);
 		GDKfree(flow);
@@ -872,6 +1034,7 @@ runMALdataflow(Client cntxt, MalBlkPtr mb, int startpc, int stoppc, MalStkPtr st
 	flow->nodes = (int*)GDKzalloc(sizeof(int) * size);
 	if (flow->nodes == NULL) {
 		GDKfree(flow->status);
+		dq_destroy(flow->todo);
 		q_destroy(flow->done);
 		MT_lock_destroy(&flow->flowlock);
 		GDKfree(flow);
@@ -881,6 +1044,7 @@ runMALdataflow(Client cntxt, MalBlkPtr mb, int startpc, int stoppc, MalStkPtr st
 	if (flow->edges == NULL) {
 		GDKfree(flow->nodes);
 		GDKfree(flow->status);
+		dq_destroy(flow->todo);
 		q_destroy(flow->done);
 		MT_lock_destroy(&flow->flowlock);
 		GDKfree(flow);
@@ -888,21 +1052,25 @@ runMALdataflow(Client cntxt, MalBlkPtr mb, int startpc, int stoppc, MalStkPtr st
 	}
 	msg = DFLOWinitBlk(flow, mb, size);
 
-	if (msg == MAL_SUCCEED)
+	if (msg == MAL_SUCCEED) {
+		DFLOWregister(i, flow);
 		msg = DFLOWscheduler(flow, &workers[i]);
+		DFLOWunregister(i);
+		/* an error may have left a delayed instruction behind */
+		cntxt->memorydelayed = 0;
+	}
 
 	GDKfree(flow->status);
 	GDKfree(flow->edges);
 	GDKfree(flow->nodes);
+	dq_destroy(flow->todo);
 	q_destroy(flow->done);
 	MT_lock_destroy(&flow->flowlock);
 	GDKfree(flow);
 
 	/* we created one worker, now tell one worker to exit again */
-	MT_lock_set(&todo->l, "runMALdataflow");
-	todo->exitcount++;
-	MT_lock_unset(&todo->l, "runMALdataflow");
-	MT_sema_up(&todo->s, "runMALdataflow");
+	(void) ATOMIC_INC(exitcount, exitingLock, "runMALdataflow");
+	MT_sema_up(&todo, "runMALdataflow");
 
 	return msg;
 }
@@ -913,9 +1081,9 @@ stopMALdataflow(void)
 	int i;
 
 	ATOMIC_SET(exiting, 1, exitingLock, "q_dequeue");
-	if (todo) {
+	if (todoready) {
 		for (i = 0; i < THREADS; i++)
-			MT_sema_up(&todo->s, "stopMALdataflow");
+			MT_sema_up(&todo, "stopMALdataflow");
 		MT_lock_set(&dataflowLock, "stopMALdataflow");
 		for (i = 0; i < THREADS; i++) {
 			if (workers[i].flag != IDLE && workers[i].flag != JOINING) {
@@ -12,6 +12,18 @@
 #include "mal.h"
 #include "mal_client.h"
 
+/* work-stealing statistics of the dataflow workers, summed over all
+ * workers since the server started */
+typedef struct {
+	lng executed;		/* instructions executed */
+	lng stolen;		/* instructions taken from the deque of a block */
+	lng direct;		/* instructions continued without queueing */
+	lng conflicts;		/* steals lost to a concurrent steal */
+	lng misses;		/* wakeups that found no work to take */
+	lng requeued;		/* instructions refused by admission control */
+} DFLOWstats;
+
 mal_export str runMALdataflow(Client cntxt, MalBlkPtr mb, int startpc, int stoppc, MalStkPtr stk);
+mal_export void DFLOWstatistics(DFLOWstats *st);
 
 #endif /*  _MAL_DATAFLOW_H*/
@@ -51,8 +51,30 @@ int memoryclaims = 0;    /* number of threads active with expensive operations *
  *
  * Another option would be to maintain a priority queue of
  * suspended instructions.
+ *
+ * On top of the global pool, each query can be given a memory budget
+ * (in MB), either for its session (clients.setmemorylimit(n)) or for
+ * all sessions of a user (clients.setmemorylimit(user, n)).  The
+ * claims of the instructions running for a client are summed in the
+ * client record.  An instruction that would push this sum over the
+ * budget is delayed until instructions of the same query finish; if
+ * its claim alone exceeds the budget, it is rejected and the query
+ * fails instead of dragging the server into swap.  If both a session
+ * and a user budget are set, the smaller one applies.
+ * Note that the budget is checked against the claims, i.e. the
+ * estimated sizes of the arguments and results of the instructions
+ * (see getMemoryClaim), not against the memory actually allocated.
+ * Allocations inside an operator that exceed its estimate are not
+ * accounted for.
  */
 
+/* per-user memory budgets in MB, protected by admissionLock */
+static struct userlimit {
+	oid user;
+	lng limit;
+} *userlimits = NULL;
+static int nuserlimits = 0, maxuserlimits = 0;
+
 /*
  * The memory claim is the estimate for the amount of memory hold.
  * Views are consider cheap and ignored
@@ -115,13 +137,78 @@ getMemoryClaim(MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, int i, int flag)
  * The argclaim provides a hint on how much we actually may need to execute
  * The hotclaim is a hint how large the result would be.
  */
-#ifdef USE_MAL_ADMISSION
 static MT_Lock admissionLock MT_LOCK_INITIALIZER("admissionLock");
 
-/* experiments on sf-100 on small machine showed no real improvement */
+str
+MALsetUserMemoryLimit(oid user, lng limit)
+{
+	int i;
+
+	MT_lock_set(&admissionLock, "MALsetUserMemoryLimit");
+	for (i = 0; i < nuserlimits; i++)
+		if (userlimits[i].user == user)
+			break;
+	if (i == nuserlimits) {
+		if (nuserlimits == maxuserlimits) {
+			struct userlimit *n;
+
+			n = GDKrealloc(userlimits, (maxuserlimits + 16) * sizeof(struct userlimit));
+			if (n == NULL) {
+				MT_lock_unset(&admissionLock, "MALsetUserMemoryLimit");
+				throw(MAL, "clients.setmemorylimit", MAL_MALLOC_FAIL);
+			}
+			userlimits = n;
+			maxuserlimits += 16;
+		}
+		userlimits[nuserlimits].user = user;
+		nuserlimits++;
+	}
+	userlimits[i].limit = limit;
+	MT_lock_unset(&admissionLock, "MALsetUserMemoryLimit");
+	return MAL_SUCCEED;
+}
+
+/* the budget that applies to the client, in MB; call with
+ * admissionLock held
+ * A session can only lower the budget of its user, not raise it, so
+ * if both are set, the smaller one applies. */
+static lng
+memoryLimit(Client cntxt)
+{
+	int i;
+	lng limit = cntxt->memorylimit > 0 ? cntxt->memorylimit : 0;
+
+	for (i = 0; i < nuserlimits; i++)
+		if (userlimits[i].user == cntxt->user) {
+			if (userlimits[i].limit > 0 &&
+			    (limit == 0 || userlimits[i].limit < limit))
+				limit = userlimits[i].limit;
+			break;
+		}
+	return limit;
+}
+
+lng
+MALgetMemoryLimit(Client cntxt)
+{
+	lng limit;
+
+	MT_lock_set(&admissionLock, "MALgetMemoryLimit");
+	limit = memoryLimit(cntxt);
+	MT_lock_unset(&admissionLock, "MALgetMemoryLimit");
+	return limit;
+}
+
+#ifdef USE_MAL_ADMISSION
+/* experiments on sf-100 on small machine showed no real improvement
+ * Returns 0 if the instruction may run, -1 if it should be delayed,
+ * and 1 if it should be rejected, because its claim alone exceeds the
+ * memory budget of the client. */
 int
-MALadmission(lng argclaim, lng hotclaim)
+MALadmission(Client cntxt, lng argclaim, lng hotclaim)
 {
+	lng limit;
+
 	/* optimistically set memory */
 	if (argclaim == 0)
 		return 0;
@@ -133,9 +220,28 @@ MALadmission(lng argclaim, lng hotclaim)
 		memorypool = (lng)(MEMORY_THRESHOLD );
 
 	if (argclaim > 0) {
+		if (cntxt && (limit = memoryLimit(cntxt)) > 0) {
+			limit *= 1024 * 1024;
+			if (cntxt->memoryclaim + argclaim + hotclaim > limit) {
+				PARDEBUG
+				mnstr_printf(GDKstdout, "#Delayed due to memory budget " LLFMT " claimed " LLFMT " requested " LLFMT "\n", limit, cntxt->memoryclaim, argclaim + hotclaim);
+				if (cntxt->memoryclaim == 0) {
+					/* nothing to wait for */
+					MT_lock_unset(&admissionLock, "MALadmission");
+					return 1;
+				}
+				cntxt->memorydelayed = 1;
+				MT_lock_unset(&admissionLock, "MALadmission");
+				return -1;
+			}
+		}
 		if (memoryclaims == 0 || memorypool > argclaim + hotclaim) {
 			memorypool -= (argclaim + hotclaim);
 			memoryclaims++;
+			if (cntxt) {
+				cntxt->memoryclaim += argclaim + hotclaim;
+				cntxt->memorydelayed = 0;
+			}
 			PARDEBUG
 			mnstr_printf(GDKstdout, "#DFLOWadmit %3d thread %d pool " LLFMT "claims " LLFMT "," LLFMT "\n",
 						 memoryclaims, THRgettid(), memorypool, argclaim, hotclaim);
@@ -144,12 +250,19 @@ MALadmission(lng argclaim, lng hotclaim)
 		}
 		PARDEBUG
 		mnstr_printf(GDKstdout, "#Delayed due to lack of memory " LLFMT " requested " LLFMT " memoryclaims %d\n", memorypool, argclaim + hotclaim, memoryclaims);
+		if (cntxt)
+			cntxt->memorydelayed = 1;
 		MT_lock_unset(&admissionLock, "MALadmission");
 		return -1;
 	}
 	/* release memory claimed before */
 	memorypool += -argclaim - hotclaim;
 	memoryclaims--;
+	if (cntxt) {
+		cntxt->memoryclaim += argclaim + hotclaim;
+		if (cntxt->memoryclaim < 0)
+			cntxt->memoryclaim = 0;
+	}
 	PARDEBUG
 	mnstr_printf(GDKstdout, "#DFLOWadmit %3d thread %d pool " LLFMT " claims " LLFMT "," LLFMT "\n",
 				 memoryclaims, THRgettid(), memorypool, argclaim, hotclaim);
@@ -220,9 +333,7 @@ initResource(void)
 {
 #ifdef NEED_MT_LOCK_INIT
 	ATOMIC_INIT(runningLock, "runningLock");
-#ifdef USE_MAL_ADMISSION
 	MT_lock_init(&admissionLock, "admissionLock");
-#endif
 #endif
 	running = (ATOMIC_TYPE) GDKnr_threads;
 }
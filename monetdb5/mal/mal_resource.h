@@ -17,8 +17,10 @@
 
 #define USE_MAL_ADMISSION
 #ifdef USE_MAL_ADMISSION
-mal_export int MALadmission(lng argclaim, lng hotclaim);
+mal_export int MALadmission(Client cntxt, lng argclaim, lng hotclaim);
 #endif
+mal_export str MALsetUserMemoryLimit(oid user, lng limit);
+mal_export lng MALgetMemoryLimit(Client cntxt);
 
 mal_export lng getMemoryClaim(MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, int i, int flag);
 mal_export void MALresourceFairness(lng usec);
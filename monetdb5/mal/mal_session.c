@@ -145,10 +145,10 @@ void
 MSscheduleClient(str command, str challenge, bstream *fin, stream *fout)
 {
 	char *user = command, *algo = NULL, *passwd = NULL, *lang = NULL;
-	char *database = NULL, *s, *dbname;
+	char *database = NULL, *features = NULL, *s, *dbname;
 	Client c;
 
-	/* decode BIG/LIT:user:{cypher}passwordchal:lang:database: line */
+	/* decode BIG/LIT:user:{cypher}passwordchal:lang:database:[features:] line */
 
 	/* byte order */
 	s = strchr(user, ':');
@@ -209,10 +209,20 @@ MSscheduleClient(str command, str challenge, bstream *fin, stream *fout)
 	if (s) {
 		*s = 0;
 		database = s + 1;
-		/* we can have stuff following, make it void */
+		/* the optional protocol features may follow */
 		s = strchr(database, ':');
-		if (s)
+		if (s) {
 			*s = 0;
+			features = s + 1;
+			/* we can have more stuff following, make it void */
+			s = strchr(features, ':');
+			if (s)
+				*s = 0;
+			/* the client compresses from now on, and so do we;
+			 * small replies, like errors, still go uncompressed */
+			if (strstr(features, "COMPRESS") != NULL)
+				block_stream_compress(fout, 1);
+		}
 	}
 
 	dbname = GDKgetenv("gdk_dbname");
@@ -284,6 +294,12 @@ MSscheduleClient(str command, str challenge, bstream *fin, stream *fout)
 			GDKfree(command);
 			return;
 		}
+		/* only accept the features we advertised */
+		c->protocol = 0;
+		if (features != NULL && strstr(features, "BINARY") != NULL)
+			c->protocol |= PROTOCOL_BINARY;
+		if (features != NULL && strstr(features, "COMPRESS") != NULL)
+			c->protocol |= PROTOCOL_COMPRESS;
 		/* move this back !! */
 		if (c->nspace == 0) {
 			c->nspace = newModule(NULL, putName("user", 4));
@@ -9,6 +9,7 @@
 #include "monetdb_config.h"
 #include "mal.h"
 #include "mal_exception.h"
+#include "mal_interpreter.h"
 
 #ifdef WIN32
 #define aggr_export extern __declspec(dllexport)
@@ -1246,6 +1247,146 @@ AGGRsubmaxcand_val(bat *retval, const bat *bid, const bat *gid, const bat *eid,
 }
 
 
+/*
+ * Several grouped aggregates over the same grouping in one pass.  The
+ * arguments following abort_on_error are triples (aggregate, b,
+ * skip_nils), one per result, where aggregate is one of "count",
+ * "sum", "min" and "max".  The result type of a sum is taken from the
+ * corresponding return variable; min and max produce the values, not
+ * their positions.
+ */
+static str
+AGGRsubaggrExt(MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, int hascand)
+{
+	int naggr = pci->retc, first = pci->retc + 3 + hascand, j;
+	BAT *g, *e, *s = NULL, **bs, **res;
+	int *ops, *tps, *skip_nils;
+	int abort_on_error;
+	gdk_return rc;
+	str msg = MAL_SUCCEED;
+
+	if (pci->argc - first != 3 * naggr)
+		throw(MAL, "aggr.subaggr", ILLEGAL_ARGUMENT " One (aggregate, b, skip_nils) triple per result expected");
+	bs = GDKzalloc(2 * naggr * sizeof(BAT *));
+	ops = GDKmalloc(3 * naggr * sizeof(int));
+	if (bs == NULL || ops == NULL) {
+		GDKfree(bs);
+		GDKfree(ops);
+		throw(MAL, "aggr.subaggr", MAL_MALLOC_FAIL);
+	}
+	res = bs + naggr;
+	tps = ops + naggr;
+	skip_nils = tps + naggr;
+
+	g = BATdescriptor(*getArgReference_bat(stk, pci, pci->retc));
+	e = BATdescriptor(*getArgReference_bat(stk, pci, pci->retc + 1));
+	if (hascand)
+		s = BATdescriptor(*getArgReference_bat(stk, pci, pci->retc + 2));
+	abort_on_error = *getArgReference_bit(stk, pci, first - 1);
+	if (g == NULL || e == NULL || (hascand && s == NULL)) {
+		msg = createException(MAL, "aggr.subaggr", RUNTIME_OBJECT_MISSING);
+		goto bailout;
+	}
+	for (j = 0; j < naggr; j++) {
+		const char *op = *getArgReference_str(stk, pci, first + 3 * j);
+
+		if (strcmp(op, "count") == 0) {
+			ops[j] = GDK_AGGR_COUNT;
+			tps[j] = TYPE_wrd;
+		} else if (strcmp(op, "sum") == 0) {
+			ops[j] = GDK_AGGR_SUM;
+			tps[j] = getColumnType(getArgType(mb, pci, j));
+		} else if (strcmp(op, "min") == 0) {
+			ops[j] = GDK_AGGR_MIN;
+			tps[j] = TYPE_oid;
+		} else if (strcmp(op, "max") == 0) {
+			ops[j] = GDK_AGGR_MAX;
+			tps[j] = TYPE_oid;
+		} else {
+			msg = createException(MAL, "aggr.subaggr", ILLEGAL_ARGUMENT " Unknown aggregate %s", op);
+			goto bailout;
+		}
+		skip_nils[j] = *getArgReference_bit(stk, pci, first + 3 * j + 2);
+		bs[j] = BATdescriptor(*getArgReference_bat(stk, pci, first + 3 * j + 1));
+		if (bs[j] == NULL) {
+			msg = createException(MAL, "aggr.subaggr", RUNTIME_OBJECT_MISSING);
+			goto bailout;
+		}
+	}
+
+	rc = BATgroupaggrmulti(res, naggr, bs, ops, tps, skip_nils, g, e, s, abort_on_error);
+	if (rc != GDK_SUCCEED) {
+		char *errbuf = GDKerrbuf;
+		char *t;
+
+		if (errbuf && *errbuf) {
+			if (strncmp(errbuf, "!ERROR: ", 8) == 0)
+				errbuf += 8;
+			if (strchr(errbuf, '!') == errbuf + 5) {
+				msg = createException(MAL, "aggr.subaggr", "%s", errbuf);
+			} else if ((t = strchr(errbuf, ':')) != NULL && t[1] == ' ') {
+				msg = createException(MAL, "aggr.subaggr", "%s", t + 2);
+			} else {
+				msg = createException(MAL, "aggr.subaggr", "%s", errbuf);
+			}
+			*GDKerrbuf = 0;
+		} else
+			msg = createException(MAL, "aggr.subaggr", OPERATION_FAILED);
+		goto bailout;
+	}
+	for (j = 0; j < naggr; j++) {
+		if (ops[j] == GDK_AGGR_MIN || ops[j] == GDK_AGGR_MAX) {
+			/* turn the positions into values */
+			BAT *t = BATproject(res[j], bs[j]);
+
+			BBPunfix(res[j]->batCacheid);
+			res[j] = t;
+			if (t == NULL) {
+				msg = createException(MAL, "aggr.subaggr", MAL_MALLOC_FAIL);
+				goto bailout;
+			}
+		}
+	}
+	for (j = 0; j < naggr; j++) {
+		BBPkeepref(*getArgReference_bat(stk, pci, j) = res[j]->batCacheid);
+		res[j] = NULL;
+	}
+
+  bailout:
+	for (j = 0; j < naggr; j++) {
+		if (bs[j])
+			BBPunfix(bs[j]->batCacheid);
+		if (res[j])
+			BBPunfix(res[j]->batCacheid);
+	}
+	if (g)
+		BBPunfix(g->batCacheid);
+	if (e)
+		BBPunfix(e->batCacheid);
+	if (s)
+		BBPunfix(s->batCacheid);
+	GDKfree(bs);
+	GDKfree(ops);
+	return msg;
+}
+
+aggr_export str AGGRsubaggr(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
+str
+AGGRsubaggr(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	(void) cntxt;
+	return AGGRsubaggrExt(mb, stk, pci, 0);
+}
+
+aggr_export str AGGRsubaggrcand(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
+str
+AGGRsubaggrcand(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	(void) cntxt;
+	return AGGRsubaggrExt(mb, stk, pci, 1);
+}
+
+
 aggr_export str AGGRmedian(bat *retval, const bat *bid, const bit *skip_nils);
 str
 AGGRmedian(bat *retval, const bat *bid, const bit *skip_nils)
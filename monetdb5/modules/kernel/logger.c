@@ -163,7 +163,7 @@ gdk_return
 log_tend_wrap(logger *L )
 {
 	logger *l = *(logger**)L;
-	if (l && log_tend(l) == LOG_OK)
+	if (l && log_tend(l) == LOG_OK && log_tflush(l, l->tends) == LOG_OK)
 		return GDK_SUCCEED;
 	return GDK_FAIL;
 }
@@ -21,6 +21,7 @@
 
 #include "monetdb_config.h"
 #include "gdk.h"
+#include "gdk_logger.h"
 #include <stdarg.h>
 #include <time.h>
 #include "mal_exception.h"
@@ -626,6 +627,14 @@ SYSgdkEnv(bat *ret, bat *ret2)
 	BUNappend(b, &BBPout, FALSE);
 	BUNappend(bn, "fromdisk", FALSE);
 	BUNappend(b, &BBPin, FALSE);
+	BUNappend(bn, "logcommits", FALSE);
+	BUNappend(b, &logger_commits, FALSE);
+	BUNappend(bn, "logflushes", FALSE);
+	BUNappend(b, &logger_flushes, FALSE);
+	/* commits per fsync of the log, > 1 with group commit */
+	tmp = logger_flushes ? logger_commits / logger_flushes : 0;
+	BUNappend(bn, "logcommitsperflush", FALSE);
+	BUNappend(b, &tmp, FALSE);
 	if (!(b->batDirty & 2)) BATsetaccess(b, BAT_READ);
 	if (!(bn->batDirty&2)) BATsetaccess(bn, BAT_READ);
 	pseudo(ret,ret2, bn,b);
@@ -25,6 +25,7 @@
 #include "mal_client.h"
 #include "mal_authorize.h"
 #include "mal_private.h"
+#include "mal_resource.h"
 #include "mtime.h"
 
 #ifdef HAVE_LIBREADLINE
@@ -383,6 +384,52 @@ CLTgetTimeout(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
     return MAL_SUCCEED;
 }
 
+str
+CLTsetMemoryLimit(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	lng limit;
+	str msg, *name;
+	BAT *users;
+	BATiter bi;
+	BUN p, q;
+	oid uid = oid_nil;
+
+	(void) mb;
+	limit = *getArgReference_lng(stk, pci, pci->argc - 1);
+	if (limit < 0 || limit == lng_nil)
+		throw(MAL, "clients.setmemorylimit", "Illegal memory limit");
+	if (pci->argc == 2) {
+		cntxt->memorylimit = limit;
+		return MAL_SUCCEED;
+	}
+	/* budget for all sessions of a user */
+	name = getArgReference_str(stk, pci, 1);
+	msg = AUTHgetUsers(&users, &cntxt);
+	if (msg)
+		return msg;
+	bi = bat_iterator(users);
+	BATloop(users, p, q) {
+		if (strcmp(BUNtail(bi, p), *name) == 0) {
+			uid = *(oid *) BUNhead(bi, p);
+			break;
+		}
+	}
+	BBPunfix(users->batCacheid);
+	if (uid == oid_nil)
+		throw(MAL, "clients.setmemorylimit", "No such user '%s'", *name);
+	return MALsetUserMemoryLimit(uid, limit);
+}
+
+str
+CLTgetMemoryLimit(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	lng *ret = getArgReference_lng(stk, pci, 0);
+
+	(void) mb;
+	*ret = MALgetMemoryLimit(cntxt);
+	return MAL_SUCCEED;
+}
+
 str
 CLTwakeup(void *ret, int *id)
 {
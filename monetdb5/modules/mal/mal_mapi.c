@@ -133,8 +133,10 @@ doChallenge(void *data)
 	/* generate the challenge string */
 	generateChallenge(challenge, 8, 12);
 	algos = mcrypt_getHashAlgorithms();
-	/* note that we claim to speak proto 9 here for hashed passwords */
-	mnstr_printf(fdout, "%s:mserver:9:%s:%s:%s:",
+	/* note that we claim to speak proto 9 here for hashed passwords,
+	 * the trailing field lists the optional protocol features; older
+	 * clients simply ignore it */
+	mnstr_printf(fdout, "%s:mserver:9:%s:%s:%s:%s:",
 			challenge,
 			algos,
 #ifdef WORDS_BIGENDIAN
@@ -142,7 +144,8 @@ doChallenge(void *data)
 #else
 			"LIT",
 #endif
-			MONETDB5_PASSWDHASH
+			MONETDB5_PASSWDHASH,
+			PROTOCOL_FEATURES
 			);
 	free(algos);
 	mnstr_flush(fdout);
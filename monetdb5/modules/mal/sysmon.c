@@ -10,6 +10,8 @@
 #include "sysmon.h"
 #include "mal_authorize.h"
 #include "mal_runtime.h"
+#include "mal_dataflow.h"
+#include "mal_resource.h"
 #include "mtime.h"
 
 /* (c) M.L. Kersten
@@ -20,6 +22,7 @@ str
 SYSMONqueue(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 {
 	BAT *tag, *user, *query, *estimate, *started, *progress, *activity, *oids;
+	BAT *memory = NULL, *memorylimit = NULL;
 	bat *t = getArgReference_bat(stk,pci,0);
 	bat *u = getArgReference_bat(stk,pci,1);
 	bat *s = getArgReference_bat(stk,pci,2);
@@ -28,7 +31,7 @@ SYSMONqueue(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 	bat *a = getArgReference_bat(stk,pci,5);
 	bat *o = getArgReference_bat(stk,pci,6);
 	bat *q = getArgReference_bat(stk,pci,7);
-	lng now;
+	lng now, mb_claim;
 	int i, prog;
 	str usr;
 	timestamp ts, tsn;
@@ -44,7 +47,13 @@ SYSMONqueue(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 	activity = BATnew(TYPE_void, TYPE_str, 256, TRANSIENT);
 	oids = BATnew(TYPE_void, TYPE_oid, 256, TRANSIENT);
 	query = BATnew(TYPE_void, TYPE_str, 256, TRANSIENT);
-	if ( tag == NULL || query == NULL || started == NULL || estimate == NULL || progress == NULL || activity == NULL || oids == NULL){
+	/* the memory budget columns are optional */
+	if ( pci->retc > 8) {
+		memory = BATnew(TYPE_void, TYPE_lng, 256, TRANSIENT);
+		memorylimit = BATnew(TYPE_void, TYPE_lng, 256, TRANSIENT);
+	}
+	if ( tag == NULL || query == NULL || started == NULL || estimate == NULL || progress == NULL || activity == NULL || oids == NULL ||
+		 (pci->retc > 8 && (memory == NULL || memorylimit == NULL))){
 		if (tag) BBPunfix(tag->batCacheid);
 		if (user) BBPunfix(user->batCacheid);
 		if (query) BBPunfix(query->batCacheid);
@@ -53,6 +62,8 @@ SYSMONqueue(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 		if (estimate) BBPunfix(estimate->batCacheid);
 		if (progress) BBPunfix(progress->batCacheid);
 		if (oids) BBPunfix(oids->batCacheid);
+		if (memory) BBPunfix(memory->batCacheid);
+		if (memorylimit) BBPunfix(memorylimit->batCacheid);
 		throw(MAL, "SYSMONqueue", MAL_MALLOC_FAIL);
 	}
 	BATseqbase(tag, 0);
@@ -79,6 +90,13 @@ SYSMONqueue(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 	BATseqbase(oids, 0);
     BATkey(oids, TRUE);
 
+	if ( memory) {
+		BATseqbase(memory, 0);
+		BATkey(memory, TRUE);
+		BATseqbase(memorylimit, 0);
+		BATkey(memorylimit, TRUE);
+	}
+
 	MT_lock_set(&mal_delayLock, "sysmon");
 	for ( i = 0; i< QRYqueue[i].tag; i++)
 	if( QRYqueue[i].query && (QRYqueue[i].cntxt->idx == 0 || QRYqueue[i].cntxt->user == cntxt->user)) {
@@ -94,7 +112,12 @@ SYSMONqueue(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 
 		BUNappend(user, usr, FALSE);
 		BUNappend(query, QRYqueue[i].query, FALSE);
-		BUNappend(activity, QRYqueue[i].status, FALSE);
+		/* a running query whose next instruction does not fit
+		 * in its memory budget */
+		if ( QRYqueue[i].cntxt->memorydelayed && QRYqueue[i].stk && QRYqueue[i].stk->status == 0)
+			BUNappend(activity, "waiting for memory", FALSE);
+		else
+			BUNappend(activity, QRYqueue[i].status, FALSE);
 
 		/* convert number of seconds into a timestamp */
 		now = QRYqueue[i].start * 1000;
@@ -120,6 +143,13 @@ SYSMONqueue(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 		}
 		BUNappend(oids, &QRYqueue[i].mb->tag, FALSE);
 		BUNappend(progress, &prog, FALSE);
+		if ( memory) {
+			/* claims are in bytes, budgets in MB */
+			mb_claim = QRYqueue[i].cntxt->memoryclaim / (1024 * 1024);
+			BUNappend(memory, &mb_claim, FALSE);
+			mb_claim = MALgetMemoryLimit(QRYqueue[i].cntxt);
+			BUNappend(memorylimit, &mb_claim, FALSE);
+		}
 	}
 	MT_lock_unset(&mal_delayLock, "sysmon");
 	BBPkeepref( *t =tag->batCacheid);
@@ -130,6 +160,10 @@ SYSMONqueue(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 	BBPkeepref( *p =progress->batCacheid);
 	BBPkeepref( *o =oids->batCacheid);
 	BBPkeepref( *q =query->batCacheid);
+	if ( memory) {
+		BBPkeepref( *getArgReference_bat(stk,pci,8) = memory->batCacheid);
+		BBPkeepref( *getArgReference_bat(stk,pci,9) = memorylimit->batCacheid);
+	}
 	return MAL_SUCCEED;
 
   bailout:
@@ -142,9 +176,52 @@ SYSMONqueue(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 	BBPunfix(estimate->batCacheid);
 	BBPunfix(progress->batCacheid);
 	BBPunfix(oids->batCacheid);
+	if ( memory) {
+		BBPunfix(memory->batCacheid);
+		BBPunfix(memorylimit->batCacheid);
+	}
 	return msg;
 }
 
+str
+SYSMONdataflow(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	BAT *name, *value;
+	bat *n = getArgReference_bat(stk,pci,0);
+	bat *v = getArgReference_bat(stk,pci,1);
+	DFLOWstats st;
+
+	(void) cntxt;
+	(void) mb;
+	name = BATnew(TYPE_void, TYPE_str, 8, TRANSIENT);
+	value = BATnew(TYPE_void, TYPE_lng, 8, TRANSIENT);
+	if (name == NULL || value == NULL) {
+		if (name) BBPunfix(name->batCacheid);
+		if (value) BBPunfix(value->batCacheid);
+		throw(MAL, "SYSMONdataflow", MAL_MALLOC_FAIL);
+	}
+	BATseqbase(name, 0);
+	BATseqbase(value, 0);
+
+	DFLOWstatistics(&st);
+	BUNappend(name, "executed", FALSE);
+	BUNappend(value, &st.executed, FALSE);
+	BUNappend(name, "stolen", FALSE);
+	BUNappend(value, &st.stolen, FALSE);
+	BUNappend(name, "direct", FALSE);
+	BUNappend(value, &st.direct, FALSE);
+	BUNappend(name, "conflicts", FALSE);
+	BUNappend(value, &st.conflicts, FALSE);
+	BUNappend(name, "misses", FALSE);
+	BUNappend(value, &st.misses, FALSE);
+	BUNappend(name, "requeued", FALSE);
+	BUNappend(value, &st.requeued, FALSE);
+
+	BBPkeepref( *n = name->batCacheid);
+	BBPkeepref( *v = value->batCacheid);
+	return MAL_SUCCEED;
+}
+
 str
 SYSMONpause(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 {	lng i, tag = 0;
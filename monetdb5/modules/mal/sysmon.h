@@ -25,5 +25,6 @@ sysmon_export str SYSMONpause(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPt
 sysmon_export str SYSMONresume(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
 sysmon_export str SYSMONstop(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
 sysmon_export str SYSMONqueue(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
+sysmon_export str SYSMONdataflow(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
 
 #endif /* _SYSMON_H */
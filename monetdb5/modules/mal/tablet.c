@@ -38,6 +38,7 @@
 #include "monetdb_config.h"
 #include "tablet.h"
 #include "algebra.h"
+#include "mtime.h"
 
 #include <string.h>
 #include <ctype.h>
@@ -609,6 +610,163 @@ output_file_ordered(Tablet *as, BAT *order, stream *fd, oid base)
 	return res;
 }
 
+/*
+ * Parallel export
+ * Dumping a large table is CPU bound in the conversion of the values
+ * to text.  When the columns are aligned (the dense and ordered cases)
+ * the rows are cut into slices that are formatted by several threads,
+ * each into a private buffer.  The buffers are written to the stream
+ * in row order by the calling thread, so the output is identical to
+ * the sequential one, whatever the stream (compressed streams are
+ * handled by the stream library).  The work proceeds in rounds of one
+ * slice per thread, which bounds the memory used for the buffers.
+ */
+#define EXPORTSLICE	((BUN) 1 << 16)	/* rows per thread per round */
+
+typedef struct {
+	Tablet *as;
+	BATiter orderi;			/* NULL order for the dense case */
+	BATiter *ci;			/* private copies of the column iterators */
+	BAT *order;
+	oid base;
+	BUN first, last;		/* rows [first,last) of the export */
+	char *buf;
+	size_t fill, len;
+	char *localbuf;
+	int locallen;
+	int res;
+} EXPORTtask;
+
+static int
+export_append(EXPORTtask *t, const char *p, size_t l)
+{
+	if (t->fill + l >= t->len) {
+		size_t len = t->fill + l + t->len;
+		char *buf = GDKrealloc(t->buf, len);
+
+		if (buf == NULL)
+			return -1;
+		t->buf = buf;
+		t->len = len;
+	}
+	memcpy(t->buf + t->fill, p, l);
+	t->fill += l;
+	return 0;
+}
+
+static void
+export_slice(void *arg)
+{
+	EXPORTtask *t = (EXPORTtask *) arg;
+	Column *fmt = t->as->format;
+	BUN nr_attrs = t->as->nr_attrs;
+	BUN r, i, id;
+
+	t->fill = 0;
+	for (r = t->first; r < t->last; r++) {
+		if (t->order)
+			id = (BUN) (*(oid *) BUNhead(t->orderi, BUNfirst(t->order) + t->as->offset + r) - t->base);
+		else
+			id = t->as->offset + r;
+		for (i = 0; i < nr_attrs; i++) {
+			Column *f = fmt + i;
+
+			if (f->c) {
+				/* BUNtail writes the value of a void column
+				 * in the iterator, so each thread uses its
+				 * own */
+				const char *p = BUNtail(t->ci[i], id + BUNfirst(f->c));
+				int l;
+
+				if (!p || ATOMcmp(f->adt, ATOMnilptr(f->adt), p) == 0) {
+					p = f->nullstr;
+					l = (int) strlen(p);
+				} else {
+					l = f->tostr(f->extra, &t->localbuf, &t->locallen, f->adt, p);
+					p = t->localbuf;
+				}
+				if (p == NULL || l < 0 || export_append(t, p, (size_t) l) < 0) {
+					t->res = -1;
+					return;
+				}
+			}
+			if (export_append(t, f->sep, (size_t) f->seplen) < 0) {
+				t->res = -1;
+				return;
+			}
+		}
+	}
+}
+
+/* Write rows [0, as->nr) using up to n threads; the order BAT is NULL
+ * for the dense case. */
+static int
+output_file_parallel(Tablet *as, BAT *order, stream *fd, oid base, int n)
+{
+	EXPORTtask t[MAXWORKERS];
+	MT_Id tids[MAXWORKERS];
+	BUN r = 0, k;
+	int i, j, res = 0;
+
+	memset(t, 0, sizeof(t));
+	for (i = 0; i < n; i++) {
+		t[i].as = as;
+		t[i].order = order;
+		if (order)
+			t[i].orderi = bat_iterator(order);
+		t[i].base = base;
+		t[i].len = BUFSIZ;
+		t[i].buf = GDKmalloc(t[i].len);
+		t[i].locallen = BUFSIZ;
+		t[i].localbuf = GDKzalloc(t[i].locallen);
+		t[i].ci = GDKzalloc(as->nr_attrs * sizeof(BATiter));
+		if (t[i].buf == NULL || t[i].localbuf == NULL || t[i].ci == NULL) {
+			res = -1;
+			n = i + 1;
+			goto bailout;
+		}
+		for (k = 0; k < as->nr_attrs; k++)
+			if (as->format[k].c)
+				t[i].ci[k] = bat_iterator(as->format[k].c);
+	}
+	while (r < as->nr && res == 0) {
+		int m;
+
+		for (m = 0; m < n && r < as->nr; m++) {
+			t[m].first = r;
+			r = as->nr - r > EXPORTSLICE ? r + EXPORTSLICE : as->nr;
+			t[m].last = r;
+		}
+		for (i = 1; i < m; i++) {
+			if (MT_create_thread(&tids[i], export_slice, &t[i], MT_THR_JOINABLE) < 0) {
+				/* format the remaining slices ourselves */
+				for (j = i; j < m; j++)
+					export_slice(&t[j]);
+				break;
+			}
+		}
+		export_slice(&t[0]);
+		for (j = 1; j < i; j++)
+			MT_join_thread(tids[j]);
+		for (i = 0; i < m && res == 0; i++) {
+			if (t[i].res < 0)
+				res = -1;
+			else if (mnstr_write(fd, t[i].buf, 1, t[i].fill) != (ssize_t) t[i].fill)
+				res = TABLET_error(fd);
+		}
+	}
+  bailout:
+	for (i = 0; i < n; i++) {
+		if (t[i].buf)
+			GDKfree(t[i].buf);
+		if (t[i].localbuf)
+			GDKfree(t[i].localbuf);
+		if (t[i].ci)
+			GDKfree(t[i].ci);
+	}
+	return res;
+}
+
 int
 TABLEToutput_file(Tablet *as, BAT *order, stream *s)
 {
@@ -625,7 +783,12 @@ TABLEToutput_file(Tablet *as, BAT *order, stream *s)
 		as->nr = maxnr;
 
 	if ((base = check_BATs(as)) != oid_nil) {
-		if (BAThdense(order) && order->hseqbase == base)
+		int dense = BAThdense(order) && order->hseqbase == base;
+		int threads = GDKnr_threads < MAXWORKERS ? GDKnr_threads : MAXWORKERS;
+
+		if (threads > 1 && as->nr / EXPORTSLICE >= 2)
+			ret = output_file_parallel(as, dense ? NULL : order, s, base, threads);
+		else if (dense)
 			ret = output_file_dense(as, s);
 		else
 			ret = output_file_ordered(as, order, s, base);
@@ -708,6 +871,10 @@ typedef struct {
 	int besteffort;
 	bte *rowerror;
 	int errorcnt;
+
+	int splitters;				/* threads to find record boundaries */
+	char **seps;				/* record separators found in parallel */
+	size_t nseps, maxseps;
 } READERtask;
 
 static void
@@ -872,16 +1039,14 @@ SQLload_error(READERtask *task, lng idx, BUN attrs)
  * If the string starts with the quote identified from SQL, we locate the tail
  * and interpret the body.
  */
-static inline int
-SQLinsert_val(READERtask *task, int col, int idx)
+static inline const void *
+SQLconvert_val(READERtask *task, int col, int idx, int *ret)
 {
 	Column *fmt = task->as->format + col;
 	const void *adt;
 	char buf[BUFSIZ];
 	char *s = task->fields[col][idx];
-	ptr key = 0;
 	char *err = NULL;
-	int ret = 0;
 
 	/* include testing on the terminating null byte !! */
 	if (s == 0) {
@@ -909,12 +1074,25 @@ SQLinsert_val(READERtask *task, int col, int idx)
 			task->errorcnt++;
 			MT_lock_unset(&errorlock, "insert_val");
 		}
-		ret = -1 * (task->besteffort == 0);
+		*ret = -1 * (task->besteffort == 0);
 		GDKfree(err);
 		/* replace it with a nil */
 		adt = fmt->nildata;
 		fmt->c->T->nonil = 0;
 	}
+	return adt;
+}
+
+static inline int
+SQLinsert_val(READERtask *task, int col, int idx)
+{
+	Column *fmt = task->as->format + col;
+	const void *adt;
+	ptr key = 0;
+	char *err = NULL;
+	int ret = 0;
+
+	adt = SQLconvert_val(task, col, idx, &ret);
 	/* key may be NULL but that's not a problem, as long as we have void */
 	bunfastins(fmt->c, key, adt);
 	return ret;
@@ -935,6 +1113,242 @@ SQLinsert_val(READERtask *task, int col, int idx)
 	return -1;
 }
 
+/*
+ * Columns of the common fixed size types are converted in bulk: a
+ * type specific loop parses the values of all lines in the buffer
+ * straight into the tail of the BAT, without going through frstr and
+ * bunfastins for every value.  The loops only recognize the plain
+ * notation of values ([+-]digits[.digits] for numbers); anything else,
+ * including erroneous values, is handed to SQLconvert_val, so the
+ * outcome is the same as that of SQLinsert_val.
+ */
+static inline int
+tablet_parse_lng(const char *s, lng *v)
+{
+	lng r = 0;
+	int neg = 0, n = 0;
+
+	if (*s == '-') {
+		neg = 1;
+		s++;
+	} else if (*s == '+')
+		s++;
+	for (; *s >= '0' && *s <= '9'; s++) {
+		/* no overflow with 18 digits */
+		if (++n > 18)
+			return 0;
+		r = 10 * r + (*s - '0');
+	}
+	if (n == 0 || *s)
+		return 0;
+	*v = neg ? -r : r;
+	return 1;
+}
+
+/* decimal with at most digits-scale digits before and at most scale
+ * digits after the point, as dec_frstr in SQL accepts them */
+static inline int
+tablet_parse_dec(const char *s, int digits, int scale, lng *v)
+{
+	lng r = 0;
+	int neg = 0, n = 0, i = 0, seen = 0;
+
+	if (*s == '-') {
+		neg = 1;
+		s++;
+	} else if (*s == '+')
+		s++;
+	for (; *s == '0'; s++)
+		seen = 1;
+	for (; *s >= '0' && *s <= '9'; s++) {
+		if (++n > digits - scale)
+			return 0;
+		r = 10 * r + (*s - '0');
+	}
+	if (*s == '.') {
+		for (s++; *s >= '0' && *s <= '9'; s++) {
+			if (++i > scale)
+				return 0;
+			r = 10 * r + (*s - '0');
+		}
+	}
+	if (*s || (!seen && n == 0 && i == 0))
+		return 0;
+	for (; i < scale; i++)
+		r *= 10;
+	*v = neg ? -r : r;
+	return 1;
+}
+
+/* powers of ten that are exact doubles */
+static const dbl tablet_pow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/* With at most 15 significant digits both the digits and the power of
+ * ten are exact doubles, so a single, correctly rounded, division
+ * gives the same result as strtod. */
+static inline int
+tablet_parse_dbl(const char *s, dbl *v)
+{
+	lng m = 0;
+	int neg = 0, n = 0, frac = 0, seen = 0;
+	dbl d;
+
+	if (*s == '-') {
+		neg = 1;
+		s++;
+	} else if (*s == '+')
+		s++;
+	for (; *s == '0'; s++)
+		seen = 1;
+	for (; *s >= '0' && *s <= '9'; s++) {
+		if (++n > 15)
+			return 0;
+		m = 10 * m + (*s - '0');
+	}
+	if (*s == '.') {
+		for (s++; *s >= '0' && *s <= '9'; s++) {
+			if (n > 0 || *s != '0')
+				n++;
+			if (n > 15 || ++frac >= (int) (sizeof(tablet_pow10) / sizeof(tablet_pow10[0])))
+				return 0;
+			m = 10 * m + (*s - '0');
+			seen = 1;
+		}
+	}
+	if (*s || (!seen && n == 0))
+		return 0;
+	d = (dbl) m / tablet_pow10[frac];
+	*v = neg ? -d : d;
+	return 1;
+}
+
+/* the atom parsers are called directly, only values they read
+ * completely and that are not nil are taken */
+static inline int
+tablet_parse_flt(const char *s, flt *v)
+{
+	int len = (int) sizeof(flt);
+	int n = fltFromStr(s, &len, &v);
+
+	return n > 0 && s[n] == 0 && *v != flt_nil;
+}
+
+static inline int
+tablet_parse_date(const char *s, date *v)
+{
+	int len = (int) sizeof(date);
+	int n = date_fromstr(s, &len, &v);
+
+	return n > 0 && s[n] == 0 && *v != date_nil;
+}
+
+static inline int
+tablet_parse_timestamp(const char *s, timestamp *v)
+{
+	int len = (int) sizeof(timestamp);
+	int n = timestamp_fromstr(s, &len, &v);
+
+	return n > 0 && s[n] == 0 && !ts_isnil(*v);
+}
+
+#define BULKPARSE(TYPE, PARSE)						\
+	do {								\
+		TYPE *dst = (TYPE *) Tloc(b, BUNlast(b));		\
+		for (i = 0; i < n; i++) {				\
+			const char *s = task->fields[col][i];		\
+									\
+			if (s == NULL) {				\
+				dst[i] = *(const TYPE *) fmt->nildata;	\
+				b->T->nonil = 0;			\
+			} else if (!(PARSE)) {				\
+				const void *adt = SQLconvert_val(task, col, i, &ret); \
+				dst[i] = *(const TYPE *) adt;		\
+				if (ret < 0) {				\
+					i++;				\
+					break;				\
+				}					\
+			}						\
+		}							\
+	} while (0)
+
+/* the smallest value of the type is its nil, so the smallest valid
+ * value is -max */
+#define BULKPARSEINT(TYPE)						\
+	BULKPARSE(TYPE, tablet_parse_lng(s, &v) &&			\
+		  v >= -GDK_##TYPE##_max && v <= GDK_##TYPE##_max &&	\
+		  (dst[i] = (TYPE) v, 1))
+
+#define BULKPARSEDEC(TYPE)						\
+	BULKPARSE(TYPE, tablet_parse_dec(s, fmt->precision, fmt->scale, &v) && \
+		  (dst[i] = (TYPE) v, 1))
+
+/* returns 1 if the column has no bulk parser, otherwise the result
+ * SQLworker_column would have */
+static int
+SQLbulk_column(READERtask *task, int col)
+{
+	Column *fmt = task->as->format + col;
+	BAT *b = fmt->c;
+	int i, n = task->top[task->cur], ret = 0;
+	lng v;
+
+	if (fmt->bulk == TABLET_BULK_NONE || b->T->varsized)
+		return 1;
+	assert(BATcapacity(b) >= BATcount(b) + n);
+	if (fmt->bulk == TABLET_BULK_DEC) {
+		if (fmt->precision > 18 || fmt->scale > fmt->precision)
+			return 1;
+		switch (fmt->adt) {
+		case TYPE_bte:
+			BULKPARSEDEC(bte);
+			break;
+		case TYPE_sht:
+			BULKPARSEDEC(sht);
+			break;
+		case TYPE_int:
+			BULKPARSEDEC(int);
+			break;
+		case TYPE_lng:
+			BULKPARSEDEC(lng);
+			break;
+		default:
+			return 1;
+		}
+	} else if (fmt->adt == TYPE_date) {
+		BULKPARSE(date, tablet_parse_date(s, &dst[i]));
+	} else if (fmt->adt == TYPE_timestamp) {
+		BULKPARSE(timestamp, tablet_parse_timestamp(s, &dst[i]));
+	} else {
+		switch (fmt->adt) {
+		case TYPE_bte:
+			BULKPARSEINT(bte);
+			break;
+		case TYPE_sht:
+			BULKPARSEINT(sht);
+			break;
+		case TYPE_int:
+			BULKPARSEINT(int);
+			break;
+		case TYPE_lng:
+			BULKPARSEINT(lng);
+			break;
+		case TYPE_flt:
+			BULKPARSE(flt, tablet_parse_flt(s, &dst[i]));
+			break;
+		case TYPE_dbl:
+			BULKPARSE(dbl, tablet_parse_dbl(s, &dst[i]));
+			break;
+		default:
+			return 1;
+		}
+	}
+	BATsetcount(b, BATcount(b) + i);
+	return ret < 0 ? -1 : 0;
+}
+
 static int
 SQLworker_column(READERtask *task, int col)
 {
@@ -952,8 +1366,13 @@ SQLworker_column(READERtask *task, int col)
 	}
 	MT_lock_unset(&mal_copyLock, "tablet insert value");
 
+	if (fmt[col].skip)
+		return 0;
+	if ((i = SQLbulk_column(task, col)) <= 0)
+		return i;
+
 	for (i = 0; i < task->top[task->cur]; i++) {
-		if (!fmt[col].skip && SQLinsert_val(task, col, i) < 0){
+		if (SQLinsert_val(task, col, i) < 0){
 			if(task->besteffort == 0)
 				return -1;
 		}
@@ -1085,8 +1504,9 @@ SQLload_parse_line(READERtask *task, int idx)
 		}
 	}
 endofline:
-	/* check for too many values as well*/
-	if (*line && i == as->nr_attrs) {
+	/* check for too many values as well (line is NULL if a quote
+	 * was missing) */
+	if (line && *line && i == as->nr_attrs) {
 		errline = SQLload_error(task, idx, task->as->nr_attrs);
 		snprintf(errmsg, BUFSIZ, "Leftover data '%s'",line);
 		tablet_error(task, idx, (int) i, errmsg, errline);
@@ -1223,6 +1643,176 @@ SQLworkdivider(READERtask *task, READERtask *ptask, int nr_attrs, int threads)
 		task->time[i] = 0;
 }
 
+/*
+ * Finding the record boundaries is the one part of the load that is
+ * inherently sequential: whether a record separator counts depends on
+ * whether it is inside a quoted field, and that depends on everything
+ * before it.  For large buffers the splitters each take a chunk and
+ * scan it speculatively, once assuming it starts outside and once
+ * assuming it starts inside a quoted field, remembering the separators
+ * found and the state in which they leave the chunk.  A cheap
+ * sequential pass then chains the chunks, picking for each chunk the
+ * scan that matches the state in which the previous chunk was left.
+ * The rare chunk that has to be entered at another position (e.g. the
+ * previous one ended halfway an escape) is rescanned sequentially.
+ * Anything unexpected, like a NUL byte in the input, makes us fall
+ * back to the sequential splitter.
+ */
+#define SPLITCHUNK	(256 * 1024)	/* minimal chunk per splitter */
+
+typedef struct {
+	char **seps;				/* separators found */
+	size_t nseps, maxseps;
+	char *exit;					/* where the scan left the chunk */
+	char q;						/* quote state at exit */
+	int failed;
+} SPLITscan;
+
+typedef struct {
+	char *start, *end;			/* chunk to scan */
+	const char *rsep;
+	size_t rseplen;
+	char quote;
+	int speculate;				/* also scan as if inside quotes */
+	SPLITscan scan[2];			/* starting outside/inside quotes */
+} SPLITtask;
+
+static void
+tablet_split_scan(SPLITtask *t, SPLITscan *sc, char *p, char q)
+{
+	const char *rsep = t->rsep;
+	size_t rseplen = t->rseplen;
+	char quote = t->quote;
+
+	sc->nseps = 0;
+	sc->failed = 0;
+	while (p < t->end) {
+		if (*p == 0) {
+			sc->failed = 1;
+			break;
+		}
+		if (q && *p == q) {
+			q = 0;
+		} else if (*p == quote) {
+			q = quote;
+		} else if (*p == '\\') {
+			if (*++p == 0)
+				break;
+		} else if (!q && *p == *rsep &&
+				   (rseplen == 1 || strncmp(p, rsep, rseplen) == 0)) {
+			if (sc->nseps == sc->maxseps) {
+				size_t n = sc->maxseps ? 2 * sc->maxseps : 1024;
+				char **seps = GDKrealloc(sc->seps, n * sizeof(char *));
+
+				if (seps == NULL) {
+					sc->failed = 1;
+					break;
+				}
+				sc->seps = seps;
+				sc->maxseps = n;
+			}
+			sc->seps[sc->nseps++] = p;
+			p += rseplen;
+			continue;
+		}
+		p++;
+	}
+	sc->exit = p;
+	sc->q = q;
+}
+
+static void
+tablet_split_chunk(void *arg)
+{
+	SPLITtask *t = (SPLITtask *) arg;
+
+	tablet_split_scan(t, &t->scan[0], t->start, 0);
+	if (t->speculate)
+		tablet_split_scan(t, &t->scan[1], t->start, t->quote);
+}
+
+/* Collect the record separators in [s, end) in task->seps using
+ * several threads.  task->nseps is left 0 if the buffer should be
+ * split sequentially instead. */
+static void
+tablet_split_parallel(READERtask *task, char *s, char *end)
+{
+	SPLITtask t[MAXWORKERS];
+	MT_Id tids[MAXWORKERS];
+	int n = task->splitters, i, j, ok = 1;
+	size_t chunk;
+	char *p, q;
+
+	task->nseps = 0;
+	if (n > (end - s) / SPLITCHUNK)
+		n = (int) ((end - s) / SPLITCHUNK);
+	if (n <= 1)
+		return;
+	chunk = (end - s) / n;
+	memset(t, 0, sizeof(t));
+	for (i = 0; i < n; i++) {
+		t[i].start = s + i * chunk;
+		t[i].end = i == n - 1 ? end : s + (i + 1) * chunk;
+		t[i].rsep = task->rsep;
+		t[i].rseplen = task->rseplen;
+		t[i].quote = task->quote;
+		t[i].speculate = task->quote && i > 0;
+	}
+	for (i = 1; i < n; i++) {
+		if (MT_create_thread(&tids[i], tablet_split_chunk, &t[i], MT_THR_JOINABLE) < 0) {
+			/* do the remaining chunks ourselves */
+			for (j = i; j < n; j++)
+				tablet_split_chunk(&t[j]);
+			break;
+		}
+	}
+	tablet_split_chunk(&t[0]);
+	for (j = 1; j < i; j++)
+		MT_join_thread(tids[j]);
+
+	/* chain the speculative scans */
+	p = s;
+	q = 0;
+	for (i = 0; i < n && ok; i++) {
+		SPLITscan *sc;
+
+		if (p == t[i].start) {
+			sc = &t[i].scan[q != 0];
+		} else {
+			/* entered at an unexpected position, redo it */
+			sc = &t[i].scan[0];
+			tablet_split_scan(&t[i], sc, p, q);
+		}
+		if (sc->failed) {
+			ok = 0;
+			break;
+		}
+		if (task->nseps + sc->nseps > task->maxseps) {
+			size_t m = task->nseps + sc->nseps + 1024;
+			char **seps = GDKrealloc(task->seps, m * sizeof(char *));
+
+			if (seps == NULL) {
+				ok = 0;
+				break;
+			}
+			task->seps = seps;
+			task->maxseps = m;
+		}
+		memcpy(task->seps + task->nseps, sc->seps, sc->nseps * sizeof(char *));
+		task->nseps += sc->nseps;
+		p = sc->exit;
+		q = sc->q;
+	}
+	for (i = 0; i < n; i++) {
+		if (t[i].scan[0].seps)
+			GDKfree(t[i].scan[0].seps);
+		if (t[i].scan[1].seps)
+			GDKfree(t[i].scan[1].seps);
+	}
+	if (!ok)
+		task->nseps = 0;
+}
+
 /*
  * Reading is handled by a separate task as a preparation for more parallelism.
  * A buffer is filled with proper lines.
@@ -1243,7 +1833,7 @@ SQLproducer(void *p)
 	BUN cnt = 0, bufcnt[MAXBUFFERS] = { 0 };
 	char *end, *e, *s, *base;
 	const char *rsep = task->rsep;
-	size_t rseplen = strlen(rsep), partial = 0;
+	size_t rseplen = strlen(rsep), partial = 0, nsep;
 	char quote = task->quote;
 	Thread thr;
 
@@ -1330,6 +1920,8 @@ SQLproducer(void *p)
 		 * scan ended (we need to back off some since we could be in
 		 * the middle of the record separator).  If this is too
 		 * costly, we have to rethink the matter. */
+		tablet_split_parallel(task, s, end);
+		nsep = 0;
 		for (e = s; *e && e < end && cnt < task->maxrow;) {
 			/* tokenize the record completely the format of the input
 			 * should comply to the following grammar rule [
@@ -1339,7 +1931,10 @@ SQLproducer(void *p)
 			 * user should supply the correct number of fields.
 			 * In the first phase we simply break the lines at the
 			 * record boundary. */
-			if (quote == 0) {
+			if (nsep < task->nseps) {
+				/* already found by the parallel splitter */
+				e = task->seps[nsep++];
+			} else if (quote == 0) {
 				switch (rseplen) {
 				case 1:
 					for (; *e; e++) {
@@ -1598,7 +2193,7 @@ SQLload_file(Client cntxt, Tablet *as, bstream *b, stream *out, char *csep, char
 	BUN i, attr;
 	READERtask *task = (READERtask *) GDKzalloc(sizeof(READERtask));
 	READERtask ptask[MAXWORKERS];
-	int threads = (!maxrow || maxrow > (1 << 16)) ? (GDKnr_threads < MAXWORKERS && GDKnr_threads > 1 ? GDKnr_threads - 1 : MAXWORKERS - 1) : 1;
+	int threads = (maxrow < 0 || maxrow > (1 << 16)) ? (GDKnr_threads < MAXWORKERS && GDKnr_threads > 1 ? GDKnr_threads - 1 : MAXWORKERS - 1) : 1;
 	lng lio = 0, tio, t1 = 0, total = 0, iototal = 0;
 	int vmtrim = GDK_vm_trim;
 
@@ -1707,6 +2302,9 @@ SQLload_file(Client cntxt, Tablet *as, bstream *b, stream *out, char *csep, char
 	}
 	task->rowerror = (bte *) GDKzalloc(sizeof(bte) * task->limit);
 
+	/* record boundaries are searched for by as many threads as
+	 * there are cores, independent of the number of columns */
+	task->splitters = (maxrow < 0 || maxrow > (1 << 16)) && GDKnr_threads > 1 ? (GDKnr_threads < MAXWORKERS ? GDKnr_threads : MAXWORKERS) : 1;
 	MT_create_thread(&task->tid, SQLproducer, (void *) task, MT_THR_JOINABLE);
 #ifdef _DEBUG_TABLET_
 	mnstr_printf(GDKout, "#parallel bulk load " LLFMT " - " BUNFMT "\n",
@@ -1965,6 +2563,8 @@ SQLload_file(Client cntxt, Tablet *as, bstream *b, stream *out, char *csep, char
 	}
 	if (task->rowerror)
 		GDKfree(task->rowerror);
+	if (task->seps)
+		GDKfree(task->seps);
 	MT_sema_destroy(&task->producer);
 	MT_sema_destroy(&task->consumer);
 	GDKfree(task);
@@ -65,8 +65,17 @@ typedef struct Column_t {
 	char quote;					/* if set use this character for string quotes */
 	const void *nildata;
 	int size;
+	int bulk;					/* values may be parsed in bulk, see below */
 } Column;
 
+/* Column.bulk tells SQLload_file that frstr parses the values the way
+ * the type specific bulk parsers do: TABLET_BULK_ATOM for the atom's
+ * own parser, TABLET_BULK_DEC for decimals with the given precision
+ * and scale. */
+#define TABLET_BULK_NONE	0
+#define TABLET_BULK_ATOM	1
+#define TABLET_BULK_DEC	2
+
 /*
  * All table printing is based on building a report structure first.
  * This table structure is private to a client, which made us to
@@ -0,0 +1,185 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2008-2015 MonetDB B.V.
+ */
+
+/*
+ * Queries with many aggregates over the same grouping end up with a
+ * series of aggr.subsum, aggr.subcount, aggr.submin and aggr.submax
+ * calls that each scan the group ids again.  This optimizer collapses
+ * the ones that share their groups, extents and candidate list into a
+ * single aggr.subaggr call, which updates all aggregates in one pass.
+ *
+ * Only sums with a constant true abort_on_error (the SQL default) and
+ * the versions of min and max that return values are considered.  The
+ * fused call replaces the last aggregate of a group, so the results
+ * of the others may not be used before that point.  The optimizer
+ * should run after mergetable, which only knows about the individual
+ * aggregates.
+ */
+#include "monetdb_config.h"
+#include "opt_aggrfuse.h"
+#include "mal_builder.h"
+
+/* return the name of the aggregate if p can be fused, NULL otherwise;
+ * *cand is set if p has a candidate list */
+static const char *
+fusableAggr(MalBlkPtr mb, InstrPtr p, int *cand)
+{
+	const char *aggr;
+	int n = 1;		/* skip_nils */
+
+	if (getModuleId(p) != aggrRef || p->retc != 1 || p->barrier)
+		return NULL;
+	if (getFunctionId(p) == subsumRef) {
+		aggr = "sum";
+		n = 2;		/* skip_nils, abort_on_error */
+	} else if (getFunctionId(p) == subcountRef) {
+		aggr = "count";
+	} else if (getFunctionId(p) == subminRef ||
+			   getFunctionId(p) == submaxRef) {
+		/* not the versions returning positions */
+		if (getColumnType(getArgType(mb, p, 0)) == TYPE_oid)
+			return NULL;
+		aggr = getFunctionId(p) == subminRef ? "min" : "max";
+	} else
+		return NULL;
+	/* r := aggr.sub<aggr>(b, g, e, [s,] ...) */
+	if (p->argc == 4 + n)
+		*cand = 0;
+	else if (p->argc == 5 + n)
+		*cand = 1;
+	else
+		return NULL;
+	if (n == 2 &&
+		(!isVarConstant(mb, getArg(p, p->argc - 1)) ||
+		 getArgType(mb, p, p->argc - 1) != TYPE_bit ||
+		 getVarConstant(mb, getArg(p, p->argc - 1)).val.btval != 1))
+		return NULL;
+	return aggr;
+}
+
+int
+OPTaggrfuseImplementation(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	int i, j, k, limit, slimit, cand, jcand, blk = 0, actions = 0;
+	int *leader = NULL, *block = NULL, *firstuse = NULL;
+	const char **aggr = NULL;
+	InstrPtr p, q, *old;
+	Lifespan span;
+
+	(void) stk;
+	(void) pci;
+
+	limit = mb->stop;
+	span = setLifespan(mb);
+	leader = (int *) GDKzalloc(limit * sizeof(int));
+	block = (int *) GDKzalloc(limit * sizeof(int));
+	aggr = (const char **) GDKzalloc(limit * sizeof(const char *));
+	firstuse = (int *) GDKzalloc(mb->vtop * sizeof(int));
+	if (span == NULL || leader == NULL || block == NULL || aggr == NULL || firstuse == NULL)
+		goto wrapup;
+
+	/* find the candidates and the first use of each variable */
+	for (k = 0; k < mb->vtop; k++)
+		firstuse[k] = limit;
+	for (i = 0; i < limit; i++) {
+		p = getInstrPtr(mb, i);
+		if (p->barrier)
+			blk++;
+		block[i] = blk;
+		leader[i] = -1;
+		for (k = p->retc; k < p->argc; k++)
+			if (firstuse[getArg(p, k)] > i)
+				firstuse[getArg(p, k)] = i;
+		aggr[i] = fusableAggr(mb, p, &cand);
+	}
+
+	/* form the groups, working backward from the aggregate that
+	 * will be replaced by the fused call */
+	for (i = limit - 1; i >= 0; i--) {
+		if (aggr[i] == NULL || leader[i] >= 0)
+			continue;
+		p = getInstrPtr(mb, i);
+		(void) fusableAggr(mb, p, &cand);
+		if (getLastUpdate(span, getArg(p, 2)) > i ||
+			getLastUpdate(span, getArg(p, 3)) > i ||
+			(cand && getLastUpdate(span, getArg(p, 4)) > i))
+			continue;
+		for (j = i - 1; j >= 0 && block[j] == block[i]; j--) {
+			q = getInstrPtr(mb, j);
+			if (aggr[j] == NULL || leader[j] >= 0)
+				continue;
+			(void) fusableAggr(mb, q, &jcand);
+			if (jcand != cand ||
+				getArg(q, 2) != getArg(p, 2) ||
+				getArg(q, 3) != getArg(p, 3) ||
+				(cand && getArg(q, 4) != getArg(p, 4)))
+				continue;
+			/* the result is needed before the fused call, or
+			 * the arguments change before it */
+			if (firstuse[getArg(q, 0)] <= i ||
+				getLastUpdate(span, getArg(q, 0)) != j ||
+				getLastUpdate(span, getArg(q, 1)) > j ||
+				getLastUpdate(span, getArg(q, 4 + cand)) > j)
+				continue;
+			leader[j] = i;
+			leader[i] = i;
+		}
+	}
+
+	old = mb->stmt;
+	slimit = mb->ssize;
+	if (newMalBlkStmt(mb, mb->ssize) < 0)
+		goto wrapup;
+	for (i = 0; i < limit; i++) {
+		p = old[i];
+		if (leader[i] < 0) {
+			pushInstruction(mb, p);
+			continue;
+		}
+		if (leader[i] != i)
+			continue;	/* moved into the fused call */
+		(void) fusableAggr(mb, p, &cand);
+		q = newInstruction(mb, ASSIGNsymbol);
+		setModuleId(q, aggrRef);
+		setFunctionId(q, subaggrRef);
+		for (j = 0; j <= i; j++)
+			if (leader[j] == i)
+				q = pushReturn(mb, q, getArg(old[j], 0));
+		q = pushArgument(mb, q, getArg(p, 2));
+		q = pushArgument(mb, q, getArg(p, 3));
+		if (cand)
+			q = pushArgument(mb, q, getArg(p, 4));
+		q = pushBit(mb, q, TRUE);
+		for (j = 0; j <= i; j++) {
+			if (leader[j] != i)
+				continue;
+			q = pushStr(mb, q, aggr[j]);
+			q = pushArgument(mb, q, getArg(old[j], 1));
+			q = pushArgument(mb, q, getArg(old[j], 4 + cand));
+			actions++;
+		}
+		pushInstruction(mb, q);
+		OPTDEBUGaggrfuse
+			printInstruction(cntxt->fdout, mb, 0, q, LIST_MAL_ALL);
+		for (j = 0; j <= i; j++)
+			if (leader[j] == i)
+				freeInstruction(old[j]);
+	}
+	for (; i < slimit; i++)
+		if (old[i])
+			freeInstruction(old[i]);
+	GDKfree(old);
+
+  wrapup:
+	GDKfree(span);
+	GDKfree(leader);
+	GDKfree(block);
+	GDKfree(aggr);
+	GDKfree(firstuse);
+	return actions;
+}
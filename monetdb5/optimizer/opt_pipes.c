@@ -78,6 +78,7 @@ static struct PIPELINES {
 	 "optimizer.deadcode();"
 	 "optimizer.reduce();"
 	 "optimizer.matpack();"
+	 "optimizer.aggrfuse();"
 	 "optimizer.dataflow();"
 	 "optimizer.querylog();"
 	 "optimizer.multiplex();"
@@ -110,6 +111,7 @@ static struct PIPELINES {
 	 "optimizer.deadcode();"
 	 "optimizer.reduce();"
 	 "optimizer.matpack();"
+	 "optimizer.aggrfuse();"
 	 "optimizer.dataflow();"
 	 "optimizer.querylog();"
 	 "optimizer.multiplex();"
@@ -142,6 +144,7 @@ static struct PIPELINES {
 	 "optimizer.deadcode();"
 	 "optimizer.reduce();"
 	 "optimizer.matpack();"
+	 "optimizer.aggrfuse();"
 	 "optimizer.querylog();"
 	 "optimizer.multiplex();"
 	 "optimizer.generator();"
@@ -168,6 +171,7 @@ static struct PIPELINES {
 	 "optimizer.deadcode();"
 	 "optimizer.reduce();"
 	 "optimizer.matpack();"
+	 "optimizer.aggrfuse();"
 	 "optimizer.dataflow();"
 	 "optimizer.recycler();"
 	 "optimizer.querylog();"
@@ -221,6 +221,7 @@ str stopRef;
 str strRef;
 str sumRef;
 str subsumRef;
+str subaggrRef;
 str subavgRef;
 str subsortRef;
 str takeRef;
@@ -477,6 +478,7 @@ void optimizerInit(void)
 	strRef = putName("str",3);
 	sumRef = putName("sum",3);
 	subsumRef = putName("subsum",6);
+	subaggrRef = putName("subaggr",7);
 	subavgRef = putName("subavg",6);
 	subsortRef = putName("subsort",7);
 	takeRef= putName("take",5);
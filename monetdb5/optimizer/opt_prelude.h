@@ -220,6 +220,7 @@ opt_export  str stopRef;
 opt_export  str strRef;
 opt_export  str sumRef;
 opt_export  str subsumRef;
+opt_export  str subaggrRef;
 opt_export  str subavgRef;
 opt_export  str subsortRef;
 opt_export  str timestampRef;
@@ -130,6 +130,7 @@ struct OPTcatalog {
 	int debug;
 } optcatalog[]= {
 {"accumulators",0,	0,	0,	DEBUG_OPT_ACCUMULATORS},
+{"aggrfuse",	0,	0,	0,	DEBUG_OPT_AGGRFUSE},
 {"aliases",		0,	0,	0,	DEBUG_OPT_ALIASES},
 {"coercions",	0,	0,	0,	DEBUG_OPT_COERCION},
 {"commonTerms",	0,	0,	0,	DEBUG_OPT_COMMONTERMS},
@@ -27,6 +27,7 @@
  * The optimizer used so far
 */
 #include "opt_accumulators.h"
+#include "opt_aggrfuse.h"
 #include "opt_aliases.h"
 #include "opt_coercion.h"
 #include "opt_commonTerms.h"
@@ -60,6 +61,7 @@ struct{
 	int (*fcn)();
 } codes[] = {
 	{"accumulators", &OPTaccumulatorsImplementation},
+	{"aggrfuse", &OPTaggrfuseImplementation},
 	{"aliases", &OPTaliasesImplementation},
 	{"coercions", &OPTcoercionImplementation},
 	{"commonTerms", &OPTcommonTermsImplementation},
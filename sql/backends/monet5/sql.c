@@ -151,10 +151,11 @@ sqlcleanup(mvc *c, int err)
 	if ((c->emod & mod_locked) == mod_locked) {
 		/* here we should commit the transaction */
 		if (!err) {
+			/* the loaded bats are written to disk as part of
+			 * the commit, no need for a checkpoint */
 			sql_trans_commit(c->session->tr);
-			/* write changes to disk */
+			store_flush_log(c->session->tr->tend);
 			sql_trans_end(c->session);
-			store_apply_deltas();
 			sql_trans_begin(c->session);
 		}
 		store_unlock();
@@ -3304,11 +3305,82 @@ mvc_import_table_wrap(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 	return msg;
 }
 
+/* Load a column of strings from a file.  The file either holds the
+ * values back to back, each terminated by a NUL byte (i.e. the string
+ * heap, the offsets being implied), or, if it contains no NUL byte at
+ * all, one value per line.  The file is mapped copy-on-write and every
+ * value is copied once, straight from the map into the string heap of
+ * the new BAT; no line buffer is involved, so there is no limit on the
+ * length of the values.
+ */
+static str
+mvc_bin_import_str(BAT **ret, const char *fname)
+{
+	struct stat st;
+	char *base, *s, *e, *end, *last = NULL;
+	char sep;
+	size_t size;
+	BUN cnt = 0;
+	BAT *c;
+
+	if (stat(fname, &st) < 0)
+		throw(SQL, "sql", "Failed to re-open file %s", fname);
+	size = (size_t) st.st_size;
+	if (size == 0) {
+		if ((c = BATnew(TYPE_void, TYPE_str, 0, PERSISTENT)) == NULL)
+			throw(SQL, "sql", MAL_MALLOC_FAIL);
+		BATseqbase(c, 0);
+		*ret = c;
+		return MAL_SUCCEED;
+	}
+	base = MT_mmap(fname, MMAP_COPY | MMAP_SEQUENTIAL, size);
+	if (base == NULL)
+		throw(SQL, "sql", "Failed to map file %s", fname);
+	end = base + size;
+	sep = memchr(base, 0, size) ? '\0' : '\n';
+	for (s = base; s < end && (e = memchr(s, sep, end - s)) != NULL; s = e + 1)
+		cnt++;
+	if (s < end)
+		cnt++;
+	if ((c = BATnew(TYPE_void, TYPE_str, cnt, PERSISTENT)) == NULL) {
+		MT_munmap(base, size);
+		throw(SQL, "sql", MAL_MALLOC_FAIL);
+	}
+	BATseqbase(c, 0);
+	for (s = base; s < end; s = e + 1) {
+		const char *v = s;
+
+		if ((e = memchr(s, sep, end - s)) == NULL) {
+			/* the last value is not terminated and we cannot
+			 * write past the end of the map */
+			if ((last = GDKmalloc(end - s + 1)) == NULL)
+				break;
+			memcpy(last, s, end - s);
+			last[end - s] = 0;
+			v = last;
+			e = end;
+		} else if (sep) {
+			*e = 0;
+		}
+		if (BUNappend(c, v, FALSE) != GDK_SUCCEED)
+			break;
+	}
+	MT_munmap(base, size);
+	if (last)
+		GDKfree(last);
+	if (BATcount(c) != cnt) {
+		BBPreclaim(c);
+		throw(SQL, "sql", "Failed to load file %s", fname);
+	}
+	*ret = c;
+	return MAL_SUCCEED;
+}
+
 /* str mvc_bin_import_table_wrap(.., str *sname, str *tname, str *fname..);
- * binary attachment only works for simple binary types.
- * Non-simple types require each line to contain a valid ascii representation
- * of the text terminate by a new-line. These strings are passed to the corresponding
- * atom conversion routines to fill the column.
+ * binary attachment only works for simple binary types.  The file of a
+ * fixed-size column holds the raw values and is adopted as the heap of
+ * the column, the properties (sorted, key, nil) being computed in the
+ * same go.  Strings are loaded by mvc_bin_import_str.
  */
 str
 mvc_bin_import_table_wrap(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
@@ -3323,8 +3395,6 @@ mvc_bin_import_table_wrap(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pc
 	sql_table *t;
 	node *n;
 	FILE *f;
-	char *buf;
-	int bufsiz = 128 * BLOCK;
 
 	if ((msg = getSQLContext(cntxt, mb, &m, NULL)) != NULL)
 		return msg;
@@ -3361,36 +3431,16 @@ mvc_bin_import_table_wrap(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pc
 			if (c == NULL)
 				throw(SQL, "sql", "Failed to attach file %s", *getArgReference_str(stk, pci, i));
 			BATsetaccess(c, BAT_READ);
-			BATderiveProps(c, 0);
 		} else if (tpe == TYPE_str) {
-			/* get the BAT and fill it with the strings */
-			c = BATnew(TYPE_void, TYPE_str, 0, PERSISTENT);
-			if (c == NULL)
-				throw(SQL, "sql", MAL_MALLOC_FAIL);
-			BATseqbase(c, 0);
-			/* this code should be extended to deal with larger text strings. */
-			f = fopen(*getArgReference_str(stk, pci, i), "r");
-			if (f == NULL)
-				throw(SQL, "sql", "Failed to re-open file %s", *getArgReference_str(stk, pci, i));
-
-			buf = GDKmalloc(bufsiz);
-			if (!buf) {
-				fclose(f);
-				throw(SQL, "sql", "Failed to create buffer");
-			}
-			while (fgets(buf, bufsiz, f) != NULL) {
-				char *t = strrchr(buf, '\n');
-				if (t)
-					*t = 0;
-				BUNappend(c, buf, FALSE);
-			}
-			fclose(f);
-			GDKfree(buf);
+			if ((msg = mvc_bin_import_str(&c, *getArgReference_str(stk, pci, i))) != MAL_SUCCEED)
+				return msg;
 		} else {
 			throw(SQL, "sql", "Failed to attach file %s", *getArgReference_str(stk, pci, i));
 		}
-		if (i != (pci->retc + 2) && cnt != BATcount(c))
+		if (i != (pci->retc + 2) && cnt != BATcount(c)) {
+			BBPreclaim(c);
 			throw(SQL, "sql", "binary files for table '%s' have inconsistent counts", tname);
+		}
 		cnt = BATcount(c);
 		*getArgReference_bat(stk, pci, i - (2 + pci->retc)) = c->batCacheid;
 		BBPkeepref(c->batCacheid);
@@ -4161,6 +4211,49 @@ sql_sessions_wrap(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 	return CLTsessions(cntxt, mb, stk, pci);
 }
 
+/*
+ * The progress of the incremental checkpoints of the store manager
+ * and the backlog of the write-ahead log, as a single row.
+ */
+str
+sql_checkpoint(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	checkpoint_status cs;
+	BAT *t[9];
+	int tpe[9] = {TYPE_bit, TYPE_int, TYPE_int, TYPE_lng, TYPE_lng, TYPE_lng, TYPE_lng, TYPE_lng, TYPE_lng};
+	bit active;
+	int i;
+
+	(void) cntxt;
+	(void) mb;
+	for (i = 0; i < 9; i++) {
+		if ((t[i] = BATnew(TYPE_void, tpe[i], 1, TRANSIENT)) == NULL) {
+			while (--i >= 0)
+				BBPunfix(t[i]->batCacheid);
+			throw(SQL, "sql.checkpoint", MAL_MALLOC_FAIL);
+		}
+		BATseqbase(t[i], 0);
+	}
+	store_checkpoint_status(&cs);
+	active = cs.active != 0;
+	BUNappend(t[0], &active, FALSE);
+	BUNappend(t[1], &cs.tables, FALSE);
+	BUNappend(t[2], &cs.ntables, FALSE);
+	BUNappend(t[3], &cs.changes, FALSE);
+	BUNappend(t[4], &cs.threshold, FALSE);
+	BUNappend(t[5], &cs.pending, FALSE);
+	BUNappend(t[6], &cs.checkpoints, FALSE);
+	BUNappend(t[7], &cs.postponed, FALSE);
+	BUNappend(t[8], &cs.duration, FALSE);
+	for (i = 0; i < 9; i++) {
+		bat id = t[i]->batCacheid;
+
+		*getArgReference_bat(stk, pci, i) = id;
+		BBPkeepref(id);
+	}
+	return MAL_SUCCEED;
+}
+
 str
 sql_querylog_catalog(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 {
@@ -833,12 +833,17 @@ mvc_import_table(Client cntxt, BAT ***bats, mvc *m, bstream *bs, sql_table *t, c
 			fmt[i].null_length = strlen(ns);
 			fmt[i].nildata = ATOMnilptr(fmt[i].adt);
 			fmt[i].skip = (col->base.name[0] == '%');
+			fmt[i].bulk = TABLET_BULK_ATOM;
 			if (col->type.type->eclass == EC_DEC) {
 				fmt[i].tostr = &dec_tostr;
 				fmt[i].frstr = &dec_frstr;
+				fmt[i].bulk = TABLET_BULK_DEC;
+				fmt[i].precision = col->type.digits;
+				fmt[i].scale = col->type.scale;
 			} else if (col->type.type->eclass == EC_SEC) {
 				fmt[i].tostr = &dec_tostr;
 				fmt[i].frstr = &sec_frstr;
+				fmt[i].bulk = TABLET_BULK_NONE;
 			}
 			fmt[i].size = ATOMsize(fmt[i].adt);
 
@@ -898,6 +903,8 @@ mvc_import_table(Client cntxt, BAT ***bats, mvc *m, bstream *bs, sql_table *t, c
 				if ( b == NULL)
 					sql_error(m, 500, "failed to bind to delta column");
 				else {
+					/* the commit logs the loaded bats by reference */
+					d->bulk = BATcount(b) > cnt;
 					d->ibase = (oid) (d->cnt = BATcount(b));
 					BBPunfix(b->batCacheid);
 				}
@@ -1440,6 +1447,271 @@ mvc_export_table(backend *b, stream *s, res_table *t, BAT *order, BUN offset, BU
 	return 0;
 }
 
+/*
+ * Binary result sets
+ * Clients that negotiated PROTOCOL_BINARY during the challenge receive
+ * the tuples of a result block column-wise instead of as tab-separated
+ * text.  After the header lines (or the &6 line of a block) the server
+ * sends the line "^ <rows>", followed by one block per column, all in
+ * server byte order:
+ *	int kind, width, scale;		layout of the column, see BIN_*
+ *	char nils[(rows + 7) / 8];	bit i set means row i is NULL
+ * followed by, for fixed width kinds:
+ *	char values[rows * width];
+ * or for BIN_STR:
+ *	lng offsets[rows], heapsize;	offsets into the heap
+ *	char heap[heapsize];		zero-terminated values
+ * Decimals are shipped as scaled integers, values of types without a
+ * fixed width binary layout are shipped as their textual rendering.
+ * Only aligned, dense result columns can be shipped this way, anything
+ * else falls back to the text format.
+ */
+#define BIN_INT		'i'	/* signed integer */
+#define BIN_DEC		'd'	/* scaled integer */
+#define BIN_FLT		'f'	/* IEEE float or double */
+#define BIN_BIT		'b'	/* boolean */
+#define BIN_STR		's'	/* string heap */
+
+static int
+bin_kind(res_col *c, BAT *b, int *width)
+{
+	int eclass = c->type.type->eclass;
+
+	*width = 0;
+	if (b->ttype == TYPE_void)
+		return BIN_STR;
+	switch (ATOMstorage(b->ttype)) {
+	case TYPE_bte:
+	case TYPE_sht:
+	case TYPE_int:
+	case TYPE_lng:
+		*width = ATOMsize(b->ttype);
+		if (b->ttype == TYPE_bit)
+			return BIN_BIT;
+		if (eclass == EC_NUM)
+			return BIN_INT;
+		if (eclass == EC_DEC)
+			return BIN_DEC;
+		break;
+	case TYPE_flt:
+	case TYPE_dbl:
+		*width = ATOMsize(b->ttype);
+		if (eclass == EC_FLT)
+			return BIN_FLT;
+		break;
+	}
+	*width = 0;
+	return BIN_STR;
+}
+
+/* render a single value the way mvc_export_table would */
+static int
+bin_tostr(mvc *m, res_col *c, int mtype, const void *p, char **buf, int *len)
+{
+	struct time_res ts_res;
+
+	switch (c->type.type->eclass) {
+	case EC_DEC:
+		return dec_tostr((void *) (ptrdiff_t) c->type.scale, buf, len, mtype, p);
+	case EC_SEC:
+		return dec_tostr((void *) (ptrdiff_t) 3, buf, len, mtype, p);
+	case EC_TIME:
+		ts_res.has_tz = (strcmp(c->type.type->sqlname, "timetz") == 0);
+		ts_res.fraction = c->type.digits ? c->type.digits - 1 : 0;
+		ts_res.timezone = m->timezone;
+		return sql_time_tostr((void *) &ts_res, buf, len, mtype, p);
+	case EC_TIMESTAMP:
+		ts_res.has_tz = (strcmp(c->type.type->sqlname, "timestamptz") == 0);
+		ts_res.fraction = c->type.digits ? c->type.digits - 1 : 0;
+		ts_res.timezone = m->timezone;
+		return sql_timestamp_tostr((void *) &ts_res, buf, len, mtype, p);
+	default:
+		return (*BATatoms[mtype].atomToStr) (buf, len, p);
+	}
+}
+
+#define BIN_NILS(TYPE)							\
+	do {								\
+		const TYPE *v = (const TYPE *) Tloc(b, BUNfirst(b) + offset); \
+		for (i = 0; i < nr; i++)				\
+			if (v[i] == TYPE##_nil)				\
+				nils[i >> 3] |= 1 << (i & 7);		\
+	} while (0)
+
+static int
+mvc_export_column_bin(mvc *m, stream *s, res_col *c, BAT *b, BUN offset, BUN nr)
+{
+	int kind, width, hdr[3];
+	unsigned char *nils;
+	BUN i;
+	int ok = 1;
+
+	kind = bin_kind(c, b, &width);
+	hdr[0] = kind;
+	hdr[1] = width;
+	hdr[2] = kind == BIN_DEC ? (int) c->type.scale : 0;
+	if (mnstr_write(s, hdr, sizeof(hdr), 1) != 1)
+		return -1;
+	nils = GDKzalloc((nr + 7) / 8 + 1);
+	if (nils == NULL)
+		return -1;
+
+	if (kind != BIN_STR) {
+		switch (ATOMstorage(b->ttype)) {
+		case TYPE_bte:
+			BIN_NILS(bte);
+			break;
+		case TYPE_sht:
+			BIN_NILS(sht);
+			break;
+		case TYPE_int:
+			BIN_NILS(int);
+			break;
+		case TYPE_lng:
+			BIN_NILS(lng);
+			break;
+		case TYPE_flt:
+			BIN_NILS(flt);
+			break;
+		case TYPE_dbl:
+			BIN_NILS(dbl);
+			break;
+		}
+		ok = (nr == 0 || mnstr_write(s, nils, (nr + 7) / 8, 1) == 1) &&
+			(nr == 0 || mnstr_write(s, Tloc(b, BUNfirst(b) + offset), nr * width, 1) == 1);
+	} else {
+		BATiter bi = bat_iterator(b);
+		int mtype = b->ttype == TYPE_void ? TYPE_oid : b->ttype;
+		const void *nil = ATOMnilptr(mtype);
+		lng *offsets = GDKmalloc((nr + 1) * sizeof(lng));
+		char *heap = NULL, *buf = NULL;
+		size_t heapsize = 0, heaplen = 0;
+		int len = 0;
+
+		if (offsets == NULL) {
+			GDKfree(nils);
+			return -1;
+		}
+		/* strings are shipped straight from the string heap,
+		 * everything else is rendered into a private heap first */
+		for (i = 0; i < nr; i++) {
+			const void *p = BUNtail(bi, BUNfirst(b) + offset + i);
+			size_t l = 0;
+
+			offsets[i] = (lng) heaplen;
+			if (ATOMcmp(mtype, nil, p) == 0) {
+				nils[i >> 3] |= 1 << (i & 7);
+				p = NULL;
+			}
+			if (mtype == TYPE_str) {
+				heaplen += (p ? strlen(p) : 0) + 1;
+				continue;
+			}
+			if (p) {
+				int r = bin_tostr(m, c, mtype, p, &buf, &len);
+
+				if (r < 0 || buf == NULL) {
+					ok = 0;
+					break;
+				}
+				l = (size_t) r;
+			}
+			if (heaplen + l + 1 > heapsize) {
+				char *h;
+
+				heapsize = heapsize ? 2 * heapsize : 1024;
+				while (heaplen + l + 1 > heapsize)
+					heapsize *= 2;
+				h = GDKrealloc(heap, heapsize);
+				if (h == NULL) {
+					ok = 0;
+					break;
+				}
+				heap = h;
+			}
+			if (l)
+				memcpy(heap + heaplen, buf, l);
+			heap[heaplen + l] = 0;
+			heaplen += l + 1;
+		}
+		offsets[nr] = (lng) heaplen;
+		if (ok)
+			ok = (nr == 0 || mnstr_write(s, nils, (nr + 7) / 8, 1) == 1) &&
+				mnstr_write(s, offsets, (nr + 1) * sizeof(lng), 1) == 1;
+		if (ok && mtype == TYPE_str) {
+			for (i = 0; ok && i < nr; i++) {
+				const char *p = BUNtail(bi, BUNfirst(b) + offset + i);
+
+				if (nils[i >> 3] & (1 << (i & 7)))
+					ok = mnstr_write(s, "", 1, 1) == 1;
+				else
+					ok = mnstr_write(s, p, strlen(p) + 1, 1) == 1;
+			}
+		} else if (ok && heaplen) {
+			ok = mnstr_write(s, heap, heaplen, 1) == 1;
+		}
+		if (buf)
+			GDKfree(buf);
+		if (heap)
+			GDKfree(heap);
+		GDKfree(offsets);
+	}
+	GDKfree(nils);
+	return ok ? 0 : -1;
+}
+
+/* check whether the result can be shipped in binary to this client;
+ * only the client's own connection negotiated the binary format, a
+ * result set written to a file (sql.resultSet) is always text */
+static int
+mvc_export_binary(backend *b, stream *s, res_table *t, BAT *order)
+{
+	int i;
+
+	if (b->client == NULL || !(b->client->protocol & PROTOCOL_BINARY) ||
+	    s != b->client->fdout ||
+	    b->output_format != OFMT_CSV || !BAThdense(order))
+		return 0;
+	for (i = 0; i < t->nr_cols; i++) {
+		res_col *c = t->cols + i;
+		BAT *bn;
+		int ok;
+
+		if (!c->b || (bn = BBPquickdesc(abs(c->b), FALSE)) == NULL)
+			return 0;
+		ok = BAThdense(bn) && bn->hseqbase == order->hseqbase &&
+			BATcount(bn) == BATcount(order);
+		if (!ok)
+			return 0;
+	}
+	return 1;
+}
+
+static int
+mvc_export_table_bin(backend *b, stream *s, res_table *t, BAT *order, BUN offset, BUN nr)
+{
+	int i, res = 0;
+
+	if (offset > BATcount(order))
+		offset = BATcount(order);
+	if (nr > BATcount(order) - offset)
+		nr = BATcount(order) - offset;
+	if (mnstr_printf(s, "^ " BUNFMT "\n", nr) < 0)
+		return -1;
+	for (i = 0; i < t->nr_cols && res == 0; i++) {
+		res_col *c = t->cols + i;
+		BAT *bn = BATdescriptor(c->b);
+
+		if (bn == NULL)
+			return -1;
+		res = mvc_export_column_bin(b->mvc, s, c, bn, offset, nr);
+		BBPunfix(bn->batCacheid);
+	}
+	if (mnstr_errnr(s))
+		return -1;
+	return res;
+}
+
 static int
 export_length(stream *s, int mtype, int eclass, int digits, int scale, int tz, bat bid, ptr p)
 {
@@ -1902,6 +2174,8 @@ mvc_export_result(backend *b, stream *s, int res_id)
 			res = mvc_export_table(b, s, t, order, 1, count - 2, "\t{\n\t\t\"%s\" : ", ",\n\t\t\"%s\" : ", "\n\t},\n", "\"", "null");
 			res = mvc_export_table(b, s, t, order, count - 1, 1, "\t{\n\t\t\"%s\" : ", ",\n\t\t\"%s\" : ", "\n\t}\n]\n", "\"", "null");
 		}
+	} else if (mvc_export_binary(b, s, t, order)) {
+		res = mvc_export_table_bin(b, s, t, order, 0, count);
 	} else {
 		res = mvc_export_table(b, s, t, order, 0, count, "[ ", ",\t", "\t]\n", "\"", "NULL");
 	}
@@ -1961,7 +2235,10 @@ mvc_export_chunk(backend *b, stream *s, int res_id, BUN offset, BUN nr)
 	if (mnstr_write(s, "\n", 1, 1) != 1)
 		return export_error(order);
 
-	res = mvc_export_table(b, s, t, order, offset, cnt, "[ ", ",\t", "\t]\n", "\"", "NULL");
+	if (mvc_export_binary(b, s, t, order))
+		res = mvc_export_table_bin(b, s, t, order, offset, cnt);
+	else
+		res = mvc_export_table(b, s, t, order, offset, cnt, "[ ", ",\t", "\t]\n", "\"", "NULL");
 	BBPunfix(order->batCacheid);
 	return res;
 }
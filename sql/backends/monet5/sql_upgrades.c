@@ -1615,6 +1615,37 @@ sql_update_jul2015(Client c)
 	return err;		/* usually MAL_SUCCEED */
 }
 
+static str
+sql_update_nov2015(Client c)
+{
+	size_t bufsize = 2048, pos = 0;
+	char *buf = GDKmalloc(bufsize), *err = NULL;
+	mvc *sql = ((backend*) c->sqlcontext)->mvc;
+	ValRecord *schvar = stack_get_var(sql, "current_schema");
+	char *schema = NULL;
+
+	if (schvar)
+		schema = strdup(schvar->val.sval);
+
+	pos += snprintf(buf + pos, bufsize - pos,
+			"set schema \"sys\";\n"
+			"create function sys.checkpoint() returns table(\"active\" bool, \"tables\" int, \"ntables\" int, \"changes\" bigint, \"threshold\" bigint, \"pending\" bigint, \"checkpoints\" bigint, \"postponed\" bigint, \"duration\" bigint) external name sql.checkpoint;\n"
+			"create view sys.checkpoint as select * from sys.checkpoint();\n"
+			"insert into sys.systemfunctions (select id from sys.functions where name = 'checkpoint' and schema_id = (select id from sys.schemas where name = 'sys') and id not in (select function_id from sys.systemfunctions));\n"
+			"update sys._tables set system = true where name = 'checkpoint' and schema_id = (select id from sys.schemas where name = 'sys');\n");
+
+	if (schema) {
+		pos += snprintf(buf + pos, bufsize - pos, "set schema \"%s\";\n", schema);
+		free(schema);
+	}
+	assert(pos < bufsize);
+
+	printf("Running database upgrade commands:\n%s\n", buf);
+	err = SQLstatementIntern(c, &buf, "update", 1, 0, NULL);
+	GDKfree(buf);
+	return err;		/* usually MAL_SUCCEED */
+}
+
 void
 SQLupgrades(Client c, mvc *m)
 {
@@ -1713,4 +1744,11 @@ SQLupgrades(Client c, mvc *m)
 			GDKfree(err);
 		}
 	}
+
+	if (!sql_bind_func(m->sa, mvc_bind_schema(m, "sys"), "checkpoint", NULL, NULL, F_UNION)) {
+		if ((err = sql_update_nov2015(c)) !=NULL) {
+			fprintf(stderr, "!%s\n", err);
+			GDKfree(err);
+		}
+	}
 }
@@ -202,6 +202,7 @@ typedef struct sql_trans {
 	int schema_number;	/* schema timestamp */
 	int schema_updates;	/* set on schema changes */
 	int status;		/* status of the last query */
+	lng tend;		/* log position of the commit, see store_flush_log */
 	list *dropped;  	/* protection against recursive cascade action*/
 
 	changeset schemas;
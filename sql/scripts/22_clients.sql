@@ -13,6 +13,12 @@ returns table("user" string, "login" timestamp, "sessiontimeout" bigint, "lastco
 external name sql.sessions;
 create view sys.sessions as select * from sys.sessions();
 
+-- progress of the incremental checkpoints and backlog of the log
+create function sys.checkpoint()
+returns table("active" bool, "tables" int, "ntables" int, "changes" bigint, "threshold" bigint, "pending" bigint, "checkpoints" bigint, "postponed" bigint, "duration" bigint)
+external name sql.checkpoint;
+create view sys.checkpoint as select * from sys.checkpoint();
+
 create procedure sys.shutdown(delay tinyint)
 external name sql.shutdown;
 
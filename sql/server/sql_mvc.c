@@ -185,6 +185,7 @@ mvc_commit(mvc *m, int chain, const char *name)
 {
 	sql_trans *cur, *tr = m->session->tr;
 	int ok = SQL_OK;//, wait = 0;
+	lng tend = 0;
 
 	assert(tr);
 	assert(m->session->active);	/* only commit an active transaction */
@@ -260,6 +261,7 @@ build up the hash (not copyied in the trans dup)) */
 			GDKfatal("%s", msg);
 			_DELETE(msg);
 		}
+		tend = tr->tend;
 	} else {
 		store_unlock();
 		(void)sql_error(m, 010, "40000!COMMIT: transaction is aborted because of concurrency conflicts, will ROLLBACK instead");
@@ -270,6 +272,12 @@ build up the hash (not copyied in the trans dup)) */
 	if (chain) 
 		sql_trans_begin(m->session);
 	store_unlock();
+	/* the commit is only done once its log is on disk */
+	if (store_flush_log(tend) != SQL_OK) {
+		char *msg = sql_message("40000!COMMIT: transation commit failed (perhaps your disk is full?) exiting (kernel error: %s)", GDKerrbuf);
+		GDKfatal("%s", msg);
+		_DELETE(msg);
+	}
 	m->type = Q_TRANS;
 	if (mvc_debug)
 		fprintf(stderr, "#mvc_commit %s done\n", (name) ? name : "");
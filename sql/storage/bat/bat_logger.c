@@ -215,9 +215,18 @@ bl_tstart(void)
 }
 
 static int 
-bl_tend(void)
+bl_tend(lng *tend)
 {
-	return log_tend(bat_logger);
+	int res = log_tend(bat_logger);
+
+	*tend = bat_logger->tends;
+	return res;
+}
+
+static int 
+bl_tflush(lng tend)
+{
+	return log_tflush(bat_logger, tend);
 }
 
 static int 
@@ -238,6 +247,7 @@ bat_logger_init( logger_functions *lf )
 	lf->log_isnew = bl_log_isnew;
 	lf->log_tstart = bl_tstart;
 	lf->log_tend = bl_tend;
+	lf->log_tflush = bl_tflush;
 	lf->log_sequence = bl_sequence;
 	return LOG_OK;
 }
@@ -494,6 +494,7 @@ delta_append_bat( sql_delta *bat, BAT *i )
 		bat->ibid = id;
 		temp_dup(id);
 		bat_destroy(b);
+		(void) BATzonemap(i);
 	} else {
 		if (!isEbat(b)){
 			assert(b->T->heap.storage != STORE_PRIV);
@@ -510,6 +511,9 @@ delta_append_bat( sql_delta *bat, BAT *i )
 		} else 
 			BATappend(b, i, TRUE);
 		assert(BUNlast(b) > b->batInserted);
+		/* keep the zone map of the inserts up to date, so
+		 * selections on large appends can skip zones */
+		(void) BATzonemap(b);
 		bat_destroy(b);
 	}
 	bat->cnt += BATcount(i);
@@ -1651,6 +1655,8 @@ gtr_update_delta( sql_trans *tr, sql_delta *cbat, int *changes)
 		(*changes)++;
 		assert(cur->T->heap.storage != STORE_PRIV);
 		BATappend(cur,ins,TRUE);
+		/* extend the zone map with the appended zones */
+		(void) BATzonemap(cur);
 		cbat->cnt = cbat->ibase = BATcount(cur);
 		BATcleanProps(cur);
 		temp_destroy(cbat->ibid);
@@ -1782,6 +1788,59 @@ gtr_update( sql_trans *tr )
 	return _gtr_update(tr, &gtr_update_table);
 }
 
+/* merge the deltas of a single table into its persistent bats, a step
+ * of an incremental checkpoint */
+static int
+gtr_update_one_table( sql_trans *tr, sql_table *t )
+{
+	int ok = LOG_OK, changes = 0;
+
+	if (!isTable(t) || !isGlobal(t) || isTempSchema(t->s))
+		return ok;
+	ok = gtr_update_table(tr, t, &changes);
+	if (changes) {
+		t->s->base.wtime = tr->wstime;
+		tr->wtime = tr->wstime;
+	}
+	return ok;
+}
+
+static size_t
+delta_pending(sql_delta *d)
+{
+	if (!d)
+		return 0;
+	return d->cnt - d->ibase + d->ucnt;
+}
+
+/* the number of inserts and updates of table t which are only in the
+ * write-ahead log, ie. not yet merged into the persistent bats */
+static size_t
+gtr_table_changes( sql_trans *tr, sql_table *t )
+{
+	size_t cnt = 0;
+	node *n;
+
+	(void)tr;
+	if (!isTable(t) || !isGlobal(t) || isTempSchema(t->s))
+		return 0;
+	for (n = t->columns.set->h; n; n = n->next) {
+		sql_column *c = n->data;
+
+		if (c->base.wtime)
+			cnt += delta_pending(c->data);
+	}
+	if (t->idxs.set) {
+		for (n = t->idxs.set->h; n; n = n->next) {
+			sql_idx *ci = n->data;
+
+			if (ci->base.wtime)
+				cnt += delta_pending(ci->data);
+		}
+	}
+	return cnt;
+}
+
 static int 
 gtr_minmax_col( sql_trans *tr, sql_column *c)
 {
@@ -1791,8 +1850,10 @@ gtr_minmax_col( sql_trans *tr, sql_column *c)
 	lng val;
 
 	(void)tr;
-	/* already set */
-	if (!cbat || c->type.type->localtype >= TYPE_str || c->t->system)
+	/* already set; inserts made before the table became read only
+	 * are only in the column after the next checkpoint */
+	if (!cbat || c->type.type->localtype > TYPE_str || c->t->system ||
+	    delta_pending(cbat))
 		return ok;
 
 	cur = temp_descriptor(cbat->bid);
@@ -1801,6 +1862,23 @@ gtr_minmax_col( sql_trans *tr, sql_column *c)
 		return ok;
 	}
 
+	/* the table is read only, so a compressed copy of the
+	 * column stays valid; failure just means it doesn't pay */
+	(void) BATcompress(cur);
+	if (cur->ttype == TYPE_str) {
+		str s;
+
+		if ((s = BATmin(cur, NULL)) != NULL) {
+			BATsetprop(cur, GDK_MIN_VALUE, TYPE_str, s);
+			GDKfree(s);
+		}
+		if ((s = BATmax(cur, NULL)) != NULL) {
+			BATsetprop(cur, GDK_MAX_VALUE, TYPE_str, s);
+			GDKfree(s);
+		}
+		bat_destroy(cur);
+		return ok;
+	}
 	BATmin(cur, &val);
 	BATsetprop(cur, GDK_MIN_VALUE, cur->ttype, &val);
 	BATmax(cur, &val);
@@ -1895,6 +1973,7 @@ tr_update_delta( sql_trans *tr, sql_delta *obat, sql_delta *cbat, int unique)
 			//assert((BATcount(cur) + BATcount(ins)) == (obat->cnt + (BUNlast(ins) - ins->batInserted)));
 			assert(!BATcount(ins) || !isEbat(ins));
 			BATappend(cur,ins,TRUE);
+			(void) BATzonemap(cur);
 			BATcleanProps(cur);
 			temp_destroy(cbat->bid);
 			temp_destroy(cbat->ibid);
@@ -2200,6 +2279,33 @@ tr_log_dbat(sql_trans *tr, sql_dbat *fdb, int cleared)
 	return ok;
 }
 
+/* A COPY INTO .. LOCKED appends directly to the main bat of the
+ * global transaction.  Instead of logging the new rows, the bat is
+ * written to disk at the end of the commit (log_tend subcommits it as
+ * a snapshot) and only a reference is logged.
+ */
+static int
+tr_log_bulk( sql_trans *tr, sql_delta *bat)
+{
+	int ok = LOG_OK;
+	BAT *b;
+
+	(void)tr;
+	assert(store_nr_active==1);
+	b = temp_descriptor(bat->bid);
+	if (b == NULL)
+		return LOG_ERR;
+	/* bats not yet known persistent by the logger get the new rows
+	 * logged the normal way */
+	if (b->batPersistence == PERSISTENT)
+		ok = log_bat_persists(bat_logger, b, bat->name);
+	else if (BUNlast(b) > b->batInserted)
+		ok = log_bat(bat_logger, b, bat->name);
+	bat_destroy(b);
+	bat->bulk = 0;
+	return ok;
+}
+
 static int
 log_table(sql_trans *tr, sql_table *ft)
 {
@@ -2212,6 +2318,11 @@ log_table(sql_trans *tr, sql_table *ft)
 	for (n = ft->columns.set->h; ok == LOG_OK && n; n = n->next) {
 		sql_column *cc = n->data;
 
+		if (cc->base.wtime && !cc->base.allocated && cc->data &&
+		    ((sql_delta *) cc->data)->bulk) {
+			ok = tr_log_bulk(tr, cc->data);
+			continue;
+		}
 		if (!cc->base.wtime || !cc->base.allocated) 
 			continue;
 		ok = tr_log_delta(tr, cc->data, ft->cleared);
@@ -2334,6 +2445,8 @@ bat_storage_init( store_functions *sf)
 	sf->snapshot_table = (update_table_fptr)&snapshot_table;
 	sf->gtrans_update = (gtrans_update_fptr)&gtr_update;
 	sf->gtrans_minmax = (gtrans_update_fptr)&gtr_minmax;
+	sf->gtrans_update_table = (gtrans_update_table_fptr)&gtr_update_one_table;
+	sf->gtrans_table_changes = (gtrans_table_changes_fptr)&gtr_table_changes;
 	return LOG_OK;
 }
 
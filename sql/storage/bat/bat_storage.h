@@ -22,6 +22,7 @@ typedef struct sql_delta {
 	size_t cnt;		/* number of tuples (excluding the deletes) */
 	size_t ucnt;		/* number of updates */
 	BAT *cached;		/* cached copy, used for schema bats only */
+	int bulk;		/* main bat was loaded in place (COPY .. LOCKED) */
 	int wtime;		/* time stamp */
 	struct sql_delta *next;	/* possibly older version of the same column/idx */
 } sql_delta;
@@ -177,6 +177,17 @@ typedef int (*update_table_fptr) (sql_trans *tr, sql_table *ft, sql_table *tt);
 */
 typedef int (*gtrans_update_fptr) (sql_trans *tr); 
 
+/*
+-- gtrans_update_table push the ibats and ubats of a single table
+-- returns LOG_OK, LOG_ERR
+*/
+typedef int (*gtrans_update_table_fptr) (sql_trans *tr, sql_table *t);
+
+/*
+-- gtrans_table_changes the number of changes of a table not yet pushed
+*/
+typedef size_t (*gtrans_table_changes_fptr) (sql_trans *tr, sql_table *t);
+
 /*
 -- handle inserts and updates of columns and indices
 -- returns LOG_OK, LOG_ERR
@@ -251,6 +262,8 @@ typedef struct store_functions {
 	update_table_fptr update_table;
 	gtrans_update_fptr gtrans_update;
 	gtrans_update_fptr gtrans_minmax;
+	gtrans_update_table_fptr gtrans_update_table;
+	gtrans_table_changes_fptr gtrans_table_changes;
 
 	col_ins_fptr col_ins;
 	col_upd_fptr col_upd;
@@ -274,7 +287,8 @@ typedef int (*logger_get_sequence_fptr) (int seq, lng *id);
 
 typedef int (*log_isnew_fptr)(void);
 typedef int (*log_tstart_fptr) (void);
-typedef int (*log_tend_fptr) (void);
+typedef int (*log_tend_fptr) (lng *tend);
+typedef int (*log_tflush_fptr) (lng tend);
 typedef int (*log_sequence_fptr) (int seq, lng id);
 
 typedef struct logger_functions {
@@ -289,6 +303,7 @@ typedef struct logger_functions {
 	log_isnew_fptr log_isnew;
 	log_tstart_fptr log_tstart;
 	log_tend_fptr log_tend;
+	log_tflush_fptr log_tflush;
 	log_sequence_fptr log_sequence;
 } logger_functions;
 
@@ -311,10 +326,26 @@ extern void store_exit(void);
 
 extern void store_apply_deltas(void);
 extern void store_manager(void);
+
+/* progress of the incremental checkpoints and backlog of the log */
+typedef struct checkpoint_status {
+	int active;		/* a checkpoint is in progress */
+	int tables;		/* tables handled by the current checkpoint */
+	int ntables;		/* out of */
+	lng changes;		/* changes in the write-ahead log */
+	lng threshold;		/* changes that trigger a checkpoint */
+	lng pending;		/* inserts/updates not merged yet */
+	lng checkpoints;	/* completed checkpoints */
+	lng postponed;		/* checkpoints that found no quiet moment */
+	lng duration;		/* ms taken by the last checkpoint */
+} checkpoint_status;
+
+extern void store_checkpoint_status(checkpoint_status *cs);
 extern void minmax_manager(void);
 
 extern void store_lock(void);
 extern void store_unlock(void);
+extern int store_flush_log(lng tend);
 extern int store_next_oid(void);
 
 extern sql_trans *sql_trans_create(backend_stack stk, sql_trans *parent, const char *name);
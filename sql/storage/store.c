@@ -1513,7 +1513,8 @@ store_init(int debug, store_type store, int readonly, int singleuser, const char
 		insert_aggrs(tr, funcs, args);
 		insert_schemas(tr);
 
-		if (sql_trans_commit(tr) != SQL_OK)
+		if (sql_trans_commit(tr) != SQL_OK ||
+		    store_flush_log(tr->tend) != SQL_OK)
 			fprintf(stderr, "cannot commit initial transaction\n");
 		sql_trans_destroy(tr);
 	}
@@ -1587,45 +1588,213 @@ store_apply_deltas(void)
 	logging = 0;
 }
 
-void
-store_manager(void)
+/* Incremental checkpoints.
+ *
+ * Once the write-ahead log holds more than ckp_changes changes, the
+ * store manager merges the deltas of the global tables into their
+ * persistent bats, one table at a time.  Merging needs a moment
+ * without active transactions, because all transactions share the
+ * delta bats of the global transaction.  To find such a moment under
+ * a continuous load, new transactions are held back (see
+ * store_checkpoint_gate) for at most ckp_wait milliseconds; if the
+ * running transactions don't finish in time, the checkpoint is
+ * postponed to the next round and transactions proceed.  When all
+ * tables are merged a final (short) step merges what was committed in
+ * the mean time and restarts the log.
+ */
+static lng ckp_changes = 1000000;
+static int ckp_wait = 100;
+static int ckp_gate = 0;
+static int ckp_active = 0;
+static int ckp_tables = 0;
+static int ckp_ntables = 0;
+static lng ckp_count = 0;
+static lng ckp_postponed = 0;
+static lng ckp_duration = 0;
+
+/* call locked ! */
+static sql_table *
+ckp_table(int nr, int *ntables)
 {
-	while (!GDKexiting()) {
-		int res = LOG_OK;
-		int t;
+	sql_table *res = NULL;
+	node *sn, *n;
 
-		for (t = 30000; t > 0; t -= 50) {
-			MT_sleep_ms(50);
-			if (GDKexiting())
-				return;
+	*ntables = 0;
+	for (sn = gtrans->schemas.set->h; sn; sn = sn->next) {
+		sql_schema *s = sn->data;
+
+		if (isTempSchema(s) || !s->tables.set)
+			continue;
+		for (n = s->tables.set->h; n; n = n->next) {
+			sql_table *t = n->data;
+
+			if (!isTable(t) || !isGlobal(t))
+				continue;
+			if ((*ntables)++ == nr)
+				res = t;
 		}
+	}
+	return res;
+}
+
+/* call locked ! Wait (at most ckp_wait ms) for the active transactions
+ * to finish while holding back new ones, return whether there are no
+ * active transactions left. */
+static int
+ckp_quiesce(void)
+{
+	int t;
+
+	ckp_gate = 1;
+	for (t = ckp_wait; store_nr_active && t > 0 && !GDKexiting(); t--) {
+		MT_lock_unset(&bs_lock, "store_manager");
+		MT_sleep_ms(1);
+		MT_lock_set(&bs_lock, "store_manager");
+	}
+	ckp_gate = 0;
+	return !store_nr_active && !GDKexiting();
+}
+
+static int
+store_checkpoint(void)
+{
+	int res = LOG_OK, nr, done = 0;
+	lng t0 = GDKusec();
+
+	MT_lock_set(&bs_lock, "store_manager");
+	ckp_active = 1;
+	ckp_tables = 0;
+	MT_lock_unset(&bs_lock, "store_manager");
+
+	/* merge the tables one by one; as the catalog may change in
+	 * between, tables are found by position, if one is missed the
+	 * final step merges it */
+	for (nr = 0; res == LOG_OK; nr++) {
+		sql_table *t;
+
 		MT_lock_set(&bs_lock, "store_manager");
-		if (GDKexiting() || logger_funcs.changes() < 1000000) {
+		if ((t = ckp_table(nr, &ckp_ntables)) == NULL) {
+			done = 1;
+			MT_lock_unset(&bs_lock, "store_manager");
+			break;
+		}
+		ckp_tables = nr;
+		if (!store_funcs.gtrans_table_changes(gtrans, t)) {
 			MT_lock_unset(&bs_lock, "store_manager");
 			continue;
 		}
-		while (store_nr_active) { /* find a moment to flush */
+		if (!ckp_quiesce()) {
 			MT_lock_unset(&bs_lock, "store_manager");
-			MT_sleep_ms(50);
-			MT_lock_set(&bs_lock, "store_manager");
+			break;
 		}
+		/* ckp_quiesce may have released the lock */
+		if ((t = ckp_table(nr, &ckp_ntables)) != NULL) {
+			logging = 1;
+			/* make sure we reset all transactions on re-activation */
+			gtrans->wstime = timestamp();
+			res = store_funcs.gtrans_update_table(gtrans, t);
+			logging = 0;
+		}
+		MT_lock_unset(&bs_lock, "store_manager");
+		/* let the transactions we held back run */
+		MT_sleep_ms(10);
+	}
+
+	MT_lock_set(&bs_lock, "store_manager");
+	if (res == LOG_OK && done && ckp_quiesce()) {
+		ckp_tables = ckp_ntables;
 		logging = 1;
-		/* make sure we reset all transactions on re-activation */
 		gtrans->wstime = timestamp();
-		if (store_funcs.gtrans_update)
-			store_funcs.gtrans_update(gtrans);
+		store_funcs.gtrans_update(gtrans);
 		res = logger_funcs.restart();
 		MT_lock_unset(&bs_lock, "store_manager");
 		if (logging && res == LOG_OK)
 			res = logger_funcs.cleanup();
 		MT_lock_set(&bs_lock, "store_manager");
 		logging = 0;
+		ckp_count++;
+		ckp_duration = (GDKusec() - t0) / 1000;
+	} else if (res == LOG_OK) {
+		ckp_postponed++;
+	}
+	ckp_active = 0;
+	MT_lock_unset(&bs_lock, "store_manager");
+	return res;
+}
+
+void
+store_manager(void)
+{
+	const char *p;
+
+	if ((p = GDKgetenv("sql_checkpoint_changes")) != NULL && atoi(p) > 0)
+		ckp_changes = strtoll(p, NULL, 10);
+	if ((p = GDKgetenv("sql_checkpoint_wait")) != NULL && atoi(p) > 0)
+		ckp_wait = atoi(p);
+	while (!GDKexiting()) {
+		int t;
+
+		for (t = 30000; t > 0; t -= 50) {
+			MT_sleep_ms(50);
+			if (GDKexiting())
+				return;
+		}
+		MT_lock_set(&bs_lock, "store_manager");
+		if (GDKexiting() || logger_funcs.changes() < ckp_changes) {
+			/* no checkpoint due; the minmax manager thread is
+			 * not started, so compress the columns of read-only
+			 * tables here while nothing runs */
+			if (!GDKexiting() && !store_nr_active && store_funcs.gtrans_minmax)
+				store_funcs.gtrans_minmax(gtrans);
+			MT_lock_unset(&bs_lock, "store_manager");
+			continue;
+		}
 		MT_lock_unset(&bs_lock, "store_manager");
-		if (res != LOG_OK)
+		if (store_checkpoint() != LOG_OK)
 			GDKfatal("write-ahead logging failure, disk full?");
 	}
 }
 
+/* call locked ! Hold back a new transaction while the store manager
+ * is waiting for a moment without active transactions.  Called by
+ * sql_trans_begin, so that no way of starting a transaction (chained
+ * commits and rollbacks included) can postpone a checkpoint forever. */
+static void
+store_checkpoint_gate(void)
+{
+	while (ckp_gate) {
+		MT_lock_unset(&bs_lock, "store_checkpoint_gate");
+		MT_sleep_ms(1);
+		MT_lock_set(&bs_lock, "store_checkpoint_gate");
+	}
+}
+
+void
+store_checkpoint_status(checkpoint_status *cs)
+{
+	node *sn, *n;
+
+	MT_lock_set(&bs_lock, "store_checkpoint_status");
+	cs->active = ckp_active;
+	cs->tables = ckp_tables;
+	cs->ntables = ckp_ntables;
+	cs->changes = logger_funcs.changes();
+	cs->threshold = ckp_changes;
+	cs->pending = 0;
+	for (sn = gtrans->schemas.set->h; sn; sn = sn->next) {
+		sql_schema *s = sn->data;
+
+		if (isTempSchema(s) || !s->tables.set)
+			continue;
+		for (n = s->tables.set->h; n; n = n->next)
+			cs->pending += store_funcs.gtrans_table_changes(gtrans, n->data);
+	}
+	cs->checkpoints = ckp_count;
+	cs->postponed = ckp_postponed;
+	cs->duration = ckp_duration;
+	MT_lock_unset(&bs_lock, "store_checkpoint_status");
+}
+
 void
 minmax_manager(void)
 {
@@ -1667,6 +1836,18 @@ store_unlock(void)
 	MT_lock_unset(&bs_lock, "trans_unlock");
 }
 
+/* Wait until the log of a commit is on disk; tend is the log position
+ * sql_trans_commit left in tr->tend.  With group commit the log is
+ * only written, not synced, at commit, and committers call this after
+ * releasing the store lock, so that they can share an fsync. */
+int
+store_flush_log(lng tend)
+{
+	if (tend && logger_funcs.log_tflush(tend) != LOG_OK)
+		return SQL_ERR;
+	return SQL_OK;
+}
+
 static sql_kc *
 kc_dup_(sql_trans *tr, int flag, sql_kc *kc, sql_table *t, int copy)
 {
@@ -3335,6 +3516,7 @@ sql_trans_commit(sql_trans *tr)
 	/* write phase */
 	if (bs_debug)
 		fprintf(stderr, "#forwarding changes %d,%d %d,%d\n", gtrans->stime, tr->stime, gtrans->wstime, tr->wstime);
+	tr->tend = 0;
 	/* snap shots should be saved first */
 	if (tr->parent == gtrans) {
 		ok = rollforward_trans(tr, R_SNAPSHOT);
@@ -3347,7 +3529,7 @@ sql_trans_commit(sql_trans *tr)
 			ok = logger_funcs.log_sequence(OBJ_SID, store_oid);
 		prev_oid = store_oid;
 		if (ok == LOG_OK)
-			ok = logger_funcs.log_tend();
+			ok = logger_funcs.log_tend(&tr->tend);
 		tr->schema_number = store_schema_number();
 	}
 	if (ok == LOG_OK) {
@@ -5161,9 +5343,13 @@ sql_session_reset(sql_session *s, int ac)
 int
 sql_trans_begin(sql_session *s)
 {
-	sql_trans *tr = s->tr;
-	int snr = tr->schema_number;
+	sql_trans *tr;
+	int snr;
 
+	/* let a pending checkpoint step go first */
+	store_checkpoint_gate();
+	tr = s->tr;
+	snr = tr->schema_number;
 #ifdef STORE_DEBUG
 	fprintf(stderr,"#sql trans begin %d\n", snr);
 #endif
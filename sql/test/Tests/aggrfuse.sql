@@ -0,0 +1,30 @@
+-- aggregates over the same groups are fused into a single
+-- aggr.subaggr call by the default pipe; the minimal pipe computes them
+-- one by one, and both must give the same answers
+-- (the sums are cast so the output is the same with and without hugeint)
+create table aggrfuse (g int, i int, l bigint, d double, n decimal(10,2), s varchar(10));
+insert into aggrfuse values
+	(1, 1, 10, 1.5, 1.25, 'b'),
+	(1, null, 20, 2.5, null, 'a'),
+	(1, 3, null, null, 3.50, null),
+	(2, -4, -40, -4.5, -4.00, 'd'),
+	(2, 5, 50, 5.5, 5.75, 'c'),
+	(3, null, null, null, null, null),
+	(3, null, null, null, null, null),
+	(null, 7, 70, 7.5, 7.00, 'e'),
+	(null, null, 80, null, 8.25, 'f');
+
+set optimizer = 'default_pipe';
+select g, count(*), count(i), cast(sum(i) as bigint), min(i), max(i), cast(sum(l) as bigint), min(l), max(l) from aggrfuse group by g order by g;
+select g, count(d), sum(d), min(d), max(d), cast(sum(n) as decimal(18,2)), min(n), max(n), min(s), max(s) from aggrfuse group by g order by g;
+select g, count(*), cast(sum(i) as bigint), min(d), max(l) from aggrfuse where i > 0 or d is null group by g order by g;
+select g, count(*), cast(sum(i) as bigint), max(i) from aggrfuse where g > 3 group by g;
+
+set optimizer = 'minimal_pipe';
+select g, count(*), count(i), cast(sum(i) as bigint), min(i), max(i), cast(sum(l) as bigint), min(l), max(l) from aggrfuse group by g order by g;
+select g, count(d), sum(d), min(d), max(d), cast(sum(n) as decimal(18,2)), min(n), max(n), min(s), max(s) from aggrfuse group by g order by g;
+select g, count(*), cast(sum(i) as bigint), min(d), max(l) from aggrfuse where i > 0 or d is null group by g order by g;
+select g, count(*), cast(sum(i) as bigint), max(i) from aggrfuse where g > 3 group by g;
+
+set optimizer = 'default_pipe';
+drop table aggrfuse;
@@ -0,0 +1,132 @@
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+import os, sys, time, threading, monetdb.sql
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-checkpoint'
+
+# clean up before we start
+if os.path.exists(os.path.join(dbfarm, dbname)):
+    import shutil
+    shutil.rmtree(os.path.join(dbfarm, dbname))
+
+NCLIENTS = 4
+DEADLINE = 150                  # the store manager looks every 30 seconds
+
+def server():
+    # no timeout since we need to kill mserver5, not the inbetween
+    # Mtimeout; a low threshold, so that the sessions below cross it
+    # well before the store manager looks
+    return process.server(args = ['--set', 'sql_checkpoint_changes=1000',
+                                  '--set', 'sql_checkpoint_wait=100'],
+                          dbname = dbname,
+                          stdin = process.PIPE,
+                          stdout = process.PIPE,
+                          stderr = process.PIPE,
+                          notimeout = True)
+
+def connect(autocommit = True):
+    return monetdb.sql.connect(database = dbname,
+                               hostname = '127.0.0.1',
+                               port = int(os.getenv('MAPIPORT')),
+                               username = 'monetdb',
+                               password = 'monetdb',
+                               autocommit = autocommit)
+
+def query(conn, sql):
+    cur = conn.cursor()
+    cur.execute(sql)
+    r = cur.fetchall()
+    cur.close()
+    return r
+
+def status(conn):
+    return query(conn, 'select checkpoints, postponed from sys.checkpoint')[0]
+
+def wait(conn, cond):
+    # poll sys.checkpoint until cond holds
+    t = time.time() + DEADLINE
+    while time.time() < t:
+        if cond(*status(conn)):
+            return True
+        time.sleep(0.5)
+    return False
+
+# each session commits into a table of its own, so that they overlap
+# without conflicting; without the checkpoint gate there would never
+# be a moment without an active transaction
+commits = [0] * NCLIENTS
+stop = False
+
+def committer(c):
+    conn = connect()
+    cur = conn.cursor()
+    while not stop:
+        cur.execute('insert into ck%d values (%d)' % (c, commits[c]))
+        commits[c] += 1
+    cur.close()
+    conn.close()
+
+s = server()
+conn = connect()
+cur = conn.cursor()
+for c in range(NCLIENTS):
+    cur.execute('create table ck%d (i int)' % c)
+cur.execute('create table cklong (i int)')
+cur.close()
+print 'initial:', status(conn)
+
+threads = [threading.Thread(target = committer, args = (c,))
+           for c in range(NCLIENTS)]
+for t in threads:
+    t.start()
+
+# a transaction that stays open for longer than sql_checkpoint_wait
+# postpones the checkpoint, but may not hold back the others
+lconn = connect(autocommit = False)
+lconn.cursor().execute('insert into cklong values (1)')
+print 'checkpoint postponed:', wait(conn, lambda ckp, pp: pp > 0)
+print 'no checkpoint completed:', status(conn)[0] == 0
+before = sum(commits)
+time.sleep(2)
+print 'sessions commit while postponed:', sum(commits) > before
+lconn.commit()
+lconn.close()
+
+# with all transactions short, the gate finds a moment to merge each
+# table, and the sessions keep committing during the checkpoint
+print 'checkpoint completed:', wait(conn, lambda ckp, pp: ckp > 0)
+before = list(commits)
+time.sleep(2)
+print 'every session commits after it:', all([commits[c] > before[c] for c in range(NCLIENTS)])
+
+stop = True
+for t in threads:
+    t.join()
+conn.close()
+
+# the merged tables and the restarted log together hold every
+# acknowledged commit
+s.kill()
+s.communicate()
+
+s = server()
+conn = connect()
+print 'all commits survive a restart:', all([query(conn, 'select count(*), count(distinct i), min(i), max(i) from ck%d' % c)[0] == (commits[c], commits[c], 0, commits[c] - 1) for c in range(NCLIENTS)])
+print query(conn, 'select i from cklong')
+cur = conn.cursor()
+for c in range(NCLIENTS):
+    cur.execute('drop table ck%d' % c)
+cur.execute('drop table cklong')
+cur.close()
+conn.close()
+s.communicate()
@@ -0,0 +1,39 @@
+import os, sys, struct
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+dst = os.environ['TSTTRGDIR']
+
+def write(name, data):
+    f = open(os.path.join(dst, name), 'wb')
+    f.write(data)
+    f.close()
+    return os.path.join(dst, name)
+
+# a string file without NUL bytes holds one value per line, one with
+# NUL bytes holds NUL terminated values (which may contain newlines);
+# either way the last value need not be terminated
+i1 = write('cbs_i1.bin', struct.pack('<4i', 1, 2, 3, 4))
+s1 = write('cbs_s1.txt', 'one\ntwo words\n\nfour\n')
+i2 = write('cbs_i2.bin', struct.pack('<4i', 5, 6, 7, 8))
+s2 = write('cbs_s2.bin', 'one\0two\nlines\0\0four')
+
+clt = process.client('sql',
+                     stdin = process.PIPE,
+                     stdout = process.PIPE,
+                     stderr = process.PIPE,
+                     interactive = False,
+                     echo = False)
+clt.stdin.write('create table cbs (i int, s varchar(20));\n')
+clt.stdin.write("copy binary into cbs from '%s', '%s';\n" % (i1, s1))
+clt.stdin.write("copy binary into cbs from '%s', '%s';\n" % (i2, s2))
+out, err = clt.communicate()
+sys.stdout.write(out.replace(os.environ['TSTTRGBASE'],'${TSTTRGBASE}').replace('\\','/'))
+sys.stderr.write(err.replace(os.environ['TSTTRGBASE'],'${TSTTRGBASE}').replace('\\','/'))
+
+clt = process.client('sql', stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+out, err = clt.communicate('select * from cbs order by i;\ndrop table cbs;\n')
+sys.stdout.write(out)
+sys.stderr.write(err)
@@ -0,0 +1,17 @@
+-- the smallest and largest valid values of each integer type, and
+-- the nil (the smallest value of the type) which must be rejected
+create table cib (t tinyint, s smallint, i int, b bigint);
+copy 3 records into cib from stdin using delimiters ',','\n';
+-127,-32767,-2147483647,-999999999999999999
+127,32767,2147483647,999999999999999999
+0,0,0,0
+select * from cib;
+select count(*) from cib where t is null or s is null or i is null or b is null;
+copy 1 records into cib from stdin using delimiters ',','\n';
+-128,0,0,0
+copy 1 records into cib from stdin using delimiters ',','\n';
+0,0,-2147483648,0
+copy 1 records into cib from stdin using delimiters ',','\n';
+0,0,2147483648,0
+select count(*) from cib;
+drop table cib;
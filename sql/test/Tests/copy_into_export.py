@@ -0,0 +1,119 @@
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+import os, sys, gzip, monetdb.sql
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-export'
+
+# clean up before we start
+if os.path.exists(os.path.join(dbfarm, dbname)):
+    import shutil
+    shutil.rmtree(os.path.join(dbfarm, dbname))
+
+# several rounds of slices of 64K rows, the last one not full
+NROWS = 300000
+
+# the same data exported by several threads, and by a single one
+EXPORTS = [('dense', 'select * from ce'),
+           ('ordered', 'select * from ce order by l, i'),
+           ('filtered', 'select i, s, dt from ce where i % 3 <> 0'),
+           ('compressed', 'select * from ce')]
+
+def server(threads):
+    return process.server(args = ['--set', 'gdk_nr_threads=%d' % threads],
+                          dbname = dbname,
+                          stdin = process.PIPE,
+                          stdout = process.PIPE,
+                          stderr = process.PIPE)
+
+def connect():
+    return monetdb.sql.connect(database = dbname,
+                               hostname = '127.0.0.1',
+                               port = int(os.getenv('MAPIPORT')),
+                               username = 'monetdb',
+                               password = 'monetdb',
+                               autocommit = True)
+
+def query(conn, sql):
+    cur = conn.cursor()
+    cur.execute(sql)
+    r = cur.fetchall()
+    cur.close()
+    return r
+
+tstdir = os.environ['TSTTRGDIR']
+
+def fname(name, suffix):
+    if name == 'compressed':
+        suffix += '.gz'
+    return os.path.join(tstdir, 'ce_%s.%s' % (name, suffix))
+
+def export(conn, suffix):
+    cur = conn.cursor()
+    for name, sql in EXPORTS:
+        cur.execute("copy %s into '%s'" % (sql, fname(name, suffix)))
+    cur.close()
+
+def content(f):
+    if f.endswith('.gz'):
+        fd = gzip.open(f, 'rb')
+    else:
+        fd = open(f, 'rb')
+    data = fd.read()
+    fd.close()
+    return data
+
+s = server(8)
+conn = connect()
+cur = conn.cursor()
+# NULLs and strings that need quotes and escapes in every column
+cur.execute('create table ce (i int, l bigint, d decimal(9,2), f double, s varchar(30), dt date, b boolean)')
+cur.execute('''insert into ce select value,
+ case when value % 11 = 0 then null else (cast(value as bigint) * 7919) % 1000003 - 500000 end,
+ cast(value % 1000000 as decimal(9,2)) / 7,
+ case when value % 7 = 0 then null else cast(value as double) / 8 end,
+ case value % 6 when 0 then null when 1 then 'a|b' || value when 2 then 'q"' || value
+  when 3 then 'back\\\\slash' when 4 then 'new\\nline\\t' || value else '' end,
+ case when value % 13 = 0 then null else date '2000-01-01' + value % 10000 * interval '1' day end,
+ case value % 3 when 0 then null when 1 then true else false end
+ from sys.generate_series(cast(0 as int), ''' + str(NROWS) + ')')
+cur.close()
+export(conn, 'par')
+conn.close()
+s.communicate()
+
+s = server(1)
+conn = connect()
+export(conn, 'seq')
+
+for name, sql in EXPORTS:
+    par = content(fname(name, 'par'))
+    print '%s: same as exported by one thread:' % name, par == content(fname(name, 'seq'))
+print 'compressed file holds the dense export:', content(fname('compressed', 'par')) == content(fname('dense', 'par'))
+
+# and what was exported loads back (the export quotes strings by
+# default, the import does not)
+cur = conn.cursor()
+cur.execute('create table ce2 (i int, l bigint, d decimal(9,2), f double, s varchar(30), dt date, b boolean)')
+cur.execute("copy into ce2 from '%s' using delimiters '|','\\n','\"'" % fname('dense', 'par'))
+cur.close()
+print query(conn, 'select count(*), count(l), count(f), count(s), count(dt), count(b) from ce2')
+same = ' and '.join(['(ce.%s = ce2.%s or ce.%s is null and ce2.%s is null)' % (c, c, c, c) for c in ['l', 'd', 'f', 's', 'dt', 'b']])
+print 'loads back:', query(conn, 'select count(*) from ce, ce2 where ce.i = ce2.i and ' + same)[0][0] == NROWS
+print query(conn, 'select * from ce2 where i in (0, 1, 2, 3, 4, 5, 65535, 65536, 131072, %d) order by i' % (NROWS - 1))
+
+conn.cursor().execute('drop table ce; drop table ce2')
+conn.close()
+s.communicate()
+for name, sql in EXPORTS:
+    os.remove(fname(name, 'par'))
+    os.remove(fname(name, 'seq'))
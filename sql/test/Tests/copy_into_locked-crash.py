@@ -0,0 +1,96 @@
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+import os, sys, monetdb.sql
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-locked'
+
+# clean up before we start
+if os.path.exists(os.path.join(dbfarm, dbname)):
+    import shutil
+    shutil.rmtree(os.path.join(dbfarm, dbname))
+
+# more rows than fit in the log as values, so that the load is logged
+# by reference to the column bats
+NROWS = 200000
+
+def server():
+    # no timeout since we need to kill mserver5, not the inbetween
+    # Mtimeout; no checkpoint may save the bats before the kill
+    return process.server(args = ['--set', 'sql_checkpoint_changes=1000000000'],
+                          dbname = dbname,
+                          stdin = process.PIPE,
+                          stdout = process.PIPE,
+                          stderr = process.PIPE,
+                          notimeout = True)
+
+def connect():
+    return monetdb.sql.connect(database = dbname,
+                               hostname = '127.0.0.1',
+                               port = int(os.getenv('MAPIPORT')),
+                               username = 'monetdb',
+                               password = 'monetdb',
+                               autocommit = True)
+
+def query(conn, sql):
+    cur = conn.cursor()
+    cur.execute(sql)
+    r = cur.fetchall()
+    cur.close()
+    return r
+
+def check(conn):
+    print query(conn, 'select count(*), sum(i), sum(length(s)), count(distinct s) from cil')
+    print query(conn, 'select i, s from cil where i in (-2, -1, 0, 1, 65535, 131072, %d) order by i' % (NROWS - 1))
+    print query(conn, "select count(*) from cil where s <> 'v' || cast(i * 7 as varchar(20))")
+
+data = os.path.join(os.environ['TSTTRGDIR'], 'cil.csv')
+f = open(data, 'w')
+for i in range(NROWS):
+    f.write('%d|v%d\n' % (i, i * 7))
+f.close()
+
+s = server()
+conn = connect()
+cur = conn.cursor()
+# the table is not new and not empty when the load starts
+cur.execute('create table cil (i int, s varchar(20))')
+cur.execute("insert into cil values (-2, 'v-14'), (-1, 'v-7')")
+cur.close()
+conn.close()
+s.communicate()
+
+s = server()
+conn = connect()
+cur = conn.cursor()
+cur.execute("copy %d records into cil from '%s' locked" % (NROWS, data))
+# and a change after the load
+cur.execute("update cil set s = 'updated' where i = 131072")
+cur.close()
+check(conn)
+conn.close()
+
+# the log only refers to the loaded bats, it does not hold the values
+logdir = os.path.join(dbfarm, dbname, 'sql_logs', 'sql')
+print 'load logged by reference:', sum([os.path.getsize(os.path.join(logdir, f)) for f in os.listdir(logdir)]) < NROWS * 4
+
+# the load must survive a crash
+s.kill()
+s.communicate()
+
+s = server()
+conn = connect()
+check(conn)
+conn.cursor().execute('drop table cil')
+conn.close()
+s.communicate()
+os.remove(data)
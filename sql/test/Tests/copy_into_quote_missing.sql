@@ -0,0 +1,11 @@
+-- a quote inside an unquoted field opens a quoted stretch that the
+-- record splitter closes in the next field, which then lacks its
+-- closing quote; the load must fail, not the server
+create table cqm (i int, s varchar(10), v varchar(10));
+copy 1 records into cqm from stdin using delimiters '|','\n','"';
+1|a"b|"c
+copy 2 records into cqm from stdin using delimiters '|','\n','"';
+1|"a|b"|c
+2|"d""e"|f
+select * from cqm;
+drop table cqm;
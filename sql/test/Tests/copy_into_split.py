@@ -0,0 +1,97 @@
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+import os, sys, monetdb.sql
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-split'
+
+# clean up before we start
+if os.path.exists(os.path.join(dbfarm, dbname)):
+    import shutil
+    shutil.rmtree(os.path.join(dbfarm, dbname))
+
+# large enough for a few buffers of 2MB, each cut in chunks of 256KB
+# by the parallel record splitter
+NROWS = 200000
+PART = 200000                   # below what the splitter cuts
+
+# the quoted field is mostly separators and escapes, so that many
+# chunk boundaries fall inside quotes or right after a backslash
+PIECES = ['|', '\n', '\\"', '\\\\', 'ab', 'cde|f', '\\t', 'x\ny', '""']
+DECODED = {'\\"': '"', '\\\\': '\\', '\\t': '\t', '""': '"'}
+
+def pieces(i):
+    return [PIECES[(i * 7 + k * 3 + k * k) % len(PIECES)] for k in range(3 + i % 23)]
+
+def record(i):
+    return '%d|"%s"|v%d\\\\%d\n' % (i, ''.join(pieces(i)), i, i % 13)
+
+def server():
+    # the splitter only runs with more than one thread
+    return process.server(args = ['--set', 'gdk_nr_threads=8'],
+                          dbname = dbname,
+                          stdin = process.PIPE,
+                          stdout = process.PIPE,
+                          stderr = process.PIPE)
+
+def query(conn, sql):
+    cur = conn.cursor()
+    cur.execute(sql)
+    r = cur.fetchall()
+    cur.close()
+    return r
+
+# the whole file, and the same records in parts that are split
+# sequentially
+tstdir = os.environ['TSTTRGDIR']
+data = os.path.join(tstdir, 'cs.csv')
+f = open(data, 'w')
+parts = []
+p = None
+for i in range(NROWS):
+    if p is None or p.tell() >= PART:
+        if p is not None:
+            p.close()
+        parts.append(os.path.join(tstdir, 'cs%d.csv' % len(parts)))
+        p = open(parts[-1], 'w')
+    f.write(record(i))
+    p.write(record(i))
+f.close()
+p.close()
+
+s = server()
+conn = monetdb.sql.connect(database = dbname,
+                           hostname = '127.0.0.1',
+                           port = int(os.getenv('MAPIPORT')),
+                           username = 'monetdb',
+                           password = 'monetdb',
+                           autocommit = True)
+cur = conn.cursor()
+cur.execute('create table cs (i int, s varchar(200), v varchar(20))')
+cur.execute('create table csseq (i int, s varchar(200), v varchar(20))')
+cur.execute("copy into cs from '%s' using delimiters '|','\\n','\"'" % data)
+for p in parts:
+    cur.execute("copy into csseq from '%s' using delimiters '|','\\n','\"'" % p)
+cur.close()
+
+print 'reference loaded in parts:', len(parts) > 1
+print query(conn, 'select count(*), count(distinct i), min(i), max(i) from cs')
+print 'same as loaded sequentially:', query(conn, 'select count(*) from cs, csseq where cs.i = csseq.i and cs.s = csseq.s and cs.v = csseq.v')[0][0] == NROWS
+print 'field lengths as expected:', query(conn, 'select sum(char_length(s)) from cs')[0][0] == sum([len(DECODED.get(x, x)) for i in range(NROWS) for x in pieces(i)])
+print query(conn, 'select * from cs where i in (0, 5, 8, 131071, %d) order by i' % (NROWS - 1))
+
+conn.cursor().execute('drop table cs; drop table csseq')
+conn.close()
+s.communicate()
+os.remove(data)
+for p in parts:
+    os.remove(p)
@@ -0,0 +1,113 @@
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+import os, sys, threading, monetdb.sql
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-groupcommit'
+
+# clean up before we start
+if os.path.exists(os.path.join(dbfarm, dbname)):
+    import shutil
+    shutil.rmtree(os.path.join(dbfarm, dbname))
+
+NCLIENTS = 8
+NCOMMITS = 50
+
+def server():
+    # no timeout since we need to kill mserver5, not the inbetween
+    # Mtimeout; let the commits wait for each other so that they are
+    # flushed in groups
+    return process.server(args = ['--set', 'gdk_nr_threads=8',
+                                  '--set', 'gdk_groupcommit=yes',
+                                  '--set', 'gdk_groupcommit_delay=5'],
+                          dbname = dbname,
+                          stdin = process.PIPE,
+                          stdout = process.PIPE,
+                          stderr = process.PIPE,
+                          notimeout = True)
+
+def connect():
+    return monetdb.sql.connect(database = dbname,
+                               hostname = '127.0.0.1',
+                               port = int(os.getenv('MAPIPORT')),
+                               username = 'monetdb',
+                               password = 'monetdb',
+                               autocommit = True)
+
+def query(conn, sql):
+    cur = conn.cursor()
+    cur.execute(sql)
+    r = cur.fetchall()
+    cur.close()
+    return r
+
+def logstats():
+    # the commit and log flush (fsync) counters of the logger
+    c = process.client('mal', dbname = dbname,
+                       stdin = process.PIPE, stdout = process.PIPE,
+                       stderr = process.PIPE)
+    out, err = c.communicate('(n,v) := status.batStatistics();\nio.print(n,v);\n')
+    stats = {}
+    for l in out.split('\n'):
+        if l.startswith('['):
+            f = l.strip('[] ').split(',')
+            stats[f[1].strip().strip('"')] = int(f[2])
+    return stats['logcommits'], stats['logflushes']
+
+# each client commits into a table of its own, so that the commits
+# don't conflict
+def committer(c):
+    conn = connect()
+    cur = conn.cursor()
+    for i in range(NCOMMITS):
+        cur.execute('insert into gc%d values (%d)' % (c, i))
+    cur.close()
+    conn.close()
+
+s = server()
+conn = connect()
+cur = conn.cursor()
+for c in range(NCLIENTS):
+    cur.execute('create table gc%d (i int)' % c)
+cur.close()
+conn.close()
+
+commits, flushes = logstats()
+threads = [threading.Thread(target = committer, args = (c,))
+           for c in range(NCLIENTS)]
+for t in threads:
+    t.start()
+for t in threads:
+    t.join()
+commits2, flushes2 = logstats()
+# every commit was logged, and concurrent commits shared an fsync
+print 'all commits logged:', commits2 - commits >= NCLIENTS * NCOMMITS
+print 'fewer log flushes than commits:', 0 < flushes2 - flushes < commits2 - commits
+
+# every insert was acknowledged, so each must survive a crash; note
+# that killing mserver5 (SIGKILL) does not drop what the OS has not
+# yet written to disk, so this checks that the commits were written
+# to the log before they were acknowledged, not that they were
+# fsynced, which only a power failure would show: that is covered by
+# the flush counters above
+s.kill()
+s.communicate()
+
+s = server()
+conn = connect()
+cur = conn.cursor()
+for c in range(NCLIENTS):
+    print query(conn, 'select count(*), min(i), max(i) from gc%d' % c)
+    cur.execute('drop table gc%d' % c)
+cur.close()
+conn.close()
+s.communicate()
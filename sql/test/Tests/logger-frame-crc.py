@@ -0,0 +1,130 @@
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+import os, sys, struct, monetdb.sql
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-framecrc'
+
+# clean up before we start
+if os.path.exists(os.path.join(dbfarm, dbname)):
+    import shutil
+    shutil.rmtree(os.path.join(dbfarm, dbname))
+
+def server():
+    # no timeout since we need to kill mserver5, not the inbetween
+    # Mtimeout; no checkpoint may empty the log before the kill
+    return process.server(args = ['--set', 'sql_checkpoint_changes=1000000000'],
+                          dbname = dbname,
+                          stdin = process.PIPE,
+                          stdout = process.PIPE,
+                          stderr = process.PIPE,
+                          notimeout = True)
+
+def connect():
+    return monetdb.sql.connect(database = dbname,
+                               hostname = '127.0.0.1',
+                               port = int(os.getenv('MAPIPORT')),
+                               username = 'monetdb',
+                               password = 'monetdb',
+                               autocommit = True)
+
+def query(conn, sql):
+    cur = conn.cursor()
+    cur.execute(sql)
+    r = cur.fetchall()
+    cur.close()
+    return r
+
+def crc32c(data):
+    crc = 0xFFFFFFFF
+    for c in data:
+        crc ^= ord(c)
+        for k in range(8):
+            crc = (crc >> 1) ^ (0x82F63B78 & -(crc & 1))
+    return crc ^ 0xFFFFFFFF
+
+def frames(log):
+    # a frame is a header of the stored size, the uncompressed size
+    # and the CRC32C of both sizes and the data, followed by the
+    # data; preallocated space (zeros) ends the log; the file starts
+    # with the byte order mark of the stream
+    pos = 2
+    while pos + 12 <= len(log):
+        size, rsize, crc = struct.unpack('<III', log[pos:pos + 12])
+        if size == 0 and rsize == 0 and crc == 0:
+            break
+        yield pos, size, crc == crc32c(log[pos:pos + 8] + log[pos + 12:pos + 12 + size])
+        pos += 12 + size
+
+def logfile():
+    logdir = os.path.join(dbfarm, dbname, 'sql_logs', 'sql')
+    return os.path.join(logdir, 'log.%d' % max([int(f[4:]) for f in os.listdir(logdir) if f.startswith('log.')]))
+
+def damage(pos):
+    # flip the first data byte of the frame at pos
+    name = logfile()
+    log = open(name, 'rb').read()
+    log = log[:pos + 12] + chr(ord(log[pos + 12]) ^ 0xFF) + log[pos + 13:]
+    open(name, 'r+b').write(log)
+    return [ok for p, size, ok in frames(log) if p == pos][0]
+
+def restart():
+    # the commits before the damaged frame are replayed, the one in
+    # it and any after it are lost
+    s = server()
+    conn = connect()
+    print query(conn, 'select i from crc order by i')
+    return s, conn
+
+s = server()
+conn = connect()
+cur = conn.cursor()
+cur.execute('create table crc (i int)')
+for i in range(1, 4):
+    cur.execute('insert into crc values (%d)' % i)
+cur.close()
+conn.close()
+s.kill()
+s.communicate()
+
+# the last frame of the current log holds the last commit
+fl = list(frames(open(logfile(), 'rb').read()))
+print 'all frames valid:', all([ok for pos, size, ok in fl])
+print 'last frame valid:', damage(fl[-1][0])
+s, conn = restart()
+
+# a damaged frame in the middle of the log ends the replay there;
+# which frames a commit wrote is found by reading the log of the
+# running server after each commit (a commit is on disk when it
+# returns)
+cur = conn.cursor()
+first = {}
+for i in range(10, 15):
+    n = len(list(frames(open(logfile(), 'rb').read())))
+    cur.execute('insert into crc values (%d)' % i)
+    fl = list(frames(open(logfile(), 'rb').read()))
+    first[i] = fl[n][0]
+cur.close()
+conn.close()
+s.kill()
+out, err = s.communicate()
+if 'ends in a damaged or incomplete block' in out:
+    print 'damaged tail of the log reported'
+
+print 'middle frame valid:', damage(first[12])
+print 'frames after it valid:', all([ok for pos, size, ok in frames(open(logfile(), 'rb').read()) if pos > first[12]])
+s, conn = restart()
+conn.cursor().execute('drop table crc')
+conn.close()
+out, err = s.communicate()
+if 'ends in a damaged or incomplete block' in out:
+    print 'damaged middle of the log reported'
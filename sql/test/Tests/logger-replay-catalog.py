@@ -0,0 +1,98 @@
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+import os, sys, monetdb.sql
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-replay'
+
+# clean up before we start
+if os.path.exists(os.path.join(dbfarm, dbname)):
+    import shutil
+    shutil.rmtree(os.path.join(dbfarm, dbname))
+
+def server():
+    # no timeout since we need to kill mserver5, not the inbetween
+    # Mtimeout; no checkpoint may empty the log before the kill, and
+    # more than one thread makes the replay of a log of more than 1MB
+    # parallel
+    return process.server(args = ['--set', 'gdk_nr_threads=4',
+                                  '--set', 'sql_checkpoint_changes=1000000000'],
+                          dbname = dbname,
+                          stdin = process.PIPE,
+                          stdout = process.PIPE,
+                          stderr = process.PIPE,
+                          notimeout = True)
+
+def connect():
+    return monetdb.sql.connect(database = dbname,
+                               hostname = '127.0.0.1',
+                               port = int(os.getenv('MAPIPORT')),
+                               username = 'monetdb',
+                               password = 'monetdb',
+                               autocommit = True)
+
+def query(conn, sql):
+    cur = conn.cursor()
+    cur.execute(sql)
+    r = cur.fetchall()
+    cur.close()
+    return r
+
+def check(conn):
+    print query(conn, 'select count(*), sum(i), sum(length(s)) from r1')
+    print query(conn, 'select count(*), sum(i), sum(j) from r2')
+    print query(conn, "select count(*) from tables where name in ('r3', 'seq')")
+
+s = server()
+conn = connect()
+cur = conn.cursor()
+
+# the inserts stay below the size at which a bat is saved instead of
+# logged, so everything ends up in the log
+cur.execute('create table seq (i bigint)')
+cur.execute('insert into seq values (0)')
+for k in range(16):
+    cur.execute('insert into seq select i + %d from seq' % (1 << k))
+
+# changes to bats that are destroyed and to bats created after them,
+# with the catalog actions in between
+cur.execute('create table r1 (i bigint)')
+for k in range(4):
+    cur.execute('insert into r1 select (i * 2654435761 + %d) %% 4294967291 from seq' % k)
+cur.execute('create table r2 (i bigint, j int)')
+for k in range(3):
+    cur.execute('insert into r2 select (i * 40503 + %d) %% 4294967291, cast(i as int) + %d from seq' % (k, k * 65536))
+cur.execute('drop table r1')
+cur.execute('create table r1 (i bigint, s varchar(10))')
+cur.execute('insert into r1 select i, cast(i as varchar(10)) from seq where i < 1000')
+cur.execute('update r2 set j = -j where j % 2 = 0')
+cur.execute('create table r3 (i int)')
+cur.execute('insert into r3 values (1), (2), (3)')
+cur.execute('delete from r2 where j % 3 = 0')
+cur.execute('insert into r2 select (i * 40503 + 3) % 4294967291, cast(i as int) + 196608 from seq where i < 10000')
+cur.execute('drop table r3')
+cur.execute('drop table seq')
+cur.close()
+check(conn)
+conn.close()
+
+# replay all of it from the log
+s.kill()
+s.communicate()
+
+s = server()
+conn = connect()
+check(conn)
+conn.cursor().execute('drop table r1')
+conn.cursor().execute('drop table r2')
+conn.close()
+s.communicate()
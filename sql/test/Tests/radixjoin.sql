@@ -0,0 +1,38 @@
+create table seq (i int);
+insert into seq values (0);
+insert into seq select i + 1 from seq;
+insert into seq select i + 2 from seq;
+insert into seq select i + 4 from seq;
+insert into seq select i + 8 from seq;
+insert into seq select i + 16 from seq;
+insert into seq select i + 32 from seq;
+insert into seq select i + 64 from seq;
+insert into seq select i + 128 from seq;
+insert into seq select i + 256 from seq;
+insert into seq select i + 512 from seq;
+insert into seq select i + 1024 from seq;
+insert into seq select i + 2048 from seq;
+insert into seq select i + 4096 from seq;
+insert into seq select i + 8192 from seq;
+insert into seq select i + 16384 from seq;
+insert into seq select i + 32768 from seq;
+insert into seq select i + 65536 from seq;
+insert into seq select i + 131072 from seq;
+insert into seq select i + 262144 from seq;
+insert into seq select i + 524288 from seq;
+insert into seq select i + 1048576 from seq;
+insert into seq select i + 2097152 from seq;
+insert into seq select i + 4194304 from seq;
+create table big1 as select cast((cast(i as bigint) * 7919) % 524288 as int) as k, i as v from seq where i < 524288 with data;
+create table small1 as select case when i % 97 = 0 then null else cast((i * 613) % 1048576 as int) end as k, i as v from seq where i < 1000 with data;
+select count(*) as cnt, cast(sum(s.v) as bigint) as ssum, cast(sum(b.v) as bigint) as bsum from (select cast(k + 0 as int) as k, v from small1) as s, big1 as b where s.k = b.k;
+select count(*) as cnt, cast(sum(s.v) as bigint) as ssum, cast(sum(b.v) as bigint) as bsum from (select cast(k + 0 as int) as k, v from small1) as s, (select cast(k + 0 as int) as k, v from big1) as b where s.k = b.k;
+create table big2 as select (cast(i as bigint) * 7919) % 8388608 as k, i as v from seq with data;
+create table small2 as select case when i % 97 = 0 then null else (cast(i as bigint) * 613) % 16777216 end as k, i as v from seq where i < 1000 with data;
+select count(*) as cnt, cast(sum(s.v) as bigint) as ssum, cast(sum(b.v) as bigint) as bsum from (select cast(k + 0 as bigint) as k, v from small2) as s, big2 as b where s.k = b.k;
+select count(*) as cnt, cast(sum(s.v) as bigint) as ssum, cast(sum(b.v) as bigint) as bsum from (select cast(k + 0 as bigint) as k, v from small2) as s, (select cast(k + 0 as bigint) as k, v from big2) as b where s.k = b.k;
+drop table small2;
+drop table big2;
+drop table small1;
+drop table big1;
+drop table seq;
@@ -0,0 +1,137 @@
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+import os, sys, time, monetdb.sql
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-strdict'
+
+# clean up before we start
+if os.path.exists(os.path.join(dbfarm, dbname)):
+    import shutil
+    shutil.rmtree(os.path.join(dbfarm, dbname))
+
+NROWS = 100000
+
+# s has a few thousand distinct strings, too many for the string heap
+# to keep only one copy of each, u only three, and t has too many
+# distinct strings for a dictionary; k is an integer column that gets
+# one too
+COLUMNS = '''value, value % 1000,
+ case when value % 17 = 0 then null when value % 19 = 0 then ''
+  else 'string ' || ((value * 7) % 2000) || ' of a few thousand in the dictionary' end,
+ 'w' || value,
+ case value % 3 when 0 then 'a' when 1 then 'b' else 'c' end'''
+
+S7 = "'string 7 of a few thousand in the dictionary'"
+QUERIES = [
+    # equality and range selects, on values in and not in the dictionary
+    'select count(*) from %s where s = ' + S7,
+    'select count(*) from %s where s <> ' + S7,
+    "select count(*) from %s where s = 'not there'",
+    "select count(*) from %s where s > 'string 5' and s < 'string 6'",
+    'select count(*) from %s where s >= ' + S7 + " and s <= 'string 9'",
+    "select count(*) from %s where s < 'string'",
+    "select count(*) from %s where s > 'z'",
+    "select count(*) from %s where s = ''",
+    'select count(*) from %s where s is null',
+    "select count(*) from %s where s between 'string 1' and 'string 2'",
+    "select count(*) from %s where i % 2 = 0 and s >= 'string 3'",
+    "select count(*) from %s where u = 'b'",
+    "select count(*) from %s where u > 'a'",
+    "select count(*) from %s where t = 'w12345'",
+    'select count(*) from %s where k = 7',
+    'select count(*) from %s where k between 100 and 199',
+    # grouping, projection and aggregates
+    'select s, count(*) from %s group by s order by s',
+    'select u, count(*), sum(i) from %s group by u order by u',
+    'select count(*), min(c), max(c) from (select k, count(*) as c from %s group by k) x',
+    'select count(distinct s), min(s), max(s), min(u), max(u) from %s',
+    'select i, k, s, t, u from %s where i in (0, 1, 17, 19, 65536, 99999) order by i',
+    "select i, s from %s where s < 'string 100 ' order by i limit 10",
+    'select count(*), count(s), sum(char_length(s)) from %s where i > 50000',
+    # joins
+    'select count(*) from %s a, sdref b where a.s = b.s and a.i < 100',
+    'select count(*) from %s a, sdref b where a.u = b.u and a.i < 10 and b.i < 10000',
+]
+
+def server():
+    return process.server(dbname = dbname,
+                          stdin = process.PIPE,
+                          stdout = process.PIPE,
+                          stderr = process.PIPE)
+
+def connect():
+    return monetdb.sql.connect(database = dbname,
+                               hostname = '127.0.0.1',
+                               port = int(os.getenv('MAPIPORT')),
+                               username = 'monetdb',
+                               password = 'monetdb',
+                               autocommit = True)
+
+def query(conn, sql):
+    cur = conn.cursor()
+    cur.execute(sql)
+    r = cur.fetchall()
+    cur.close()
+    return r
+
+def compressed():
+    n = 0
+    for d, dirs, files in os.walk(os.path.join(dbfarm, dbname, 'bat')):
+        n += len([f for f in files if f.endswith('.tcompress')])
+    return n
+
+# every query must give the same answer on the read-only table as on
+# the writable copy
+def check(conn):
+    for q in QUERIES:
+        r = query(conn, q.replace('%s', 'sd'))
+        if r == query(conn, q.replace('%s', 'sdref')):
+            if len(r) <= 10:
+                print r
+            else:
+                print len(r), 'rows'
+        else:
+            print 'DIFFERENT:', q.replace('%s', 'sd'), r, query(conn, q.replace('%s', 'sdref'))
+
+s = server()
+conn = connect()
+cur = conn.cursor()
+cur.execute('create table sd (i int, k int, s varchar(60), t varchar(20), u varchar(5))')
+cur.execute('create table sdref (i int, k int, s varchar(60), t varchar(20), u varchar(5))')
+cur.execute('insert into sd select ' + COLUMNS + ' from sys.generate_series(cast(0 as int), ' + str(NROWS) + ')')
+cur.execute('insert into sdref select * from sd')
+cur.execute('alter table sd set read only')
+cur.close()
+conn.close()
+s.communicate()
+
+# once the columns are saved, the dictionaries are made by the server
+# in the background, which looks at read-only tables every 30 seconds
+s = server()
+conn = connect()
+for t in range(120):
+    if compressed() >= 3:
+        break
+    time.sleep(1)
+print 'compressed copies of k, s and u made:', compressed() >= 3
+check(conn)
+conn.close()
+s.communicate()
+
+# and used again after a restart
+s = server()
+conn = connect()
+check(conn)
+conn.cursor().execute('drop table sd; drop table sdref')
+conn.close()
+s.communicate()
@@ -0,0 +1,3 @@
+#!/bin/sh
+
+Mlog -x "binresult $HOST $MAPIPORT sql"
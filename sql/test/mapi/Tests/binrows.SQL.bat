@@ -0,0 +1,6 @@
+@echo off
+
+prompt # $t $g  
+echo on
+
+binrows.exe %HOST% %MAPIPORT% sql
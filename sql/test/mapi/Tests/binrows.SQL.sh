@@ -0,0 +1,3 @@
+#!/bin/sh
+
+Mlog -x "binrows $HOST $MAPIPORT sql"